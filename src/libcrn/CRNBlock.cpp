@@ -25,6 +25,7 @@
 #include <CRNImage/CRNImageRGB.h>
 #include <CRNImage/CRNImageGray.h>
 #include <CRNImage/CRNImageBW.h>
+#include <CRNImage/CRNImageCache.h>
 #include <CRNData/CRNMap.h>
 #include <CRNException.h>
 #include <algorithm>
@@ -32,9 +33,28 @@
 #include <CRNIO/CRNFileShield.h>
 #include <CRNIO/CRNIO.h>
 #include <CRNXml/CRNXml.h>
+#include <CRNData/CRNBinary.h>
+#include <fstream>
+#include <cstring>
 
 using namespace crn;
 
+/*! \internal Extension of the binary block files */
+static const char BinaryBlockExtension[] = ".crnb";
+/*! \internal Signature of the binary block files */
+static const char BinaryBlockMagic[8] = {'C', 'R', 'N', 'B', 'L', 'O', 'C', 'K'};
+/*! \internal Version of the binary block files */
+static constexpr uint32_t BinaryBlockVersion = 1;
+
+/*! \internal Copies of the source or of another buffer are evicted first */
+static constexpr int CachePriorityCopy = 0;
+/*! \internal Binarization */
+static constexpr int CachePriorityBW = 1;
+/*! \internal Decoding of the image file */
+static constexpr int CachePrioritySource = 2;
+/*! \internal Gradients are the most expensive to recompute */
+static constexpr int CachePriorityGradient = 3;
+
 /*****************************************************************************/
 /*!
  * Constructor for a top Block
@@ -71,7 +91,8 @@ Block::Block(const SImage &src, const String &nam):
 	buffGradient(nullptr),
 	grad_sigma(-1),
 	grad_diffusemaxiter(0),
-	grad_diffusemaxdiv(std::numeric_limits<double>::max())
+	grad_diffusemaxdiv(std::numeric_limits<double>::max()),
+	modified(false)
 {
 	if (!nam)
 		SetName(_("NewBlock"));
@@ -119,7 +140,7 @@ SBlock Block::New(const Path &ifname, const Path &xfname, const String &nam)
 		b->Append(xfname);
 	if ((!b->bbox.IsValid()) || (b->bbox.GetWidth() == 0) || (b->bbox.GetHeight() == 0))
 	{
-		auto irgb = b->GetRGB();
+		auto irgb = b->getRGB();
 		b->bbox.SetLeft(0);
 		b->bbox.SetTop(0);
 		b->bbox.SetWidth(int(irgb->GetWidth()));
@@ -155,7 +176,8 @@ Block::Block(const Path &ifname, const Path &xfname, const String &nam):
 	buffGradient(nullptr),
 	grad_sigma(-1),
 	grad_diffusemaxiter(0),
-	grad_diffusemaxdiv(std::numeric_limits<double>::max())
+	grad_diffusemaxdiv(std::numeric_limits<double>::max()),
+	modified(false)
 {
 	if (!nam)
 		SetName(_("NewBlock"));
@@ -204,40 +226,21 @@ Block::Block(const WBlock &par, const String &tree, const Rect &clip, const Stri
 	buffGradient(nullptr),
 	grad_sigma(-1),
 	grad_diffusemaxiter(0),
-	grad_diffusemaxdiv(std::numeric_limits<double>::max())
+	grad_diffusemaxdiv(std::numeric_limits<double>::max()),
+	modified(true)
 {
 	if (!nam)
 		SetName(U"NewChildBlock");
 	if (par.expired())
 		throw ExceptionInvalidArgument(StringUTF8("Block::Block(WBlock par, const String &tree, Rect clip, String nam) : ") +
 				_("No parent."));
-	srcRGB = par.lock()->srcRGB;
-	srcGray = par.lock()->srcGray;
-	srcBW = par.lock()->srcBW;
-	srcGradient = par.lock()->srcGradient;
-	image_is_open = par.lock()->image_is_open;
+	// the sources are read through the topmost block
+	image_is_open = false;
 	// clipping!
-	SImage src = nullptr;
-	if (srcRGB) // search for a valid source
-		src = srcRGB;
-	else if (srcGray)
-		src = srcGray;
-	else if (srcBW)
-		src = srcBW;
-	else if (srcGradient)
-		src = srcGradient;
 	bbox = bbox & par.lock()->GetAbsoluteBBox();
-	if (src)
-	{
-		if (bbox.GetLeft() < 0)
-			bbox.SetLeft(0);
-		if (bbox.GetTop() < 0)
-			bbox.SetTop(0);
-		if (bbox.GetRight() >= int(src->GetWidth()))
-			bbox.SetRight(int(src->GetWidth()) - 1);
-		if (bbox.GetBottom() >= int(src->GetHeight()))
-			bbox.SetBottom(int(src->GetHeight()) - 1);
-	}
+	const auto top = par.lock()->GetTop().lock();
+	if (top->image_is_open)
+		bbox = bbox & top->GetAbsoluteBBox(); // the bounding box of the image
 }
 
 /*!
@@ -284,6 +287,7 @@ void Block::SetAbsoluteBBox(const Rect &newbox)
 		}
 	FlushAll();
 	bbox = nr;
+	SetModified();
 }
 
 /*!
@@ -410,16 +414,19 @@ Block::const_block_iterator Block::BlockEnd(const String &tree) const
  */
 void Block::openImage(void)
 {
-	if (image_is_open)
+	if (!parent.expired())
 	{
+		parent.lock()->openImage();
 		return;
 	}
-	if (!parent.expired())
+	if (image_is_open)
 	{
-		parent.lock()->openImage();
 		return;
 	}
 
+	std::lock_guard<std::recursive_mutex> lock(buffmutex);
+	if (image_is_open)
+		return; // opened by another thread while waiting for the lock
 	SImage src(nullptr);
 	try
 	{
@@ -433,14 +440,126 @@ void Block::openImage(void)
 		throw ExceptionIO(StringUTF8("Block::openImage(void): ") +
 				_("Cannot open image."));
 	}
-	srcRGB = std::dynamic_pointer_cast<ImageRGB>(src);
-	srcGray = std::dynamic_pointer_cast<ImageGray>(src);
-	srcBW = std::dynamic_pointer_cast<ImageBW>(src);
+	const auto rgb = std::dynamic_pointer_cast<ImageRGB>(src);
+	const auto gray = std::dynamic_pointer_cast<ImageGray>(src);
+	const auto bw = std::dynamic_pointer_cast<ImageBW>(src);
+	std::atomic_store(&srcRGB, rgb);
+	std::atomic_store(&srcGray, gray);
+	std::atomic_store(&srcBW, bw);
 	bbox = Rect(0, 0, int(src->GetWidth()) - 1, int(src->GetHeight()) - 1);
 	image_is_open = true;
+	// the image can be reloaded from the file, so it can be freed to respect the memory budget
+	const auto bytes = rgb ? ImageCache::GetBytes(*rgb) : gray ? ImageCache::GetBytes(*gray) : bw ? ImageCache::GetBytes(*bw) : size_t(0);
+	ImageCache::Register(this, bytes, CachePrioritySource, [this]()
+			{
+				auto rgb = std::atomic_load(&srcRGB);
+				auto gray = std::atomic_load(&srcGray);
+				auto bw = std::atomic_load(&srcBW);
+				if ((rgb.use_count() > 2) || (gray.use_count() > 2) || (bw.use_count() > 2))
+					return false; // someone is using the image
+				image_is_open = false;
+				// the image may have been reloaded by another thread as soon as the flag was cleared
+				std::atomic_compare_exchange_strong(&srcRGB, &rgb, SImageRGB{});
+				std::atomic_compare_exchange_strong(&srcGray, &gray, SImageGray{});
+				std::atomic_compare_exchange_strong(&srcBW, &bw, SImageBW{});
+				return true;
+			});
 	return;
 }
 
+/*!
+ * Publishes a newly created buffer and registers it to the image cache
+ *
+ * \param[in]	slot	the member that holds the buffer
+ * \param[in]	buff	the new buffer
+ * \param[in]	priority	the eviction priority
+ * \return	the buffer
+ */
+template<typename T> std::shared_ptr<T> Block::cacheBuffer(std::shared_ptr<T> &slot, std::shared_ptr<T> buff, int priority)
+{
+	std::atomic_store(&slot, buff);
+	auto *b = &slot;
+	ImageCache::Register(b, ImageCache::GetBytes(*buff), priority, [b]()
+			{
+				auto cur = std::atomic_load(b);
+				if (cur.use_count() > 2)
+					return false; // someone is using the buffer
+				std::atomic_store(b, std::shared_ptr<T>{});
+				return true;
+			});
+	return buff;
+}
+
+/*!
+ * Returns a local buffer. If it does not exist, it is created by a single thread while the others wait.
+ * Once it exists, the buffer is read without locking.
+ *
+ * \param[in]	slot	the member that holds the buffer
+ * \param[in]	create	a function that creates the buffer and publishes it with cacheBuffer(), called with the buffer lock held
+ * \return	the buffer or nullptr
+ */
+template<typename T, typename F> std::shared_ptr<T> Block::getBuffer(std::shared_ptr<T> &slot, F &&create)
+{
+	auto buff = std::atomic_load(&slot);
+	if (!buff)
+	{
+		std::lock_guard<std::recursive_mutex> lock(buffmutex);
+		buff = std::atomic_load(&slot); // may have been created while waiting for the lock
+		if (!buff)
+			return create();
+	}
+	ImageCache::Touch(&slot);
+	return buff;
+}
+
+/*!
+ * Returns a local buffer that the caller may modify in place.
+ * The buffer is withdrawn from the image cache, that could not recompute the modifications, and is kept until it is flushed or substituted.
+ *
+ * \param[in]	slot	the member that holds the buffer
+ * \param[in]	get	a function that returns the buffer, possibly creating it
+ * \return	the buffer or nullptr
+ */
+template<typename T, typename F> std::shared_ptr<T> Block::editBuffer(std::shared_ptr<T> &slot, F &&get)
+{
+	while (true)
+	{
+		auto buff = get();
+		if (!buff)
+			return buff;
+		ImageCache::Unregister(&slot);
+		if (std::atomic_load(&slot) == buff)
+			return buff;
+		// the buffer was evicted before it could be withdrawn
+	}
+}
+
+/*!
+ * Returns a source image of the topmost block. The image is loaded from file if it is not open or if it was freed by the image cache.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]	slot	the member that holds the source
+ * \return	the source image or nullptr if not applicable
+ */
+template<typename T> std::shared_ptr<T> Block::loadSource(std::shared_ptr<T> &slot)
+{
+	openImage();
+	auto img = std::atomic_load(&slot);
+	if (img)
+		return img;
+	// the image cannot be reopened while the lock is held, so a null source with an open image is not applicable
+	std::lock_guard<std::recursive_mutex> lock(buffmutex);
+	while (true)
+	{
+		openImage();
+		img = std::atomic_load(&slot);
+		if (img || image_is_open)
+			return img;
+	}
+}
+
 /*!
  * Returns the source RGB image. Loads it from file if necessary.
  *
@@ -453,9 +572,7 @@ SImageRGB Block::get_srcRGB(void)
 {
 	if (!parent.expired())
 		return parent.lock()->get_srcRGB();
-
-	openImage();
-	return srcRGB;
+	return loadSource(srcRGB);
 }
 
 /*!
@@ -470,9 +587,7 @@ SImageGray Block::get_srcGray(void)
 {
 	if (!parent.expired())
 		return parent.lock()->get_srcGray();
-
-	openImage();
-	return srcGray;
+	return loadSource(srcGray);
 }
 
 /*!
@@ -487,9 +602,7 @@ SImageBW Block::get_srcBW(void)
 {
 	if (!parent.expired())
 		return parent.lock()->get_srcBW();
-
-	openImage();
-	return srcBW;
+	return loadSource(srcBW);
 }
 
 /*!
@@ -504,9 +617,7 @@ SImageGradient Block::get_srcGradient(void)
 {
 	if (!parent.expired())
 		return parent.lock()->get_srcGradient();
-
-	openImage();
-	return srcGradient;
+	return loadSource(srcGradient);
 }
 
 /*****************************************************************************/
@@ -515,6 +626,8 @@ SImageGradient Block::get_srcGradient(void)
  */
 Block::~Block()
 {
+	for (const void *key : {(const void*)this, (const void*)&buffRGB, (const void*)&buffGray, (const void*)&buffGrayPyramid, (const void*)&buffBW, (const void*)&buffGradient})
+		ImageCache::Unregister(key);
 	if (GetFilename().IsNotEmpty())
 	{
 		Save();
@@ -557,6 +670,7 @@ SBlock Block::AddChildAbsolute(const String &tree, Rect clip)
 				_("Clipping rectangle out of bounds."));
 	}
 	getChildList(tree)->PushBack(nb);
+	SetModified();
 	return nb;
 }
 
@@ -584,6 +698,7 @@ SBlock Block::AddChildAbsolute(const String &tree, Rect clip, const String &name
 				_("Clipping rectangle out of bounds."));
 	}
 	getChildList(tree)->PushBack(nb);
+	SetModified();
 	return nb;
 }
 
@@ -617,6 +732,7 @@ SBlock Block::AddChildAbsoluteAt(const String &tree, Rect clip, size_t pos)
 					_("Clipping rectangle out of bounds."));
 		}
 		getChildList(tree)->Insert(nb, pos);
+		SetModified();
 		return nb;
 	}
 }
@@ -652,6 +768,7 @@ SBlock Block::AddChildAbsoluteAt(const String &tree, Rect clip, const String &na
 					_("Clipping rectangle out of bounds."));
 		}
 		getChildList(tree)->Insert(nb, pos);
+		SetModified();
 		return nb;
 	}
 }
@@ -680,6 +797,7 @@ SBlock Block::AddChildRelative(const String &tree, Rect clip)
 				_("Clipping rectangle out of bounds."));
 	}
 	getChildList(tree)->PushBack(nb);
+	SetModified();
 	return nb;
 }
 
@@ -708,6 +826,7 @@ SBlock Block::AddChildRelative(const String &tree, Rect clip, const String &name
 				_("Clipping rectangle out of bounds."));
 	}
 	getChildList(tree)->PushBack(nb);
+	SetModified();
 	return nb;
 }
 
@@ -742,6 +861,7 @@ SBlock Block::AddChildRelativeAt(const String &tree, Rect clip, size_t pos)
 					_("Clipping rectangle out of bounds."));
 		}
 		getChildList(tree)->Insert(nb, pos);
+		SetModified();
 		return nb;
 	}
 }
@@ -778,6 +898,7 @@ SBlock Block::AddChildRelativeAt(const String &tree, Rect clip, const String &na
 					_("Clipping rectangle out of bounds."));
 		}
 		getChildList(tree)->Insert(nb, pos);
+		SetModified();
 		return nb;
 	}
 }
@@ -787,6 +908,9 @@ SBlock Block::AddChildRelativeAt(const String &tree, Rect clip, const String &na
 /*!
  * Returns a pointer to the local RGB buffer.
  *
+ * The buffer may be modified in place, so it is withdrawn from the image cache and kept until it is flushed or substituted.
+ * Use GetRGBView() to read the pixels.
+ *
  * \throws	ExceptionIO	cannot open image
  * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
  *
@@ -794,56 +918,57 @@ SBlock Block::AddChildRelativeAt(const String &tree, Rect clip, const String &na
  */
 SImageRGB Block::GetRGB()
 {
-	if (!buffRGB)
-	{
-		// 1st option: get from the RGB source
-		if (get_srcRGB())
-		{
-			buffRGB = std::make_shared<ImageRGB>(*get_srcRGB(), bbox);
-			return buffRGB;
-		}
-		// 2nd option: get parent RGB buffer
-		if (!parent.expired())
-		{
-			if (parent.lock()->GetRGB())
-			{
-				Rect localbbox(bbox.GetLeft() - parent.lock()->GetAbsoluteBBox().GetLeft(),
-						bbox.GetTop() - parent.lock()->GetAbsoluteBBox().GetTop(),
-						bbox.GetRight() - parent.lock()->GetAbsoluteBBox().GetLeft(),
-						bbox.GetBottom() - parent.lock()->GetAbsoluteBBox().GetTop());
-				buffRGB = std::make_shared<ImageRGB>(*parent.lock()->GetRGB(), localbbox);
-				return buffRGB;
-			}
-		}
-		// 3rd option: get from the gray local buffer
-		if (buffGray)
-		{
-			buffRGB = std::make_shared<ImageRGB>(*buffGray);
-			return buffRGB;
-		}
-		// 4th option: get from the b&w local buffer
-		if (buffBW)
-		{
-			buffRGB = std::make_shared<ImageRGB>(*buffBW);
-			return buffRGB;
-		}
-		// 5th option: get from the gray source
-		if (get_srcGray())
-		{
-			buffRGB = std::make_shared<ImageRGB>(*get_srcGray());
-			return buffRGB;
-		}
-		// 6th option: get from the b&w source
-		if (get_srcBW())
-		{
-			buffRGB = std::make_shared<ImageRGB>(*get_srcBW());
-			return buffRGB;
-		}
-		//else
-		return nullptr;
-	}
+	return editBuffer(buffRGB, [this]() { return getRGB(); });
+}
 
-	return buffRGB;
+/*!
+ * Returns the local RGB buffer, that stays under the control of the image cache.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \return		The RGB local buffer.
+ */
+SImageRGB Block::getRGB()
+{
+	return getBuffer(buffRGB, [this]() -> SImageRGB
+			{
+				// 1st option: get from the RGB source
+				auto srgb = get_srcRGB();
+				if (srgb)
+					return cacheBuffer(buffRGB, std::make_shared<ImageRGB>(*srgb, bbox), CachePriorityCopy);
+				// 2nd option: get parent RGB buffer
+				if (!parent.expired())
+				{
+					auto prgb = parent.lock()->getRGB();
+					if (prgb)
+					{
+						Rect localbbox(bbox.GetLeft() - parent.lock()->GetAbsoluteBBox().GetLeft(),
+								bbox.GetTop() - parent.lock()->GetAbsoluteBBox().GetTop(),
+								bbox.GetRight() - parent.lock()->GetAbsoluteBBox().GetLeft(),
+								bbox.GetBottom() - parent.lock()->GetAbsoluteBBox().GetTop());
+						return cacheBuffer(buffRGB, std::make_shared<ImageRGB>(*prgb, localbbox), CachePriorityCopy);
+					}
+				}
+				// 3rd option: get from the gray local buffer
+				auto gray = std::atomic_load(&buffGray);
+				if (gray)
+					return cacheBuffer(buffRGB, std::make_shared<ImageRGB>(*gray), CachePriorityCopy);
+				// 4th option: get from the b&w local buffer
+				auto bw = std::atomic_load(&buffBW);
+				if (bw)
+					return cacheBuffer(buffRGB, std::make_shared<ImageRGB>(*bw), CachePriorityCopy);
+				// 5th option: get from the gray source
+				auto sgray = get_srcGray();
+				if (sgray)
+					return cacheBuffer(buffRGB, std::make_shared<ImageRGB>(*sgray), CachePriorityCopy);
+				// 6th option: get from the b&w source
+				auto sbw = get_srcBW();
+				if (sbw)
+					return cacheBuffer(buffRGB, std::make_shared<ImageRGB>(*sbw), CachePriorityCopy);
+				//else
+				return nullptr;
+			});
 }
 
 
@@ -853,6 +978,9 @@ SImageRGB Block::GetRGB()
  * Returns a pointer to the local gray buffer.
  * Creates the buffer if non existent.
  *
+ * The buffer may be modified in place, so it is withdrawn from the image cache and kept until it is flushed or substituted.
+ * Use GetGrayView() to read the pixels.
+ *
  * \throws	ExceptionIO	cannot open image
  * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
  *
@@ -861,60 +989,77 @@ SImageRGB Block::GetRGB()
  */
 SImageGray Block::GetGray(bool create)
 {
-	if (!buffGray)
-	{
-		// 1st option: get from the gray source
-		if (get_srcGray())
-		{
-			buffGray = std::make_shared<ImageGray>(*get_srcGray(), bbox);
-			return buffGray;
-		}
-		// 2nd option: get parent gray buffer
-		if (!parent.expired())
-		{
-			if (parent.lock()->GetGray(create))
-			{
-				Rect localbbox(bbox.GetLeft() - parent.lock()->GetAbsoluteBBox().GetLeft(),
-						bbox.GetTop() - parent.lock()->GetAbsoluteBBox().GetTop(),
-						bbox.GetRight() - parent.lock()->GetAbsoluteBBox().GetLeft(),
-						bbox.GetBottom() - parent.lock()->GetAbsoluteBBox().GetTop());
-				buffGray = std::make_shared<ImageGray>(*parent.lock()->GetGray(false), localbbox);
-				return buffGray;
-			}
-		}
-		// 3rd option: get from the RGB buffer
-		if (buffRGB && create)
-		{
-			buffGray = MoveShared(MakeImageGray(*buffRGB));
-			return buffGray;
-		}
-		// 4th option: get from the RGB source
-		if (get_srcRGB() && create)
-		{
-			buffGray = MoveShared(MakeImageGray(*GetRGB()));
-			return buffGray;
-		}
-		// 5th option: get from the BW buffer
-		if (buffBW)
-		{
-			buffGray = std::make_shared<ImageGray>(*buffBW);
-			return buffGray;
-		}
-		// 6th option: get from the BW source
-		if (get_srcBW())
-		{
-			buffGray = std::make_shared<ImageGray>(*get_srcBW());
-			return buffGray;
-		}
-		//else
-		if (create)
-		{
-			CRNWarning(String(U"SImageGray* Block::GetGray(): ") +
-					_("Cannot access to any source or buffer."));
-		}
-		return nullptr;
+	auto buff = editBuffer(buffGray, [this, create]() { return getGray(create); });
+	if (buff)
+	{ // the pixels may be modified, so the pyramid would be stale
+		std::lock_guard<std::recursive_mutex> lock(buffmutex); // not while the pyramid is being created
+		std::atomic_store(&buffGrayPyramid, SCImagePyramidGray{});
+		ImageCache::Unregister(&buffGrayPyramid);
 	}
-	return buffGray;
+	return buff;
+}
+
+/*!
+ * Returns the local gray buffer, that stays under the control of the image cache.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]		create	Shall the buffer be created from a rgb one?
+ * \return		The gray local buffer.
+ */
+SImageGray Block::getGray(bool create)
+{
+	return getBuffer(buffGray, [this, create]() -> SImageGray
+			{
+				// 1st option: get from the gray source
+				auto sgray = get_srcGray();
+				if (sgray)
+					return cacheBuffer(buffGray, std::make_shared<ImageGray>(*sgray, bbox), CachePriorityCopy);
+				// 2nd option: get parent gray buffer
+				if (!parent.expired())
+				{
+					auto pgray = parent.lock()->getGray(create);
+					if (pgray)
+					{
+						Rect localbbox(bbox.GetLeft() - parent.lock()->GetAbsoluteBBox().GetLeft(),
+								bbox.GetTop() - parent.lock()->GetAbsoluteBBox().GetTop(),
+								bbox.GetRight() - parent.lock()->GetAbsoluteBBox().GetLeft(),
+								bbox.GetBottom() - parent.lock()->GetAbsoluteBBox().GetTop());
+						return cacheBuffer(buffGray, std::make_shared<ImageGray>(*pgray, localbbox), CachePriorityCopy);
+					}
+				}
+				if (create)
+				{
+					// 3rd option: get from the RGB buffer
+					auto rgb = std::atomic_load(&buffRGB);
+					if (rgb)
+						return cacheBuffer(buffGray, MoveShared(MakeImageGray(*rgb)), CachePriorityCopy);
+					// 4th option: get from the RGB source
+					auto srgb = get_srcRGB(); // kept while the RGB buffer is created
+					if (srgb)
+					{
+						auto brgb = getRGB();
+						if (brgb)
+							return cacheBuffer(buffGray, MoveShared(MakeImageGray(*brgb)), CachePriorityCopy);
+					}
+				}
+				// 5th option: get from the BW buffer
+				auto bw = std::atomic_load(&buffBW);
+				if (bw)
+					return cacheBuffer(buffGray, std::make_shared<ImageGray>(*bw), CachePriorityCopy);
+				// 6th option: get from the BW source
+				auto sbw = get_srcBW();
+				if (sbw)
+					return cacheBuffer(buffGray, std::make_shared<ImageGray>(*sbw), CachePriorityCopy);
+				//else
+				if (create)
+				{
+					CRNWarning(String(U"SImageGray* Block::GetGray(): ") +
+							_("Cannot access to any source or buffer."));
+				}
+				return nullptr;
+			});
 }
 
 
@@ -923,6 +1068,9 @@ SImageGray Block::GetGray(bool create)
  * Returns a pointer to the local b&w buffer.
  * Creates the buffer if non existent.
  *
+ * The buffer may be modified in place, so it is withdrawn from the image cache and kept until it is flushed or substituted.
+ * Use GetBWView() to read the pixels.
+ *
  * \throws	ExceptionIO	cannot open image
  * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
  *
@@ -931,51 +1079,181 @@ SImageGray Block::GetGray(bool create)
  */
 SImageBW Block::GetBW(bool create)
 {
-	if (!buffBW)
-	{
-		// 1st option: get from the b&w source
-		if (get_srcBW())
-		{
-			buffBW = std::make_shared<ImageBW>(*get_srcBW(), bbox);
-			return buffBW;
-		}
-		// 2nd option: get parent BW buffer
-		if (!parent.expired())
-		{
-			if (parent.lock()->GetBW(create))
-			{
-				Rect localbbox(bbox.GetLeft() - parent.lock()->GetAbsoluteBBox().GetLeft(),
-						bbox.GetTop() - parent.lock()->GetAbsoluteBBox().GetTop(),
-						bbox.GetRight() - parent.lock()->GetAbsoluteBBox().GetLeft(),
-						bbox.GetBottom() - parent.lock()->GetAbsoluteBBox().GetTop());
-				buffBW = std::make_shared<ImageBW>(*parent.lock()->GetBW(false), localbbox);
-				return buffBW;
-			}
-		}
-		// 3rd option: create it
-		if (create)
-		{
-			SImageGray tmp = GetGray(true);
-			if (tmp)
-			{
-				buffBW = MoveShared(MakeImageBW(*tmp));
-				return buffBW;
-			}
-			else
+	return editBuffer(buffBW, [this, create]() { return getBW(create); });
+}
+
+/*!
+ * Returns the local b&w buffer, that stays under the control of the image cache.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]		create	Shall the buffer be created from a rgb or gray one?
+ * \return		The b&w local buffer.
+ */
+SImageBW Block::getBW(bool create)
+{
+	return getBuffer(buffBW, [this, create]() -> SImageBW
 			{
+				// 1st option: get from the b&w source
+				auto sbw = get_srcBW();
+				if (sbw)
+					return cacheBuffer(buffBW, std::make_shared<ImageBW>(*sbw, bbox), CachePriorityBW);
+				// 2nd option: get parent BW buffer
+				if (!parent.expired())
+				{
+					auto pbw = parent.lock()->getBW(create);
+					if (pbw)
+					{
+						Rect localbbox(bbox.GetLeft() - parent.lock()->GetAbsoluteBBox().GetLeft(),
+								bbox.GetTop() - parent.lock()->GetAbsoluteBBox().GetTop(),
+								bbox.GetRight() - parent.lock()->GetAbsoluteBBox().GetLeft(),
+								bbox.GetBottom() - parent.lock()->GetAbsoluteBBox().GetTop());
+						return cacheBuffer(buffBW, std::make_shared<ImageBW>(*pbw, localbbox), CachePriorityBW);
+					}
+				}
+				// 3rd option: create it
+				if (create)
+				{
+					SImageGray tmp = getGray(true);
+					if (tmp)
+						return cacheBuffer(buffBW, MoveShared(MakeImageBW(*tmp)), CachePriorityBW);
+				}
 				return nullptr;
-			}
-		}
-		// else
-		if (create)
-		{
-			CRNWarning(String(U"SImageBW* Block::GetBW(): ") +
-					_("Cannot access to any source or buffer."));
-		}
-		return nullptr;
+			});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns a read-only view on the RGB pixels of the block.
+ *
+ * The view shares the pixels of the local buffer, of the source image or of the parent's view, so that no pixel is copied.
+ * The local buffer is created (by copy or conversion) only if none of them is available.
+ * Use GetRGB() to get a modifiable buffer.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \return		a view on the RGB pixels, null if no source or buffer is available
+ */
+ImageViewRGB Block::GetRGBView()
+{
+	auto buff = std::atomic_load(&buffRGB);
+	if (buff)
+	{
+		ImageCache::Touch(&buffRGB);
+		return ImageViewRGB(buff);
 	}
+	auto src = get_srcRGB();
+	if (src)
+		return ImageViewRGB(src, bbox);
+	if (!parent.expired())
+	{
+		auto view = parent.lock()->GetRGBView();
+		if (view)
+			return view.Sub(GetRelativeBBox());
+	}
+	return ImageViewRGB(getRGB());
+}
 
-	return buffBW;
+/*****************************************************************************/
+/*!
+ * Returns a read-only view on the gray pixels of the block.
+ *
+ * The view shares the pixels of the local buffer, of the source image or of the parent's view, so that no pixel is copied.
+ * The local buffer is created (by copy or conversion) only if none of them is available.
+ * Use GetGray() to get a modifiable buffer.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]		create	Shall the buffer be created from a rgb one? default = true.
+ * \return		a view on the gray pixels, null if no source or buffer is available
+ */
+ImageViewGray Block::GetGrayView(bool create)
+{
+	auto buff = std::atomic_load(&buffGray);
+	if (buff)
+	{
+		ImageCache::Touch(&buffGray);
+		return ImageViewGray(buff);
+	}
+	auto src = get_srcGray();
+	if (src)
+		return ImageViewGray(src, bbox);
+	if (!parent.expired())
+	{
+		auto view = parent.lock()->GetGrayView(create);
+		if (view)
+			return view.Sub(GetRelativeBBox());
+	}
+	return ImageViewGray(getGray(create));
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the multi-resolution pyramid of the gray pixels of the block.
+ * The pyramid is computed once and kept, so that the estimators can work at a reduced resolution (e.g.: EstimateSkew()).
+ *
+ * The pyramid is built from a copy of the pixels, so that it does not prevent the image cache from freeing the gray buffer or the source image.
+ * It is dropped when the gray buffer is flushed, substituted or returned by GetGray(). The modifications made to a gray buffer that was obtained before the pyramid are not reflected in the pyramid.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]		create	Shall the pyramid (and the gray buffer) be created if non existent? default = true.
+ * \return		the pyramid, null if not available
+ */
+SCImagePyramidGray Block::GetGrayPyramid(bool create)
+{
+	if (!create)
+	{
+		auto buff = std::atomic_load(&buffGrayPyramid);
+		if (buff)
+			ImageCache::Touch(&buffGrayPyramid);
+		return buff;
+	}
+	return getBuffer(buffGrayPyramid, [this]() -> SCImagePyramidGray
+			{
+				auto view = GetGrayView(true);
+				if (!view)
+					return nullptr;
+				return cacheBuffer(buffGrayPyramid, SCImagePyramidGray(std::make_shared<ImagePyramidGray>(std::make_shared<ImageGray>(view.Copy()))), CachePriorityCopy);
+			});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns a read-only view on the b&w pixels of the block.
+ *
+ * The view shares the pixels of the local buffer, of the source image or of the parent's view, so that no pixel is copied.
+ * The local buffer is created (by copy or conversion) only if none of them is available.
+ * Use GetBW() to get a modifiable buffer.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]		create	Shall the buffer be created from a rgb or gray one? default = true.
+ * \return		a view on the b&w pixels, null if no source or buffer is available
+ */
+ImageViewBW Block::GetBWView(bool create)
+{
+	auto buff = std::atomic_load(&buffBW);
+	if (buff)
+	{
+		ImageCache::Touch(&buffBW);
+		return ImageViewBW(buff);
+	}
+	auto src = get_srcBW();
+	if (src)
+		return ImageViewBW(src, bbox);
+	if (!parent.expired())
+	{
+		auto view = parent.lock()->GetBWView(create);
+		if (view)
+			return view.Sub(GetRelativeBBox());
+	}
+	return ImageViewBW(getBW(create));
 }
 
 /*!
@@ -994,10 +1272,10 @@ std::vector<String> Block::GetTreeNames() const
 }
 
 /*!
- * Saves the child trees into a file.
+ * Saves the child trees into a file. The file is binary if its name ends with ".crnb" (see IsBinaryFilename()) and XML otherwise.
  *
  * \throws	ExceptionInvalidArgument	empty file name
- * \throws	ExceptionIO	cannot save XML file
+ * \throws	ExceptionIO	cannot save file
  * \throws	ExceptionRuntime	error creating the file
  * \param[in]		fname	The file to create.
  */
@@ -1010,10 +1288,146 @@ void Block::Save(const Path &fname)
 				_("No filename given."));
 	}
 
-	xml::Document doc;
-	doc.PushBackComment("libcrn Block tree file");
-	addToXml(doc);
-	doc.Save(fname.CStr()); // may throw
+	const auto isdefault = fname == GetFilename();
+	if (IsBinaryFilename(fname))
+	{
+		binary::Writer w;
+		w.WriteBytes(BinaryBlockMagic, sizeof(BinaryBlockMagic));
+		w.WriteU32(BinaryBlockVersion);
+		addToBinary(w, isdefault);
+		w.Save(fname); // may throw
+	}
+	else
+	{
+		xml::Document doc;
+		doc.PushBackComment("libcrn Block tree file");
+		addToXml(doc);
+		doc.Save(fname.CStr()); // may throw
+	}
+	if (isdefault)
+		clearModified();
+}
+
+/*!
+ * Saves the child trees into the default file.
+ *
+ * Nothing is written if the file exists and the block was not modified since it was loaded from or saved to this file.
+ * Changes made in place to the objects returned by GetTree() or GetUserData() are not tracked and must be signaled with SetModified().
+ *
+ * \throws	ExceptionInvalidArgument	empty file name
+ * \throws	ExceptionIO	cannot save file
+ */
+void Block::Save()
+{
+	if (!modified)
+	{
+		Path fn(GetFilename());
+		fn.ToLocal();
+		if (fn.IsNotEmpty() && IO::Access(fn, IO::EXISTS))
+			return;
+	}
+	Save(GetFilename());
+}
+
+/*!
+ * Saves the child trees into a file and makes it the default file (used by Save() and the destructor).
+ *
+ * \throws	ExceptionInvalidArgument	empty file name
+ * \throws	ExceptionIO	cannot save file
+ * \param[in]		fname	The file to create.
+ */
+void Block::SaveAs(const Path &fname)
+{
+	Save(fname);
+	setFilename(fname);
+	clearModified();
+}
+
+/*!
+ * Marks the block and its ancestors as modified, so that the next call to Save() rewrites the default file.
+ *
+ * Blocks are marked automatically by the methods that modify them. Lookups such as GetTree() and Savable::GetUserData() do not mark the block, so this method must be called after editing the returned objects in place.
+ */
+void Block::SetModified() noexcept
+{
+	binarycache = std::vector<uint8_t>{}; // may have been filled by a save that failed
+	if (modified)
+		return; // the ancestors are already marked
+	modified = true;
+	if (!parent.expired())
+		parent.lock()->SetModified();
+}
+
+/*!
+ * Tracks the modifications of the name and user data. Blocks under construction are not tracked.
+ */
+void Block::internalDataChanged() noexcept
+{
+	if (!self.expired())
+		SetModified();
+}
+
+/*!
+ * Marks the block and its descendants as saved. The descendants of an unmodified block are unmodified.
+ */
+void Block::clearModified()
+{
+	if (!modified)
+		return;
+	modified = false;
+	for (const auto &tree : *child)
+		for (const auto &b : *std::static_pointer_cast<Vector>(tree.second))
+			std::static_pointer_cast<Block>(b)->clearModified();
+}
+
+/*!
+ * Checks if a file name designates a binary block file, ie: it ends with ".crnb".
+ * Save() writes binary files for such names and XML files otherwise. Append() detects the format from the content of the file.
+ *
+ * \param[in]		fname	The file name
+ * \return	true if the file name has the binary extension
+ */
+bool Block::IsBinaryFilename(const Path &fname)
+{
+	return fname.EndsWith(BinaryBlockExtension);
+}
+
+/*!
+ * Adds the block's coordinates, name, user data and subblock trees to a binary stream.
+ *
+ * The records of unmodified children are copied from their cache.
+ *
+ * \param[in]	w	the stream
+ * \param[in]	cachechildren	shall the records of the children be cached? (only if the block is marked as saved afterwards)
+ */
+void Block::addToBinary(binary::Writer &w, bool cachechildren)
+{
+	w.WriteI32(bbox.GetLeft());
+	w.WriteI32(bbox.GetTop());
+	w.WriteI32(bbox.GetRight());
+	w.WriteI32(bbox.GetBottom());
+	w.WriteString(GetName().CStr());
+	serialize_internal_data(w);
+	w.WriteU32(uint32_t(child->Size()));
+	for (Map::const_iterator it = child->begin(); it != child->end(); ++it)
+	{
+		w.WriteString(it->first.CStr());
+		SVector v = std::static_pointer_cast<Vector>(it->second);
+		w.WriteU32(uint32_t(v->Size()));
+		for (size_t tmp = 0; tmp < v->Size(); tmp++)
+		{
+			SBlock b(std::static_pointer_cast<Block>(v->At(tmp)));
+			if (!b->modified && !b->binarycache.empty())
+				w.WriteBytes(b->binarycache.data(), b->binarycache.size());
+			else
+			{
+				const auto begin = w.GetBuffer().size();
+				b->addToBinary(w, false);
+				if (cachechildren)
+					b->binarycache.assign(w.GetBuffer().data() + begin, w.GetBuffer().data() + w.GetBuffer().size());
+			}
+		}
+	}
 }
 
 /*!
@@ -1067,11 +1481,11 @@ void Block::addToXml(xml::Element &parent)
 }
 
 /*!
- * Appends child trees from a file.
+ * Appends child trees from a file. The file can be an XML or a binary block file (see IsBinaryFilename()).
  *
  * \throws	ExceptionInvalidArgument	empty file name
  * \throws	ExceptionIO	file exists but cannot be accessed or has invalid structure
- * \throws	ExceptionRuntime	the XML file does not fit the block's image
+ * \throws	ExceptionRuntime	the file does not fit the block's image
  *
  * \param[in]		fname	The file to load.
  * \return	true if success, false if file not found.
@@ -1080,6 +1494,10 @@ bool Block::Append(const Path &fname)
 {
 	std::lock_guard<std::mutex> lockf(crn::FileShield::GetMutex(fname)); // lock the file
 
+	// if the block is empty, its content will be the file's, else it will differ from both
+	const auto fresh = !modified && child->IsEmpty();
+	if (!fresh)
+		SetModified();
 	setFilename(fname);
 	if (!fname)
 	{
@@ -1092,30 +1510,97 @@ bool Block::Append(const Path &fname)
 	{ // file not found, do not warn
 		return false;
 	}
+	auto setbbox = [this](int l, int t, int r, int b)
+		{
+			if (GetTop().lock()->image_is_open)
+			{
+				if ((l != bbox.GetLeft()) || (t != bbox.GetTop()) ||
+						(r != bbox.GetRight()) || (b != bbox.GetBottom()))
+				{
+					throw ExceptionRuntime(StringUTF8("bool Block::Append(const Path &fname): ") +
+							_("Saved block do not have the same size."));
+				}
+			}
+			else
+			{
+				bbox.SetLeft(l);
+				bbox.SetRight(r);
+				bbox.SetTop(t);
+				bbox.SetBottom(b);
+			}
+		};
+
+	char magic[sizeof(BinaryBlockMagic)];
+	std::ifstream header(fn.CStr(), std::ios::binary);
+	if (header.read(magic, sizeof(magic)) && !std::memcmp(magic, BinaryBlockMagic, sizeof(magic)))
+	{ // binary file
+		header.close();
+		const auto data = binary::LoadFile(fn); // may throw
+		binary::Reader reader(data.data(), data.size());
+		reader.ReadBytes(sizeof(BinaryBlockMagic));
+		if (reader.ReadU32() > BinaryBlockVersion)
+			throw ExceptionIO(StringUTF8("bool Block::Append(const Path &fname): ") +
+					_("Unsupported binary block file version."));
+		const auto l = reader.ReadI32(); // may throw
+		const auto t = reader.ReadI32(); // may throw
+		const auto r = reader.ReadI32(); // may throw
+		const auto b = reader.ReadI32(); // may throw
+		reader.ReadString(); // the name of the top block is not restored, as in XML files
+		setbbox(l, t, r, b);
+		addTreeFromBinary(reader, fresh);
+		if (fresh)
+			clearModified();
+		return true;
+	}
+	header.close();
+
 	xml::Document doc(fname); // may throw
 	xml::Element root = doc.GetRoot();
 	int l = root.GetAttribute<int>("left", false); // may throw
 	int t = root.GetAttribute<int>("top", false); // may throw
 	int b = root.GetAttribute<int>("bottom", false); // may throw
 	int r = root.GetAttribute<int>("right", false); // may throw
-	if (image_is_open)
+	setbbox(l, t, r, b);
+	addTreeFromXml(root);
+	if (fresh)
+		clearModified();
+	return true;
+}
+
+/*!
+ * Reads block's user data and subblock trees from a binary stream.
+ *
+ * \throws	ExceptionIO	truncated stream or invalid content
+ *
+ * \param[in]	r	the stream, positioned after the block's coordinates and name
+ * \param[in]	cachechildren	shall the records of the children be cached? (only if the block is marked as saved afterwards)
+ */
+void Block::addTreeFromBinary(binary::Reader &r, bool cachechildren)
+{
+	deserialize_internal_data(r);
+	const auto ntrees = r.ReadU32();
+	for (auto tree = uint32_t(0); tree < ntrees; ++tree)
 	{
-		if ((l != bbox.GetLeft()) || (t != bbox.GetTop()) ||
-				(r != bbox.GetRight()) || (b != bbox.GetBottom()))
+		const auto treename = String(r.ReadString());
+		const auto nblocks = r.ReadU32();
+		for (auto block = uint32_t(0); block < nblocks; ++block)
 		{
-			throw ExceptionRuntime(StringUTF8("bool Block::Append(const Path &fname): ") +
-						_("Saved block do not have the same size."));
+			const auto begin = r.GetPosition();
+			const auto left = r.ReadI32();
+			const auto top = r.ReadI32();
+			const auto right = r.ReadI32();
+			const auto bottom = r.ReadI32();
+			const auto rec = Rect(left, top, right, bottom);
+			const auto bn = String(r.ReadString());
+			if (!rec.IsValid())
+				throw ExceptionIO(StringUTF8("void Block::addTreeFromBinary(binary::Reader &r): ") +
+						_("Wrong content."));
+			SBlock newblock = AddChildAbsolute(treename, rec, bn);
+			newblock->addTreeFromBinary(r, false);
+			if (cachechildren && (newblock->GetAbsoluteBBox() == rec) && (newblock->GetName() == bn))
+				newblock->binarycache.assign(begin, r.GetPosition()); // the block was not altered when added
 		}
 	}
-	else
-	{
-		bbox.SetLeft(l);
-		bbox.SetRight(r);
-		bbox.SetTop(t);
-		bbox.SetBottom(b);
-	}
-	addTreeFromXml(root);
-	return true;
 }
 
 /*!
@@ -1187,12 +1672,15 @@ bool Block::HasTree(const String &tname) const
 void Block::RemoveTree(const String &tname)
 {
 	child->Remove(tname); // may throw
+	SetModified();
 }
 
 /*****************************************************************************/
 /*!
  * Returns a pointer to the local gradient buffer.
  *
+ * The buffer may be modified in place, so it is withdrawn from the image cache and kept until it is flushed or substituted.
+ *
  * \throws	ExceptionIO	cannot open image
  * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
  *
@@ -1204,93 +1692,114 @@ void Block::RemoveTree(const String &tname)
  */
 SImageGradient Block::GetGradient(bool create, double sigma, size_t diffusemaxiter, double diffusemaxdiv)
 {
-	if (buffGradient)
-		return buffGradient;
-	if (!create)
-		return nullptr;
-	// need to compute the buffer
-	grad_sigma = sigma;
-	grad_diffusemaxiter = diffusemaxiter;
-	grad_diffusemaxdiv = diffusemaxdiv;
-
-	// is the source a gradient?
-	if (get_srcGradient())
-	{
-		// warning all arguments are ignored!
-		buffGradient = std::make_shared<ImageGradient>(*get_srcGradient(), bbox);
-		buffGradient->SetMinModule(get_srcGradient()->GetMinModule());
-		return buffGradient;
-	}
+	return editBuffer(buffGradient, [this, create, sigma, diffusemaxiter, diffusemaxdiv]() { return getGradient(create, sigma, diffusemaxiter, diffusemaxdiv); });
+}
 
-	// autocompute sigma if needed
-	if (sigma == -1)
+/*!
+ * Returns the local gradient buffer, that stays under the control of the image cache.
+ *
+ * \throws	ExceptionIO	cannot open image
+ * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
+ *
+ * \param[in]		create	Shall the buffer be created from a gray or b&w one?
+ * \param[in]		sigma	The standard deviation of the gaussian core used to apply the gradient
+ * \param[in]		diffusemaxiter	maximal number of iterations of the diffusion
+ * \param[in]		diffusemaxdiv	maximal divergence to allow modification for each pixel during the diffusion
+ * \return		The gradient local buffer or nullptr
+ */
+SImageGradient Block::getGradient(bool create, double sigma, size_t diffusemaxiter, double diffusemaxdiv)
+{
+	if (!create)
 	{
-		sigma = 0.5;
-		auto ig = GetGray(true);
-		if (ig)
-		{
-			size_t sw = StrokesWidth(*ig, 50, 3);
-			sigma = double(sw) / 6.0;
-		}
+		auto buff = std::atomic_load(&buffGradient);
+		if (buff)
+			ImageCache::Touch(&buffGradient);
+		return buff;
 	}
+	return getBuffer(buffGradient, [this, sigma, diffusemaxiter, diffusemaxdiv]() mutable -> SImageGradient
+			{
+				// need to compute the buffer
+				grad_sigma = sigma;
+				grad_diffusemaxiter = diffusemaxiter;
+				grad_diffusemaxdiv = diffusemaxdiv;
+
+				// is the source a gradient?
+				auto srcgrad = get_srcGradient();
+				if (srcgrad)
+				{
+					// warning all arguments are ignored!
+					auto grad = std::make_shared<ImageGradient>(*srcgrad, bbox);
+					grad->SetMinModule(srcgrad->GetMinModule());
+					return cacheBuffer(buffGradient, grad, CachePriorityGradient);
+				}
 
-	// topmost block
-	if (parent.expired())
-	{
-		auto diff = Differential::NewGaussian(*GetRGB(), Differential::RGBProjection::ABSMAX, sigma);
-		if (diffusemaxiter)
-			diff.Diffuse(diffusemaxiter, diffusemaxdiv);
+				// autocompute sigma if needed
+				if (sigma == -1)
+				{
+					sigma = 0.5;
+					auto ig = getGray(true);
+					if (ig)
+					{
+						size_t sw = StrokesWidth(*ig, 50, 3);
+						sigma = double(sw) / 6.0;
+					}
+				}
 
-		buffGradient = MoveShared(diff.MakeImageGradient());
-		return buffGradient;
-	}
+				// topmost block
+				if (parent.expired())
+				{
+					auto diff = Differential::NewGaussian(*getRGB(), Differential::RGBProjection::ABSMAX, sigma);
+					if (diffusemaxiter)
+						diff.Diffuse(diffusemaxiter, diffusemaxdiv);
 
-	// not topmost
-	// look for a parent with a gradient
-	WBlock gpar = parent;
-	while (!gpar.expired())
-	{
-		if (gpar.lock()->GetGradient(false) && (gpar.lock()->grad_sigma == grad_sigma) && (gpar.lock()->grad_diffusemaxiter == grad_diffusemaxiter) && (gpar.lock()->grad_diffusemaxdiv == grad_diffusemaxdiv))
-			break;
-		gpar = gpar.lock()->parent;
-	}
-	if (!gpar.expired())
-	{ // some top gradient was already computed
-		Rect b(bbox);
-		b.Translate(-gpar.lock()->GetAbsoluteBBox().GetLeft(),
-				-gpar.lock()->GetAbsoluteBBox().GetTop());
-		SImageGradient topgrad(gpar.lock()->GetGradient(true, sigma, diffusemaxiter, diffusemaxdiv));
-		buffGradient = std::make_shared<ImageGradient>(*topgrad, b);
-		buffGradient->SetMinModule(topgrad->GetMinModule());
+					return cacheBuffer(buffGradient, MoveShared(diff.MakeImageGradient()), CachePriorityGradient);
+				}
 
-		return buffGradient;
-	}
-	else
-	{ // top gradient not computed
-		Rect clip = GetTop().lock()->GetAbsoluteBBox();
-		// add a margin
-		clip.SetLeft(Max(0, bbox.GetLeft() - 10));
-		clip.SetTop(Max(0, bbox.GetTop() - 10));
-		clip.SetRight(Min(clip.GetRight(), bbox.GetRight() + 10));
-		clip.SetBottom(Min(clip.GetBottom(), bbox.GetBottom() + 10));
-		int offsetx = bbox.GetLeft() - clip.GetLeft();
-		int offsety = bbox.GetTop() - clip.GetTop();
-		auto tmp = ImageRGB(*GetTop().lock()->GetRGB(), clip);
-		auto diff = Differential::NewGaussian(tmp, Differential::RGBProjection::ABSMAX, sigma);
-		if (diffusemaxiter)
-			diff.Diffuse(diffusemaxiter, diffusemaxdiv);
-
-		auto tmpGradient = diff.MakeImageGradient();
-		Rect r;
-		r.SetLeft((int)offsetx);
-		r.SetTop((int)offsety);
-		r.SetRight((int)(offsetx + bbox.GetWidth() - 1));
-		r.SetBottom((int)(offsety + bbox.GetHeight() - 1));
-		buffGradient = std::make_shared<ImageGradient>(tmpGradient, r);
-		buffGradient->SetMinModule(tmpGradient.GetMinModule());
-
-		return buffGradient;
-	}
+				// not topmost
+				// look for a parent with a gradient
+				WBlock gpar = parent;
+				while (!gpar.expired())
+				{
+					if (gpar.lock()->getGradient(false, -1, 0, std::numeric_limits<double>::max()) && (gpar.lock()->grad_sigma == grad_sigma) && (gpar.lock()->grad_diffusemaxiter == grad_diffusemaxiter) && (gpar.lock()->grad_diffusemaxdiv == grad_diffusemaxdiv))
+						break;
+					gpar = gpar.lock()->parent;
+				}
+				if (!gpar.expired())
+				{ // some top gradient was already computed
+					Rect b(bbox);
+					b.Translate(-gpar.lock()->GetAbsoluteBBox().GetLeft(),
+							-gpar.lock()->GetAbsoluteBBox().GetTop());
+					SImageGradient topgrad(gpar.lock()->getGradient(true, sigma, diffusemaxiter, diffusemaxdiv));
+					auto grad = std::make_shared<ImageGradient>(*topgrad, b);
+					grad->SetMinModule(topgrad->GetMinModule());
+					return cacheBuffer(buffGradient, grad, CachePriorityGradient);
+				}
+				else
+				{ // top gradient not computed
+					Rect clip = GetTop().lock()->GetAbsoluteBBox();
+					// add a margin
+					clip.SetLeft(Max(0, bbox.GetLeft() - 10));
+					clip.SetTop(Max(0, bbox.GetTop() - 10));
+					clip.SetRight(Min(clip.GetRight(), bbox.GetRight() + 10));
+					clip.SetBottom(Min(clip.GetBottom(), bbox.GetBottom() + 10));
+					int offsetx = bbox.GetLeft() - clip.GetLeft();
+					int offsety = bbox.GetTop() - clip.GetTop();
+					auto tmp = ImageRGB(*GetTop().lock()->getRGB(), clip);
+					auto diff = Differential::NewGaussian(tmp, Differential::RGBProjection::ABSMAX, sigma);
+					if (diffusemaxiter)
+						diff.Diffuse(diffusemaxiter, diffusemaxdiv);
+
+					auto tmpGradient = diff.MakeImageGradient();
+					Rect r;
+					r.SetLeft((int)offsetx);
+					r.SetTop((int)offsety);
+					r.SetRight((int)(offsetx + bbox.GetWidth() - 1));
+					r.SetBottom((int)(offsety + bbox.GetHeight() - 1));
+					auto grad = std::make_shared<ImageGradient>(tmpGradient, r);
+					grad->SetMinModule(tmpGradient.GetMinModule());
+					return cacheBuffer(buffGradient, grad, CachePriorityGradient);
+				}
+			});
 }
 
 
@@ -1308,13 +1817,13 @@ void Block::ReloadImage()
 	else
 	{
 		FlushAll(true);
+		ImageCache::Unregister(this);
 		image_is_open = false;
-		srcRGB = nullptr;
-		srcGray = nullptr;
-		srcBW = nullptr;
-		srcGradient = nullptr;
+		std::atomic_store(&srcRGB, SImageRGB{});
+		std::atomic_store(&srcGray, SImageGray{});
+		std::atomic_store(&srcBW, SImageBW{});
+		std::atomic_store(&srcGradient, SImageGradient{});
 		openImage();
-		refreshSources();
 	}
 }
 
@@ -1340,7 +1849,8 @@ void Block::FlushAll(bool recursive)
  */
 void Block::FlushRGB(bool recursive)
 {
-	buffRGB = nullptr;
+	std::atomic_store(&buffRGB, SImageRGB{});
+	ImageCache::Unregister(&buffRGB);
 	if (recursive)
 	{
 		for (crn::Map::pair p : child)
@@ -1362,7 +1872,11 @@ void Block::FlushRGB(bool recursive)
  */
 void Block::FlushGray(bool recursive)
 {
-	buffGray = nullptr;
+	std::atomic_store(&buffGray, SImageGray{});
+	ImageCache::Unregister(&buffGray);
+	// the pyramid was computed from the former pixels
+	std::atomic_store(&buffGrayPyramid, SCImagePyramidGray{});
+	ImageCache::Unregister(&buffGrayPyramid);
 	if (recursive)
 	{
 		for (crn::Map::pair p : child)
@@ -1384,7 +1898,8 @@ void Block::FlushGray(bool recursive)
  */
 void Block::FlushBW(bool recursive)
 {
-	buffBW = nullptr;
+	std::atomic_store(&buffBW, SImageBW{});
+	ImageCache::Unregister(&buffBW);
 	if (recursive)
 	{
 		for (crn::Map::pair p : child)
@@ -1406,7 +1921,8 @@ void Block::FlushBW(bool recursive)
  */
 void Block::FlushGradient(bool recursive)
 {
-	buffGradient = nullptr;
+	std::atomic_store(&buffGradient, SImageGradient{});
+	ImageCache::Unregister(&buffGradient);
 	if (recursive)
 	{
 		for (crn::Map::pair p : child)
@@ -1446,8 +1962,9 @@ void Block::SubstituteRGB(const SImageRGB &img)
 		throw ExceptionDimension(StringUTF8("bool Block::SubstituteRGB(const SImageRGB &img): ") +
 				_("Wrong image dimensions."));
 	}
+	std::lock_guard<std::recursive_mutex> lock(buffmutex); // not while a buffer is being created
 	FlushRGB();
-	buffRGB = img;
+	std::atomic_store(&buffRGB, img);
 }
 
 /*****************************************************************************/
@@ -1476,8 +1993,9 @@ void Block::SubstituteGray(const SImageGray &img)
 		throw ExceptionDimension(StringUTF8("bool Block::SubstituteGray(const SImageGray &img): ") +
 				_("Wrong image dimensions."));
 	}
+	std::lock_guard<std::recursive_mutex> lock(buffmutex); // not while a buffer is being created
 	FlushGray();
-	buffGray = img;
+	std::atomic_store(&buffGray, img);
 }
 
 /*****************************************************************************/
@@ -1506,8 +2024,9 @@ void Block::SubstituteBW(const SImageBW &img)
 		throw ExceptionDimension(StringUTF8("bool Block::SubstituteBW(const SImageBW &img): ") +
 				_("Wrong image dimensions."));
 	}
+	std::lock_guard<std::recursive_mutex> lock(buffmutex); // not while a buffer is being created
 	FlushBW();
-	buffBW = img;
+	std::atomic_store(&buffBW, img);
 }
 
 /*****************************************************************************/
@@ -1536,99 +2055,16 @@ void Block::SubstituteGradient(const SImageGradient &img)
 		throw ExceptionDimension(StringUTF8("bool Block::SubstituteGradient(const SImageGradient &img): ") +
 				_("Wrong image dimensions."));
 	}
+	std::lock_guard<std::recursive_mutex> lock(buffmutex); // not while a buffer is being created
 	FlushGradient();
-	buffGradient = img;
+	std::atomic_store(&buffGradient, img);
 }
 
-/*! \cond Internal */
-struct interResolv
-{
-	/*! \brief Adds a pair of equivalent labels */
-	void Add(int a, int b)
-	{
-		int found = -1;
-		int foundwhat = 0; // -1 = a, +1 = b
-		for (int tmp = 0; tmp < int(inter.size()); ++tmp)
-		{
-			if (inter[tmp].count(a))
-			{
-				inter[tmp].insert(b);
-				found = tmp;
-				foundwhat = -1;
-				break;
-			}
-			if (inter[tmp].count(b))
-			{
-				inter[tmp].insert(a);
-				found = tmp;
-				foundwhat = +1;
-				break;
-			}
-		}
-		if (found == -1)
-		{
-			inter.push_back(std::set<int>());
-			inter.back().insert(a);
-			inter.back().insert(b);
-		}
-		else
-		{
-			if (foundwhat == -1) // found a
-			{
-				for (int tmp = 0; tmp < int(inter.size()); ++tmp)
-				{
-					if (tmp == found)
-						continue;
-					if (inter[tmp].count(b))
-					{
-						inter[found].insert(inter[tmp].begin(), inter[tmp].end());
-						inter.erase(inter.begin() + tmp);
-						break;
-					}
-				}
-			}
-			else
-			{ // foundwhat == +1, found b
-				for (int tmp = 0; tmp < int(inter.size()); ++tmp)
-				{
-					if (tmp == found)
-						continue;
-					if (inter[tmp].count(a))
-					{
-						inter[found].insert(inter[tmp].begin(), inter[tmp].end());
-						inter.erase(inter.begin() + tmp);
-						break;
-					}
-				}
-			}
-		}
-	}
-	// this ought to be a list since erase() are performed on it, but sweeping a list is slower than sweeping a vector
-	std::vector<std::set<int> > inter; /*!< sets of equivalent labels */
-	/*! \brief computes a map of equivalence */
-	void Compile()
-	{
-		corresp.clear();
-		for (std::set<int> &s : inter)
-		{
-			auto it = s.begin();
-			int rep = *it;
-			++it;
-			for (; it != s.end(); ++it)
-				corresp[*it] = rep;
-		}
-	}
-	std::map<int,int> corresp; /*!< equivalence for each label */
-};
-/*! \endcond */
-
 /*****************************************************************************/
 /*!
  * Creates a child tree with connected components.
  *
- * Each child block's name is the index of the connected component it represents.
- *
- * Inspired from "Fast connected-component labeling" by Lifeng He, Yuyan Chao, Kenji Suzuki and Kesheng Wu.
+ * Each child block's name is the index of the connected component it represents, starting from 1 in raster order.
  *
  * \throws	ExceptionIO	cannot open image
  * \throws	ExceptionRuntime	unsupported image format (not BW, Gray nor RGB)
@@ -1639,193 +2075,10 @@ struct interResolv
  */
 UImageIntGray Block::ExtractCC(const String &tree)
 {
-	SImageBW bwi = GetBW(true);
-
-	int num = 1;
-	size_t w = bwi->GetWidth();
-	size_t h = bwi->GetHeight();
-	UImageIntGray imap = std::make_unique<ImageIntGray>(w, h, 0);
-	interResolv ir;
-	// c2 c3 c4
-	// c1  C  .
-	//  .  .  .
-	// 1st pixel
-	if (bwi->At(0) == pixel::BWBlack)
-	{ // first CC found
-		imap->At(0) = num;
-		num += 1;
-	}
-	// 1st line
-	for (size_t x = 1; x < w; ++x)
-	{
-		if (bwi->At(x) == pixel::BWBlack)
-		{
-			int pv = imap->At(x - 1);
-			if (pv != 0)
-			{ // continue previous CC
-				imap->At(x) = pv;
-			}
-			else
-			{ // new CC
-				imap->At(x) = num;
-				num += 1;
-			}
-		}
-	}
-	// all other lines
-	size_t yoffset = 0;
-	for (size_t y = 1; y < h; ++y)
-	{
-		yoffset += w;
-		// 1st pixel of the line
-		if (bwi->At(yoffset) == pixel::BWBlack)
-		{
-			// c3
-			size_t c3 = yoffset - w;
-			int cval = imap->At(c3);
-			if (cval != 0)
-			{
-				imap->At(yoffset) = cval;
-			}
-			else
-			{
-				// c4
-				cval = imap->At(c3 + 1);
-				if (cval != 0)
-				{
-					imap->At(yoffset) = cval;
-				}
-				else
-				{
-					// new
-					imap->At(yoffset) = num;
-					num += 1;
-				}
-			}
-		}
-		// middle pixels
-		for (size_t x = 1; x < w - 1; ++x)
-		{
-			size_t offset = x + yoffset;
-			if (bwi->At(offset) == pixel::BWBlack)
-			{
-				// c3
-				size_t c3 = offset - w;
-				int cval = imap->At(c3);
-				if (cval != 0)
-				{
-					imap->At(offset) = cval;
-					continue;
-				}
-				// c1
-				size_t c1 = offset - 1;
-				size_t c4 = c3 + 1;
-				cval = imap->At(c1);
-				int cval4 = imap->At(c4);
-				if (cval != 0)
-				{
-					imap->At(offset) = cval;
-					if ((cval4 != 0) && (cval4 != cval))
-						ir.Add(cval, cval4);
-					continue;
-				}
-				// c2
-				size_t c2 = c3 - 1;
-				cval = imap->At(c2);
-				if (cval != 0)
-				{
-					imap->At(offset) = cval;
-					if ((cval4 != 0) && (cval4 != cval))
-						ir.Add(cval, cval4);
-					continue;
-				}
-				// c4
-				if (cval4 != 0)
-				{
-					imap->At(offset) = cval4;
-					continue;
-				}
-				// new
-				imap->At(offset) = num;
-				num += 1;
-			}
-		}
-		// last pixel
-		size_t offset = w - 1 + yoffset;
-		if (bwi->At(offset) == pixel::BWBlack)
-		{
-			// c3
-			size_t c3 = offset - w;
-			int cval = imap->At(c3);
-			if (cval != 0)
-			{
-				imap->At(offset) = cval;
-				continue;
-			}
-			// c1
-			size_t c1 = offset - 1;
-			cval = imap->At(c1);
-			if (cval != 0)
-			{
-				imap->At(offset) = cval;
-				continue;
-			}
-			// c2
-			size_t c2 = c3 - 1;
-			cval = imap->At(c2);
-			if (cval != 0)
-			{
-				imap->At(offset) = cval;
-				continue;
-			}
-			// new
-			imap->At(offset) = num;
-			num += 1;
-		}
-	}
-	// now merge the CCs and create the boxes
-	std::map<int, Rect> bboxes;
-	ir.Compile();
-	FOREACHPIXEL(x, y, *imap)
-	{
-		int v = imap->At(x, y);
-		if (v != 0)
-		{
-			auto it = ir.corresp.find(v);
-			if (it != ir.corresp.end())
-			{ // has to be changed
-				v = it->second;
-				imap->At(x, y) = v;
-			}
-			if (bboxes.find(v) == bboxes.end())
-			{ // create bounding box
-				//bboxes[v] = Rect(x, y, x, y);
-				bboxes.insert(std::make_pair(v, Rect(int(x), int(y), int(x), int(y))));
-			}
-			else
-			{ // grow bounding box
-				Rect &r = bboxes[v];
-				if (r.GetLeft() > int(x))
-					r.SetLeft(int(x));
-				if (r.GetTop() > int(y))
-					r.SetTop(int(y));
-				if (r.GetRight() < int(x))
-					r.SetRight(int(x));
-				if (r.GetBottom() < int(y))
-					r.SetBottom(int(y));
-			}
-		}
-	}
-	// add sub blocks
-	for (const auto &bbox : bboxes)
-	{
-		if (!bbox.second.IsValid())
-		{
-			continue;
-		}
-		AddChildRelative(tree, bbox.second, String(bbox.first));
-	}
-
+	auto ccs = std::vector<ConnectedComponent>{};
+	auto imap = std::make_unique<ImageIntGray>(LabelConnectedComponents(GetBWView(true), ccs));
+	for (auto tmp : Range(ccs))
+		AddChildRelative(tree, ccs[tmp].bbox, String(tmp + 1));
 	return std::forward<UImageIntGray>(imap);
 }
 
@@ -2004,6 +2257,7 @@ void Block::RemoveChild(const String &tree, size_t num)
 	SBlock b(std::static_pointer_cast<Block>((*getChildList(tree))[num]));
 	b->parent = WBlock();
 	getChildList(tree)->Remove(num);
+	SetModified();
 }
 
 /*****************************************************************************/
@@ -2041,6 +2295,7 @@ void Block::RemoveChild(const String &tree, SBlock b)
 	{
 		b->parent = WBlock();
 		getChildList(tree)->Remove(b);
+		SetModified();
 	}
 	else
 		throw ExceptionNotFound(StringUTF8("void Block::RemoveChild(const String &tree, SBlock b): ") +
@@ -2065,6 +2320,7 @@ void Block::RemoveChildren(const String &tree, const std::set<SBlock> &toremove)
 			[&toremove](const SObject &b)
 			{ return toremove.find(std::static_pointer_cast<Block>(b)) != toremove.end(); }
 			);
+	SetModified();
 }
 
 /*****************************************************************************/
@@ -2189,17 +2445,19 @@ void Block::FilterBorders(const String &tree, size_t margin)
 	if (child->Find(tree) == child->end())
 		throw ExceptionNotFound(StringUTF8("void Block::FilterBorders(const String &tree, size_t margin): ") +
 				_("tree not found."));
-	std::set<SBlock> v;
-	for (Vector::iterator it = getChildList(tree)->begin(); it != getChildList(tree)->end(); ++it)
-	{
-		SBlock b(std::static_pointer_cast<Block>(*it));
-		if ((b->GetAbsoluteBBox().GetLeft() < int(GetAbsoluteBBox().GetLeft() + margin)) ||
-				(b->GetAbsoluteBBox().GetTop() < int(GetAbsoluteBBox().GetTop() + margin)) ||
-				(b->GetAbsoluteBBox().GetRight() > int(GetAbsoluteBBox().GetRight() - margin)) ||
-				(b->GetAbsoluteBBox().GetBottom() > int(GetAbsoluteBBox().GetBottom() - margin)))
-			v.insert(b);
-	}
-	RemoveChildren(tree, v);
+	const auto &bb = GetAbsoluteBBox();
+	const auto left = int(bb.GetLeft() + margin);
+	const auto top = int(bb.GetTop() + margin);
+	const auto right = int(bb.GetRight() - margin);
+	const auto bottom = int(bb.GetBottom() - margin);
+	getChildList(tree)->RemoveIf(
+			[left, top, right, bottom](const SObject &b)
+			{
+				const auto &cbb = std::static_pointer_cast<Block>(b)->GetAbsoluteBBox();
+				return (cbb.GetLeft() < left) || (cbb.GetTop() < top) || (cbb.GetRight() > right) || (cbb.GetBottom() > bottom);
+			}
+			);
+	SetModified();
 }
 
 /*****************************************************************************/
@@ -2229,6 +2487,7 @@ void Block::FilterWidthRatio(const String &tree, double ratio)
 				return bbox.GetWidth() > ratio * bbox.GetHeight();
 			}
 			);
+	SetModified();
 }
 
 /*****************************************************************************/
@@ -2258,6 +2517,7 @@ void Block::FilterHeightRatio(const String &tree, double ratio)
 				return bbox.GetHeight() > ratio * bbox.GetWidth();
 			}
 			);
+	SetModified();
 }
 
 /*****************************************************************************/
@@ -2287,15 +2547,21 @@ bool Block::MergeChildren(const String &tree, double overlap, ImageIntGray *imap
 
 	std::map<size_t, std::map<size_t, size_t> > overlaps;
 	SVector vtree(GetTree(tree));
-	for (size_t b1 = 0; b1 < vtree->Size(); ++b1)
-	{
-		SBlock cb1(std::static_pointer_cast<Block>((*vtree)[b1]));
-		Rect bb1(cb1->GetAbsoluteBBox());
+	auto bboxes = std::vector<Rect>{};
+	bboxes.reserve(vtree->Size());
+	for (const auto &b : *vtree)
+		bboxes.push_back(std::static_pointer_cast<Block>(b)->GetAbsoluteBBox());
+	// only the intersecting pairs are examined, in the same order as an all-pairs scan
+	const auto pairs = Rect::FindIntersectingPairs(bboxes);
+	auto pit = pairs.begin();
+	for (size_t b1 = 0; b1 < bboxes.size(); ++b1)
+	{
+		const Rect &bb1(bboxes[b1]);
 		double ov1 = bb1.GetArea() * overlap;
-		for (size_t b2 = b1 + 1; b2 < vtree->Size(); ++b2)
+		for (; (pit != pairs.end()) && (pit->first == b1); ++pit)
 		{
-			SBlock cb2(std::static_pointer_cast<Block>((*vtree)[b2]));
-			Rect bb2(cb2->GetAbsoluteBBox());
+			const auto b2 = pit->second;
+			const Rect &bb2(bboxes[b2]);
 			Rect rov = bb1 & bb2;
 			if (rov.IsValid())
 			{
@@ -2325,6 +2591,8 @@ bool Block::MergeChildren(const String &tree, double overlap, ImageIntGray *imap
 				} // b2 overlaps
 			} // intersection
 		} // for b2
+		while ((pit != pairs.end()) && (pit->first == b1))
+			++pit;
 	} // for b1
 	if (overlaps.empty())
 		return false;
@@ -2417,6 +2685,7 @@ void Block::MergeSiblings(const String &tree, size_t index1, size_t index2, Imag
 	}
 	// update child 1
 	GetChild(tree, index1)->bbox |= GetChild(tree, index2)->GetAbsoluteBBox();
+	GetChild(tree, index1)->SetModified();
 	// copy childrens from child2 into child1
 	const std::vector<String> child2TreeNames = GetChild(tree, index2)->GetTreeNames();
 	for (const auto & child2TreeName : child2TreeNames)
@@ -2609,7 +2878,7 @@ Block::masked_pixel_iterator Block::MaskedPixelBegin(const String &tree, size_t
 	SBlock b(std::static_pointer_cast<Block>(v->At(num)));
 	Rect r = b->GetAbsoluteBBox();
 	r.Translate(-bbox.GetLeft(), -bbox.GetTop());
-	return Block::masked_pixel_iterator(r, b->GetBW(true), r.GetLeft(), r.GetTop(), mask_value);
+	return Block::masked_pixel_iterator(r, b->GetBWView(true), r.GetLeft(), r.GetTop(), mask_value);
 }
 
 /*!
@@ -2631,7 +2900,7 @@ Block::masked_pixel_iterator Block::MaskedPixelBegin(const SBlock &b, pixel::BW
 				_("tree not found."));
 	Rect r = b->GetAbsoluteBBox();
 	r.Translate(-bbox.GetLeft(), -bbox.GetTop());
-	return Block::masked_pixel_iterator(r, b->GetBW(true), r.GetLeft(), r.GetTop(), mask_value);
+	return Block::masked_pixel_iterator(r, b->GetBWView(true), r.GetLeft(), r.GetTop(), mask_value);
 }
 
 /*!
@@ -2736,25 +3005,6 @@ void Block::SortTree(const String &name, Direction direction)
 		throw ExceptionDomain(StringUTF8("void Block::SortTree(const String &name, Direction direction): ")
 				+ _("Wrong direction."));
 	}
-}
-
-/*! Refreshes the source images */
-void Block::refreshSources()
-{
-	if (!parent.expired())
-	{
-		srcRGB = parent.lock()->srcRGB;
-		srcGray = parent.lock()->srcGray;
-		srcBW = parent.lock()->srcBW;
-		srcGradient = parent.lock()->srcGradient;
-	}
-	for (crn::Map::pair p : child)
-	{
-		SVector l(std::static_pointer_cast<Vector>(p.second));
-		for (SObject b : l)
-		{
-			std::static_pointer_cast<Block>(b)->refreshSources();
-		}
-	}
+	SetModified();
 }
 
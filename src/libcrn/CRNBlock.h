@@ -27,8 +27,12 @@
 #include <CRNData/CRNMap.h>
 #include <CRNData/CRNVector.h>
 #include <CRNImage/CRNImage.h>
+#include <CRNImage/CRNImageView.h>
 #include <CRNImage/CRNImageGradient.h>
+#include <CRNImage/CRNImagePyramid.h>
 #include <CRNBlockPtr.h>
+#include <atomic>
+#include <mutex>
 
 namespace crn
 {
@@ -43,6 +47,14 @@ namespace crn
 	 * Each block refers to a source image and has a local copy of a part of it.
 	 * A top block is typically a page or a double page.
 	 *
+	 * The local buffers and the image loaded from a file are registered to the ImageCache, that may free them to respect its memory budget.
+	 * They are recomputed on demand. A buffer is never freed while a pointer to it is held outside the block.
+	 * The buffers returned by GetRGB(), GetGray(), GetBW() and GetGradient() may be modified, so they are withdrawn from the cache and kept until they are flushed, as are substituted buffers.
+	 * The read-only views (e.g.: GetGrayView()) leave the buffers under the control of the cache.
+	 *
+	 * The local buffers can be requested from several threads: each one is computed once and the readers are not blocked once it exists.
+	 * Modifying the block trees or bounding boxes still requires an external synchronization.
+	 *
 	 * \author  Yann Leydier
 	 * \date    16 August 2006
 	 * \version 0.1
@@ -65,7 +77,12 @@ namespace crn
 			Block& operator=(Block&&) = delete;
 
 			/*! \brief Sets the default filename of the block */
-			void SetFilename(const Path &nam) { setFilename(nam); }
+			void SetFilename(const Path &nam) { setFilename(nam); SetModified(); }
+
+			/*! \brief Checks if the block or one of its descendants was modified since it was last loaded from or saved to its default file */
+			bool IsModified() const noexcept { return modified; }
+			/*! \brief Marks the block and its ancestors as modified */
+			void SetModified() noexcept;
 
 			/*! \brief Gets the absolute bounding box of the block */
 			const Rect& GetAbsoluteBBox() const noexcept { return bbox; }
@@ -133,14 +150,12 @@ namespace crn
 			bool Append(const Path &fname);
 			/*! \brief Saves the child trees into a file */
 			void Save(const Path &fname);
-			/*! \brief Saves the child trees into the default file 
-			 *
-			 * Saves the child trees into the default file
-			 *
-			 * \throws	ExceptionInvalidArgument	empty file name
-			 * \throws	ExceptionIO	cannot save XML file
-			 */
-			void Save() { Save(GetFilename()); }
+			/*! \brief Saves the child trees into a file and makes it the default file */
+			void SaveAs(const Path &fname);
+			/*! \brief Checks if a file name designates a binary block file */
+			static bool IsBinaryFilename(const Path &fname);
+			/*! \brief Saves the child trees into the default file if they were modified */
+			void Save();
 
 			/*! \brief Returns a pointer to the local RGB buffer */
 			SImageRGB GetRGB();
@@ -148,8 +163,18 @@ namespace crn
 			SImageGray GetGray(bool create = true);
 			/*! \brief Returns a pointer to the local b&w buffer */
 			SImageBW GetBW(bool create = true);
+			/*! \brief Returns a read-only view on the RGB pixels of the block */
+			ImageViewRGB GetRGBView();
+			/*! \brief Returns a read-only view on the gray pixels of the block */
+			ImageViewGray GetGrayView(bool create = true);
+			/*! \brief Returns a read-only view on the b&w pixels of the block */
+			ImageViewBW GetBWView(bool create = true);
+			/*! \brief Returns the multi-resolution pyramid of the gray pixels of the block */
+			SCImagePyramidGray GetGrayPyramid(bool create = true);
 			/*! \brief Returns a pointer to the local gradient buffer */
 			SImageGradient GetGradient(bool create = true, double sigma = -1, size_t diffusemaxiter = 0, double diffusemaxdiv = std::numeric_limits<double>::max());
+			/*! \brief Loads the image from its file if it was not already loaded */
+			void LoadImage() { openImage(); }
 			/*! \brief Reloads the image */
 			void ReloadImage();
 			/*! \brief Frees the local buffers */
@@ -208,7 +233,7 @@ namespace crn
 			/*! \brief Returns a const iterator after the last block of a tree */
 			const_block_iterator BlockEnd(const String &tree) const;
 
-			/*! \brief Returns a list of children. Can be used with CRN_FOREACH. */
+			/*! \brief Returns a list of children. Can be used with CRN_FOREACH. Call SetModified() after editing the list in place. */
 			SVector GetTree(const String &name)
 			{
 				if (child->Find(name) == child->end()) return nullptr; 
@@ -246,14 +271,18 @@ namespace crn
 						pixel_iterator(it),mask(it.mask),offsetx(it.offsetx),offsety(it.offsety),value(it.value) 
 					{
 						if (mask)
-							if (mask->At(pos.X - offsetx, pos.Y - offsety) != value)
+							if (mask.At(pos.X - offsetx, pos.Y - offsety) != value)
 								operator++();
 					}
 					/*! \brief Constructor */
 					masked_pixel_iterator(const Rect &r, const SImageBW &ibw, int ox, int oy, pixel::BW val = pixel::BWBlack) noexcept:
-						pixel_iterator(r),mask(ibw),offsetx(ox),offsety(oy),value(val) 
+						masked_pixel_iterator(r, ImageViewBW(ibw), ox, oy, val)
+					{ }
+					/*! \brief Constructor */
+					masked_pixel_iterator(const Rect &r, ImageViewBW ibw, int ox, int oy, pixel::BW val = pixel::BWBlack) noexcept:
+						pixel_iterator(r),mask(std::move(ibw)),offsetx(ox),offsety(oy),value(val) 
 					{
-						if (mask->At(pos.X - offsetx, pos.Y - offsety) != value)
+						if (mask.At(pos.X - offsetx, pos.Y - offsety) != value)
 							operator++();
 					}
 					/*! \brief Destructor */
@@ -274,14 +303,14 @@ namespace crn
 						pixel_iterator::operator++(); 
 						while (valid) 
 						{ 
-							if (mask->At(pos.X - offsetx, pos.Y - offsety) == value) 
+							if (mask.At(pos.X - offsetx, pos.Y - offsety) == value) 
 								break; 
 							pixel_iterator::operator++(); 
 						} 
 						return *this;
 					}
 				private:
-					SCImageBW mask; /*!< the binary mask */
+					ImageViewBW mask; /*!< the binary mask */
 					int offsetx, offsety; /*!< current position */
 					pixel::BW value; /*!< mask value */
 			};
@@ -295,6 +324,7 @@ namespace crn
 			masked_pixel_iterator MaskedPixelEnd(const SBlock &b, pixel::BW mask_value = pixel::BWBlack);
 
 		private:
+			friend class FlatBlockTree;
 			/*! \brief Top block creator */
 			Block(const SImage &src, const String &nam = U"");
 			/*! \brief Constructor from filenames */
@@ -310,10 +340,25 @@ namespace crn
 			void addToXml(xml::Element &parent); 
 			/*! \brief Internal. */
 			void addTreeFromXml(xml::Element &bnode); 
+			/*! \brief Internal. */
+			void addToBinary(binary::Writer &w, bool cachechildren); 
+			/*! \brief Internal. */
+			void addTreeFromBinary(binary::Reader &r, bool cachechildren); 
+			/*! \brief Tracks the modifications of the name and user data */
+			virtual void internalDataChanged() noexcept override;
+			/*! \brief Marks the block and its descendants as saved */
+			void clearModified();
 			/*! \brief Loads the image corresponding to the block. */
 			void openImage(void); 
-			/*! \brief Refreshes the source images */
-			void refreshSources();
+			/*! \brief Publishes a newly created buffer and registers it to the image cache */
+			template<typename T> std::shared_ptr<T> cacheBuffer(std::shared_ptr<T> &slot, std::shared_ptr<T> buff, int priority);
+			/*! \brief Returns a local buffer, created once under the buffer lock if needed */
+			template<typename T, typename F> std::shared_ptr<T> getBuffer(std::shared_ptr<T> &slot, F &&create);
+			/*! \brief Returns a local buffer that may be modified and withdraws it from the image cache */
+			template<typename T, typename F> std::shared_ptr<T> editBuffer(std::shared_ptr<T> &slot, F &&get);
+			/*! \brief Returns a source image of the topmost block, reloaded if it was freed by the image cache */
+			template<typename T> std::shared_ptr<T> loadSource(std::shared_ptr<T> &slot);
+			std::recursive_mutex buffmutex; /*!< Serializes the creation of the local buffers and the loading of the image */
 
 			SMap child; /*!< The list of subblock trees */
 			/*! \brief Returns a subblock tree */
@@ -323,27 +368,38 @@ namespace crn
 			String parenttree; /*!< The name of the parent tree */
 
 			Path imagefilename; /*!< File name of the image */
-			bool image_is_open; /*!< Was the image already loaded? */
-			SImageRGB srcRGB; /*!< Source RGB image */
+			std::atomic<bool> image_is_open; /*!< Was the image already loaded? (topmost block only) */
+			SImageRGB srcRGB; /*!< Source RGB image (topmost block only) */
 			/*! \brief Returns the source RGB image */
 			SImageRGB get_srcRGB(void); 
-			SImageGray srcGray; /*!< Source gray image */
+			SImageGray srcGray; /*!< Source gray image (topmost block only) */
 			/*! \brief Returns the source gray image */
 			SImageGray get_srcGray(void); 
-			SImageBW srcBW; /*!< Source black&white image */
+			SImageBW srcBW; /*!< Source black&white image (topmost block only) */
 			/*! \brief Returns the source BW image */
 			SImageBW get_srcBW(void); 
-			SImageGradient srcGradient; /*!< Source gradient image */
+			SImageGradient srcGradient; /*!< Source gradient image (topmost block only) */
 			/*! \brief Returns the source gradient image */
 			SImageGradient get_srcGradient(void); 
+			/*! \brief Returns the local RGB buffer without withdrawing it from the image cache */
+			SImageRGB getRGB();
+			/*! \brief Returns the local gray buffer without withdrawing it from the image cache */
+			SImageGray getGray(bool create);
+			/*! \brief Returns the local b&w buffer without withdrawing it from the image cache */
+			SImageBW getBW(bool create);
+			/*! \brief Returns the local gradient buffer without withdrawing it from the image cache */
+			SImageGradient getGradient(bool create, double sigma, size_t diffusemaxiter, double diffusemaxdiv);
 			Rect bbox; /*!< Bounding box of the block */
 			SImageRGB buffRGB; /*!< Local RGB buffer */
 			SImageGray buffGray; /*!< Local gray buffer */
+			SCImagePyramidGray buffGrayPyramid; /*!< Pyramid of the local gray buffer */
 			SImageBW buffBW; /*!< Local black&white buffer */
 			SImageGradient buffGradient; /*!< Local gradient buffer */
 			double grad_sigma; /*!< Gradient property */
 			size_t grad_diffusemaxiter; /*!< Gradient property */
 			double grad_diffusemaxdiv; /*!< Gradient property */
+			bool modified; /*!< Was the block or one of its descendants modified since last load or save? */
+			std::vector<uint8_t> binarycache; /*!< Binary record of an unmodified block, reused when saving */
 	};
 }
 #endif
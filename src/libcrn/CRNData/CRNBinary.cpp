@@ -0,0 +1,330 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNBinary.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include <CRNData/CRNBinary.h>
+#include <CRNData/CRNInt.h>
+#include <CRNData/CRNReal.h>
+#include <CRNData/CRNMap.h>
+#include <CRNData/CRNVector.h>
+#include <CRNData/CRNDataFactory.h>
+#include <CRNGeometry/CRNRect.h>
+#include <CRNString.h>
+#include <CRNException.h>
+#include <CRNXml/CRNXml.h>
+#include <CRNi18n.h>
+#include <fstream>
+#include <cstring>
+#include <typeinfo>
+
+using namespace crn;
+using namespace crn::binary;
+
+/*! Type tags of the serialized objects */
+enum class Tag: uint8_t { Null = 0, Int = 1, Real = 2, String = 3, StringUTF8 = 4, Rect = 5, Map = 6, Vector = 7, Xml = 255 };
+
+/*! Appends an unsigned 32 bits integer
+ * \param[in]	v	the value
+ */
+void Writer::WriteU32(uint32_t v)
+{
+	for (auto tmp = 0; tmp < 4; ++tmp)
+		buffer.push_back(uint8_t(v >> (8 * tmp)));
+}
+
+/*! Appends a double precision real
+ * \param[in]	v	the value
+ */
+void Writer::WriteReal(double v)
+{
+	auto bits = uint64_t(0);
+	std::memcpy(&bits, &v, sizeof(double));
+	WriteU32(uint32_t(bits));
+	WriteU32(uint32_t(bits >> 32));
+}
+
+/*! Appends a string
+ * \param[in]	s	the string
+ */
+void Writer::WriteString(const StringUTF8 &s)
+{
+	WriteU32(uint32_t(s.Size()));
+	WriteBytes(s.CStr(), s.Size());
+}
+
+/*! Appends raw bytes
+ * \param[in]	data	the bytes
+ * \param[in]	size	the number of bytes
+ */
+void Writer::WriteBytes(const void *data, size_t size)
+{
+	const auto p = reinterpret_cast<const uint8_t*>(data);
+	buffer.insert(buffer.end(), p, p + size);
+}
+
+/*! Appends a rectangle
+ * \param[in]	r	the rectangle
+ */
+void Writer::WriteRect(const Rect &r)
+{
+	WriteU8(r.IsValid() ? 1 : 0);
+	if (r.IsValid())
+	{
+		WriteI32(r.GetLeft());
+		WriteI32(r.GetTop());
+		WriteI32(r.GetRight());
+		WriteI32(r.GetBottom());
+	}
+}
+
+/*! Appends an object that can be null
+ * \throws	ExceptionProtocol	the object is not serializable
+ * \param[in]	obj	the object
+ */
+void Writer::WriteObject(const SCObject &obj)
+{
+	if (obj)
+		WriteObject(*obj);
+	else
+		WriteU8(uint8_t(Tag::Null));
+}
+
+/*! Appends an object. Int, Real, String, StringUTF8, Rect, Map and Vector are stored in binary form, other serializable objects are stored as XML.
+ * \throws	ExceptionProtocol	the object is not serializable
+ * \param[in]	obj	the object
+ */
+void Writer::WriteObject(const Object &obj)
+{
+	const auto &type = typeid(obj);
+	if (type == typeid(Int))
+	{
+		WriteU8(uint8_t(Tag::Int));
+		WriteI32(int(static_cast<const Int&>(obj)));
+	}
+	else if (type == typeid(Real))
+	{
+		WriteU8(uint8_t(Tag::Real));
+		WriteReal(double(static_cast<const Real&>(obj)));
+	}
+	else if (type == typeid(String))
+	{
+		WriteU8(uint8_t(Tag::String));
+		WriteString(static_cast<const String&>(obj).CStr());
+	}
+	else if (type == typeid(StringUTF8))
+	{
+		WriteU8(uint8_t(Tag::StringUTF8));
+		WriteString(static_cast<const StringUTF8&>(obj));
+	}
+	else if (type == typeid(Rect))
+	{
+		WriteU8(uint8_t(Tag::Rect));
+		WriteRect(static_cast<const Rect&>(obj));
+	}
+	else if (type == typeid(Map))
+	{
+		const auto &m = static_cast<const Map&>(obj);
+		WriteU8(uint8_t(Tag::Map));
+		WriteU32(uint32_t(m.Size()));
+		for (const auto &p : m)
+		{
+			WriteString(p.first.CStr());
+			WriteObject(p.second);
+		}
+	}
+	else if (type == typeid(Vector))
+	{
+		const auto &v = static_cast<const Vector&>(obj);
+		WriteU8(uint8_t(Tag::Vector));
+		WriteU32(uint32_t(v.Size()));
+		for (const auto &o : v)
+			WriteObject(o);
+	}
+	else
+	{
+		xml::Document doc;
+		auto root = doc.PushBackElement("Data");
+		crn::Serialize(obj, root); // may throw
+		WriteU8(uint8_t(Tag::Xml));
+		WriteString(doc.AsString());
+	}
+}
+
+/*! Writes the encoded data to a file
+ * \throws	ExceptionIO	cannot write the file
+ * \param[in]	fname	the file name
+ */
+void Writer::Save(const Path &fname) const
+{
+	auto fn = Path(fname);
+	fn.ToLocal();
+	std::ofstream out(fn.CStr(), std::ios::binary | std::ios::trunc);
+	if (out)
+		out.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(buffer.size()));
+	if (!out)
+		throw ExceptionIO(StringUTF8("void binary::Writer::Save(const Path &fname): ") + _("Cannot write file: ") + StringUTF8(fname));
+}
+
+/*! Reads raw bytes
+ * \throws	ExceptionIO	truncated data
+ * \param[in]	size	the number of bytes
+ * \return	a pointer to the bytes, valid as long as the data
+ */
+const uint8_t* Reader::ReadBytes(size_t size)
+{
+	if (GetRemaining() < size)
+		throw ExceptionIO(StringUTF8("const uint8_t* binary::Reader::ReadBytes(size_t size): ") + _("Truncated binary data."));
+	const auto p = cur;
+	cur += size;
+	return p;
+}
+
+/*! Reads an unsigned byte
+ * \throws	ExceptionIO	truncated data
+ * \return	the value
+ */
+uint8_t Reader::ReadU8()
+{
+	return *ReadBytes(1);
+}
+
+/*! Reads an unsigned 32 bits integer
+ * \throws	ExceptionIO	truncated data
+ * \return	the value
+ */
+uint32_t Reader::ReadU32()
+{
+	const auto p = ReadBytes(4);
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/*! Reads a double precision real
+ * \throws	ExceptionIO	truncated data
+ * \return	the value
+ */
+double Reader::ReadReal()
+{
+	auto bits = uint64_t(ReadU32());
+	bits |= uint64_t(ReadU32()) << 32;
+	auto v = 0.0;
+	std::memcpy(&v, &bits, sizeof(double));
+	return v;
+}
+
+/*! Reads a string
+ * \throws	ExceptionIO	truncated data
+ * \return	the string
+ */
+StringUTF8 Reader::ReadString()
+{
+	const auto size = size_t(ReadU32());
+	const auto p = reinterpret_cast<const char*>(ReadBytes(size));
+	return StringUTF8(std::string(p, size));
+}
+
+/*! Reads a rectangle
+ * \throws	ExceptionIO	truncated data
+ * \return	the rectangle
+ */
+Rect Reader::ReadRect()
+{
+	if (!ReadU8())
+		return Rect{};
+	const auto l = ReadI32();
+	const auto t = ReadI32();
+	const auto r = ReadI32();
+	const auto b = ReadI32();
+	return Rect(l, t, r, b);
+}
+
+/*! Reads an object
+ * \throws	ExceptionIO	truncated data or unknown type
+ * \return	the object (can be null)
+ */
+SObject Reader::ReadObject()
+{
+	switch (Tag(ReadU8()))
+	{
+		case Tag::Null:
+			return nullptr;
+		case Tag::Int:
+			return std::make_shared<Int>(ReadI32());
+		case Tag::Real:
+			return std::make_shared<Real>(ReadReal());
+		case Tag::String:
+			return std::make_shared<String>(ReadString());
+		case Tag::StringUTF8:
+			return std::make_shared<StringUTF8>(ReadString());
+		case Tag::Rect:
+			return std::make_shared<Rect>(ReadRect());
+		case Tag::Map:
+			{
+				auto m = std::make_shared<Map>();
+				const auto n = ReadU32();
+				for (auto tmp = uint32_t(0); tmp < n; ++tmp)
+				{
+					const auto key = String(ReadString());
+					m->Set(key, ReadObject());
+				}
+				return m;
+			}
+		case Tag::Vector:
+			{
+				auto v = std::make_shared<Vector>();
+				const auto n = ReadU32();
+				for (auto tmp = uint32_t(0); tmp < n; ++tmp)
+					v->PushBack(ReadObject());
+				return v;
+			}
+		case Tag::Xml:
+			{
+				const auto s = ReadString();
+				xml::Document doc(s.CStr()); // may throw
+				auto root = doc.GetRoot();
+				auto el = root.BeginElement();
+				if (el == root.EndElement())
+					return nullptr;
+				return SObject(DataFactory::CreateData(el)); // may throw
+			}
+	}
+	throw ExceptionIO(StringUTF8("SObject binary::Reader::ReadObject(): ") + _("Unknown binary object type."));
+}
+
+/*! Loads a whole file in memory
+ * \throws	ExceptionIO	cannot read the file
+ * \param[in]	fname	the file name
+ * \return	the content of the file
+ */
+std::vector<uint8_t> crn::binary::LoadFile(const Path &fname)
+{
+	auto fn = Path(fname);
+	fn.ToLocal();
+	std::ifstream in(fn.CStr(), std::ios::binary | std::ios::ate);
+	if (!in)
+		throw ExceptionIO(StringUTF8("std::vector<uint8_t> binary::LoadFile(const Path &fname): ") + _("Cannot read file: ") + StringUTF8(fname));
+	const auto size = size_t(in.tellg());
+	auto data = std::vector<uint8_t>(size);
+	in.seekg(0);
+	in.read(reinterpret_cast<char*>(data.data()), std::streamsize(size));
+	if (!in)
+		throw ExceptionIO(StringUTF8("std::vector<uint8_t> binary::LoadFile(const Path &fname): ") + _("Cannot read file: ") + StringUTF8(fname));
+	return data;
+}
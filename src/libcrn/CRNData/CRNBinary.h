@@ -0,0 +1,133 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNBinary.h
+ * \author Yann LEYDIER
+ */
+
+
+#ifndef CRNBINARY_HEADER
+#define CRNBINARY_HEADER
+
+#include <CRNObject.h>
+#include <CRNStringUTF8.h>
+#include <CRNIO/CRNPath.h>
+#include <vector>
+
+namespace crn
+{
+	class Rect;
+
+	/*! \brief Compact binary serialization
+	 *
+	 * Numbers are stored in little endian order, strings as UTF-8 preceded by their size in bytes.
+	 * The readers work on a contiguous memory area, so a whole file can be loaded (or mapped) at once and parsed without copies.
+	 *
+	 * \ingroup data
+	 */
+	namespace binary
+	{
+		/****************************************************************************/
+		/*! \brief Binary encoder
+		 *
+		 * Appends values to a memory buffer.
+		 *
+		 * \author 	Yann LEYDIER
+		 * \date		Oct 2016
+		 * \version 0.1
+		 * \ingroup data
+		 */
+		class Writer
+		{
+			public:
+				/*! \brief Appends an unsigned byte */
+				void WriteU8(uint8_t v) { buffer.push_back(v); }
+				/*! \brief Appends an unsigned 32 bits integer */
+				void WriteU32(uint32_t v);
+				/*! \brief Appends a signed 32 bits integer */
+				void WriteI32(int32_t v) { WriteU32(uint32_t(v)); }
+				/*! \brief Appends a double precision real */
+				void WriteReal(double v);
+				/*! \brief Appends a string */
+				void WriteString(const StringUTF8 &s);
+				/*! \brief Appends raw bytes */
+				void WriteBytes(const void *data, size_t size);
+				/*! \brief Appends a rectangle */
+				void WriteRect(const Rect &r);
+				/*! \brief Appends an object */
+				void WriteObject(const Object &obj);
+				/*! \brief Appends an object that can be null */
+				void WriteObject(const SCObject &obj);
+
+				/*! \brief Returns the encoded data */
+				const std::vector<uint8_t>& GetBuffer() const noexcept { return buffer; }
+				/*! \brief Writes the encoded data to a file */
+				void Save(const Path &fname) const;
+
+			private:
+				std::vector<uint8_t> buffer; /*!< encoded data */
+		};
+
+		/****************************************************************************/
+		/*! \brief Binary decoder
+		 *
+		 * Reads values from a memory area that it does not own.
+		 *
+		 * \author 	Yann LEYDIER
+		 * \date		Oct 2016
+		 * \version 0.1
+		 * \ingroup data
+		 */
+		class Reader
+		{
+			public:
+				/*! \brief Constructor */
+				Reader(const uint8_t *data, size_t size) noexcept:cur(data),end(data + size) {}
+
+				/*! \brief Reads an unsigned byte */
+				uint8_t ReadU8();
+				/*! \brief Reads an unsigned 32 bits integer */
+				uint32_t ReadU32();
+				/*! \brief Reads a signed 32 bits integer */
+				int32_t ReadI32() { return int32_t(ReadU32()); }
+				/*! \brief Reads a double precision real */
+				double ReadReal();
+				/*! \brief Reads a string */
+				StringUTF8 ReadString();
+				/*! \brief Reads raw bytes */
+				const uint8_t* ReadBytes(size_t size);
+				/*! \brief Reads a rectangle */
+				Rect ReadRect();
+				/*! \brief Reads an object */
+				SObject ReadObject();
+
+				/*! \brief Returns the current position in the memory area */
+				const uint8_t* GetPosition() const noexcept { return cur; }
+				/*! \brief Returns the number of bytes left */
+				size_t GetRemaining() const noexcept { return size_t(end - cur); }
+
+			private:
+				const uint8_t *cur; /*!< current position */
+				const uint8_t *end; /*!< end of the data */
+		};
+
+		/*! \brief Loads a whole file in memory */
+		std::vector<uint8_t> LoadFile(const Path &fname);
+	}
+}
+
+#endif
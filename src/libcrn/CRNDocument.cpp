@@ -21,12 +21,17 @@
 
 #include <CRNi18n.h>
 #include <CRNDocument.h>
+#include <CRNImage/CRNImageCache.h>
 #include <CRNException.h>
 #include <CRNConfig.h>
 #include <CRNUtils/CRNAtScopeExit.h>
 #include <CRNUtils/CRNProgress.h>
+#include <CRNUtils/CRNThreadPool.h>
 #include <CRNXml/CRNXml.h>
 #include <CRNIO/CRNIO.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #ifdef CRN_USING_HARU
 #	include <CRNUtils/CRNPDF.h>
 #endif
@@ -46,7 +51,8 @@ size_t Document::thumbHeight = 100;
 Document::Document():Savable(U""),
 	basename(""),
 	author(U""),
-	date(U"")
+	date(U""),
+	binaryviews(false)
 {
 }
 
@@ -154,12 +160,15 @@ void Document::RemoveView(size_t num)
 	{
 		IO::Rm(thumbname);
 	} catch (...) { }
-	// remove xml
-	Path xmlname(basename + "/" + views[num].id + ".xml");
-	try
+	// remove xml or binary file
+	for (const auto ext : {".xml", ".crnb"})
 	{
-		IO::Rm(xmlname);
-	} catch (...) { }
+		Path xmlname(basename + "/" + views[num].id + ext);
+		try
+		{
+			IO::Rm(xmlname);
+		} catch (...) { }
+	}
 	// remove block
 	views.erase(views.begin() + num);
 }
@@ -182,6 +191,7 @@ void Document::RemoveView(const String &id)
  * Returns a pointer to a view.
  *
  * Its counter is incremented.
+ * If the view was only saved in the other format than the one selected with SetBinaryViews(), it is loaded from this file and will be saved to it. Use ConvertViews() to change the format.
  *
  * \throws	ExceptionDomain	index out of bounds
  * \throws	ExceptionIO	XML file exists but cannot be accessed or has invalid structure
@@ -198,19 +208,56 @@ SBlock Document::GetView(size_t num) const
 	{
 		throw ExceptionDomain(StringUTF8("SBlock Document::GetView(size_t num) const: ") + _("Index out of bounds."));
 	}
-	if (views[num].ptr.expired())
+	auto view = views[num].ptr.lock();
+	if (!view)
 	{
-		Path s;
-		if (basename.IsNotEmpty())
-		{
-			s += basename + Path::Separator();
-			s += Path(views[num].id) + ".xml";
-		}
+		auto s = viewBlockFilename(num, binaryviews);
+		const auto other = viewBlockFilename(num, !binaryviews);
+		if (other.IsNotEmpty() && !IO::Access(s, IO::EXISTS) && IO::Access(other, IO::EXISTS))
+			s = other; // the view was saved in the other format
 		SBlock b(Block::New(views[num].filename, s, views[num].filename));
 		views[num].ptr = b;
 		return b;
 	}
-	return views[num].ptr.lock();
+	ImageCache::Touch(view.get()); // the image of the view was recently used
+	return view;
+}
+
+/*****************************************************************************/
+/*!
+ * Rewrites the views that are stored in the other format than the one selected with SetBinaryViews().
+ *
+ * Each view is saved in the selected format before its former file is removed, and the loaded views are saved to the new file from now on.
+ *
+ * \throws	ExceptionIO	cannot open or save a file
+ * \throws	ExceptionRuntime	an XML file does not fit its image
+ */
+void Document::ConvertViews()
+{
+	for (auto num : Range(views))
+	{
+		const auto s = viewBlockFilename(num, binaryviews);
+		const auto other = viewBlockFilename(num, !binaryviews);
+		if (other.IsEmpty() || IO::Access(s, IO::EXISTS) || !IO::Access(other, IO::EXISTS))
+			continue;
+		auto b = GetView(num);
+		b->SaveAs(s); // may throw
+		IO::Rm(other);
+	}
+}
+
+/*!
+ * Returns the file where the subblocks of a view are stored in a given format
+ *
+ * \param[in]	num	the index of the view
+ * \param[in]	binary	binary or XML format
+ * \return	the file name, empty if the document has no base name
+ */
+Path Document::viewBlockFilename(size_t num, bool binary) const
+{
+	if (basename.IsEmpty())
+		return Path{};
+	return basename + Path::Separator() + Path(views[num].id) + (binary ? ".crnb" : ".xml");
 }
 
 /*! 
@@ -247,6 +294,115 @@ SBlock Document::GetView(const Path &fname) const
 	return GetView(GetViewIndex(fname));
 }
 
+/*! 
+ * Calls a function on each view, in parallel
+ *
+ * The views are loaded (XML and image) and processed by a pool of worker threads. The workers load the next views in advance, while other views are processed, but there are never more than maxinflight views loaded at the same time.
+ * Each view is saved after it was processed. The function is called on the views in no particular order.
+ *
+ * The library's parallel algorithms called from the function run in the worker's thread only.
+ *
+ * \throws	ExceptionIO	cannot open an image or an XML file
+ * \throws	ExceptionRuntime	an XML file does not fit its image
+ * \throws	...	the first exception thrown by the function (no view is processed after it)
+ *
+ * \param[in]  fun  the function to call, with the view's block and the index of the view
+ * \param[in]  prog  a progress bar or nullptr
+ * \param[in]  nthreads  the number of worker threads, 0 to use GetConcurrency()
+ * \param[in]  maxinflight  the maximal number of views loaded at the same time, 0 for twice the number of threads
+ */
+void Document::ForEachView(const std::function<void(const SBlock &view, size_t index)> &fun, Progress *prog, size_t nthreads, size_t maxinflight) const
+{
+	const auto nviews = views.size();
+	if (!nthreads)
+		nthreads = GetConcurrency();
+	if (!maxinflight)
+		maxinflight = 2 * nthreads;
+	nthreads = Min(nthreads, maxinflight, nviews);
+	if (prog)
+		prog->SetMaxCount(nviews);
+	if (!nthreads)
+		return;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	auto next = size_t(0); // next view to load
+	auto inflight = size_t(0); // loaded and not finished
+	auto ready = std::deque<std::pair<size_t, SBlock>>{}; // loaded and not processed
+	auto error = std::exception_ptr{};
+	auto work = [&]()
+		{
+			auto lock = std::unique_lock<std::mutex>(mutex);
+			auto fail = [&](std::exception_ptr ex)
+				{
+					if (!error)
+						error = ex;
+					cond.notify_all();
+				};
+			while (!error)
+			{
+				if ((next < nviews) && (inflight < maxinflight))
+				{ // load the next view
+					const auto num = next++;
+					inflight += 1;
+					lock.unlock();
+					auto b = SBlock{};
+					try
+					{
+						b = GetView(num);
+						b->LoadImage();
+					}
+					catch (...)
+					{
+						lock.lock();
+						fail(std::current_exception());
+						return;
+					}
+					lock.lock();
+					ready.emplace_back(num, std::move(b));
+					cond.notify_one();
+				}
+				else if (!ready.empty())
+				{ // process a loaded view
+					auto item = std::move(ready.front());
+					ready.pop_front();
+					lock.unlock();
+					try
+					{
+						fun(item.second, item.first);
+						if (item.second->GetFilename().IsNotEmpty())
+							item.second->Save();
+						item.second = nullptr;
+					}
+					catch (...)
+					{
+						lock.lock();
+						fail(std::current_exception());
+						return;
+					}
+					lock.lock();
+					inflight -= 1;
+					if (prog)
+						prog->Advance();
+					cond.notify_all();
+				}
+				else if (next >= nviews)
+					return; // the remaining views are processed by the workers that loaded them
+				else
+					cond.wait(lock);
+			}
+		};
+
+	ThreadPool pool(nthreads);
+	auto tasks = std::vector<std::future<void>>{};
+	for (auto tmp = size_t(0); tmp < nthreads; ++tmp)
+		tasks.push_back(pool.Push(work));
+	for (auto &t : tasks)
+		t.wait();
+	if (error)
+		std::rethrow_exception(error);
+}
+
 /*! 
  * Returns the index of a view
  *
@@ -430,6 +586,7 @@ void Document::Clear()
 	SetName(U"");
 	SetAuthor(U"");
 	SetDate(U"");
+	binaryviews = false;
 	ClearUserData();
 }
 
@@ -484,6 +641,7 @@ void Document::load(const Path &fname)
 	bn = root.GetAttribute<StringUTF8>("date");
 	if (bn.IsNotEmpty())
 		date = bn;
+	binaryviews = root.GetAttribute<int>("binaryviews") != 0;
 
 	views.clear();
 	for (auto & xmlview : xmlviews)
@@ -530,19 +688,24 @@ Path Document::GetThumbnailPath() const
  */
 UImage Document::createThumbnail(const Path &imagename) const
 {
-	UImage img = NewImageFromFile(imagename);
+	const auto size = GetImageFileSize(imagename);
 	// scale the image
 	size_t nw, nh;
-	nh = img->GetHeight() * thumbWidth / img->GetWidth();
+	nh = size.second * thumbWidth / size.first;
 	if (nh <= thumbHeight)
 	{
 		nw = thumbWidth;
 	}
 	else
 	{
-		nw = img->GetWidth() * thumbHeight / img->GetHeight();
+		nw = size.first * thumbHeight / size.second;
 		nh = thumbHeight;
 	}
+	// decode at the lowest resolution that is still larger than the thumbnail
+	auto reduction = size_t(8);
+	while ((reduction > 1) && ((size.first / reduction < nw) || (size.second / reduction < nh)))
+		reduction /= 2;
+	UImage img = NewImageFromFile(imagename, Rect{}, reduction);
 	img->ScaleToSize(nw, nh);
 	return std::forward<UImage>(img);
 }
@@ -658,6 +821,8 @@ void Document::save(const Path &fname)
 	root.SetAttribute("basename", basename.CStr());
 	root.SetAttribute("author", author.CStr());
 	root.SetAttribute("date", date.CStr());
+	if (binaryviews)
+		root.SetAttribute("binaryviews", 1);
 
 	// save views
 	for (size_t tmp = 0; tmp < views.size(); tmp++)
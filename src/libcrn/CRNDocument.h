@@ -23,6 +23,7 @@
 #define CRNDOCUMENT_HEADER
 
 #include <vector>
+#include <functional>
 #include <CRNSavable.h>
 #include <CRNBlock.h>
 #include <CRNDocumentPtr.h>
@@ -69,6 +70,11 @@ namespace crn
 			/*! \brief Sets the date of the document */
 			void SetDate(const String &s) { date = s; }
 
+			/*! \brief Sets whether the new views are saved in binary files (see Block::IsBinaryFilename()) instead of XML files */
+			void SetBinaryViews(bool b) noexcept { binaryviews = b; }
+			/*! \brief Are the views saved in binary files? */
+			bool GetBinaryViews() const noexcept { return binaryviews; }
+
 			/*! \brief Gets the file base name of the document */
 			const Path& GetBasename() const noexcept { return basename; }
 			/*! \brief Gets the author of the document */
@@ -96,6 +102,10 @@ namespace crn
 			SBlock GetView(const String &id) const;
 			/*! \brief Returns a pointer to a view */
 			SBlock GetView(const Path &fname) const;
+			/*! \brief Rewrites the views that are stored in the other format than the one selected with SetBinaryViews() */
+			void ConvertViews();
+			/*! \brief Calls a function on each view, in parallel */
+			void ForEachView(const std::function<void(const SBlock &view, size_t index)> &fun, Progress *prog = nullptr, size_t nthreads = 0, size_t maxinflight = 0) const;
 			/*! \brief Returns the index of a view */
 			size_t GetViewIndex(const String &id) const;
 			/*! \brief Returns the index of a view */
@@ -181,6 +191,8 @@ namespace crn
 			/*! \brief Saves the object to an XML file (Unsafe) */
 			virtual void save(const Path &fname) override;
 
+			/*! \brief Returns the file where the subblocks of a view are stored in a given format */
+			Path viewBlockFilename(size_t num, bool binary) const;
 			/*! \brief Creates a thumbnail image from an image filename */
 			UImage createThumbnail(const Path &imagename) const;
 
@@ -205,6 +217,7 @@ namespace crn
 			Path basename; /*!< The base directory to save the views XML files */
 			String author; /*!< The author of the document */
 			String date; /*!< The date of the document */
+			bool binaryviews; /*!< Are the views saved in binary files? */
 
 			static const Path thumbdir; /*!< Relative to the thumbnails */
 			static size_t thumbWidth; /*!< Global setting for new thumbnails' width */
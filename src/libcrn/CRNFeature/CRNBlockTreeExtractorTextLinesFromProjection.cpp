@@ -78,7 +78,7 @@ void BlockTreeExtractorTextLinesFromProjection::Extract(Block &b)
 	
 	// Step 2 : perform horizontal projection
 	
-	auto hProj = HorizontalProjection(*b.GetBW());
+	auto hProj = HorizontalProjection(b.GetBWView());
 
 	// Step 3 : smoothing histogram until modes get mutually far enough
 	
@@ -182,7 +182,7 @@ void BlockTreeExtractorTextLinesFromProjection::Extract(Block &b)
 	
 	// Retrieve unsmoothed projection histogram
 	
-	hProj = HorizontalProjection(*b.GetBW());
+	hProj = HorizontalProjection(b.GetBWView());
 	
 	std::vector< int > baselines;
 	std::vector< int > x_heights;
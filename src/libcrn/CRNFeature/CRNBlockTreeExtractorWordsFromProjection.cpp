@@ -62,7 +62,7 @@ void BlockTreeExtractorWordsFromProjection::Extract(Block &b)
 	
 	// Step 1 : vertical projection
 	
-	auto vProj = VerticalProjection(*b.GetBW());
+	auto vProj = VerticalProjection(b.GetBWView());
 	
 	// Step 2 : find white streams (start points, end points, lengths) 
 	//          in profile
@@ -64,7 +64,7 @@ SObject FeatureExtractorProfile::Extract(Block &b)
 	if (!!(dirs & Direction::LEFT))
 	{
 		// extract
-		auto hp = LeftProfile(*b.GetBW());
+		auto hp = LeftProfile(b.GetBWView());
 		// scale
 		if (maxval)
 		{
@@ -86,7 +86,7 @@ SObject FeatureExtractorProfile::Extract(Block &b)
 	if (!!(dirs & Direction::RIGHT))
 	{
 		// extract
-		auto hp = RightProfile(*b.GetBW());
+		auto hp = RightProfile(b.GetBWView());
 		// scale
 		if (maxval)
 		{
@@ -108,7 +108,7 @@ SObject FeatureExtractorProfile::Extract(Block &b)
 	if (!!(dirs & Direction::TOP))
 	{
 		// extract
-		auto hp = TopProfile(*b.GetBW());
+		auto hp = TopProfile(b.GetBWView());
 		// scale
 		if (maxval)
 		{
@@ -130,7 +130,7 @@ SObject FeatureExtractorProfile::Extract(Block &b)
 	if (!!(dirs & Direction::BOTTOM))
 	{
 		// extract
-		auto hp = BottomProfile(*b.GetBW());
+		auto hp = BottomProfile(b.GetBWView());
 		// scale
 		if (maxval)
 		{
@@ -63,7 +63,7 @@ SObject FeatureExtractorProjection::Extract(Block &b)
 	if (!!(dirs & Orientation::HORIZONTAL))
 	{
 		// extract
-		auto hp = HorizontalProjection(*b.GetBW());
+		auto hp = HorizontalProjection(b.GetBWView());
 		// scale
 		if (maxval)
 		{
@@ -85,7 +85,7 @@ SObject FeatureExtractorProjection::Extract(Block &b)
 	if (!!(dirs & Orientation::VERTICAL))
 	{
 		// extract
-		auto hp = VerticalProjection(*b.GetBW());
+		auto hp = VerticalProjection(b.GetBWView());
 		// scale
 		if (maxval)
 		{
@@ -0,0 +1,345 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNFlatBlockTree.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include <CRNi18n.h>
+#include <CRNFlatBlockTree.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNData/CRNReal.h>
+#include <CRNException.h>
+#include <CRNStringUTF8.h>
+#include <limits>
+#include <cmath>
+
+using namespace crn;
+
+/*! \internal Value of an attribute that was not set */
+static const double UnsetAttribute = std::numeric_limits<double>::quiet_NaN();
+
+/*!
+ * Creates an empty tree
+ *
+ * \throws	ExceptionInvalidArgument	null parent
+ *
+ * \param[in]	par	the parent block
+ * \param[in]	tname	the name of the tree in the parent block
+ */
+FlatBlockTree::FlatBlockTree(const SBlock &par, const String &tname):
+	parent(par),
+	treename(tname)
+{
+	if (!par)
+		throw ExceptionInvalidArgument(StringUTF8("FlatBlockTree::FlatBlockTree(const SBlock &par, const String &tname): ") +
+				_("No parent."));
+}
+
+/*!
+ * Creates a tree with the connected components of the parent block, as Block::ExtractCC() does.
+ *
+ * The children are labeled from 1 and have three attributes: "area" (number of pixels), "x" and "y" (absolute coordinates of the center of mass).
+ *
+ * \throws	ExceptionInvalidArgument	null parent
+ *
+ * \param[in]	par	the parent block
+ * \param[in]	tname	the name of the tree in the parent block
+ * \param[out]	labels	if not null, receives the map of the connected components, relative to the parent block
+ * \return	the tree of the connected components
+ */
+FlatBlockTree FlatBlockTree::FromConnectedComponents(const SBlock &par, const String &tname, ImageIntGray *labels)
+{
+	auto tree = FlatBlockTree(par, tname);
+	auto ccs = std::vector<ConnectedComponent>{};
+	auto imap = LabelConnectedComponents(par->GetBWView(true), ccs);
+	const auto ox = par->GetAbsoluteBBox().GetLeft();
+	const auto oy = par->GetAbsoluteBBox().GetTop();
+	tree.bboxes.reserve(ccs.size());
+	tree.labels.reserve(ccs.size());
+	auto &area = tree.attributes[U"area"];
+	auto &x = tree.attributes[U"x"];
+	auto &y = tree.attributes[U"y"];
+	area.reserve(ccs.size());
+	x.reserve(ccs.size());
+	y.reserve(ccs.size());
+	for (auto tmp : Range(ccs))
+	{
+		auto r = ccs[tmp].bbox;
+		r.Translate(ox, oy);
+		tree.bboxes.push_back(r);
+		tree.labels.emplace_back(tmp + 1);
+		area.push_back(double(ccs[tmp].area));
+		x.push_back(ccs[tmp].centroid.X + ox);
+		y.push_back(ccs[tmp].centroid.Y + oy);
+	}
+	if (labels)
+		*labels = std::move(imap);
+	return tree;
+}
+
+/*!
+ * Adds a child. The bounding box is clipped to the parent's bounding box.
+ *
+ * \throws	ExceptionUninitialized	the parent block was destroyed
+ * \throws	ExceptionInvalidArgument	uninitialized rectangle
+ * \throws	ExceptionDomain	rectangle is out of bounds
+ *
+ * \param[in]	clip	the absolute bounding box of the child
+ * \param[in]	label	the name of the child
+ * \return	the index of the new child
+ */
+size_t FlatBlockTree::PushBack(const Rect &clip, const String &label)
+{
+	if (parent.expired())
+		throw ExceptionUninitialized(StringUTF8("size_t FlatBlockTree::PushBack(const Rect &clip, const String &label): ") +
+				_("The parent block was destroyed."));
+	if (!clip.IsValid())
+		throw ExceptionInvalidArgument(StringUTF8("size_t FlatBlockTree::PushBack(const Rect &clip, const String &label): ") +
+				_("Uninitialized clipping rectangle."));
+	const auto r = clip & parent.lock()->GetAbsoluteBBox();
+	if (!r.IsValid())
+		throw ExceptionDomain(StringUTF8("size_t FlatBlockTree::PushBack(const Rect &clip, const String &label): ") +
+				_("Clipping rectangle out of bounds."));
+	bboxes.push_back(r);
+	labels.push_back(label);
+	for (auto &attr : attributes)
+		attr.second.push_back(UnsetAttribute);
+	if (!blocks.empty())
+		blocks.emplace_back();
+	return bboxes.size() - 1;
+}
+
+/*!
+ * Removes the children that match a predicate. The order of the remaining children is preserved.
+ *
+ * \param[in]	pred	a function that is given the index of each child and returns true if the child must be removed
+ */
+void FlatBlockTree::RemoveIf(const std::function<bool(size_t index)> &pred)
+{
+	auto dst = size_t(0);
+	for (auto src : Range(bboxes))
+	{
+		if (pred(src))
+			continue;
+		if (dst != src)
+		{ // the children before src were already examined
+			bboxes[dst] = bboxes[src];
+			labels[dst] = std::move(labels[src]);
+			for (auto &attr : attributes)
+				attr.second[dst] = attr.second[src];
+			if (!blocks.empty())
+				blocks[dst] = std::move(blocks[src]);
+		}
+		dst += 1;
+	}
+	bboxes.resize(dst);
+	labels.resize(dst);
+	for (auto &attr : attributes)
+		attr.second.resize(dst);
+	if (!blocks.empty())
+		blocks.resize(dst);
+}
+
+/*!
+ * Sets the absolute bounding box of a child. The bounding box is clipped to the parent's bounding box.
+ *
+ * \throws	ExceptionDomain	index out of bounds or rectangle out of bounds
+ * \throws	ExceptionUninitialized	the parent block was destroyed
+ * \throws	ExceptionInvalidArgument	uninitialized rectangle
+ *
+ * \param[in]	index	the index of the child
+ * \param[in]	clip	the new bounding box
+ */
+void FlatBlockTree::SetBBox(size_t index, const Rect &clip)
+{
+	if (index >= Size())
+		throw ExceptionDomain(StringUTF8("void FlatBlockTree::SetBBox(size_t index, const Rect &clip): ") +
+				_("index out of bounds."));
+	if (parent.expired())
+		throw ExceptionUninitialized(StringUTF8("void FlatBlockTree::SetBBox(size_t index, const Rect &clip): ") +
+				_("The parent block was destroyed."));
+	if (!clip.IsValid())
+		throw ExceptionInvalidArgument(StringUTF8("void FlatBlockTree::SetBBox(size_t index, const Rect &clip): ") +
+				_("Uninitialized clipping rectangle."));
+	const auto r = clip & parent.lock()->GetAbsoluteBBox();
+	if (!r.IsValid())
+		throw ExceptionDomain(StringUTF8("void FlatBlockTree::SetBBox(size_t index, const Rect &clip): ") +
+				_("Clipping rectangle out of bounds."));
+	bboxes[index] = r;
+	if (IsMaterialized(index))
+		blocks[index]->SetAbsoluteBBox(r);
+}
+
+/*!
+ * Sets the label of a child. A materialized child with an empty label is named after the tree, as in GetBlock().
+ *
+ * \throws	ExceptionDomain	index out of bounds
+ *
+ * \param[in]	index	the index of the child
+ * \param[in]	label	the new label
+ */
+void FlatBlockTree::SetLabel(size_t index, const String &label)
+{
+	if (index >= Size())
+		throw ExceptionDomain(StringUTF8("void FlatBlockTree::SetLabel(size_t index, const String &label): ") +
+				_("index out of bounds."));
+	labels[index] = label;
+	if (IsMaterialized(index))
+		blocks[index]->SetName(label.IsNotEmpty() ? label : treename);
+}
+
+/*!
+ * Returns the names of the attributes
+ *
+ * \return	the list of the attributes' names
+ */
+std::vector<String> FlatBlockTree::GetAttributeNames() const
+{
+	auto names = std::vector<String>{};
+	for (const auto &attr : attributes)
+		names.push_back(attr.first);
+	return names;
+}
+
+/*!
+ * Returns the values of an attribute for all children. Children for which the attribute was not set have a NaN value.
+ *
+ * \throws	ExceptionNotFound	attribute not found
+ *
+ * \param[in]	key	the name of the attribute
+ * \return	the values of the attribute, contiguous and in the order of the children
+ */
+const std::vector<double>& FlatBlockTree::GetAttributes(const String &key) const
+{
+	const auto it = attributes.find(key);
+	if (it == attributes.end())
+		throw ExceptionNotFound(StringUTF8("const std::vector<double>& FlatBlockTree::GetAttributes(const String &key) const: ") +
+				_("attribute not found."));
+	return it->second;
+}
+
+/*!
+ * Returns the value of an attribute for a child (unchecked index)
+ *
+ * \throws	ExceptionNotFound	attribute not found
+ *
+ * \param[in]	key	the name of the attribute
+ * \param[in]	index	the index of the child
+ * \return	the value of the attribute or NaN if it was not set for this child
+ */
+double FlatBlockTree::GetAttribute(const String &key, size_t index) const
+{
+	return GetAttributes(key)[index];
+}
+
+/*!
+ * Sets the value of an attribute for a child
+ *
+ * \throws	ExceptionDomain	index out of bounds
+ *
+ * \param[in]	key	the name of the attribute
+ * \param[in]	index	the index of the child
+ * \param[in]	value	the new value
+ */
+void FlatBlockTree::SetAttribute(const String &key, size_t index, double value)
+{
+	if (index >= Size())
+		throw ExceptionDomain(StringUTF8("void FlatBlockTree::SetAttribute(const String &key, size_t index, double value): ") +
+				_("index out of bounds."));
+	auto &attr = attributes[key];
+	if (attr.empty())
+		attr.resize(Size(), UnsetAttribute);
+	attr[index] = value;
+}
+
+/*!
+ * Returns a child as a block. The block is created on the first call and it is not added to the parent block.
+ *
+ * The block is named after the label of the child (or after the tree if the label is empty, as in Block::AddChildAbsolute()). The attributes are not copied to the block.
+ *
+ * \throws	ExceptionDomain	index out of bounds
+ * \throws	ExceptionUninitialized	the parent block was destroyed
+ *
+ * \param[in]	index	the index of the child
+ * \return	the block
+ */
+SBlock FlatBlockTree::GetBlock(size_t index)
+{
+	if (index >= Size())
+		throw ExceptionDomain(StringUTF8("SBlock FlatBlockTree::GetBlock(size_t index): ") +
+				_("index out of bounds."));
+	if (parent.expired())
+		throw ExceptionUninitialized(StringUTF8("SBlock FlatBlockTree::GetBlock(size_t index): ") +
+				_("The parent block was destroyed."));
+	if (blocks.empty())
+		blocks.resize(Size());
+	if (!blocks[index])
+		blocks[index] = Block::create(parent, treename, bboxes[index], labels[index].IsNotEmpty() ? labels[index] : treename);
+	return blocks[index];
+}
+
+/*!
+ * Stores all children in the parent block's tree, replacing its previous content. The attributes that were set are stored as Real user data.
+ *
+ * All children are materialized and the blocks returned by GetBlock() are the ones stored in the parent block.
+ * The method can be called again after the tree was modified to update the parent block.
+ *
+ * \throws	ExceptionUninitialized	the parent block was destroyed
+ */
+void FlatBlockTree::AddToParent()
+{
+	if (parent.expired())
+		throw ExceptionUninitialized(StringUTF8("void FlatBlockTree::AddToParent(): ") +
+				_("The parent block was destroyed."));
+	auto par = parent.lock();
+	auto list = par->getChildList(treename);
+	for (const auto &o : *list) // the children removed since the last call are detached as in Block::RemoveChild()
+		std::static_pointer_cast<Block>(o)->parent = WBlock();
+	list->Clear();
+	for (auto tmp : Range(bboxes))
+	{
+		auto b = GetBlock(tmp);
+		b->parent = par;
+		for (const auto &attr : attributes)
+		{
+			if (!std::isnan(attr.second[tmp]))
+				b->SetUserData(attr.first, std::make_shared<Real>(attr.second[tmp]));
+			else if (b->IsUserData(attr.first))
+				b->DeleteUserData(attr.first);
+		}
+		list->PushBack(b);
+	}
+	par->SetModified();
+}
+
+/*!
+ * Returns the approximate memory used by the tree, including the labels but not the materialized blocks.
+ *
+ * \return	a number of bytes
+ */
+size_t FlatBlockTree::GetMemoryUsage() const
+{
+	auto mem = sizeof(FlatBlockTree) + bboxes.capacity() * sizeof(Rect) + labels.capacity() * sizeof(String) + blocks.capacity() * sizeof(SBlock);
+	for (const auto &l : labels)
+		mem += l.Size() * sizeof(char32_t);
+	for (const auto &attr : attributes)
+		mem += attr.first.Size() * sizeof(char32_t) + attr.second.capacity() * sizeof(double);
+	return mem;
+}
+
@@ -0,0 +1,169 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNFlatBlockTree.h
+ * \author Yann LEYDIER
+ */
+
+
+#ifndef CRNFLATBLOCKTREE_HEADER
+#define CRNFLATBLOCKTREE_HEADER
+
+#include <CRNBlock.h>
+#include <CRNImage/CRNImageFormats.h>
+#include <functional>
+#include <map>
+
+namespace crn
+{
+	/****************************************************************************/
+	/*! \brief A compact child tree of a block
+	 *
+	 * Stores the bounding boxes, labels and numeric attributes of a large set of children in contiguous arrays instead of one Block per child.
+	 * A Block is materialized only when it is accessed through GetBlock() or an iterator, and it is kept until the tree is destroyed.
+	 * Materialized blocks are not added to the parent block: call AddToParent() to store the tree in the parent block, and call it again to replace the stored tree after a modification.
+	 * The arrays are the reference: the bounding boxes and names of the materialized blocks must only be modified through SetBBox() and SetLabel(), since changes made directly to the blocks are not written back to the tree.
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date		Oct 2016
+	 * \version 0.1
+	 * \ingroup document
+	 */
+	class FlatBlockTree
+	{
+		public:
+			/*! \brief Creates an empty tree */
+			FlatBlockTree(const SBlock &par, const String &tname);
+			FlatBlockTree(const FlatBlockTree&) = delete;
+			FlatBlockTree(FlatBlockTree&&) = default;
+			FlatBlockTree& operator=(const FlatBlockTree&) = delete;
+			FlatBlockTree& operator=(FlatBlockTree&&) = default;
+
+			/*! \brief Creates a tree with the connected components of the parent block */
+			static FlatBlockTree FromConnectedComponents(const SBlock &par, const String &tname, ImageIntGray *labels = nullptr);
+
+			/*! \brief Returns the parent block */
+			WBlock GetParent() const { return parent; }
+			/*! \brief Returns the name of the tree in the parent block */
+			const String& GetTreeName() const noexcept { return treename; }
+
+			/*! \brief Returns the number of children */
+			size_t Size() const noexcept { return bboxes.size(); }
+			/*! \brief Checks if the tree is empty */
+			bool IsEmpty() const noexcept { return bboxes.empty(); }
+			/*! \brief Adds a child */
+			size_t PushBack(const Rect &clip, const String &label = U"");
+			/*! \brief Removes the children that match a predicate */
+			void RemoveIf(const std::function<bool(size_t index)> &pred);
+
+			/*! \brief Returns the absolute bounding box of a child (unchecked) */
+			const Rect& GetBBox(size_t index) const { return bboxes[index]; }
+			/*! \brief Returns the absolute bounding boxes of all children */
+			const std::vector<Rect>& GetBBoxes() const noexcept { return bboxes; }
+			/*! \brief Sets the absolute bounding box of a child */
+			void SetBBox(size_t index, const Rect &clip);
+			/*! \brief Returns the label of a child (unchecked) */
+			const String& GetLabel(size_t index) const { return labels[index]; }
+			/*! \brief Sets the label of a child */
+			void SetLabel(size_t index, const String &label);
+
+			/*! \brief Checks if an attribute exists */
+			bool HasAttribute(const String &key) const { return attributes.find(key) != attributes.end(); }
+			/*! \brief Returns the names of the attributes */
+			std::vector<String> GetAttributeNames() const;
+			/*! \brief Returns the values of an attribute for all children */
+			const std::vector<double>& GetAttributes(const String &key) const;
+			/*! \brief Returns the value of an attribute for a child */
+			double GetAttribute(const String &key, size_t index) const;
+			/*! \brief Sets the value of an attribute for a child */
+			void SetAttribute(const String &key, size_t index, double value);
+
+			/*! \brief Returns a child as a block, that is created if needed */
+			SBlock GetBlock(size_t index);
+			/*! \brief Checks if a child was materialized as a block */
+			bool IsMaterialized(size_t index) const noexcept { return (index < blocks.size()) && blocks[index]; }
+			/*! \brief Stores all children in the parent block, replacing its previous content */
+			void AddToParent();
+			/*! \brief Returns the approximate memory used by the tree, in bytes */
+			size_t GetMemoryUsage() const;
+
+			/*! \brief Iterator on the children, with the same interface as Block::block_iterator */
+			class block_iterator: public std::iterator<std::random_access_iterator_tag, SObject, ptrdiff_t, const SObject*, SObject>
+			{
+				public:
+					block_iterator() noexcept:tree(nullptr),index(0) {}
+					block_iterator(FlatBlockTree &t, size_t i) noexcept:tree(&t),index(i) {}
+
+					/* forward iterator */
+					const block_iterator& operator++() noexcept { ++index; return *this; }
+					block_iterator operator++(int) noexcept { block_iterator bis(*this); ++index; return bis; }
+					bool operator==(block_iterator const &other) const noexcept { return index == other.index; }
+					bool operator!=(block_iterator const &other) const noexcept { return index != other.index; }
+					/*! \brief Materializes the block */
+					reference operator*() const { return tree->GetBlock(index); }
+					/*! \brief Materializes the block */
+					SBlock AsBlock() const { return tree->GetBlock(index); }
+					/*! \brief Materializes the block */
+					SBlock operator->() const { return tree->GetBlock(index); }
+					/* bidirectional iterator */
+					block_iterator& operator--() noexcept { --index; return *this; }
+					block_iterator operator--(int) noexcept { block_iterator bis(*this); --index; return bis; }
+					/* random access iterator */
+					ptrdiff_t operator-(block_iterator const &rhs) const noexcept { return ptrdiff_t(index) - ptrdiff_t(rhs.index); }
+					bool operator<(block_iterator const &other) const noexcept { return index < other.index; }
+					bool operator>(block_iterator const &other) const noexcept { return index > other.index; }
+					bool operator<=(block_iterator const &other) const noexcept { return index <= other.index; }
+					bool operator>=(block_iterator const &other) const noexcept { return index >= other.index; }
+					block_iterator operator+(int step) const noexcept { return block_iterator(*tree, size_t(ptrdiff_t(index) + step)); }
+					block_iterator operator-(int step) const noexcept { return block_iterator(*tree, size_t(ptrdiff_t(index) - step)); }
+					const block_iterator& operator+=(int step) noexcept { index = size_t(ptrdiff_t(index) + step); return *this; }
+					const block_iterator& operator-=(int step) noexcept { index = size_t(ptrdiff_t(index) - step); return *this; }
+					reference operator[](int i) const { return tree->GetBlock(size_t(ptrdiff_t(index) + i)); }
+
+					/*! \brief Returns the index of the child */
+					size_t GetIndex() const noexcept { return index; }
+					/*! \brief Returns the absolute bounding box of the child without materializing it */
+					const Rect& GetBBox() const { return tree->GetBBox(index); }
+					/*! \brief Returns the label of the child without materializing it */
+					const String& GetLabel() const { return tree->GetLabel(index); }
+					/*! \brief Returns an attribute of the child without materializing it */
+					double GetAttribute(const String &key) const { return tree->GetAttribute(key, index); }
+
+				private:
+					FlatBlockTree *tree; /*!< the tree */
+					size_t index; /*!< the index of the child */
+			};
+			/*! \brief Returns an iterator on the first child */
+			block_iterator BlockBegin() { return block_iterator(*this, 0); }
+			/*! \brief Returns an iterator after the last child */
+			block_iterator BlockEnd() { return block_iterator(*this, Size()); }
+			/*! \brief Returns an iterator on the first child */
+			block_iterator begin() { return BlockBegin(); }
+			/*! \brief Returns an iterator after the last child */
+			block_iterator end() { return BlockEnd(); }
+
+		private:
+			WBlock parent; /*!< the parent block */
+			String treename; /*!< the name of the tree in the parent block */
+			std::vector<Rect> bboxes; /*!< absolute bounding boxes */
+			std::vector<String> labels; /*!< names of the children */
+			std::map<String, std::vector<double>> attributes; /*!< numeric attributes, NaN when unset */
+			std::vector<SBlock> blocks; /*!< materialized blocks, allocated on first materialization */
+	};
+}
+
+#endif
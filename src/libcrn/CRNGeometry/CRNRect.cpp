@@ -21,6 +21,8 @@
 
 #include <CRNIO/CRNIO.h>
 #include <limits>
+#include <numeric>
+#include <algorithm>
 
 #include <CRNGeometry/CRNRect.h>
 #include <CRNData/CRNDataFactory.h>
@@ -764,6 +766,116 @@ void Rect::spiral_iterator::update()
 	}
 }
 
+/*****************************************************************************/
+/*!
+ * Finds all pairs of intersecting rectangles in a collection, ie: the pairs whose intersection (operator&()) is valid.
+ * The rectangles are sorted by left coordinate and swept once, so only the rectangles that overlap along the x axis are compared.
+ *
+ * \param[in]	rects	the rectangles (invalid rectangles never intersect)
+ * \return	the pairs of indices (i, j) with i < j, sorted
+ */
+std::vector<std::pair<size_t, size_t>> Rect::FindIntersectingPairs(const std::vector<Rect> &rects)
+{
+	auto order = std::vector<size_t>{};
+	order.reserve(rects.size());
+	for (size_t tmp = 0; tmp < rects.size(); ++tmp)
+		if (rects[tmp].IsValid())
+			order.push_back(tmp);
+	std::stable_sort(order.begin(), order.end(), [&rects](size_t i1, size_t i2)
+			{ return rects[i1].GetLeft() < rects[i2].GetLeft(); });
+
+	auto pairs = std::vector<std::pair<size_t, size_t>>{};
+	for (size_t p = 0; p < order.size(); ++p)
+	{
+		const auto &r1 = rects[order[p]];
+		for (auto q = p + 1; (q < order.size()) && (rects[order[q]].GetLeft() <= r1.GetRight()); ++q)
+		{
+			const auto &r2 = rects[order[q]];
+			if ((r2.GetTop() <= r1.GetBottom()) && (r1.GetTop() <= r2.GetBottom()))
+				pairs.emplace_back(Min(order[p], order[q]), Max(order[p], order[q]));
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+	return pairs;
+}
+
+/*****************************************************************************/
+/*!
+ * Flags the rectangles closest to border in a direction.
+ * A rectangle is discarded when a rectangle that is closer to the border has a non-null Overlap() with it.
+ *
+ * \param[in]	rects	the rectangles
+ * \param[in]	drt	the reference direction
+ * \return	a vector of flags, true for the rectangles that are closest to the border
+ */
+std::vector<bool> Rect::closestsToBorder(const std::vector<Rect> &rects, Direction drt)
+{
+	const auto n = rects.size();
+	auto keep = std::vector<bool>(n, false);
+	if ((drt != Direction::LEFT) && (drt != Direction::RIGHT) && (drt != Direction::TOP) && (drt != Direction::BOTTOM))
+		return keep;
+
+	// lo: the coordinate that is the smallest for the rectangles closest to the border
+	// [lo, hi]: the extent along the same axis (coordinates are negated for right and bottom)
+	auto lo = std::vector<int>(n);
+	auto hi = std::vector<int>(n);
+	for (size_t tmp = 0; tmp < n; ++tmp)
+	{
+		const auto &r = rects[tmp];
+		if (drt == Direction::LEFT)
+		{
+			lo[tmp] = r.GetLeft();
+			hi[tmp] = r.GetRight();
+		}
+		else if (drt == Direction::RIGHT)
+		{
+			lo[tmp] = -r.GetRight();
+			hi[tmp] = -r.GetLeft();
+		}
+		else if (drt == Direction::TOP)
+		{
+			lo[tmp] = r.GetTop();
+			hi[tmp] = r.GetBottom();
+		}
+		else
+		{
+			lo[tmp] = -r.GetBottom();
+			hi[tmp] = -r.GetTop();
+		}
+	}
+	auto order = std::vector<size_t>(n);
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::sort(order.begin(), order.end(), [&lo](size_t i1, size_t i2) { return lo[i1] < lo[i2]; });
+
+	// a closer rectangle c has lo[c] < lo[r] and Overlap() == min(hi[r], hi[c]) - lo[r]
+	// so r is kept iff min(hi[r], hi[c]) == lo[r] for all closer c, which only depends on the extrema of hi[c]
+	auto minhi = std::numeric_limits<int>::max();
+	auto maxhi = std::numeric_limits<int>::min();
+	for (size_t g = 0; g < n; )
+	{
+		auto ge = g;
+		while ((ge < n) && (lo[order[ge]] == lo[order[g]]))
+			ge += 1;
+		for (auto k = g; k < ge; ++k)
+		{
+			const auto r = order[k];
+			if (g == 0)
+				keep[r] = true;
+			else if (hi[r] == lo[r])
+				keep[r] = minhi >= lo[r];
+			else if (hi[r] > lo[r])
+				keep[r] = (minhi == lo[r]) && (maxhi == lo[r]);
+		}
+		for (auto k = g; k < ge; ++k)
+		{
+			minhi = Min(minhi, hi[order[k]]);
+			maxhi = Max(maxhi, hi[order[k]]);
+		}
+		g = ge;
+	}
+	return keep;
+}
+
 CRN_BEGIN_CLASS_CONSTRUCTOR(Rect)
 	CRN_DATA_FACTORY_REGISTER(U"Rect", Rect)
 	Cloner::Register<Rect>();
@@ -357,7 +357,9 @@ namespace crn
 
 			/*! \brief Get rectangles closest to border in a direction from a collection of rectangles */
 			/*!
-			 * Get rectangles closest to border in a given direction from a collection of rectangles
+			 * Get rectangles closest to border in a given direction from a collection of rectangles.
+			 * A rectangle is discarded when a rectangle that is closer to the border has a non-null Overlap() with it.
+			 * The rectangles are swept once in sorted order, in O(n log n).
 			 * 
 			 * \param[in]	it_begin	The iterator pointing to the begining of the collection
 			 * \param[in]	it_end	The iterator pointing to the end of the collection
@@ -366,113 +368,19 @@ namespace crn
 			 */			
 			template <class ITER> static std::vector<Rect> FindClosestsToBorder(ITER it_begin, ITER it_end, Direction drt)			
 			{
+				auto rects = std::vector<Rect>{};
+				for (ITER it = it_begin; it != it_end; ++it)
+					rects.push_back(*it);
+				const auto keep = closestsToBorder(rects, drt);
 				std::vector<Rect> closest;
-				
-				ITER it_ref = it_begin;
-				
-				if (drt == Direction::LEFT)
-				{
-					while (it_ref != it_end)
-					{
-						bool is_extremal = true;
-						int border_ref = it_ref->GetLeft();
-					
-						ITER it_cmp = it_begin;
-					
-						while ((it_cmp != it_end) && (is_extremal))
-						{
-							if (it_cmp != it_ref)
-								if (it_ref->Overlap(*it_cmp, Orientation::VERTICAL))
-									if (border_ref > it_cmp->GetLeft())
-										is_extremal = false;
-						
-							++it_cmp;
-						}
-					
-						if (is_extremal)
-							closest.push_back(*it_ref);
-					
-						++it_ref;
-					}
-				}
-				else if (drt == Direction::RIGHT)
-				{
-					while (it_ref != it_end)
-					{
-						bool is_extremal = true;
-						int border_ref = it_ref->GetRight();
-					
-						ITER it_cmp = it_begin;
-					
-						while ((it_cmp != it_end) && (is_extremal))
-						{
-							if (it_cmp != it_ref)
-								if (it_ref->Overlap(*it_cmp, Orientation::VERTICAL))
-									if (border_ref < it_cmp->GetRight())
-										is_extremal = false;
-						
-							++it_cmp;
-						}
-					
-						if (is_extremal)
-							closest.push_back(*it_ref);
-					
-						++it_ref;
-					}
-				}
-				else if (drt == Direction::TOP)
-				{
-					while (it_ref != it_end)
-					{
-						bool is_extremal = true;
-						int border_ref = it_ref->GetTop();
-					
-						ITER it_cmp = it_begin;
-					
-						while ((it_cmp != it_end) && (is_extremal))
-						{
-							if (it_cmp != it_ref)
-								if (it_ref->Overlap(*it_cmp, Orientation::HORIZONTAL))
-									if (border_ref > it_cmp->GetTop())
-										is_extremal = false;
-						
-							++it_cmp;
-						}
-					
-						if (is_extremal)
-							closest.push_back(*it_ref);
-					
-						++it_ref;
-					}
-				}
-				else if (drt == Direction::BOTTOM)
-				{
-					while (it_ref != it_end)
-					{
-						bool is_extremal = true;
-						int border_ref = it_ref->GetBottom();
-					
-						ITER it_cmp = it_begin;
-					
-						while ((it_cmp != it_end) && (is_extremal))
-						{
-							if (it_cmp != it_ref)
-								if (it_ref->Overlap(*it_cmp, Orientation::HORIZONTAL))
-									if (border_ref < it_cmp->GetBottom())
-										is_extremal = false;
-						
-							++it_cmp;
-						}
-					
-						if (is_extremal)
-							closest.push_back(*it_ref);
-					
-						++it_ref;
-					}
-				}
-
+				for (size_t tmp = 0; tmp < rects.size(); ++tmp)
+					if (keep[tmp])
+						closest.push_back(rects[tmp]);
 				return closest;
 			}			
+
+			/*! \brief Finds all pairs of intersecting rectangles in a collection */
+			static std::vector<std::pair<size_t, size_t>> FindIntersectingPairs(const std::vector<Rect> &rects);
 			
 			/*! \brief Get the rectangles included in this */
 			/*!
@@ -799,6 +707,9 @@ namespace crn
 			xml::Element Serialize(xml::Element &parent) const;
 
 		private:
+			/*! \brief Flags the rectangles closest to border in a direction */
+			static std::vector<bool> closestsToBorder(const std::vector<Rect> &rects, Direction drt);
+
 			int bx, by, ex, ey; /*!< the coordinates */
 			int w, h; /*!< the width and height */
 			bool valid; /*!< whether the rectangle is valid */
@@ -44,6 +44,7 @@ FileShield& FileShield::getInstance()
 std::mutex& FileShield::GetMutex(const Path &fname)
 {
 	FileShield &fs(getInstance());
+	std::lock_guard<std::mutex> lock(fs.mutex); // files may be opened from several threads
 	auto it = fs.shields.find(fname);
 	if (it == fs.shields.end())
 	{
@@ -56,6 +56,7 @@ namespace crn
 			/*! \brief Constructor */
 			FileShield();
 			std::map<Path, std::unique_ptr<std::mutex> > shields; /*!< list of mutex */
+			std::mutex mutex; /*!< protects the list of mutex */
 	};
 }
 
@@ -0,0 +1,266 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNColorConversion.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include <CRNImage/CRNColorConversion.h>
+#include <CRNImage/CRNPixel.h>
+#include <cmath>
+
+using namespace crn;
+
+namespace
+{
+	/*! Lookup tables of the non-linear stages of the conversions */
+	struct ColorTables
+	{
+		static constexpr size_t LabFSize = 4096; /*!< number of samples of the L*a*b* function */
+		static constexpr double LabFRange = 2.0; /*!< the L*a*b* function is sampled on [0, LabFRange] */
+
+		ColorTables()
+		{
+			for (size_t v = 0; v < 256; ++v)
+			{
+				const auto c = double(v) / 255.0;
+				linear[v] = 100.0 * ((c > 0.04045) ? pow((c + 0.055) / 1.055, 2.4) : c / 12.92);
+			}
+			for (size_t i = 0; i <= LabFSize; ++i)
+				labf[i] = exact_labf(double(i) * LabFRange / double(LabFSize));
+		}
+
+		/*! Exact L*a*b* function */
+		static double exact_labf(double t) noexcept
+		{
+			return (t > 0.008856) ? cbrt(t) : (7.787 * t + 16.0 / 116.0);
+		}
+		/*! L*a*b* function: the cube root is interpolated in the table then refined with one Newton step */
+		double LabF(double t) const noexcept
+		{
+			const auto pos = t * (double(LabFSize) / LabFRange);
+			if ((t <= 0.008856) || (pos >= double(LabFSize)))
+				return exact_labf(t);
+			const auto i = size_t(pos);
+			const auto y = labf[i] + (pos - double(i)) * (labf[i + 1] - labf[i]);
+			return y - (y * y * y - t) / (3.0 * y * y);
+		}
+
+		double linear[256]; /*!< sRGB to linear RGB, ×100 */
+		double labf[LabFSize + 1]; /*!< samples of the L*a*b* function */
+	};
+
+	const ColorTables& tables()
+	{
+		static const ColorTables t;
+		return t;
+	}
+}
+
+/*! Converts an RGB image by bands of rows in parallel. Each row is converted channel by channel in plain arrays so that the linear stages are vectorized by the compiler.
+ * \param[in]	img	the source image
+ * \param[in]	space	the destination color space
+ * \param[in]	store	a function (offset, c0, c1, c2) that writes a converted pixel
+ */
+template<typename STORE> static void convert_rgb(const ImageRGB &img, ColorSpace space, STORE &&store)
+{
+	const auto &lut = tables();
+	const auto w = img.GetWidth();
+	impl::ForEachRowBand<double>(w, img.GetHeight(), [&img, &lut, &store, space, w](size_t b, size_t e)
+		{
+			auto c0 = std::vector<double>(w);
+			auto c1 = std::vector<double>(w);
+			auto c2 = std::vector<double>(w);
+			for (auto y = b; y < e; ++y)
+			{
+				const auto *row = &img.At(0, y);
+				if (space == ColorSpace::YUV)
+				{
+					for (size_t x = 0; x < w; ++x)
+					{
+						const auto r = double(row[x].r), g = double(row[x].g), bl = double(row[x].b);
+						const auto yl = 0.299 * r + 0.587 * g + 0.114 * bl;
+						c0[x] = yl;
+						c1[x] = 0.492 * (bl - yl);
+						c2[x] = 0.877 * (r - yl);
+					}
+				}
+				else
+				{
+					for (size_t x = 0; x < w; ++x)
+					{
+						c0[x] = lut.linear[row[x].r];
+						c1[x] = lut.linear[row[x].g];
+						c2[x] = lut.linear[row[x].b];
+					}
+					// linear RGB to XYZ (D65)
+					for (size_t x = 0; x < w; ++x)
+					{
+						const auto r = c0[x], g = c1[x], bl = c2[x];
+						c0[x] = r * 0.4124 + g * 0.3576 + bl * 0.1805;
+						c1[x] = r * 0.2126 + g * 0.7152 + bl * 0.0722;
+						c2[x] = r * 0.0193 + g * 0.1192 + bl * 0.9505;
+					}
+					if (space == ColorSpace::Lab)
+					{
+						for (size_t x = 0; x < w; ++x)
+						{
+							const auto fx = lut.LabF(c0[x] / 95.047);
+							const auto fy = lut.LabF(c1[x] / 100.0);
+							const auto fz = lut.LabF(c2[x] / 108.883);
+							c0[x] = 116.0 * fy - 16.0;
+							c1[x] = 500.0 * (fx - fy);
+							c2[x] = 200.0 * (fy - fz);
+						}
+					}
+					else if (space == ColorSpace::Luv)
+					{
+						static const auto refu = (4 * 95.047) / (95.047 + (15 * 100.0) + (3 * 108.883));
+						static const auto refv = (9 * 100.0) / (95.047 + (15 * 100.0) + (3 * 108.883));
+						for (size_t x = 0; x < w; ++x)
+						{
+							const auto l = 116.0 * lut.LabF(c1[x] / 100.0) - 16.0;
+							const auto denom = c0[x] + 15 * c1[x] + 3 * c2[x];
+							if (denom != 0.0)
+							{
+								const auto u = 13 * l * ((4 * c0[x]) / denom - refu);
+								c2[x] = 13 * l * ((9 * c1[x]) / denom - refv);
+								c1[x] = u;
+							}
+							else
+								c1[x] = c2[x] = 0.0;
+							c0[x] = l;
+						}
+					}
+				}
+				const auto offset = y * w;
+				for (size_t x = 0; x < w; ++x)
+					store(offset + x, c0[x], c1[x], c2[x]);
+			}
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to HSV, in parallel
+ *
+ * \param[in]	img	the source image
+ * \return	a new image
+ */
+ImageHSV crn::MakeImageHSV(const ImageRGB &img)
+{
+	auto out = ImageHSV(img.GetWidth(), img.GetHeight());
+	impl::ForEachPixelBand(img.Size(), [&img, &out](size_t b, size_t e)
+		{
+			for (auto tmp = b; tmp < e; ++tmp)
+				out.At(tmp) = pixel::HSV(img.At(tmp));
+		});
+	return out;
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to XYZ, with a lookup table for the gamma and in parallel
+ *
+ * \param[in]	img	the source image
+ * \return	a new image
+ */
+ImageXYZ crn::MakeImageXYZ(const ImageRGB &img)
+{
+	auto out = ImageXYZ(img.GetWidth(), img.GetHeight());
+	convert_rgb(img, ColorSpace::XYZ, [&out](size_t o, double c0, double c1, double c2) { out.At(o) = pixel::XYZ{c0, c1, c2}; });
+	return out;
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to YUV, in parallel
+ *
+ * \param[in]	img	the source image
+ * \return	a new image
+ */
+ImageYUV crn::MakeImageYUV(const ImageRGB &img)
+{
+	auto out = ImageYUV(img.GetWidth(), img.GetHeight());
+	convert_rgb(img, ColorSpace::YUV, [&out](size_t o, double c0, double c1, double c2) { out.At(o) = pixel::YUV{c0, c1, c2}; });
+	return out;
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to L*a*b*, with lookup tables for the gamma and the cube root and in parallel (the results differ from the per pixel conversions by less than 1e-6)
+ *
+ * \param[in]	img	the source image
+ * \return	a new image
+ */
+ImageLab crn::MakeImageLab(const ImageRGB &img)
+{
+	auto out = ImageLab(img.GetWidth(), img.GetHeight());
+	convert_rgb(img, ColorSpace::Lab, [&out](size_t o, double c0, double c1, double c2) { out.At(o) = pixel::Lab{c0, c1, c2}; });
+	return out;
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to L*u*v*, with lookup tables for the gamma and the cube root and in parallel (the results differ from the per pixel conversions by less than 1e-6)
+ *
+ * \param[in]	img	the source image
+ * \return	a new image
+ */
+ImageLuv crn::MakeImageLuv(const ImageRGB &img)
+{
+	auto out = ImageLuv(img.GetWidth(), img.GetHeight());
+	convert_rgb(img, ColorSpace::Luv, [&out](size_t o, double c0, double c1, double c2) { out.At(o) = pixel::Luv{c0, c1, c2}; });
+	return out;
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to a color space stored as floats (half the memory of the double precision images)
+ *
+ * \param[in]	img	the source image
+ * \param[in]	space	the destination color space
+ * \return	a new image whose channels are (x, y, z), (y, u, v), (l, a, b) or (l, u, v)
+ */
+ImageFloat3 crn::MakeImageFloat3(const ImageRGB &img, ColorSpace space)
+{
+	auto out = ImageFloat3(img.GetWidth(), img.GetHeight());
+	convert_rgb(img, space, [&out](size_t o, double c0, double c1, double c2) { out.At(o) = pixel::Triplet<float>{float(c0), float(c1), float(c2)}; });
+	return out;
+}
+
+/*! Rounds and saturates a channel to 16 bits fixed point */
+static inline int16_t to_short(double c) noexcept
+{
+	return int16_t(Cap(int(floor(c * ShortColorScale + 0.5)), -32768, 32767));
+}
+
+/*****************************************************************************/
+/*!
+ * Converts an RGB image to a color space stored as 16 bits fixed point values (a quarter of the memory of the double precision images)
+ *
+ * \param[in]	img	the source image
+ * \param[in]	space	the destination color space
+ * \return	a new image whose channels are (x, y, z), (y, u, v), (l, a, b) or (l, u, v), multiplied by ShortColorScale
+ */
+ImageShort3 crn::MakeImageShort3(const ImageRGB &img, ColorSpace space)
+{
+	auto out = ImageShort3(img.GetWidth(), img.GetHeight());
+	convert_rgb(img, space, [&out](size_t o, double c0, double c1, double c2) { out.At(o) = pixel::Triplet<int16_t>{to_short(c0), to_short(c1), to_short(c2)}; });
+	return out;
+}
@@ -0,0 +1,56 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNColorConversion.h
+ * \author Yann LEYDIER
+ */
+
+
+#ifndef CRNColorConversion_HEADER
+#define CRNColorConversion_HEADER
+
+#include <CRNImage/CRNImage.h>
+
+namespace crn
+{
+	/*! \addtogroup imageother */
+	/*@{*/
+
+	/*! \brief Color spaces of the batch conversions from RGB */
+	enum class ColorSpace { XYZ, YUV, Lab, Luv };
+
+	/*! \brief Scale of the 16 bits fixed point channels of ImageShort3 (1/100 of a unit) */
+	constexpr double ShortColorScale = 100.0;
+
+	/*! \brief Converts an RGB image to HSV */
+	ImageHSV MakeImageHSV(const ImageRGB &img);
+	/*! \brief Converts an RGB image to XYZ */
+	ImageXYZ MakeImageXYZ(const ImageRGB &img);
+	/*! \brief Converts an RGB image to YUV */
+	ImageYUV MakeImageYUV(const ImageRGB &img);
+	/*! \brief Converts an RGB image to L*a*b* */
+	ImageLab MakeImageLab(const ImageRGB &img);
+	/*! \brief Converts an RGB image to L*u*v* */
+	ImageLuv MakeImageLuv(const ImageRGB &img);
+	/*! \brief Converts an RGB image to a color space stored as floats */
+	ImageFloat3 MakeImageFloat3(const ImageRGB &img, ColorSpace space);
+	/*! \brief Converts an RGB image to a color space stored as 16 bits fixed point values */
+	ImageShort3 MakeImageShort3(const ImageRGB &img, ColorSpace space);
+	/*@}*/
+}
+
+#endif
@@ -23,6 +23,7 @@
 #include <vector>
 #include <math.h>
 #include <CRNException.h>
+#include <CRNStringUTF8.h>
 #include <CRNImage/CRNImageRGB.h>
 #include <CRNGeometry/CRNPoint2DDouble.h>
 #include <CRNi18n.h>
@@ -483,7 +484,7 @@ const ImageDoubleGray& Differential::GetLxx()
 	if (lxx.Size() != lx.Size())
 	{
 		lxx = GetLx();
-		MatrixDouble sobx = MatrixDouble::NewGaussianLineDerivative(0);
+		auto sobx = MatrixDouble({-1, 0, 1}, Orientation::HORIZONTAL); // same sign as derivate1()
 		lxx.Convolve(sobx);
 	}
 	return lxx;
@@ -501,7 +502,7 @@ const ImageDoubleGray& Differential::GetLyy()
 	if (lyy.Size() != ly.Size())
 	{
 		lyy = GetLy();
-		MatrixDouble soby = MatrixDouble::NewGaussianLineDerivative(0);
+		auto soby = MatrixDouble({-1, 0, 1}, Orientation::HORIZONTAL); // same sign as derivate1()
 		soby.Transpose();
 		lyy.Convolve(soby);
 	}
@@ -520,7 +521,7 @@ const ImageDoubleGray& Differential::GetLxy()
 	if (lxy.Size() != lx.Size())
 	{
 		lxy = GetLx();
-		MatrixDouble soby = MatrixDouble::NewGaussianLineDerivative(0);
+		auto soby = MatrixDouble({-1, 0, 1}, Orientation::HORIZONTAL); // same sign as derivate1()
 		soby.Transpose();
 		lxy.Convolve(soby);
 	}
@@ -539,7 +540,7 @@ const ImageDoubleGray& Differential::GetLyx()
 	if (lyx.Size() != ly.Size())
 	{
 		lyx = GetLy();
-		MatrixDouble sobx = MatrixDouble::NewGaussianLineDerivative(0);
+		auto sobx = MatrixDouble({-1, 0, 1}, Orientation::HORIZONTAL); // same sign as derivate1()
 		lyx.Convolve(sobx);
 	}
 	return lyx;
@@ -595,8 +596,8 @@ ImageDoubleGray Differential::MakeLww()
 		double n = lx2ly2.At(tmp);
 		if (n != 0.0)
 			lww.At(tmp) =
-					(Sqr(GetLx().At(tmp)) * GetLyy().At(tmp) 
-					 + Sqr(GetLy().At(tmp)) * GetLxx().At(tmp)
+					(Sqr(GetLx().At(tmp)) * GetLxx().At(tmp) 
+					 + Sqr(GetLy().At(tmp)) * GetLyy().At(tmp)
 					 + GetLx().At(tmp) * GetLy().At(tmp) * (GetLxy().At(tmp) + GetLyx().At(tmp)))
 					/ n;
 	}
@@ -1027,3 +1028,309 @@ ImageDoubleGray Differential::MakeCanny()
 	return l1;
 }
 
+
+/*****************************************************************************/
+/*!
+ * Creates the separable kernels
+ * \throws	ExceptionDomain	sigma<0
+ * \param[in]	s	the standard deviation of the Gaussian
+ */
+void LazyDifferential::init(double s)
+{
+	if (s < 0)
+		throw ExceptionDomain(StringUTF8("LazyDifferential::LazyDifferential(const Image<T> &src, double sigma): ") + _("Negative standard deviation"));
+	sigma = s;
+	if (sigma == 0)
+	{
+		smooth = {1.0};
+		diff1 = {-1.0, 0.0, 1.0};
+		diff2 = {1.0, -2.0, 1.0};
+		return;
+	}
+	auto tovector = [](MatrixDouble &&m)
+		{
+			m.NormalizeForConvolution();
+			return std::vector<double>(m[0], m[0] + m.GetCols());
+		};
+	smooth = tovector(MatrixDouble::NewGaussianLine(sigma));
+	diff1 = tovector(MatrixDouble::NewGaussianLineDerivative(sigma));
+	diff2 = tovector(MatrixDouble::NewGaussianLineSecondDerivative(sigma));
+}
+
+/*****************************************************************************/
+/*!
+ * Computes a derivative with two 1D passes on a copy of the source
+ * \param[in]	d	the derivative to compute
+ * \return	the newly created image
+ */
+ImageFloatGray LazyDifferential::compute(Derivative d) const
+{
+	auto img = source;
+	switch (d)
+	{
+		case Derivative::X:
+			img.ConvolveSeparable(diff1, smooth);
+			break;
+		case Derivative::Y:
+			img.ConvolveSeparable(smooth, diff1);
+			break;
+		case Derivative::XX:
+			img.ConvolveSeparable(diff2, smooth);
+			break;
+		case Derivative::XY:
+			img.ConvolveSeparable(diff1, diff1);
+			break;
+		case Derivative::YY:
+			img.ConvolveSeparable(smooth, diff2);
+			break;
+	}
+	return img;
+}
+
+/*****************************************************************************/
+/*!
+ * Returns a derivative. Computes it if needed.
+ * \warning	The reference is invalidated by Free().
+ * \throws	ExceptionDomain	the kernel is bigger than the image
+ * \param[in]	d	the derivative
+ * \return	a reference to the internal derivative
+ */
+const ImageFloatGray& LazyDifferential::Get(Derivative d)
+{
+	std::lock_guard<std::mutex> l(*lazydata);
+	auto &img = derivatives[size_t(d)];
+	if (!computed[size_t(d)])
+	{
+		img = compute(d);
+		computed[size_t(d)] = true;
+	}
+	return img;
+}
+
+/*****************************************************************************/
+/*!
+ * Checks if a derivative is currently stored
+ * \param[in]	d	the derivative
+ * \return	true if the derivative was computed and not freed
+ */
+bool LazyDifferential::IsComputed(Derivative d) const
+{
+	std::lock_guard<std::mutex> l(*lazydata);
+	return computed[size_t(d)];
+}
+
+/*****************************************************************************/
+/*!
+ * Frees a derivative. It will be computed again if needed.
+ * \param[in]	d	the derivative
+ */
+void LazyDifferential::Free(Derivative d)
+{
+	std::lock_guard<std::mutex> l(*lazydata);
+	derivatives[size_t(d)] = ImageFloatGray{};
+	computed[size_t(d)] = false;
+}
+
+/*****************************************************************************/
+/*!
+ * Frees all derivatives. They will be computed again if needed.
+ */
+void LazyDifferential::Free()
+{
+	std::lock_guard<std::mutex> l(*lazydata);
+	for (auto &img : derivatives)
+		img = ImageFloatGray{};
+	computed.fill(false);
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the number of bytes used by the source and the stored derivatives
+ * \return	the memory used by the pixels
+ */
+size_t LazyDifferential::GetMemoryUsage() const
+{
+	std::lock_guard<std::mutex> l(*lazydata);
+	auto s = source.Size();
+	for (auto tmp : Range(derivatives))
+		if (computed[tmp])
+			s += derivatives[tmp].Size();
+	return s * sizeof(float);
+}
+
+/*! Creates an image from a function of the pixel index
+ * \param[in]	w	the width of the image
+ * \param[in]	h	the height of the image
+ * \param[in]	fun	a function (size_t i) that returns the value of the i-th pixel
+ * \return	the newly created image
+ */
+template<typename FUNC> static ImageFloatGray make_invariant(size_t w, size_t h, FUNC fun)
+{
+	auto img = ImageFloatGray(w, h);
+	impl::ForEachPixelBand(img.Size(), [&img, &fun](size_t b, size_t e)
+		{
+			for (auto tmp = b; tmp < e; ++tmp)
+				img.At(tmp) = float(fun(tmp));
+		});
+	return img;
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the first derivate of the normal to the isophotes. sqrt(Lx²+Ly²).
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeLw()
+{
+	const auto &lx = GetLx();
+	const auto &ly = GetLy();
+	return make_invariant(GetWidth(), GetHeight(), [&lx, &ly](size_t i)
+		{
+			return sqrt(Sqr(double(lx.At(i))) + Sqr(double(ly.At(i))));
+		});
+}
+
+/*! Second derivative of the tangent to the isophotes at a pixel
+ * \param[in]	lx	the x derivative
+ * \param[in]	ly	the y derivative
+ * \param[in]	lxx	the xx derivative
+ * \param[in]	lxy	the xy derivative
+ * \param[in]	lyy	the yy derivative
+ * \param[in]	n	Lx²+Ly²
+ * \return	Lvv
+ */
+static inline double lazy_lvv(double lx, double ly, double lxx, double lxy, double lyy, double n) noexcept
+{
+	return (n != 0.0) ? (Sqr(lx) * lyy + Sqr(ly) * lxx - 2 * lx * ly * lxy) / n : 0.0;
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the second derivate of the tangent to the isophotes. (Lx²*Lyy + Ly²*Lxx - 2*Lx*Ly*Lxy) / (Lx² + Ly²)
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeLvv()
+{
+	const auto &lx = GetLx();
+	const auto &ly = GetLy();
+	const auto &lxx = GetLxx();
+	const auto &lxy = GetLxy();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&](size_t i)
+		{
+			const auto x = double(lx.At(i)), y = double(ly.At(i));
+			return lazy_lvv(x, y, lxx.At(i), lxy.At(i), lyy.At(i), Sqr(x) + Sqr(y));
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the second derivative of the normal to the isophotes. (Lx²*Lxx + Ly²*Lyy + 2*Lx*Ly*Lxy) / (Lx² + Ly²)
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeLww()
+{
+	const auto &lx = GetLx();
+	const auto &ly = GetLy();
+	const auto &lxx = GetLxx();
+	const auto &lxy = GetLxy();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&](size_t i)
+		{
+			const auto x = double(lx.At(i)), y = double(ly.At(i));
+			const auto n = Sqr(x) + Sqr(y);
+			return (n != 0.0) ? (Sqr(x) * lxx.At(i) + Sqr(y) * lyy.At(i) + 2 * x * y * lxy.At(i)) / n : 0.0;
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the laplacian image. Lxx + Lyy
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeLaplacian()
+{
+	const auto &lxx = GetLxx();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&lxx, &lyy](size_t i)
+		{
+			return double(lxx.At(i)) + double(lyy.At(i));
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the isophote curvature image. Lvv / Lw
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeIsophoteCurvature()
+{
+	const auto &lx = GetLx();
+	const auto &ly = GetLy();
+	const auto &lxx = GetLxx();
+	const auto &lxy = GetLxy();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&](size_t i)
+		{
+			const auto x = double(lx.At(i)), y = double(ly.At(i));
+			const auto n = Sqr(x) + Sqr(y);
+			const auto lvv = lazy_lvv(x, y, lxx.At(i), lxy.At(i), lyy.At(i), n);
+			return (n != 0.0) ? lvv / sqrt(n) : lvv;
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the edge image. Lww / Lw
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeEdge()
+{
+	const auto &lx = GetLx();
+	const auto &ly = GetLy();
+	const auto &lxx = GetLxx();
+	const auto &lxy = GetLxy();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&](size_t i)
+		{
+			const auto x = double(lx.At(i)), y = double(ly.At(i));
+			const auto n = Sqr(x) + Sqr(y);
+			return (n != 0.0) ? (Sqr(x) * lxx.At(i) + Sqr(y) * lyy.At(i) + 2 * x * y * lxy.At(i)) / (n * sqrt(n)) : 0.0;
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the corner image. Lvv * Lw²
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeCorner()
+{
+	const auto &lx = GetLx();
+	const auto &ly = GetLy();
+	const auto &lxx = GetLxx();
+	const auto &lxy = GetLxy();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&](size_t i)
+		{
+			const auto x = double(lx.At(i)), y = double(ly.At(i));
+			const auto n = Sqr(x) + Sqr(y);
+			return lazy_lvv(x, y, lxx.At(i), lxy.At(i), lyy.At(i), n) * n;
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * Returns the Gaussian curvature image. Lxx*Lyy - Lxy²
+ * \return the newly created image
+ */
+ImageFloatGray LazyDifferential::MakeGaussianCurvature()
+{
+	const auto &lxx = GetLxx();
+	const auto &lxy = GetLxy();
+	const auto &lyy = GetLyy();
+	return make_invariant(GetWidth(), GetHeight(), [&](size_t i)
+		{
+			return double(lxx.At(i)) * double(lyy.At(i)) - Sqr(double(lxy.At(i)));
+		});
+}
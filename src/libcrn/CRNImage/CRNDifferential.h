@@ -25,6 +25,7 @@
 #include <CRNImage/CRNImageGradient.h>
 #include <CRNImage/CRNImageGray.h>
 #include <mutex>
+#include <array>
 
 /*! \defgroup diff	PDE
  * \ingroup	image */
@@ -33,6 +34,8 @@ namespace crn
 {
 	class Differential;
 	CRN_ALIAS_SMART_PTR(Differential)
+	class LazyDifferential;
+	CRN_ALIAS_SMART_PTR(LazyDifferential)
 }
 namespace crn
 {
@@ -104,7 +107,10 @@ namespace crn
 			const ImageDoubleGray& GetLx2Ly2() const { return lx2ly2; }
 			/*! \brief Returns a reference to the internal xx derivate */
 			const ImageDoubleGray& GetLxx();
-			/*! \brief Returns a reference to the internal xy derivate */
+			/*! \brief Returns a reference to the internal xy derivate
+			 *
+			 * The cross derivative is Lx derived along y with [-1 0 1]. It is not smoothed again, so for sigma > 0 it differs from LazyDifferential::GetLxy(), which applies the Gaussian derivative in both directions.
+			 */
 			const ImageDoubleGray& GetLxy();
 			/*! \brief Returns a reference to the internal yx derivate */
 			const ImageDoubleGray& GetLyx();
@@ -199,5 +205,104 @@ namespace crn
 			double thres; /*!< the square gradient module threshold */
 			std::unique_ptr<std::mutex> lazydata; /*!< protects the lazy computation of data */
 	};
+
+	/****************************************************************************/
+	/*! \brief Memory-frugal Gaussian differential computation on images.
+	 *
+	 * Each derivative is computed with a separable Gaussian derivative kernel only on first access and stored in single precision.
+	 * The derivatives can be freed once the needed invariants were produced, and they will be computed again if accessed later.
+	 * Unlike Differential, the source image is the only plane allocated at construction (4 bytes per pixel).
+	 * With a null sigma, both classes produce the same derivatives and invariants. With sigma > 0, Differential derives Lx again with [-1 0 1] to get the cross derivative, so Lxy and the invariants using it (Lww, Lvv, Lvw, edge, corner…) differ slightly from the ones computed here.
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date		Oct 2016
+	 * \version 0.1
+	 * \ingroup	diff
+	 */
+	class LazyDifferential
+	{
+		public:
+			/*! \brief The available derivatives */
+			enum class Derivative { X = 0, Y, XX, XY, YY };
+
+			/*! \brief Constructor
+			 * \throws	ExceptionDomain	sigma<0
+			 * \param[in]	src	the image to derivate
+			 * \param[in]	sigma	the standard deviation of the Gaussian (if null, the derivation kernels are [-1 0 1] and [1 -2 1])
+			 */
+			template<typename T> LazyDifferential(const Image<T> &src, double sigma):
+				source(src),
+				computed{{false, false, false, false, false}},
+				lazydata(std::make_unique<std::mutex>())
+			{ init(sigma); }
+
+			/*! \brief Destructor */
+			~LazyDifferential() = default;
+
+			LazyDifferential(const LazyDifferential &) = delete;
+			LazyDifferential(LazyDifferential &&) = default;
+			LazyDifferential& operator=(const LazyDifferential &) = delete;
+			LazyDifferential& operator=(LazyDifferential &&) = default;
+
+			/*! \brief Returns the standard deviation of the Gaussian */
+			double GetSigma() const noexcept { return sigma; }
+			/*! \brief Returns the width of the images */
+			size_t GetWidth() const noexcept { return source.GetWidth(); }
+			/*! \brief Returns the height of the images */
+			size_t GetHeight() const noexcept { return source.GetHeight(); }
+
+			/*! \brief Returns a derivative, computes it if needed */
+			const ImageFloatGray& Get(Derivative d);
+			/*! \brief Returns the x derivative, computes it if needed */
+			const ImageFloatGray& GetLx() { return Get(Derivative::X); }
+			/*! \brief Returns the y derivative, computes it if needed */
+			const ImageFloatGray& GetLy() { return Get(Derivative::Y); }
+			/*! \brief Returns the xx derivative, computes it if needed */
+			const ImageFloatGray& GetLxx() { return Get(Derivative::XX); }
+			/*! \brief Returns the xy derivative, computes it if needed */
+			const ImageFloatGray& GetLxy() { return Get(Derivative::XY); }
+			/*! \brief Returns the yy derivative, computes it if needed */
+			const ImageFloatGray& GetLyy() { return Get(Derivative::YY); }
+			/*! \brief Checks if a derivative is currently stored */
+			bool IsComputed(Derivative d) const;
+			/*! \brief Frees a derivative */
+			void Free(Derivative d);
+			/*! \brief Frees all derivatives */
+			void Free();
+			/*! \brief Returns the number of bytes used by the source and the stored derivatives */
+			size_t GetMemoryUsage() const;
+
+			/*! \brief Returns the derivative of the normal to the isophotes */
+			ImageFloatGray MakeLw();
+			/*! \brief Returns the second derivative of the tangent to the isophote */
+			ImageFloatGray MakeLvv();
+			/*! \brief Returns the second derivative of the normal to the isophote  */
+			ImageFloatGray MakeLww();
+			/*! \brief Returns the Laplacian image */
+			ImageFloatGray MakeLaplacian();
+			/*! \brief Returns the isophote curvature image */
+			ImageFloatGray MakeIsophoteCurvature();
+			/*! \brief Returns the edge image */
+			ImageFloatGray MakeEdge();
+			/*! \brief Returns the corner image */
+			ImageFloatGray MakeCorner();
+			/*! \brief Returns the Gaussian curvature image */
+			ImageFloatGray MakeGaussianCurvature();
+
+		private:
+			/*! \brief Creates the kernels */
+			void init(double s);
+			/*! \brief Computes a derivative */
+			ImageFloatGray compute(Derivative d) const;
+
+			ImageFloatGray source; /*!< a single precision copy of the source */
+			double sigma; /*!< the standard deviation of the Gaussian */
+			std::vector<double> smooth; /*!< the smoothing kernel */
+			std::vector<double> diff1; /*!< the first derivative kernel */
+			std::vector<double> diff2; /*!< the second derivative kernel */
+			std::array<ImageFloatGray, 5> derivatives; /*!< the stored derivatives */
+			std::array<bool, 5> computed; /*!< which derivatives are stored */
+			std::unique_ptr<std::mutex> lazydata; /*!< protects the lazy computation of data */
+	};
 }
 #endif
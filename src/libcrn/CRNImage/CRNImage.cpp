@@ -26,6 +26,8 @@
 #include <CRNException.h>
 #include <CRNIO/CRNFileShield.h>
 #include <typeindex>
+#include <functional>
+#include <algorithm>
 #include <CRNi18n.h>
 
 #ifdef CRN_USING_GDKPB
@@ -71,71 +73,248 @@ void fclose_if_not_null(FILE *f)
 		fclose(f);
 }
 
-#ifdef CRN_USING_LIBPNG
-// cf http://www.libpng.org/pub/png/libpng-1.2.5-manual.html
-static std::pair<UImage, String> load_libpng(const Path &filename)
+/*! \internal
+ * Rectangle of an image to decode, with a reduction factor
+ */
+struct DecodeRegion
 {
-	// libpng does not support URIs
-	auto fname = filename;
-	fname.ToLocal();
+	size_t left, top, right, bottom; /*!< inclusive bounds in the decoder's coordinates */
+	size_t step; /*!< each pixel of the image covers step × step pixels of the decoder */
 
-	/* open image file */
-	std::unique_ptr<FILE, decltype(fclose_if_not_null)*> fp(fopen(fname.CStr(), "rb"), fclose_if_not_null);
-	if (!fp)
-		return std::make_pair(UImage{}, String(_("Cannot open file ")) + fname);
+	size_t GetWidth() const noexcept { return (right - left) / step + 1; }
+	size_t GetHeight() const noexcept { return (bottom - top) / step + 1; }
+};
 
-	/* read magic number */
-	png_byte magic[8];
-	size_t readsize = fread(magic, 1, sizeof(magic), fp.get());
-	if (!readsize)
-		return std::make_pair(UImage{}, String(U"Empty file."));
+/*! \internal
+ * Clips a region of interest to a decoded image
+ * \param[in]	roi	the region in full resolution coordinates, or an invalid rectangle for the whole image
+ * \param[in]	w	the width of the decoded image
+ * \param[in]	h	the height of the decoded image
+ * \param[in]	scale	the reduction applied by the decoder
+ * \param[in]	step	the reduction to apply after decoding
+ * \param[out]	reg	the region in the decoder's coordinates
+ * \return	false if the region does not intersect the image
+ */
+static bool make_region(const Rect &roi, size_t w, size_t h, size_t scale, size_t step, DecodeRegion &reg)
+{
+	if (!w || !h)
+		return false;
+	reg.step = step;
+	if (!roi.IsValid())
+	{
+		reg.left = reg.top = 0;
+		reg.right = w - 1;
+		reg.bottom = h - 1;
+		return true;
+	}
+	if ((roi.GetRight() < 0) || (roi.GetBottom() < 0))
+		return false;
+	reg.left = size_t(Max(roi.GetLeft(), 0)) / scale;
+	reg.top = size_t(Max(roi.GetTop(), 0)) / scale;
+	reg.right = Min(size_t(roi.GetRight()) / scale, w - 1);
+	reg.bottom = Min(size_t(roi.GetBottom()) / scale, h - 1);
+	if ((reg.left > reg.right) || (reg.top > reg.bottom))
+		return false;
+	// the last pixels cover whole boxes when possible
+	reg.right = Min(reg.left + reg.GetWidth() * step - 1, w - 1);
+	reg.bottom = Min(reg.top + reg.GetHeight() * step - 1, h - 1);
+	return true;
+}
 
-	/* check for valid magic number */
-	if (png_sig_cmp(magic, 0, sizeof(magic)))
-		return std::make_pair(UImage{}, String(U"Not a PNG file."));
+/*! \internal
+ * Reduces decoded rows with a box filter and stores them in an image.
+ * Colors and gray levels are averaged. A b&w pixel is black if any of the pixels it covers is black, so that thin strokes are kept.
+ * It is trivially destructible, so that libpng can jump over it.
+ */
+struct RowReducer
+{
+	DecodeRegion reg; /*!< the region to store */
+	ColorType type; /*!< the type of the image */
+	size_t channels; /*!< number of bytes per pixel in the decoded rows */
+	pixel::BW col0, col1; /*!< colors of the null and non-null bytes of b&w rows */
+	ImageRGB *irgb; /*!< the image if type is RGB */
+	ImageGray *ig; /*!< the image if type is GRAY */
+	ImageBW *ibw; /*!< the image if type is BW */
+	unsigned int *acc; /*!< sums of the current row of the image (3 × width values) */
+	size_t nrows; /*!< number of decoded rows in the sums */
 
+	void AddRow(size_t y, const uint8_t *row) noexcept;
+};
 
-	/* create a png read struct */
-	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-	if (!png_ptr)
-		return std::make_pair(UImage{}, String(_("Cannot create PNG reader.")));
+/*! \internal
+ * Adds a decoded row to the sums and stores a row of the image when its box is complete
+ * \param[in]	y	the index of the decoded row
+ * \param[in]	row	the decoded row
+ */
+void RowReducer::AddRow(size_t y, const uint8_t *row) noexcept
+{
+	if ((y < reg.top) || (y > reg.bottom))
+		return;
+	const auto w = reg.GetWidth();
+	const auto nchan = (type == RGB) ? size_t(3) : size_t(1);
+	for (size_t x = 0; x < w; ++x)
+	{
+		const auto x0 = reg.left + x * reg.step;
+		const auto x1 = Min(x0 + reg.step - 1, reg.right);
+		auto *a = acc + x * nchan;
+		for (auto sx = x0; sx <= x1; ++sx)
+		{
+			const auto *px = row + sx * channels;
+			if (type == BW)
+				a[0] += ((px[0] ? col1 : col0) == pixel::BWBlack) ? 1 : 0;
+			else
+				for (size_t c = 0; c < nchan; ++c)
+					a[c] += px[c];
+		}
+	}
+	nrows += 1;
+	if (((y - reg.top) % reg.step != reg.step - 1) && (y != reg.bottom))
+		return;
 
-	/* create a png info struct */
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	if (!info_ptr)
+	const auto oy = (y - reg.top) / reg.step;
+	for (size_t x = 0; x < w; ++x)
 	{
-		png_destroy_read_struct(&png_ptr, NULL, NULL);
-		return std::make_pair(UImage{}, String(_("Cannot create PNG info.")));
+		const auto x0 = reg.left + x * reg.step;
+		const auto n = unsigned((Min(x0 + reg.step - 1, reg.right) - x0 + 1) * nrows);
+		const auto *a = acc + x * nchan;
+		switch (type)
+		{
+			case RGB:
+				irgb->At(x, oy) = { uint8_t((a[0] + n / 2) / n), uint8_t((a[1] + n / 2) / n), uint8_t((a[2] + n / 2) / n) };
+				break;
+			case GRAY:
+				ig->At(x, oy) = uint8_t((a[0] + n / 2) / n);
+				break;
+			case BW:
+				ibw->At(x, oy) = a[0] ? pixel::BWBlack : pixel::BWWhite;
+				break;
+		}
 	}
+	std::fill_n(acc, w * nchan, 0u);
+	nrows = 0;
+}
 
-	/* Set up the error handling */
-	if (setjmp(png_jmpbuf(png_ptr)))
+/*! \internal
+ * Creates the image filled by a row reducer
+ * \param[in,out]	red	the reducer whose region and type are set
+ * \return	the image, that must be kept alive while the reducer is used
+ */
+static UImage make_reduced_image(RowReducer &red)
+{
+	const auto w = red.reg.GetWidth();
+	const auto h = red.reg.GetHeight();
+	switch (red.type)
 	{
-		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-		return std::make_pair(UImage{}, String(_("Error while reading the PNG file ")) + fname);
+		case RGB:
+			{
+				auto irgb = std::make_unique<ImageRGB>(w, h);
+				red.irgb = irgb.get();
+				return std::move(irgb);
+			}
+		case GRAY:
+			{
+				auto ig = std::make_unique<ImageGray>(w, h);
+				red.ig = ig.get();
+				return std::move(ig);
+			}
+		case BW:
+			{
+				auto ibw = std::make_unique<ImageBW>(w, h);
+				red.ibw = ibw.get();
+				return std::move(ibw);
+			}
 	}
+	return nullptr;
+}
+
+#if defined(CRN_USING_GDIPLUS) || defined(CRN_USING_GDKPB)
+/*! \internal
+ * Crops and reduces a fully decoded image
+ */
+template<typename T, typename F> static UImage reduce_image(const Image<T> &img, RowReducer &red, F to_bytes)
+{
+	auto out = make_reduced_image(red);
+	auto acc = std::vector<unsigned int>(3 * red.reg.GetWidth(), 0);
+	red.acc = acc.data();
+	auto row = std::vector<uint8_t>(red.channels * img.GetWidth());
+	for (auto y = red.reg.top; y <= red.reg.bottom; ++y)
+	{
+		for (size_t x = 0; x < img.GetWidth(); ++x)
+			to_bytes(img.At(x, y), row.data() + x * red.channels);
+		red.AddRow(y, row.data());
+	}
+	return out;
+}
+
+/*! \internal
+ * Crops and reduces an image loaded by a decoder that cannot do it while decoding
+ */
+static std::pair<UImage, String> reduce_image(std::pair<UImage, String> &&res, const Rect &roi, size_t reduction)
+{
+	if (!res.first || (!roi.IsValid() && (reduction == 1)))
+		return std::move(res);
+	auto red = RowReducer{};
+	if (!make_region(roi, res.first->GetWidth(), res.first->GetHeight(), 1, reduction, red.reg))
+		return std::make_pair(UImage{}, String(_("The region is outside the image.")));
+	red.col0 = pixel::BWBlack;
+	red.col1 = pixel::BWWhite;
+	if (auto *irgb = dynamic_cast<const ImageRGB*>(res.first.get()))
+	{
+		red.type = RGB;
+		red.channels = 3;
+		return std::make_pair(reduce_image(*irgb, red, [](const pixel::RGB<uint8_t> &px, uint8_t *b) { b[0] = px.r; b[1] = px.g; b[2] = px.b; }), String(U""));
+	}
+	if (auto *ig = dynamic_cast<const ImageGray*>(res.first.get()))
+	{
+		red.type = GRAY;
+		red.channels = 1;
+		return std::make_pair(reduce_image(*ig, red, [](uint8_t px, uint8_t *b) { b[0] = px; }), String(U""));
+	}
+	if (auto *ibw = dynamic_cast<const ImageBW*>(res.first.get()))
+	{
+		red.type = BW;
+		red.channels = 1;
+		return std::make_pair(reduce_image(*ibw, red, [](pixel::BW px, uint8_t *b) { b[0] = px ? 1 : 0; }), String(U""));
+	}
+	return std::make_pair(UImage{}, String(_("Unknown image format.")));
+}
+#endif
+
+#ifdef CRN_USING_LIBPNG
+/*! \internal
+ * Reads the header of a PNG file and sets the transformations.
+ * Only trivially destructible objects are used since libpng jumps back here on errors.
+ * \param[in]	png_ptr	the reader
+ * \param[in]	info_ptr	the info of the reader
+ * \param[in]	fp	the file, whose magic number was already read
+ * \param[out]	red	the type of image, the number of channels and the colors of b&w images
+ * \param[out]	width	the width of the image
+ * \param[out]	height	the height of the image
+ * \param[out]	passes	the number of passes needed to decode the image
+ * \return	false if libpng failed
+ */
+static bool png_read_header(png_structp png_ptr, png_infop info_ptr, FILE *fp, RowReducer &red, png_uint_32 &width, png_uint_32 &height, int &passes)
+{
+	if (setjmp(png_jmpbuf(png_ptr)))
+		return false;
 
 	/* setup libpng for using standard C fread() function with our FILE pointer */
-	png_init_io(png_ptr, fp.get());
+	png_init_io(png_ptr, fp);
 	/* tell libpng that we have already read the magic number */
-	png_set_sig_bytes(png_ptr, sizeof(magic));
+	png_set_sig_bytes(png_ptr, 8);
 
 	/* Read informations */
 	png_read_info(png_ptr, info_ptr);
-	png_uint_32 width, height;
 	int bit_depth, color_type, interlace_type, compression_type, filter_method;
-	bool modified = false;
 	png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, &compression_type, &filter_method);
 
-	ColorType read_type(RGB);
-
-	auto col0 = pixel::BWBlack;
-	auto col1 = pixel::BWWhite;
+	red.type = RGB;
+	red.col0 = pixel::BWBlack;
+	red.col1 = pixel::BWWhite;
 	if (bit_depth == 1)
 	{ // binary image
 		png_set_packing(png_ptr);
-		modified = true;
-		read_type = BW;
+		red.type = BW;
 		if (png_get_valid(png_ptr, info_ptr, PNG_INFO_PLTE))
 		{ // has a palette -_-
 			// we convert it to black & white
@@ -148,8 +327,8 @@ static std::pair<UImage, String> load_libpng(const Path &filename)
 				int m1 = pal[1].red + pal[1].green + pal[1].blue;
 				if (m1 < m0) // color 1 is darker than color 0
 				{
-					col0 = pixel::BWWhite;
-					col1 = pixel::BWBlack;
+					red.col0 = pixel::BWWhite;
+					red.col1 = pixel::BWBlack;
 				}
 			}
 		}
@@ -157,138 +336,138 @@ static std::pair<UImage, String> load_libpng(const Path &filename)
 	else if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
 	{ // Grayscale image
 		if (bit_depth < 8)
-		{
 			png_set_expand_gray_1_2_4_to_8(png_ptr);
-			modified = true;
-		}
-		read_type = GRAY;
+		red.type = GRAY;
 	}
 	else if (color_type == PNG_COLOR_TYPE_PALETTE)
 	{ // Changes palletted image to RGB
 		png_set_palette_to_rgb(png_ptr);  // Just an alias of png_set_expand()
-		modified = true;
 	}
 	// Transform 16 bits samples to 8 bits samples
 	if (bit_depth == 16)
-	{
 		png_set_strip_16(png_ptr);
-		modified = true;
-	}
 	// Remove alpha channel
 	if (color_type & PNG_COLOR_MASK_ALPHA)
-	{
 		png_set_strip_alpha(png_ptr);
-		modified = true;
-	}
+	// Interlaced images are decoded in several passes over the whole image
+	passes = png_set_interlace_handling(png_ptr);
 
-	// If any of the above were applied,
-	if (modified)
-	{
-		// After setting the transformations, libpng can update your png_info structure to reflect any transformations
-		// you've requested with this call. This is most useful to update the info structure's rowbytes field so you can
-		// use it to allocate your image memory. This function will also update your palette with the correct screen_gamma
-		// and background if these have been given with the calls above.
-		png_read_update_info(png_ptr, info_ptr);
+	// Update the info structure to reflect the transformations, so that rowbytes and channels are right
+	png_read_update_info(png_ptr, info_ptr);
+	red.channels = size_t(png_get_channels(png_ptr, info_ptr));
+	return true;
+}
+
+/*! \internal
+ * Decodes the pixels of a PNG file.
+ * Only trivially destructible objects are used since libpng jumps back here on errors.
+ * \param[in]	png_ptr	the reader
+ * \param[in]	info_ptr	the info of the reader
+ * \param[in]	red	the reducer that stores the rows in the image
+ * \param[in]	height	the height of the image
+ * \param[in]	rows	height pointers to the rows of an image buffer for interlaced images, or one pointer to a row buffer
+ * \param[in]	interlaced	is the whole image decoded before any row is complete?
+ * \return	false if libpng failed
+ */
+static bool png_read_pixels(png_structp png_ptr, png_infop info_ptr, RowReducer &red, size_t height, png_bytep *rows, bool interlaced)
+{
+	if (setjmp(png_jmpbuf(png_ptr)))
+		return false;
 
-		// Just in case any of these have changed
-		png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, NULL, NULL);
+	if (interlaced)
+	{ // the whole image must be decoded before any row is complete
+		png_read_image(png_ptr, rows);
+		for (auto y = red.reg.top; y <= red.reg.bottom; ++y)
+			red.AddRow(y, rows[y]);
+		png_read_end(png_ptr, NULL);
 	}
+	else
+	{ // only one row is stored at a time and the decoding stops after the last row of the region
+		for (auto y = size_t(0); y <= red.reg.bottom; ++y)
+		{
+			png_read_row(png_ptr, rows[0], NULL);
+			red.AddRow(y, rows[0]);
+		}
+		if (red.reg.bottom + 1 == height)
+			png_read_end(png_ptr, NULL);
+	}
+	return true;
+}
 
-	int channels = png_get_channels(png_ptr, info_ptr);
+/*! \internal
+ * Decodes a PNG file row by row directly in the image, keeping only the rows and columns in a region
+ * cf http://www.libpng.org/pub/png/libpng-1.2.5-manual.html
+ * The libpng calls are made in functions with no objects to destroy, since libpng reports errors with longjmp.
+ */
+static std::pair<UImage, String> load_libpng(const Path &filename, const Rect &roi, size_t reduction)
+{
+	// libpng does not support URIs
+	auto fname = filename;
+	fname.ToLocal();
+
+	/* open image file */
+	std::unique_ptr<FILE, decltype(fclose_if_not_null)*> fp(fopen(fname.CStr(), "rb"), fclose_if_not_null);
+	if (!fp)
+		return std::make_pair(UImage{}, String(_("Cannot open file ")) + fname);
+
+	/* read magic number */
+	png_byte magic[8];
+	size_t readsize = fread(magic, 1, sizeof(magic), fp.get());
+	if (!readsize)
+		return std::make_pair(UImage{}, String(U"Empty file."));
+
+	/* check for valid magic number */
+	if (png_sig_cmp(magic, 0, sizeof(magic)))
+		return std::make_pair(UImage{}, String(U"Not a PNG file."));
 
-	png_bytepp row_pointers;
 
-	/* we can now allocate memory for storing pixel data */
-	row_pointers = (png_bytep*)malloc(sizeof(png_byte*) * height);
-	for (size_t i = 0; i < height ; ++i)
+	/* create a png read struct */
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png_ptr)
+		return std::make_pair(UImage{}, String(_("Cannot create PNG reader.")));
+
+	/* create a png info struct */
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	if (!info_ptr)
 	{
-#if (PNG_LIBPNG_VER > 10300)
-		row_pointers[i] = (png_bytep)malloc(png_get_rowbytes(png_ptr, info_ptr));
-#else
-		row_pointers[i] = (png_bytep)malloc(info_ptr->rowbytes);
-#endif
+		png_destroy_read_struct(&png_ptr, NULL, NULL);
+		return std::make_pair(UImage{}, String(_("Cannot create PNG info.")));
 	}
-	/* Read PNG file */
-	png_read_image(png_ptr, row_pointers);
 
-	/* Conversion */
-	UImage img;
-	switch (read_type)
+	auto red = RowReducer{};
+	png_uint_32 width = 0, height = 0;
+	int passes = 1;
+	if (!png_read_header(png_ptr, info_ptr, fp.get(), red, width, height, passes))
 	{
-		case RGB:
-			{
-				auto irgb = std::make_unique<ImageRGB>(size_t(width), size_t(height));
-				for (size_t y = 0; y < height; y++)
-					for (size_t x = 0; x < width; x++)
-					{
-						png_byte *pixel = &((row_pointers[y])[x*channels]);
-						irgb->At(x, y) = {pixel[0], pixel[1], pixel[2]};
-					}
-				img = std::move(irgb);
-			}
-			break;
-		case GRAY:
-			{
-				auto ig = std::make_unique<ImageGray>(size_t(width), size_t(height));
-				for (size_t y = 0; y < height; y++)
-					for (size_t x = 0; x < width; x++)
-					{
-						png_byte *pixel = &((row_pointers[y])[x]);
-						ig->At(x, y) = *pixel;
-					}
-				img = std::move(ig);
-			}
-			break;
-		case BW:
-			{
-				auto ibw = std::make_unique<ImageBW>(size_t(width), size_t(height));
-				for (size_t y = 0; y < height; y++)
-					for (size_t x = 0; x < width; x++)
-					{
-						png_byte *pixel = &((row_pointers[y])[x]);
-						ibw->At(x, y) = (*pixel) ? col1 : col0;
-					}
-				img = std::move(ibw);
-			}
-			break;
-	}
-
-	/* read metadata */
-/*
-	png_textp txt;
-	int nb = png_get_text(png_ptr, info_ptr, &txt, NULL);
-	CRNVerbose(nb);
-	for (int tmp = 0; tmp < nb; ++tmp)
-	{
-		String s(U"compression: ");
-		s += txt[tmp].compression;
-		s += U"\nkey: ";
-		s += txt[tmp].key;
-		s += U"\ntext: ";
-		s += txt[tmp].text;
-		s += U"\ntext length: ";
-		s += txt[tmp].text_length;
-#ifdef PNG_iTXt_SUPPORTED // not supported in 1.2 branch
-		s += U"\ni text length: ";
-		s += txt[tmp].itxt_length;
-		s += U"\nlang: "
-		s += txt[tmp].lang;
-		s += U"\nlang key: "
-		s += txt[tmp].lang_key;
-#endif
-		CRNVerbose(s);
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		return std::make_pair(UImage{}, String(_("Error while reading the PNG file ")) + fname);
 	}
-*/
-
-	/* finish decompression and release memory */
-	png_read_end(png_ptr, NULL);
-	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-	for (size_t i = 0; i < height ; ++i)
+	if (!make_region(roi, width, height, 1, reduction, red.reg))
 	{
-		free(row_pointers[i]);
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		return std::make_pair(UImage{}, String(_("The region is outside the image.")));
 	}
-	free(row_pointers);
+#if (PNG_LIBPNG_VER > 10300)
+	const auto rowbytes = size_t(png_get_rowbytes(png_ptr, info_ptr));
+#else
+	const auto rowbytes = size_t(info_ptr->rowbytes);
+#endif
 
+	auto img = make_reduced_image(red);
+	auto acc = std::vector<unsigned int>(3 * red.reg.GetWidth(), 0);
+	red.acc = acc.data();
+	const auto interlaced = passes > 1;
+	auto buffer = std::vector<png_byte>(interlaced ? rowbytes * height : rowbytes);
+	auto rows = std::vector<png_bytep>(interlaced ? height : 1);
+	for (size_t y = 0; y < rows.size(); ++y)
+		rows[y] = buffer.data() + y * rowbytes;
+	const auto ok = png_read_pixels(png_ptr, info_ptr, red, height, rows.data(), interlaced);
+
+	/* release memory */
+	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+	if (!ok)
+		return std::make_pair(UImage{}, String(_("Error while reading the PNG file ")) + fname);
 	return std::make_pair(std::move(img), String(U""));
 }
 #endif
@@ -311,7 +490,11 @@ void crn_jpeg_error_exit(j_common_ptr cinfo)
   longjmp(myerr->setjmp_buffer, 1);
 }
 
-static std::pair<UImage, String> load_libjpeg(const Path &filename)
+/*! \internal
+ * Decodes a JPEG file directly in the image, keeping only the rows and columns in a region
+ * The reduction is done by libjpeg in the DCT domain, so the full resolution image is never decoded.
+ */
+static std::pair<UImage, String> load_libjpeg(const Path &filename, const Rect &roi, size_t reduction)
 {
 	// libjpeg does not support URIs
 	auto fname(filename);
@@ -326,6 +509,9 @@ static std::pair<UImage, String> load_libjpeg(const Path &filename)
 	struct crn_jpeg_error_mgr jerr;
 	cinfo.err = jpeg_std_error(&jerr.pub);
 	jerr.pub.error_exit = crn_jpeg_error_exit;
+	// objects that must be released when libjpeg jumps back here
+	UImageRGB irgb;
+	UImageGray ig;
 	if (setjmp(jerr.setjmp_buffer))
 	{
 		jpeg_destroy_decompress(&cinfo);
@@ -336,12 +522,18 @@ static std::pair<UImage, String> load_libjpeg(const Path &filename)
 		jpeg_create_decompress(&cinfo);
 		jpeg_stdio_src(&cinfo, fp.get());
 		jpeg_read_header(&cinfo, TRUE);
+		cinfo.scale_num = 1;
+		cinfo.scale_denom = (unsigned int)reduction;
 		jpeg_start_decompress(&cinfo);
-		int w = cinfo.output_width;
-		int h = cinfo.output_height;
-		int bpp = cinfo.out_color_components;
-		UImageRGB irgb;
-		UImageGray ig;
+		auto reg = DecodeRegion{};
+		if (!make_region(roi, cinfo.output_width, cinfo.output_height, reduction, 1, reg))
+		{
+			jpeg_destroy_decompress(&cinfo);
+			return std::make_pair(UImage{}, String(_("The region is outside the image.")));
+		}
+		const auto w = reg.GetWidth();
+		const auto h = reg.GetHeight();
+		const auto bpp = size_t(cinfo.out_color_components);
 		if (bpp == 3)
 		{
 			irgb = std::make_unique<ImageRGB>(w, h);
@@ -352,34 +544,38 @@ static std::pair<UImage, String> load_libjpeg(const Path &filename)
 		}
 		else
 		{
-			jpeg_finish_decompress(&cinfo);
 			jpeg_destroy_decompress(&cinfo);
 			return std::make_pair(UImage{}, String(_("JPEG file contains unnatural bytes per pixel count.")));
 		}
-		JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr) &cinfo, JPOOL_IMAGE, w * bpp, 1);
-		int y = 0;
-		while (cinfo.output_scanline < cinfo.output_height)
+		JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr) &cinfo, JPOOL_IMAGE, JDIMENSION(cinfo.output_width * bpp), 1);
+		while (cinfo.output_scanline <= reg.bottom)
 		{
+			const auto y = size_t(cinfo.output_scanline);
 			(void) jpeg_read_scanlines(&cinfo, buffer, 1);
-			for (int x = 0; x < w; ++x)
+			if (y < reg.top)
+				continue;
+			if (bpp == 3)
 			{
-				if (bpp == 3)
-				{
-					irgb->At(x, y) = { buffer[0][3 * x], buffer[0][3 * x + 1], buffer[0][3 * x + 2] };
-				}
-				else
+				for (size_t x = 0; x < w; ++x)
 				{
-					ig->At(x, y) = buffer[0][x];
+					const auto *pixel = buffer[0] + 3 * (reg.left + x);
+					irgb->At(x, y - reg.top) = { pixel[0], pixel[1], pixel[2] };
 				}
 			}
-			y += 1;
+			else
+			{
+				std::copy_n(buffer[0] + reg.left, w, ig->GetPixels() + (y - reg.top) * w);
+			}
 		}
 
 		// read comments
 		// TODO
 		// jpeg_read_header() then cinfo->marker_list (linked list)
 
-		jpeg_finish_decompress(&cinfo);
+		if (cinfo.output_scanline < cinfo.output_height)
+			jpeg_abort_decompress(&cinfo); // the rows after the region are not decoded
+		else
+			jpeg_finish_decompress(&cinfo);
 		jpeg_destroy_decompress(&cinfo);
 		if (bpp == 3)
 			return std::make_pair(std::move(irgb), String(U""));
@@ -607,10 +803,35 @@ static std::pair<UImage, String> load_gdiplus(const Path &filename)
  * \return	a pointer on an image
  */
 UImage crn::NewImageFromFile(const Path &fname)
+{
+	return NewImageFromFile(fname, Rect{}, 1);
+}
+
+/*! \brief Loads a region of an image from a file, possibly at a reduced resolution
+ *
+ * PNG files are decoded row by row and the decoding stops after the last row of the region.
+ * JPEG files are reduced in the DCT domain, so the full resolution image is never decoded.
+ * Other formats are fully decoded and then cropped.
+ * The reduction averages the pixels (box filter), except for b&w images where a pixel is black if any of the pixels it covers is black, so that thin strokes are kept.
+ *
+ * The image has about roi.w / reduction × roi.h / reduction pixels (the region is aligned on the reduced grid).
+ *
+ * \throws	ExceptionInvalidArgument	null file name
+ * \throws	ExceptionDomain	reduction is not 1, 2, 4 or 8
+ * \throws	ExceptionIO	no decoder found or the region is outside the image
+ * \param[in]	fname	full path to the image file
+ * \param[in]	roi	the region to load in full resolution coordinates (clipped to the image), or an invalid rectangle to load the whole image
+ * \param[in]	reduction	the image is loaded at 1/reduction of its resolution
+ * \return	a pointer on an image
+ */
+UImage crn::NewImageFromFile(const Path &fname, const Rect &roi, size_t reduction)
 {
 	if (!fname)
-		throw ExceptionInvalidArgument(StringUTF8("UImage NewImageFromFile(const Path &fname): ") +
+		throw ExceptionInvalidArgument(StringUTF8("UImage NewImageFromFile(const Path &fname, const Rect &roi, size_t reduction): ") +
 				_("Null file name."));
+	if ((reduction != 1) && (reduction != 2) && (reduction != 4) && (reduction != 8))
+		throw ExceptionDomain(StringUTF8("UImage NewImageFromFile(const Path &fname, const Rect &roi, size_t reduction): ") +
+				_("The reduction must be 1, 2, 4 or 8."));
 
 	std::lock_guard<std::mutex> lock(crn::FileShield::GetMutex(fname)); // lock the file
 
@@ -619,37 +840,94 @@ UImage crn::NewImageFromFile(const Path &fname)
 #ifdef CRN_USING_LIBPNG
 	if (res.first.get() == nullptr)
 	{
-		res = load_libpng(fname);
+		res = load_libpng(fname, roi, reduction);
 		errors += U" " + res.second;
 	}
 #endif // CRN_USING_LIBPNG
 #ifdef CRN_USING_LIBJPEG
 	if (res.first.get() == nullptr)
 	{
-		res = load_libjpeg(fname);
+		res = load_libjpeg(fname, roi, reduction);
 		errors += U" " + res.second;
 	}
 #endif // CRN_USING_LIBJPEG
 #ifdef CRN_USING_GDIPLUS
 	if (res.first == NULL)
 	{
-		res = load_gdiplus(fname);
+		res = reduce_image(load_gdiplus(fname), roi, reduction);
 		errors += U" " + res.second;
 	}
 #endif // CRN_USING_GDIPLUS
 #ifdef CRN_USING_GDKPB
 	if (res.first.get() == nullptr)
 	{
-		res = load_gdkpixbuf(fname);
+		res = reduce_image(load_gdkpixbuf(fname), roi, reduction);
 		errors += U" " + res.second;
 	}
 #endif // CRN_USING_GDKPB
 	if (res.first.get() == nullptr)
-		throw ExceptionIO(StringUTF8("UImage NewImageFromFile(const Path &fname): ") +
+		throw ExceptionIO(StringUTF8("UImage NewImageFromFile(const Path &fname, const Rect &roi, size_t reduction): ") +
 			_("No decoder could open the file ") + StringUTF8{ fname } + "\n" + errors.CStr());
 	return std::move(res.first);
 }
 
+/*! \brief Reads the dimensions of an image without decoding it
+ *
+ * Only the header of PNG and JPEG files is read. Other formats are fully decoded.
+ *
+ * \throws	ExceptionInvalidArgument	null file name
+ * \throws	ExceptionIO	no decoder found
+ * \param[in]	fname	full path to the image file
+ * \return	the width and height of the image
+ */
+std::pair<size_t, size_t> crn::GetImageFileSize(const Path &fname)
+{
+	if (!fname)
+		throw ExceptionInvalidArgument(StringUTF8("std::pair<size_t, size_t> GetImageFileSize(const Path &fname): ") +
+				_("Null file name."));
+	{
+		std::lock_guard<std::mutex> lock(crn::FileShield::GetMutex(fname)); // lock the file
+		auto lname = fname;
+		lname.ToLocal();
+		std::unique_ptr<FILE, decltype(fclose_if_not_null)*> fp(fopen(lname.CStr(), "rb"), fclose_if_not_null);
+		if (fp)
+		{
+			// PNG: the signature is followed by the IHDR chunk that starts with the big endian width and height
+			static const uint8_t png_magic[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+			uint8_t header[24];
+			if ((fread(header, 1, sizeof(header), fp.get()) == sizeof(header)) &&
+					std::equal(std::begin(png_magic), std::end(png_magic), header) &&
+					std::equal(header + 12, header + 16, "IHDR"))
+			{
+				auto read32 = [](const uint8_t *b) { return (size_t(b[0]) << 24) | (size_t(b[1]) << 16) | (size_t(b[2]) << 8) | size_t(b[3]); };
+				return std::make_pair(read32(header + 16), read32(header + 20));
+			}
+#ifdef CRN_USING_LIBJPEG
+			rewind(fp.get());
+			struct jpeg_decompress_struct cinfo;
+			struct crn_jpeg_error_mgr jerr;
+			cinfo.err = jpeg_std_error(&jerr.pub);
+			jerr.pub.error_exit = crn_jpeg_error_exit;
+			if (setjmp(jerr.setjmp_buffer))
+			{ // not a JPEG file
+				jpeg_destroy_decompress(&cinfo);
+			}
+			else
+			{
+				jpeg_create_decompress(&cinfo);
+				jpeg_stdio_src(&cinfo, fp.get());
+				jpeg_read_header(&cinfo, TRUE);
+				const auto size = std::make_pair(size_t(cinfo.image_width), size_t(cinfo.image_height));
+				jpeg_destroy_decompress(&cinfo);
+				return size;
+			}
+#endif // CRN_USING_LIBJPEG
+		}
+	}
+	const auto img = NewImageFromFile(fname);
+	return std::make_pair(img->GetWidth(), img->GetHeight());
+}
+
 /*! Loads an image from a file and converts it if necessary
  * \throws	ExceptionInvalidArgument	null file name
  * \throws	ExceptionIO	no decoder found
@@ -712,3 +990,281 @@ UImageBW crn::NewImageBWFromFile(const Path &fname)
 		return std::unique_ptr<ImageBW>(static_cast<ImageBW*>(img.release()));
 	throw ExceptionDomain("NewImageBWFromFile(): "_s + _("unknown image format."));
 }
+
+/*! Decomposes a convolution matrix into the outer product of a column vector and a row vector, if possible.
+ * \param[in]	mat	the convolution matrix
+ * \param[out]	vkernel	the column (vertical) kernel
+ * \param[out]	hkernel	the row (horizontal) kernel
+ * \return	true if the matrix is of rank 1 (up to a relative tolerance), false else
+ */
+bool crn::impl::SeparateKernel(const MatrixDouble &mat, std::vector<double> &vkernel, std::vector<double> &hkernel)
+{
+	// pivot = largest absolute value
+	auto pr = size_t(0), pc = size_t(0);
+	auto pivot = 0.0;
+	for (size_t r = 0; r < mat.GetRows(); ++r)
+		for (size_t c = 0; c < mat.GetCols(); ++c)
+			if (Abs(mat[r][c]) > Abs(pivot))
+			{
+				pivot = mat[r][c];
+				pr = r;
+				pc = c;
+			}
+	if (pivot == 0.0)
+		return false;
+	vkernel.resize(mat.GetRows());
+	for (size_t r = 0; r < mat.GetRows(); ++r)
+		vkernel[r] = mat[r][pc];
+	hkernel.resize(mat.GetCols());
+	for (size_t c = 0; c < mat.GetCols(); ++c)
+		hkernel[c] = mat[pr][c] / pivot;
+	const auto tolerance = Abs(pivot) * 1e-9;
+	for (size_t r = 0; r < mat.GetRows(); ++r)
+		for (size_t c = 0; c < mat.GetCols(); ++c)
+			if (Abs(mat[r][c] - vkernel[r] * hkernel[c]) > tolerance)
+				return false;
+	return true;
+}
+
+/*! Computes the resampling coefficients along one axis
+ * \throws	ExceptionDomain	null size
+ * \throws	ExceptionInvalidArgument	unknown filter
+ * \param[in]	insize	the number of source samples
+ * \param[in]	outsize	the number of output samples
+ * \param[in]	filter	the resampling filter
+ */
+crn::impl::ResamplingTable::ResamplingTable(size_t insize, size_t outsize, Resampling filter):
+	taps(0),
+	first(outsize, 0),
+	count(outsize, 0)
+{
+	if (!insize || !outsize)
+		throw ExceptionDomain("ResamplingTable::ResamplingTable(): "_s + _("null size."));
+	const auto step = double(insize) / double(outsize);
+	auto lists = std::vector<std::vector<double>>(outsize);
+	if (filter == Resampling::AREA)
+	{ // mean of the covered samples when reducing, linear interpolation when enlarging
+		for (size_t o = 0; o < outsize; ++o)
+		{
+			const auto min = size_t(double(o) * step);
+			const auto coeffmin = 1 - (double(o) * step - double(min));
+			auto max = size_t(double(o + 1) * step);
+			auto coeffmax = double(o + 1) * step - double(max);
+			if (step < 1.0)
+			{
+				max = min + 1;
+				coeffmax = 1 - coeffmin;
+			}
+			if (max >= insize)
+				coeffmax = 0;
+			first[o] = min;
+			lists[o].push_back(coeffmin);
+			for (auto k = min + 1; k < max; ++k)
+				lists[o].push_back(1);
+			if (coeffmax)
+				lists[o].push_back(coeffmax);
+		}
+	}
+	else
+	{ // the filter is stretched when reducing, so that it covers all the source samples
+		auto kernel = std::function<double(double)>{};
+		auto support = 0.0;
+		switch (filter)
+		{
+			case Resampling::BOX:
+				support = 0.5;
+				kernel = [](double x) { return ((x >= -0.5) && (x < 0.5)) ? 1.0 : 0.0; };
+				break;
+			case Resampling::BILINEAR:
+				support = 1.0;
+				kernel = [](double x) { x = Abs(x); return (x < 1.0) ? 1.0 - x : 0.0; };
+				break;
+			case Resampling::BICUBIC:
+				support = 2.0;
+				kernel = [](double x)
+					{
+						const auto a = -0.5;
+						x = Abs(x);
+						if (x < 1.0)
+							return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+						if (x < 2.0)
+							return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+						return 0.0;
+					};
+				break;
+			case Resampling::LANCZOS:
+				support = 3.0;
+				kernel = [](double x)
+					{
+						if (x == 0.0)
+							return 1.0;
+						if ((x <= -3.0) || (x >= 3.0))
+							return 0.0;
+						const auto px = M_PI * x;
+						return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+					};
+				break;
+			default:
+				throw ExceptionInvalidArgument("ResamplingTable::ResamplingTable(): "_s + _("unknown filter."));
+		}
+		const auto scale = Max(step, 1.0);
+		const auto halfwidth = support * scale;
+		for (size_t o = 0; o < outsize; ++o)
+		{
+			const auto center = (double(o) + 0.5) * step;
+			const auto b = size_t(Max(0.0, floor(center - halfwidth + 0.5)));
+			const auto e = Min(insize, size_t(Max(0.0, floor(center + halfwidth + 0.5))));
+			first[o] = b;
+			for (auto x = b; x < e; ++x)
+				lists[o].push_back(kernel((double(x) + 0.5 - center) / scale));
+		}
+	}
+
+	for (size_t o = 0; o < outsize; ++o)
+	{
+		auto &l = lists[o];
+		auto sum = 0.0;
+		for (auto w : l)
+			sum += w;
+		if (sum == 0.0)
+		{ // no source sample under the filter: nearest neighbour
+			first[o] = Min(size_t((double(o) + 0.5) * step), insize - 1);
+			l.assign(1, 1.0);
+			sum = 1.0;
+		}
+		for (auto &w : l)
+			w /= sum;
+		count[o] = l.size();
+		taps = Max(taps, l.size());
+	}
+
+	const auto one = int32_t(1) << FixedPointBits;
+	weights.resize(outsize * taps, 0.0);
+	fixed.resize(outsize * taps, 0);
+	for (size_t o = 0; o < outsize; ++o)
+	{
+		auto sum = int32_t(0);
+		auto pivot = size_t(0);
+		for (size_t t = 0; t < count[o]; ++t)
+		{
+			weights[o * taps + t] = lists[o][t];
+			fixed[o * taps + t] = int32_t(floor(lists[o][t] * one + 0.5));
+			sum += fixed[o * taps + t];
+			if (Abs(lists[o][t]) > Abs(lists[o][pivot]))
+				pivot = t;
+		}
+		// rounding errors are given to the largest weight, so that flat areas are preserved
+		fixed[o * taps + pivot] += one - sum;
+	}
+}
+
+namespace
+{
+	inline uint8_t get_channel(uint8_t p, size_t) noexcept { return p; }
+	inline void set_channel(uint8_t &p, size_t, uint8_t v) noexcept { p = v; }
+	inline uint8_t get_channel(const pixel::RGB<uint8_t> &p, size_t c) noexcept { return c == 0 ? p.r : (c == 1 ? p.g : p.b); }
+	inline void set_channel(pixel::RGB<uint8_t> &p, size_t c, uint8_t v) noexcept
+	{
+		if (c == 0)
+			p.r = v;
+		else if (c == 1)
+			p.g = v;
+		else
+			p.b = v;
+	}
+
+	/*! Rounds a fixed point accumulator (that includes the rounding bias) to 8 bits */
+	inline uint8_t fixed_to_byte(int32_t acc) noexcept
+	{
+		return uint8_t(Cap(acc >> impl::ResamplingTable::FixedPointBits, int32_t(0), int32_t(255)));
+	}
+
+	/*! Resamples 8 bits pixels of N channels with 32 bits integer accumulators. The inner loops are along contiguous rows, so that the compiler can vectorize them. */
+	template<size_t N, typename P> void resample_fixed(std::vector<P> &pixels, size_t w, size_t h, size_t nw, size_t nh, Resampling filter)
+	{
+		const auto half = int32_t(1) << (impl::ResamplingTable::FixedPointBits - 1);
+		auto hbuf = std::vector<P>{};
+		if (nw != w)
+		{
+			const auto tab = impl::ResamplingTable(w, nw, filter);
+			hbuf.resize(nw * h);
+			ParallelFor(0, h, [&pixels, &hbuf, &tab, half, w, nw](size_t b, size_t e)
+				{
+					for (auto y = b; y < e; ++y)
+					{
+						const auto *src = pixels.data() + y * w;
+						auto *dst = hbuf.data() + y * nw;
+						for (size_t x = 0; x < nw; ++x)
+						{
+							const auto *s = src + tab.first[x];
+							const auto *k = tab.fixed.data() + x * tab.taps;
+							int32_t acc[N];
+							for (size_t c = 0; c < N; ++c)
+								acc[c] = half;
+							for (size_t t = 0; t < tab.count[x]; ++t)
+								for (size_t c = 0; c < N; ++c)
+									acc[c] += k[t] * get_channel(s[t], c);
+							for (size_t c = 0; c < N; ++c)
+								set_channel(dst[x], c, fixed_to_byte(acc[c]));
+						}
+					}
+				}, 0, Max(size_t(1), impl::ParallelPixelGrain / nw));
+		}
+		else
+			hbuf.swap(pixels);
+
+		if (nh != h)
+		{
+			const auto tab = impl::ResamplingTable(h, nh, filter);
+			pixels = std::vector<P>(nw * nh);
+			ParallelFor(0, nh, [&pixels, &hbuf, &tab, half, nw](size_t b, size_t e)
+				{
+					auto acc = std::vector<int32_t>(N * nw);
+					for (auto y = b; y < e; ++y)
+					{
+						std::fill(acc.begin(), acc.end(), half);
+						for (size_t t = 0; t < tab.count[y]; ++t)
+						{
+							const auto k = tab.fixed[y * tab.taps + t];
+							const auto *row = hbuf.data() + (tab.first[y] + t) * nw;
+							for (size_t x = 0; x < nw; ++x)
+								for (size_t c = 0; c < N; ++c)
+									acc[x * N + c] += k * get_channel(row[x], c);
+						}
+						auto *dst = pixels.data() + y * nw;
+						for (size_t x = 0; x < nw; ++x)
+							for (size_t c = 0; c < N; ++c)
+								set_channel(dst[x], c, fixed_to_byte(acc[x * N + c]));
+					}
+				}, 0, Max(size_t(1), impl::ParallelPixelGrain / nw));
+		}
+		else
+			pixels.swap(hbuf);
+	}
+}
+
+/*! Resamples 8 bits gray pixels with fixed point arithmetics
+ * \param[in,out]	pixels	the pixels
+ * \param[in]	w	the width of the source
+ * \param[in]	h	the height of the source
+ * \param[in]	nw	the width of the result
+ * \param[in]	nh	the height of the result
+ * \param[in]	filter	the resampling filter
+ */
+void crn::impl::Resample(std::vector<uint8_t> &pixels, size_t w, size_t h, size_t nw, size_t nh, Resampling filter)
+{
+	resample_fixed<1>(pixels, w, h, nw, nh, filter);
+}
+
+/*! Resamples 8 bits RGB pixels with fixed point arithmetics
+ * \param[in,out]	pixels	the pixels
+ * \param[in]	w	the width of the source
+ * \param[in]	h	the height of the source
+ * \param[in]	nw	the width of the result
+ * \param[in]	nh	the height of the result
+ * \param[in]	filter	the resampling filter
+ */
+void crn::impl::Resample(std::vector<pixel::RGB<uint8_t>> &pixels, size_t w, size_t h, size_t nw, size_t nh, Resampling filter)
+{
+	resample_fixed<3>(pixels, w, h, nw, nh, filter);
+}
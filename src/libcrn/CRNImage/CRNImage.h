@@ -26,8 +26,10 @@
 #include <CRNException.h>
 #include <CRNString.h>
 #include <CRNImage/CRNSummedAreaTable.h>
+#include <CRNUtils/CRNThreadPool.h>
 #include <vector>
 #include <type_traits>
+#include <limits>
 
 namespace crn
 {
@@ -42,6 +44,24 @@ namespace crn
 	class Path;
 	class Point2DInt;
 
+	/*! \brief Filters used to resample images */
+	enum class Resampling
+	{
+		AREA, /*!< mean of the covered area when reducing, linear interpolation when enlarging */
+		BOX, /*!< box filter (nearest neighbour when enlarging) */
+		BILINEAR, /*!< triangle filter */
+		BICUBIC, /*!< Keys cubic filter (a = -0.5) */
+		LANCZOS /*!< Lanczos filter with 3 lobes */
+	};
+
+	/*! \brief Interpolations used to sample images at fractional positions */
+	enum class Interpolation
+	{
+		NEAREST, /*!< nearest pixel */
+		BILINEAR, /*!< linear interpolation of the 4 neighbouring pixels */
+		BICUBIC /*!< Keys cubic interpolation (a = -0.5) of the 16 neighbouring pixels */
+	};
+
 	/*! \brief Base class for images */
 	class ImageBase
 	{
@@ -82,7 +102,7 @@ namespace crn
 			 *************************************************************************************/
 
 			/*! \brief Scales the image */
-			virtual void ScaleToSize(size_t w, size_t h) = 0;
+			virtual void ScaleToSize(size_t w, size_t h, Resampling filter = Resampling::AREA) = 0;
 
 			/**************************************************************************************
 			 * Transformation
@@ -108,6 +128,10 @@ namespace crn
 	class Path;
 	/*! \brief Loads an image from a file */
 	UImage NewImageFromFile(const Path &fname);
+	/*! \brief Loads a region of an image from a file, possibly at a reduced resolution */
+	UImage NewImageFromFile(const Path &fname, const Rect &roi, size_t reduction = 1);
+	/*! \brief Reads the dimensions of an image without decoding it */
+	std::pair<size_t, size_t> GetImageFileSize(const Path &fname);
 	
 	/*! \internal */
 	template<typename T> struct BoolNotBool
@@ -272,7 +296,7 @@ namespace crn
 			void DrawLine(size_t x1, size_t y1, size_t x2, size_t y2, pixel_type color);
 
 			/*! \brief Scales the image */
-			virtual void ScaleToSize(size_t w, size_t h) override;
+			virtual void ScaleToSize(size_t w, size_t h, Resampling filter = Resampling::AREA) override;
 
 			/*! \brief Flips the image */
 			void Flip(const Orientation &ori);
@@ -285,9 +309,15 @@ namespace crn
 			template<typename CMP = std::less<pixel_type>> void FastDilate(size_t halfwin, size_t index = 0, CMP cmp = std::less<pixel_type>{});
 			/*! \brief Morphological erosion */
 			template<typename CMP = std::less<pixel_type>> void FastErode(size_t halfwin, size_t index = 0, CMP cmp = std::less<pixel_type>{});
+			/*! \brief Morphological dilatation with a rectangular structuring element */
+			template<typename CMP = std::less<pixel_type>> void DilateRect(size_t halfw, size_t halfh, CMP cmp = std::less<pixel_type>{});
+			/*! \brief Morphological erosion with a rectangular structuring element */
+			template<typename CMP = std::less<pixel_type>> void ErodeRect(size_t halfw, size_t halfh, CMP cmp = std::less<pixel_type>{});
 
 			/*! \brief Convolution */
 			void Convolve(const MatrixDouble &mat);
+			/*! \brief Convolution with a separable kernel */
+			void ConvolveSeparable(const std::vector<double> &hkernel, const std::vector<double> &vkernel);
 			/*! \brief Gaussian blur */
 			void GaussianBlur(double sigma);
 
@@ -332,6 +362,11 @@ namespace crn
 	/*! \brief Creates a rotated version of the image */
 	template<typename T> Image<T> Make270Rotation(const Image<T> &img);
 
+	/*! \brief Creates an image by applying an affine transform to an image */
+	template<typename T> Image<T> MakeAffineWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp = Interpolation::BILINEAR);
+	/*! \brief Creates an image by applying a projective transform to an image */
+	template<typename T> Image<T> MakeProjectiveWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp = Interpolation::BILINEAR);
+
 	template<typename T> inline auto Size(const Image<T> &img) noexcept(noexcept(img.Size())) -> decltype(img.Size()) { return img.Size(); }
 	/*@}*/
 } // namespace crn
@@ -428,6 +463,355 @@ namespace crn
 		return res;
 	}
 
+	/*************************************************************************************
+	 * Parallel execution
+	 ************************************************************************************/
+
+	namespace impl
+	{
+		/*! Minimal number of pixels processed by a thread. It is a multiple of the storage word of std::vector<bool>, so that two bands of an ImageBW never share a word. */
+		constexpr size_t ParallelPixelGrain = 4096;
+
+		/*! Processes bands of pixel indices in parallel. Safe for any pixel type.
+		 * \param[in]	npix	the number of pixels
+		 * \param[in]	fun	the function to call on each band [begin, end) of pixel indices
+		 */
+		template<typename FUNC> void ForEachPixelBand(size_t npix, FUNC &&fun)
+		{
+			ParallelFor(0, npix, std::forward<FUNC>(fun), 0, ParallelPixelGrain);
+		}
+
+		/*! Processes bands of rows in parallel. Images of booleans are processed serially, since two rows may share a storage word.
+		 * \param[in]	w	the width of the written image
+		 * \param[in]	h	the height of the written image
+		 * \param[in]	fun	the function to call on each band [begin, end) of rows
+		 */
+		template<typename T, typename FUNC> void ForEachRowBand(size_t w, size_t h, FUNC &&fun)
+		{
+			const auto nthreads = std::is_same<T, bool>::value ? size_t(1) : size_t(0);
+			ParallelFor(0, h, std::forward<FUNC>(fun), nthreads, Max(size_t(1), ParallelPixelGrain / Max(w, size_t(1))));
+		}
+
+		/*! Running extremum over a sliding window (van Herk/Gil-Werman), in three comparisons per element whatever the window size.
+		 *
+		 * The windows are clipped at both ends of the sequence.
+		 *
+		 * \param[in]	n	the length of the sequence
+		 * \param[in]	halfwin	the half size of the window (window size = 2*halfwin+1)
+		 * \param[in]	get	a function (size_t i) that returns the i-th element of the sequence
+		 * \param[in]	set	a function (size_t i, const V &v) that writes the i-th result
+		 * \param[in]	sel	a function (const V &a, const V &b) that returns the extremum of a and b
+		 * \param[in,out]	pre	a buffer of n elements (prefix extrema of each block)
+		 * \param[in,out]	suf	a buffer of n elements (suffix extrema of each block)
+		 */
+		template<typename V, typename GET, typename SET, typename SEL> void RunningExtremum(size_t n, size_t halfwin, GET get, SET set, SEL sel, std::vector<V> &pre, std::vector<V> &suf)
+		{
+			const auto k = 2 * halfwin + 1;
+			for (size_t i = 0; i < n; ++i)
+				pre[i] = (i % k == 0) ? V(get(i)) : V(sel(pre[i - 1], get(i)));
+			for (size_t i = n; i > 0; --i)
+			{
+				const auto j = i - 1;
+				suf[j] = ((j + 1 == n) || ((j + 1) % k == 0)) ? V(get(j)) : V(sel(suf[j + 1], get(j)));
+			}
+			for (size_t i = 0; i < n; ++i)
+			{
+				const auto a = (i >= halfwin) ? i - halfwin : 0;
+				const auto b = Min(i + halfwin, n - 1);
+				if (a / k != b / k)
+					set(i, V(sel(suf[a], pre[b])));
+				else if (a % k == 0)
+					set(i, V(pre[b]));
+				else
+					set(i, V(suf[a]));
+			}
+		}
+
+		/*! Replaces each pixel with the extremum of a rectangular window around it (clipped to the image), with a constant number of comparisons per pixel.
+		 * \param[in,out]	pixels	the pixels
+		 * \param[in]	w	the width of the image
+		 * \param[in]	h	the height of the image
+		 * \param[in]	halfw	the half width of the window
+		 * \param[in]	halfh	the half height of the window
+		 * \param[in]	sel	a function (const T &a, const T &b) that returns the extremum of a and b
+		 */
+		template<typename T, typename SEL> void RectExtremum(std::vector<T> &pixels, size_t w, size_t h, size_t halfw, size_t halfh, SEL sel)
+		{
+			if (!w || !h)
+				return;
+			if (halfw)
+				ForEachRowBand<T>(w, h, [&pixels, &sel, w, halfw](size_t by, size_t ey)
+					{
+						auto pre = std::vector<T>(w, pixels.front());
+						auto suf = std::vector<T>(w, pixels.front());
+						for (auto y = by; y < ey; ++y)
+						{
+							const auto offset = y * w;
+							RunningExtremum(w, halfw,
+									[&pixels, offset](size_t x) { return pixels[offset + x]; },
+									[&pixels, offset](size_t x, const T &v) { pixels[offset + x] = v; },
+									sel, pre, suf);
+						}
+					});
+			if (halfh)
+			{ // columns are processed by bands so that rows are read contiguously
+				const auto k = 2 * halfh + 1;
+				const auto nthreads = std::is_same<T, bool>::value ? size_t(1) : size_t(0);
+				ParallelFor(0, w, [&pixels, &sel, w, h, k, halfh](size_t bx, size_t ex)
+					{
+						const auto bw = ex - bx;
+						auto pre = std::vector<T>(bw * h, pixels.front());
+						auto suf = std::vector<T>(bw * h, pixels.front());
+						for (size_t y = 0; y < h; ++y)
+						{
+							const auto src = y * w + bx;
+							if (y % k == 0)
+								for (size_t x = 0; x < bw; ++x)
+									pre[y * bw + x] = pixels[src + x];
+							else
+								for (size_t x = 0; x < bw; ++x)
+									pre[y * bw + x] = sel(pre[(y - 1) * bw + x], pixels[src + x]);
+						}
+						for (auto y = h; y > 0; --y)
+						{
+							const auto src = (y - 1) * w + bx;
+							if ((y == h) || (y % k == 0))
+								for (size_t x = 0; x < bw; ++x)
+									suf[(y - 1) * bw + x] = pixels[src + x];
+							else
+								for (size_t x = 0; x < bw; ++x)
+									suf[(y - 1) * bw + x] = sel(suf[y * bw + x], pixels[src + x]);
+						}
+						for (size_t y = 0; y < h; ++y)
+						{
+							const auto a = (y >= halfh) ? y - halfh : 0;
+							const auto b = Min(y + halfh, h - 1);
+							const auto dst = y * w + bx;
+							if (a / k != b / k)
+								for (size_t x = 0; x < bw; ++x)
+									pixels[dst + x] = sel(suf[a * bw + x], pre[b * bw + x]);
+							else if (a % k == 0)
+								for (size_t x = 0; x < bw; ++x)
+									pixels[dst + x] = pre[b * bw + x];
+							else
+								for (size_t x = 0; x < bw; ++x)
+									pixels[dst + x] = suf[a * bw + x];
+						}
+					}, nthreads, 64);
+			}
+		}
+
+		/*! Morphology with a rectangular structuring element.
+		 * \param[in,out]	pixels	the pixels
+		 * \param[in]	w	the width of the image
+		 * \param[in]	h	the height of the image
+		 * \param[in]	halfw	the half width of the window
+		 * \param[in]	halfh	the half height of the window
+		 * \param[in]	cmp	the comparison function
+		 * \param[in]	maximum	false to compute local minima (dilatation), true for local maxima (erosion)
+		 */
+		template<typename T, typename CMP> void RectMorphology(std::vector<T> &pixels, size_t w, size_t h, size_t halfw, size_t halfh, CMP cmp, bool maximum)
+		{
+			if (maximum)
+				RectExtremum(pixels, w, h, halfw, halfh, [&cmp](const T &a, const T &b) -> T { return cmp(a, b) ? b : a; });
+			else
+				RectExtremum(pixels, w, h, halfw, halfh, [&cmp](const T &a, const T &b) -> T { return cmp(b, a) ? b : a; });
+		}
+		/*! \brief Morphology with a rectangular structuring element on bit-packed rows */
+		void RectMorphology(std::vector<bool> &pixels, size_t w, size_t h, size_t halfw, size_t halfh, std::less<bool>, bool maximum);
+
+		/*! \brief Decomposes a rank-1 convolution matrix into a column and a row kernel */
+		bool SeparateKernel(const MatrixDouble &mat, std::vector<double> &vkernel, std::vector<double> &hkernel);
+
+		/*! Modifies an image in place, by bands of rows, when each output row depends on the neighbouring rows of an intermediate representation.
+		 *
+		 * Each band streams its intermediate rows in a ring of 2 * halo + 1 rows, so the whole image is never copied.
+		 * The intermediate rows that belong to the neighbouring bands are computed before any band is written.
+		 *
+		 * \param[in]	w	the width of the intermediate rows
+		 * \param[in]	h	the height of the image
+		 * \param[in]	halo	the number of rows needed above and below an output row
+		 * \param[in]	zero	the initial value of the intermediate rows
+		 * \param[in]	produce	a function (size_t y, R *row) that computes the intermediate row y from the unmodified image
+		 * \param[in]	consume	a function (size_t y, const R * const *rows, R *scratch) that writes the output row y from the intermediate rows y - halo to y + halo (clamped to the image), scratch is a row of w values that is reused for all the rows of a band
+		 * \param[in]	nthreads	the maximal number of bands, 0 for GetConcurrency()
+		 */
+		template<typename R, typename PROD, typename CONS> void InPlaceRowFilter(size_t w, size_t h, size_t halo, const R &zero, PROD produce, CONS consume, size_t nthreads = 0)
+		{
+			if (!h || !w)
+				return;
+			if (!nthreads)
+				nthreads = ThreadPool::IsWorkerThread() ? 1 : GetConcurrency();
+			const auto ksize = 2 * halo + 1;
+			const auto minrows = Max(ksize, ParallelPixelGrain / w);
+			const auto nbands = Max(size_t(1), Min(nthreads, h / minrows));
+			const auto bandh = (h + nbands - 1) / nbands;
+			auto above = std::vector<std::vector<R>>(nbands);
+			auto below = std::vector<std::vector<R>>(nbands);
+			// intermediate rows of the neighbouring bands
+			ParallelFor(0, nbands, [&](size_t bb, size_t be)
+				{
+					for (auto band = bb; band < be; ++band)
+					{
+						const auto y0 = band * bandh;
+						const auto y1 = Min(y0 + bandh, h);
+						const auto top = (y0 >= halo) ? y0 - halo : 0;
+						const auto bottom = Min(y1 + halo, h);
+						above[band].resize((y0 - top) * w, zero);
+						for (auto y = top; y < y0; ++y)
+							produce(y, above[band].data() + (y - top) * w);
+						below[band].resize((bottom - y1) * w, zero);
+						for (auto y = y1; y < bottom; ++y)
+							produce(y, below[band].data() + (y - y1) * w);
+					}
+				}, nbands);
+			// stream the bands
+			ParallelFor(0, nbands, [&](size_t bb, size_t be)
+				{
+					auto ring = std::vector<R>(ksize * w, zero);
+					auto rows = std::vector<const R*>(ksize, nullptr);
+					auto scratch = std::vector<R>(w, zero);
+					for (auto band = bb; band < be; ++band)
+					{
+						const auto y0 = band * bandh;
+						const auto y1 = Min(y0 + bandh, h);
+						const auto top = (y0 >= halo) ? y0 - halo : 0;
+						auto next = y0;
+						for (auto y = y0; y < y1; ++y)
+						{
+							for (; (next < y1) && (next <= y + halo); ++next)
+								produce(next, ring.data() + ((next - y0) % ksize) * w);
+							for (auto k = size_t(0); k < ksize; ++k)
+							{
+								const auto r = size_t(Cap(int(y) + int(k) - int(halo), 0, int(h) - 1));
+								if (r < y0)
+									rows[k] = above[band].data() + (r - top) * w;
+								else if (r >= y1)
+									rows[k] = below[band].data() + (r - y1) * w;
+								else
+									rows[k] = ring.data() + ((r - y0) % ksize) * w;
+							}
+							consume(y, rows.data(), scratch.data());
+						}
+					}
+				}, nbands);
+		}
+
+		/*! \brief Coefficients of a resampling along one axis
+		 *
+		 * The output sample o is the weighted sum of the source samples first[o] to first[o] + count[o] - 1, whose weights are stored from weights[o * taps].
+		 */
+		struct ResamplingTable
+		{
+			/*! \brief Computes the coefficients */
+			ResamplingTable(size_t insize, size_t outsize, Resampling filter);
+
+			/*! \brief Number of fractional bits of the fixed point weights */
+			static constexpr int FixedPointBits = 14;
+
+			size_t taps; /*!< the maximal number of source samples of an output sample */
+			std::vector<size_t> first; /*!< the first source sample of each output sample */
+			std::vector<size_t> count; /*!< the number of source samples of each output sample */
+			std::vector<double> weights; /*!< the weights, that sum to 1 for each output sample */
+			std::vector<int32_t> fixed; /*!< the weights in fixed point, that sum to 1 << FixedPointBits for each output sample */
+		};
+
+		/*! Converts an interpolated value to a pixel */
+		template<typename T, typename Enable = void> struct Saturate
+		{
+			template<typename D> static T Cast(const D &v) { return T(v); }
+		};
+		/*! Converts an interpolated value to an integer pixel, with rounding and saturation */
+		template<typename T> struct Saturate<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+		{
+			template<typename D> static T Cast(const D &v)
+			{
+				return T(Cap(floor(double(v) + 0.5), double(std::numeric_limits<T>::lowest()), double(std::numeric_limits<T>::max())));
+			}
+		};
+		/*! Converts an interpolated value to a bitonal pixel, with a threshold at half intensity */
+		template<> struct Saturate<bool>
+		{
+			template<typename D> static bool Cast(const D &v) { return double(v) >= 0.5; }
+		};
+		/*! Converts an interpolated value to a RGB pixel, channel by channel */
+		template<typename I> struct Saturate<pixel::RGB<I>>
+		{
+			template<typename D> static pixel::RGB<I> Cast(const D &v)
+			{
+				return pixel::RGB<I>(Saturate<I>::Cast(v.r), Saturate<I>::Cast(v.g), Saturate<I>::Cast(v.b));
+			}
+		};
+
+		/*! \brief Resamples 8 bits gray pixels with fixed point arithmetics */
+		void Resample(std::vector<uint8_t> &pixels, size_t w, size_t h, size_t nw, size_t nh, Resampling filter);
+		/*! \brief Resamples 8 bits RGB pixels with fixed point arithmetics */
+		void Resample(std::vector<pixel::RGB<uint8_t>> &pixels, size_t w, size_t h, size_t nw, size_t nh, Resampling filter);
+
+		/*! Resamples an array of pixels, with a horizontal pass followed by a vertical pass. Both passes process the rows in parallel.
+		 * \param[in,out]	pixels	the pixels
+		 * \param[in]	w	the width of the source
+		 * \param[in]	h	the height of the source
+		 * \param[in]	nw	the width of the result
+		 * \param[in]	nh	the height of the result
+		 * \param[in]	filter	the resampling filter
+		 */
+		template<typename T> void Resample(std::vector<T> &pixels, size_t w, size_t h, size_t nw, size_t nh, Resampling filter)
+		{
+			using decimal_type = DecimalType<T>;
+			const auto nullvalue = decimal_type(pixels.front() - pixels.front());
+			// horizontal pass (serial for booleans, since two rows may share a storage word)
+			auto hbuf = std::vector<decimal_type>(nw * h, nullvalue);
+			if (nw != w)
+			{
+				const auto tab = ResamplingTable(w, nw, filter);
+				ForEachRowBand<T>(nw, h, [&pixels, &hbuf, &tab, w, nw](size_t b, size_t e)
+					{
+						for (auto y = b; y < e; ++y)
+							for (size_t x = 0; x < nw; ++x)
+							{
+								auto &acc = hbuf[x + y * nw];
+								const auto offset = tab.first[x] + y * w;
+								const auto k = tab.weights.data() + x * tab.taps;
+								for (size_t t = 0; t < tab.count[x]; ++t)
+									acc += k[t] * pixels[offset + t];
+							}
+					});
+			}
+			else
+				for (size_t i = 0; i < pixels.size(); ++i)
+					hbuf[i] = decimal_type(pixels[i]);
+
+			// vertical pass, along contiguous rows
+			auto out = std::vector<T>(nw * nh, pixels.front());
+			if (nh != h)
+			{
+				const auto tab = ResamplingTable(h, nh, filter);
+				ForEachRowBand<T>(nw, nh, [&out, &hbuf, &tab, &nullvalue, nw](size_t b, size_t e)
+					{
+						auto acc = std::vector<decimal_type>(nw, nullvalue);
+						for (auto y = b; y < e; ++y)
+						{
+							std::fill(acc.begin(), acc.end(), nullvalue);
+							for (size_t t = 0; t < tab.count[y]; ++t)
+							{
+								const auto k = tab.weights[y * tab.taps + t];
+								const auto *row = hbuf.data() + (tab.first[y] + t) * nw;
+								for (size_t x = 0; x < nw; ++x)
+									acc[x] += k * row[x];
+							}
+							for (size_t x = 0; x < nw; ++x)
+								out[x + y * nw] = Saturate<T>::Cast(acc[x]);
+						}
+					});
+			}
+			else
+				for (size_t i = 0; i < out.size(); ++i)
+					out[i] = Saturate<T>::Cast(hbuf[i]);
+			pixels.swap(out);
+		}
+	}
+
 	/*************************************************************************************
 	 * File operations
 	 ************************************************************************************/
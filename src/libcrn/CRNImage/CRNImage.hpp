@@ -29,7 +29,9 @@
 #include <CRNMath/CRNMatrixDouble.h>
 #include <CRNGeometry/CRNPoint2DInt.h>
 #include <CRNMath/CRNMatrixComplex.h>
+#include <CRNMath/CRNFFT.h>
 #include <set>
+#include <algorithm>
 
 #ifdef _MSC_VER // remove annoying warnings in Microsoft Visual C++
 #	pragma warning(disable:4800)
@@ -149,8 +151,11 @@ namespace crn
 		width = img.GetWidth();
 		height = img.GetHeight();
 		pixels.resize(width * height);
-		for (auto tmp : Range(img))
-			pixels[tmp] = T(img.At(tmp));
+		impl::ForEachPixelBand(width * height, [this, &img](size_t b, size_t e)
+			{
+				for (auto tmp = b; tmp < e; ++tmp)
+					pixels[tmp] = T(img.At(tmp));
+			});
 	}
 
 	/*! Saves as PNG file
@@ -195,8 +200,11 @@ namespace crn
 	{
 		if ((GetWidth() != img.GetWidth()) || (GetHeight() != img.GetHeight()))
 			throw ExceptionDimension("Image+=(Image): images have different sizes.");
-		for (auto i : Range(img))
-			At(i) = T(At(i) + img.At(i));
+		impl::ForEachPixelBand(width * height, [this, &img](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+					At(i) = T(At(i) + img.At(i));
+			});
 		return *this;
 	}
 	
@@ -209,8 +217,11 @@ namespace crn
 	{
 		if ((GetWidth() != img.GetWidth()) || (GetHeight() != img.GetHeight()))
 			throw ExceptionDimension("Image-=(Image): images have different sizes.");
-		for (auto i : Range(img))
-			At(i) = T(At(i) - img.At(i));
+		impl::ForEachPixelBand(width * height, [this, &img](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+					At(i) = T(At(i) - img.At(i));
+			});
 		return *this;
 	}
 	
@@ -220,8 +231,11 @@ namespace crn
 	 */
 	template<typename T> Image<T>& Image<T>::operator*=(double f)
 	{
-		for (auto &v : pixels)
-			v = T(DecimalType<T>(v) * f);
+		impl::ForEachPixelBand(width * height, [this, f](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+					pixels[i] = T(DecimalType<T>(pixels[i]) * f);
+			});
 		return *this;
 	}
 	
@@ -234,8 +248,11 @@ namespace crn
 	{
 		if ((GetWidth() != img.GetWidth()) || (GetHeight() != img.GetHeight()))
 			throw ExceptionDimension("Image*=(Image): images have different sizes.");
-		for (auto i : Range(img))
-			At(i) = T(At(i) * img.At(i));
+		impl::ForEachPixelBand(width * height, [this, &img](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+					At(i) = T(At(i) * img.At(i));
+			});
 		return *this;
 	}
 	
@@ -248,8 +265,11 @@ namespace crn
 	{
 		if ((GetWidth() != img.GetWidth()) || (GetHeight() != img.GetHeight()))
 			throw ExceptionDimension("Image/=(Image): images have different sizes.");
-		for (auto i : Range(img))
-			At(i) = T(At(i) / img.At(i));
+		impl::ForEachPixelBand(width * height, [this, &img](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+					At(i) = T(At(i) / img.At(i));
+			});
 		return *this;
 	}
 
@@ -260,8 +280,11 @@ namespace crn
 	/*! Negative */
 	template<typename T> void Image<T>::Negative()
 	{
-		for (size_t tmp = 0; tmp < width * height; ++tmp)
-			pixels[tmp] = -pixels[tmp];
+		impl::ForEachPixelBand(width * height, [this](size_t b, size_t e)
+			{
+				for (auto tmp = b; tmp < e; ++tmp)
+					pixels[tmp] = -pixels[tmp];
+			});
 	}
 
 	/*! Complement
@@ -269,8 +292,11 @@ namespace crn
 	 */
 	template<typename T> void Image<T>::Complement(T maxval)
 	{
-		for (size_t tmp = 0; tmp < width * height; ++tmp)
-			pixels[tmp] = T(maxval - pixels[tmp]);
+		impl::ForEachPixelBand(width * height, [this, maxval](size_t b, size_t e)
+			{
+				for (auto tmp = b; tmp < e; ++tmp)
+					pixels[tmp] = T(maxval - pixels[tmp]);
+			});
 	}
 
 	/*! Copies a part of an image
@@ -289,10 +315,13 @@ namespace crn
 		if (dx + bbox.GetWidth() > width)
 			bbox.SetWidth(int(width) - int(dx));
 		if (dy + bbox.GetHeight() > height)
-			bbox.SetWidth(int(height) - int(dy));
+			bbox.SetHeight(int(height) - int(dy));
 		// copy
-		for (int y = 0; y < bbox.GetHeight(); ++y)
-			std::copy_n(src.begin() + bbox.GetLeft() + (y + bbox.GetTop()) * src.GetWidth(), bbox.GetWidth(), pixels.begin() + dx + (dy + y) * width);
+		impl::ForEachRowBand<T>(bbox.GetWidth(), bbox.GetHeight(), [this, &src, &bbox, dx, dy](size_t b, size_t e)
+			{
+				for (auto y = int(b); y < int(e); ++y)
+					std::copy_n(src.begin() + bbox.GetLeft() + (y + bbox.GetTop()) * src.GetWidth(), bbox.GetWidth(), pixels.begin() + dx + (dy + y) * width);
+			});
 	}
 
 	/****************************************************************************/
@@ -608,113 +637,23 @@ namespace crn
 	/*!
 	 * Scales the image
 	 *
+	 * The image is resampled horizontally then vertically, using coefficients that are computed once per row and per column.
+	 * 8 bits gray and RGB images are resampled with fixed point arithmetics and their values are clamped.
+	 *
+	 * \throws	ExceptionUninitialized	empty image
+	 * \throws	ExceptionDomain	null width or height
 	 * \param[in]	w	the new width
 	 * \param[in] h the new height
+	 * \param[in]	filter	the resampling filter
 	 */
-	template<typename T> void Image<T>::ScaleToSize(size_t w, size_t h)
+	template<typename T> void Image<T>::ScaleToSize(size_t w, size_t h, Resampling filter)
 	{
-		const auto defaultvalue = pixels.front();
-		const auto nullvalue = defaultvalue - defaultvalue;
-		// width scaling
-		auto wscale = std::vector<pixel_type>();
-		auto step = (double)width / (double)w;
-
-		if (step == 1)
-		{ // just copy (assuming the values are base types)
-			wscale.swap(pixels);
-		}
-		else
-		{
-			wscale = std::vector<pixel_type>(w * height, defaultvalue);
-			for (auto x = size_t(0); x < w; ++x)
-			{
-				auto min = int(double(x) * step);
-				auto coeffmin = 1 - (double(x) * step - double(min));
-
-				auto max = int(double(x + 1) * step);
-				auto coeffmax = double(x + 1) * step - double(max);
-
-				if (step < 1.0)
-				{
-					max = min + 1;
-					coeffmax = 1 - coeffmin;
-				}
-				if (max >= int(width))
-					coeffmax = 0;
-				for (size_t y = 0; y < height; ++y)
-				{
-					auto acc = DecimalType<pixel_type>(nullvalue);
-					auto coeff = 0.0;
-					auto yoff = y * width;
-
-					acc += coeffmin * pixels[min + yoff];
-					coeff += coeffmin;
-					if (coeffmax)
-					{
-						acc += coeffmax * pixels[max + yoff];
-						coeff += coeffmax;
-					}
-					for (int k = min + 1; k < max; ++k)
-					{
-						acc += pixels[k + yoff];
-						coeff += 1;
-					}
-					// mean
-					wscale[x + y * w] = T(acc / coeff);
-				}
-			}
-		}
-
-		// height scaling
-		step = (double)height / (double)h;
-
-		if (step == 1)
-		{ // just copy (assuming the values are base types)
-			pixels.swap(wscale);
-		}
-		else
-		{
-			pixels = std::vector<pixel_type>(w * h, defaultvalue);
-			
-			for (size_t y = 0; y < h; ++y)
-			{
-				auto min = int(double(y) * step);
-				auto coeffmin = 1 - (double(y) * step - double(min));
-
-				auto max = int(double(y + 1) * step);
-				auto coeffmax = double(y + 1) * step - double(max);
-
-				if (step < 1.0)
-				{
-					max = min + 1;
-					coeffmax = 1 - coeffmin;
-				}
-				if (max >= int(height))
-					coeffmax = 0;
-				for (size_t x = 0; x < w; ++x)
-				{
-					auto acc = DecimalType<pixel_type>(nullvalue);
-					auto coeff = 0.0;
-
-					acc += coeffmin * wscale[x + min * w];
-					coeff += coeffmin;
-					if (coeffmax)
-					{
-						acc += coeffmax * wscale[x + max * w];
-						coeff += coeffmax;
-					}
-					for (int k = min + 1; k < max; ++k)
-					{
-						acc += wscale[x + k * w];
-						coeff += 1;
-					}
-
-					// mean
-					pixels[x + y * w] = T(acc / coeff);
-				}
-			}
-		}
-		
+		if (pixels.empty())
+			throw ExceptionUninitialized("void Image::ScaleToSize(size_t w, size_t h, Resampling filter): empty image.");
+		if (!w || !h)
+			throw ExceptionDomain("void Image::ScaleToSize(size_t w, size_t h, Resampling filter): null width or height.");
+		if ((w != width) || (h != height))
+			impl::Resample(pixels, width, height, w, h, filter);
 		width = w;
 		height = h;
 	}
@@ -753,6 +692,8 @@ namespace crn
 	/*!
 	 * Morphological dilatation
 	 *
+	 * Structuring elements that are filled rectangles or lines are processed in constant time per pixel (see DilateRect()).
+	 *
 	 * \warning Invalidates proxy
 	 *
 	 * \throws	ExceptionDimension	even element
@@ -763,21 +704,45 @@ namespace crn
 		if (!(strel.GetRows() & 1) || !(strel.GetCols() & 1))
 			throw ExceptionDimension("void Image::Dilate(const MatrixInt &strel): even matrix dimensions.");
 
+		if (std::all_of(strel.Std().begin(), strel.Std().end(), [](int v) { return v != 0; }))
+		{ // rectangle or line
+			DilateRect(strel.GetCols() / 2, strel.GetRows() / 2, cmp);
+			return;
+		}
+
 		auto halfw = int(strel.GetCols()) / 2;
 		auto halfh = int(strel.GetRows()) / 2;
 
 		auto newpix = std::vector<pixel_type>(width * height, pixels.front());
-		for (size_t y = 0; y < height; ++y)
-		{
-			for (size_t x = 0; x < width; ++x)
+		impl::ForEachRowBand<T>(width, height, [this, &strel, &newpix, &cmp, halfw, halfh](size_t by, size_t ey)
 			{
-				auto basey = int(y) - halfh;
-				auto basex = int(x) - halfw;
-				//auto pix = std::numeric_limits<pixel_type>::max();
-				auto pix = [&strel, basex, basey, this]()
+				for (size_t y = by; y < ey; ++y)
+				{
+					for (size_t x = 0; x < width; ++x)
 					{
-						for (size_t cy = 0; cy < strel.GetRows(); cy++)
-							for (size_t cx = 0; cx < strel.GetCols(); cx++)
+						auto basey = int(y) - halfh;
+						auto basex = int(x) - halfw;
+						//auto pix = std::numeric_limits<pixel_type>::max();
+						auto pix = [&strel, basex, basey, this]()
+							{
+								for (size_t cy = 0; cy < strel.GetRows(); cy++)
+									for (size_t cx = 0; cx < strel.GetCols(); cx++)
+									{
+										if (!strel[cy][cx])
+											continue;
+										auto tx = basex + int(cx);
+										if (tx < 0) continue;
+										if (tx >= int(GetWidth())) continue;
+										auto ty = basey + int(cy);
+										if (ty < 0) continue;
+										if (ty >= int(GetHeight())) continue;
+
+										return pixels[tx + ty * width];
+									}
+								return pixels[basex + basey * width];
+							}();
+						for (size_t cy = 0; cy < strel.GetRows(); ++cy)
+							for (size_t cx = 0; cx < strel.GetCols(); ++cx)
 							{
 								if (!strel[cy][cx])
 									continue;
@@ -788,29 +753,14 @@ namespace crn
 								if (ty < 0) continue;
 								if (ty >= int(GetHeight())) continue;
 
-								return pixels[tx + ty * width];
+								pixel_type tmppix = pixels[tx + ty * width];
+								if (cmp(tmppix, pix))
+									pix = tmppix;
 							}
-						return pixels[basex + basey * width];
-					}();
-				for (size_t cy = 0; cy < strel.GetRows(); ++cy)
-					for (size_t cx = 0; cx < strel.GetCols(); ++cx)
-					{
-						if (!strel[cy][cx])
-							continue;
-						auto tx = basex + int(cx);
-						if (tx < 0) continue;
-						if (tx >= int(GetWidth())) continue;
-						auto ty = basey + int(cy);
-						if (ty < 0) continue;
-						if (ty >= int(GetHeight())) continue;
-
-						pixel_type tmppix = pixels[tx + ty * width];
-						if (cmp(tmppix, pix))
-							pix = tmppix;
+						newpix[x + y * width] = pix;
 					}
-				newpix[x + y * width] = pix;
-			}
-		}
+				}
+			});
 		pixels.swap(newpix);
 	}
 
@@ -818,6 +768,8 @@ namespace crn
 	/*!
 	 * Morphological erosion.
 	 *
+	 * Structuring elements that are filled rectangles or lines are processed in constant time per pixel (see ErodeRect()).
+	 *
 	 * \warning Invalidates proxy
 	 * \throws	ExceptionDimension	even element
 	 *
@@ -829,18 +781,42 @@ namespace crn
 		if (!(strel.GetRows() & 1) || !(strel.GetCols() & 1))
 			throw ExceptionDimension("void Image::Erode(MatrixInt &strel): even matrix dimensions.");
 
+		if (std::all_of(strel.Std().begin(), strel.Std().end(), [](int v) { return v != 0; }))
+		{ // rectangle or line
+			ErodeRect(strel.GetCols() / 2, strel.GetRows() / 2, cmp);
+			return;
+		}
+
 		auto halfw = int(strel.GetCols()) / 2;
 		auto halfh = int(strel.GetRows()) / 2;
 
 		auto newpix = std::vector<pixel_type>(width * height, pixels.front());
-		for (size_t y = 0; y < height; y++)
-			for (size_t x = 0; x < width; x++)
+		impl::ForEachRowBand<T>(width, height, [this, &strel, &newpix, &cmp, halfw, halfh](size_t by, size_t ey)
 			{
-				const auto basey = int(y) - halfh;
-				const auto basex = int(x) - halfw;
-				//auto pix = std::numeric_limits<pixel_type>::min();
-				auto pix = [&strel, basex, basey, this]()
+				for (size_t y = by; y < ey; y++)
+					for (size_t x = 0; x < width; x++)
 					{
+						const auto basey = int(y) - halfh;
+						const auto basex = int(x) - halfw;
+						//auto pix = std::numeric_limits<pixel_type>::min();
+						auto pix = [&strel, basex, basey, this]()
+							{
+								for (size_t cy = 0; cy < strel.GetRows(); cy++)
+									for (size_t cx = 0; cx < strel.GetCols(); cx++)
+									{
+										if (!strel[cy][cx])
+											continue;
+										auto tx = basex + int(cx);
+										if (tx < 0) continue;
+										if (tx >= int(GetWidth())) continue;
+										auto ty = basey + int(cy);
+										if (ty < 0) continue;
+										if (ty >= int(GetHeight())) continue;
+
+										return pixels[tx + ty * width];
+									}
+								return pixels[basex + basey * width];
+							}();
 						for (size_t cy = 0; cy < strel.GetRows(); cy++)
 							for (size_t cx = 0; cx < strel.GetCols(); cx++)
 							{
@@ -853,47 +829,62 @@ namespace crn
 								if (ty < 0) continue;
 								if (ty >= int(GetHeight())) continue;
 
-								return pixels[tx + ty * width];
+								pixel_type tmppix = pixels[tx + ty * width];
+								if (!cmp(tmppix, pix))
+									pix = tmppix;
 							}
-						return pixels[basex + basey * width];
-					}();
-				for (size_t cy = 0; cy < strel.GetRows(); cy++)
-					for (size_t cx = 0; cx < strel.GetCols(); cx++)
-					{
-						if (!strel[cy][cx])
-							continue;
-						auto tx = basex + int(cx);
-						if (tx < 0) continue;
-						if (tx >= int(GetWidth())) continue;
-						auto ty = basey + int(cy);
-						if (ty < 0) continue;
-						if (ty >= int(GetHeight())) continue;
-
-						pixel_type tmppix = pixels[tx + ty * width];
-						if (!cmp(tmppix, pix))
-							pix = tmppix;
+						newpix[x + y * width] = pix;
 					}
-				newpix[x + y * width] = pix;
-			}
+			});
 
 		pixels.swap(newpix);
 	}
 
-	/*! Morphological dilatation (faster than normal dilatation for halfwin >= 8)
+	/*! Morphological dilatation with a rectangular structuring element, with a constant number of comparisons per pixel whatever the size of the element (van Herk/Gil-Werman).
+	 *
+	 * Use halfh = 0 or halfw = 0 for horizontal or vertical lines.
+	 *
+	 * \warning Invalidates proxy
+	 *
+	 * \param[in]	halfw	the half width of the structuring element (width = 2*halfw+1)
+	 * \param[in]	halfh	the half height of the structuring element (height = 2*halfh+1)
+	 * \param[in]	cmp	the comparison function
+	 */
+	template<typename T> template<typename CMP> void Image<T>::DilateRect(size_t halfw, size_t halfh, CMP cmp)
+	{
+		impl::RectMorphology(pixels, width, height, halfw, halfh, cmp, false);
+	}
+
+	/*! Morphological erosion with a rectangular structuring element, with a constant number of comparisons per pixel whatever the size of the element (van Herk/Gil-Werman).
+	 *
+	 * Use halfh = 0 or halfw = 0 for horizontal or vertical lines.
+	 *
+	 * \warning Invalidates proxy
+	 *
+	 * \param[in]	halfw	the half width of the structuring element (width = 2*halfw+1)
+	 * \param[in]	halfh	the half height of the structuring element (height = 2*halfh+1)
+	 * \param[in]	cmp	the comparison function
+	 */
+	template<typename T> template<typename CMP> void Image<T>::ErodeRect(size_t halfw, size_t halfh, CMP cmp)
+	{
+		impl::RectMorphology(pixels, width, height, halfw, halfh, cmp, true);
+	}
+
+	/*! Morphological dilatation with a square structuring element
 	 *
 	 * \warning Invalidates proxy
 	 *
 	 * \param[in]	halfwin	the half window size (window width and height = 2*halfwin+1)
-	 * \param[in]	index	the rank of the value to use on each column (0 = regular dilatation, halfwin = something closer to a median filter)
+	 * \param[in]	index	the rank of the value to use on each column (0 = regular dilatation in constant time per pixel, halfwin = something closer to a median filter)
 	 *
 	 */
 	template<typename T> template<typename CMP> void Image<T>::FastDilate(size_t halfwin, size_t index, CMP cmp)
 	{
 		if (halfwin == 0)
 			return;
-		if ((index == 0) && (halfwin < 8))
+		if (index == 0)
 		{
-			Dilate(MatrixInt{halfwin + halfwin + 1, halfwin + halfwin + 1, 1}, cmp);
+			DilateRect(halfwin, halfwin, cmp);
 			return;
 		}
 		// initialize windows
@@ -945,21 +936,21 @@ namespace crn
 		pixels.swap(newpix);
 	}
 
-	/*! Morphological erosion (faster than normal erosion for halfwin >= 8)
+	/*! Morphological erosion with a square structuring element
 	 *
 	 * \warning Invalidates proxy
 	 *
 	 * \param[in]	halfwin	the half window size (window width and height = 2*halfwin+1)
-	 * \param[in]	index	the rank of the value to use on each column (0 = regular erosion, halfwin = something closer to a median filter)
+	 * \param[in]	index	the rank of the value to use on each column (0 = regular erosion in constant time per pixel, halfwin = something closer to a median filter)
 	 *
 	 */
 	template<typename T> template<typename CMP> void Image<T>::FastErode(size_t halfwin, size_t index, CMP cmp)
 	{
 		if (halfwin == 0)
 			return;
-		if ((index == 0) && (halfwin < 8))
+		if (index == 0)
 		{
-			Erode(MatrixInt{halfwin + halfwin + 1, halfwin + halfwin + 1, 1}, cmp);
+			ErodeRect(halfwin, halfwin, cmp);
 			return;
 		}
 		// initialize windows
@@ -1011,11 +1002,63 @@ namespace crn
 		pixels.swap(newpix);
 	}
 
+	namespace impl
+	{
+		/*! Convolves an image in the frequency domain when it is faster, with the borders clamped as in Image::Convolve()
+		 * \param[in,out]	img	the image
+		 * \param[in]	mat	the convolution matrix (odd dimensions, smaller than the image)
+		 * \return	false if the direct convolution is faster
+		 */
+		template<typename T> bool ConvolveFFT(Image<T> &img, const MatrixDouble &mat, std::true_type)
+		{
+			const auto w = img.GetWidth();
+			const auto h = img.GetHeight();
+			const auto halfw = mat.GetCols() / 2;
+			const auto halfh = mat.GetRows() / 2;
+			const auto pw = w + 2 * halfw;
+			const auto ph = h + 2 * halfh;
+			if (!IsFFTCorrelationFaster(pw, ph, mat.GetCols(), mat.GetRows()))
+				return false;
+			auto padded = std::vector<double>(pw * ph);
+			ParallelFor(0, ph, [&img, &padded, w, h, pw, halfw, halfh](size_t b, size_t e)
+				{
+					for (auto y = b; y < e; ++y)
+					{
+						const auto sy = size_t(Cap(int(y) - int(halfh), 0, int(h) - 1));
+						for (size_t x = 0; x < pw; ++x)
+							padded[x + y * pw] = double(img.At(size_t(Cap(int(x) - int(halfw), 0, int(w) - 1)), sy));
+					}
+				});
+			const auto out = FFTCorrelateValid(padded, pw, ph, mat);
+			ForEachPixelBand(img.Size(), [&img, &out](size_t b, size_t e)
+				{
+					for (auto tmp = b; tmp < e; ++tmp)
+					{
+						auto v = out[tmp];
+						if (std::is_integral<T>::value)
+						{ // remove the rounding errors of the transforms before truncating
+							const auto r = std::round(v);
+							if (std::abs(v - r) < 1e-6)
+								v = r;
+						}
+						img.At(tmp) = T(v);
+					}
+				});
+			return true;
+		}
+		/*! Non-scalar pixels are always convolved directly */
+		template<typename T> bool ConvolveFFT(Image<T> &img, const MatrixDouble &mat, std::false_type) { return false; }
+	}
+
 	/****************************************************************************/
 	/*!
 	 *
 	 * Convolves the image with a matrix.
 	 *
+	 * Rank-1 (separable) matrices are applied as two 1D passes (see ConvolveSeparable()).
+	 * Large kernels of scalar images are applied in the frequency domain when it is cheaper.
+	 * Otherwise the image is processed in place, by bands of rows, without copying it.
+	 *
 	 * \throws	ExceptionDimension	even matrix
 	 * \throws	ExceptionDomain	matrix bigger than image
 	 * \param[in]	mat	The convolution matrix
@@ -1025,103 +1068,130 @@ namespace crn
 		if (!(mat.GetRows() & 1) || !(mat.GetCols() & 1))
 			throw ExceptionDimension("void Image::Convolve(MatrixDouble &mat): even matrix dimensions.");
 
-		auto halfw = mat.GetCols() / 2;
-		auto halfh = mat.GetRows() / 2;
+		const auto halfw = mat.GetCols() / 2;
+		const auto halfh = mat.GetRows() / 2;
 		if ((halfh > height) || (halfw > width))
 			throw ExceptionDomain("void Image::Convolve(MatrixDouble &mat): matrix bigger than the image!");
 
-		auto oldimg = pixels;
-
-		const auto nullvalue = pixels.front() - pixels.front();
-		for (size_t y = 0; y < halfh; y++)
-			for (size_t x = 0; x < width; x++)
-			{ // top
-				auto basey = int(y) - int(halfh);
-				auto basex = int(x) - int(halfw);
-				auto sum = DecimalType<pixel_type>(nullvalue);
-				for (size_t cy = 0; cy < mat.GetRows(); cy++)
-					for (size_t cx = 0; cx < mat.GetCols(); cx++)
-					{
-						auto tx = basex + int(cx);
-						if (tx < 0) tx = 0;
-						if (tx >= int(width)) tx = int(width) - 1;
-						auto ty = basey + int(cy);
-						if (ty < 0) ty = 0;
-						if (ty >= int(height)) ty = int(height) - 1;
-						sum += oldimg[tx + ty * width] * mat[cy][cx];
-					}
-				pixels[x + y * width] = pixel_type(sum);
-			}
-		for (int y = int(height) - int(halfh); y < int(height); y++)
-			for (size_t x = 0; x < width; x++)
-			{ // bottom
-				auto basey = y - int(halfh);
-				auto basex = int(x) - int(halfw);
-				auto sum = DecimalType<pixel_type>(nullvalue);
-				for (size_t cy = 0; cy < mat.GetRows(); cy++)
-					for (size_t cx = 0; cx < mat.GetCols(); cx++)
-					{
-						auto tx = basex + int(cx);
-						if (tx < 0) tx = 0;
-						if (tx >= int(width)) tx = int(width) - 1;
-						auto ty = basey + int(cy);
-						if (ty < 0) ty = 0;
-						if (ty >= int(height)) ty = int(height) - 1;
-						sum += oldimg[tx + ty * width] * mat[cy][cx];
-					}
-				pixels[x + y * width] = pixel_type(sum);
-			}
-		for (int y = int(halfh); y < int(height) - int(halfh); y++)
-			for (size_t x = 0; x < halfw; x++)
-			{ // left
-				auto basey = y - int(halfh);
-				auto basex = int(x) - int(halfw);
-				auto sum = DecimalType<pixel_type>(nullvalue);
-				for (size_t cy = 0; cy < mat.GetRows(); cy++)
-					for (size_t cx = 0; cx < mat.GetCols(); cx++)
-					{
-						auto tx = basex + int(cx);
-						if (tx < 0) tx = 0;
-						if (tx >= int(width)) tx = int(width) - 1;
-						auto ty = basey + int(cy);
-						if (ty < 0) ty = 0;
-						if (ty >= int(height)) ty = int(height) - 1;
-						sum += oldimg[tx + ty * width] * mat[cy][cx];
-					}
-				pixels[x + y * width] = pixel_type(sum);
-			}
-		for (int y = int(halfh); y < int(height) - int(halfh); y++)
-			for (int x = int(width) - int(halfw); x < int(width); x++)
-			{ // right
-				auto basey = y - int(halfh);
-				auto basex = x - int(halfw);
-				auto sum = DecimalType<pixel_type>(nullvalue);
-				for (size_t cy = 0; cy < mat.GetRows(); cy++)
-					for (size_t cx = 0; cx < mat.GetCols(); cx++)
+		auto vkernel = std::vector<double>{};
+		auto hkernel = std::vector<double>{};
+		if (impl::SeparateKernel(mat, vkernel, hkernel))
+		{
+			ConvolveSeparable(hkernel, vkernel);
+			return;
+		}
+		if (impl::ConvolveFFT(*this, mat, std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>{}))
+			return;
+
+		using decimal_type = DecimalType<pixel_type>;
+		const auto nullvalue = decimal_type(pixels.front() - pixels.front());
+		const auto nthreads = std::is_same<T, bool>::value ? size_t(1) : size_t(0);
+		impl::InPlaceRowFilter(width, height, halfh, nullvalue,
+				[this](size_t y, decimal_type *row)
+				{ // the intermediate rows are the source rows
+					for (size_t x = 0; x < width; ++x)
+						row[x] = decimal_type(pixels[x + y * width]);
+				},
+				[this, &mat, &nullvalue, halfw](size_t y, const decimal_type * const *rows, decimal_type *acc)
+				{
+					std::fill(acc, acc + width, nullvalue);
+					// borders
+					auto clamped = [this, &mat, acc, rows, halfw](size_t x)
+						{
+							for (size_t cy = 0; cy < mat.GetRows(); cy++)
+								for (size_t cx = 0; cx < mat.GetCols(); cx++)
+								{
+									const auto tx = Cap(int(x + cx) - int(halfw), 0, int(width) - 1);
+									acc[x] += rows[cy][tx] * mat[cy][cx];
+								}
+						};
+					const auto ib = Min(halfw, width);
+					const auto ie = Max(ib, width - halfw);
+					for (size_t x = 0; x < ib; ++x)
+						clamped(x);
+					for (auto x = ie; x < width; ++x)
+						clamped(x);
+					// interior: contiguous accumulations that the compiler can vectorize
+					for (size_t cy = 0; cy < mat.GetRows(); cy++)
+						for (size_t cx = 0; cx < mat.GetCols(); cx++)
+						{
+							const auto k = mat[cy][cx];
+							const auto *src = rows[cy];
+							for (auto x = ib; x < ie; ++x)
+								acc[x] += src[x + cx - halfw] * k;
+						}
+					for (size_t x = 0; x < width; ++x)
+						pixels[x + y * width] = pixel_type(acc[x]);
+				}, nthreads);
+	}
+
+	/****************************************************************************/
+	/*!
+	 * Convolves the image with a separable kernel, ie: the outer product of a column kernel and a row kernel.
+	 *
+	 * The rows are first convolved with the horizontal kernel into intermediate rows that are not rounded, then the intermediate rows are convolved with the vertical kernel.
+	 * The borders are clamped. The image is processed in place, by bands of rows, without copying it.
+	 *
+	 * \throws	ExceptionDimension	even kernel
+	 * \throws	ExceptionDomain	kernel bigger than image
+	 * \param[in]	hkernel	the horizontal kernel (applied on rows)
+	 * \param[in]	vkernel	the vertical kernel (applied on columns)
+	 */
+	template<typename T> void Image<T>::ConvolveSeparable(const std::vector<double> &hkernel, const std::vector<double> &vkernel)
+	{
+		if (!(hkernel.size() & 1) || !(vkernel.size() & 1))
+			throw ExceptionDimension("void Image::ConvolveSeparable(const std::vector<double> &hkernel, const std::vector<double> &vkernel): even kernel dimensions.");
+
+		const auto halfw = hkernel.size() / 2;
+		const auto halfh = vkernel.size() / 2;
+		if ((halfh > height) || (halfw > width))
+			throw ExceptionDomain("void Image::ConvolveSeparable(const std::vector<double> &hkernel, const std::vector<double> &vkernel): kernel bigger than the image!");
+
+		using decimal_type = DecimalType<pixel_type>;
+		const auto nullvalue = decimal_type(pixels.front() - pixels.front());
+		const auto nthreads = std::is_same<T, bool>::value ? size_t(1) : size_t(0);
+		impl::InPlaceRowFilter(width, height, halfh, nullvalue,
+				[this, &hkernel, &nullvalue, halfw](size_t y, decimal_type *row)
+				{ // horizontal pass
+					const auto offset = y * width;
+					for (size_t x = 0; x < width; ++x)
+						row[x] = nullvalue;
+					auto clamped = [this, &hkernel, row, offset, halfw](size_t x)
+						{
+							for (size_t cx = 0; cx < hkernel.size(); cx++)
+							{
+								const auto tx = Cap(int(x + cx) - int(halfw), 0, int(width) - 1);
+								row[x] += pixels[offset + tx] * hkernel[cx];
+							}
+						};
+					const auto ib = Min(halfw, width);
+					const auto ie = Max(ib, width - halfw);
+					for (size_t x = 0; x < ib; ++x)
+						clamped(x);
+					for (auto x = ie; x < width; ++x)
+						clamped(x);
+					// interior: contiguous accumulations that the compiler can vectorize
+					for (size_t cx = 0; cx < hkernel.size(); cx++)
 					{
-						auto tx = basex + int(cx);
-						if (tx < 0) tx = 0;
-						if (tx >= int(width)) tx = int(width) - 1;
-						auto ty = basey + int(cy);
-						if (ty < 0) ty = 0;
-						if (ty >= int(height)) ty = int(height) - 1;
-						sum += oldimg[tx + ty * width] * mat[cy][cx];
+						const auto k = hkernel[cx];
+						const auto srcoffset = offset + cx - halfw;
+						for (auto x = ib; x < ie; ++x)
+							row[x] += pixels[srcoffset + x] * k;
 					}
-				pixels[x + y * width] = pixel_type(sum);
-			}
-		for (int y = int(halfh); y < int(height) - int(halfh); y++)
-			for (int x = int(halfw); x < int(width) - int(halfw); x++)
-			{
-				auto basey = y - int(halfh);
-				auto basex = x - int(halfw);
-				auto sum = DecimalType<pixel_type>(nullvalue);
-				for (size_t cy = 0; cy < mat.GetRows(); cy++)
-					for (size_t cx = 0; cx < mat.GetCols(); cx++)
+				},
+				[this, &vkernel, &nullvalue](size_t y, const decimal_type * const *rows, decimal_type *acc)
+				{ // vertical pass
+					std::fill(acc, acc + width, nullvalue);
+					for (size_t cy = 0; cy < vkernel.size(); cy++)
 					{
-						sum += oldimg[basex + cx + (basey + cy) * width] * mat[cy][cx];
+						const auto k = vkernel[cy];
+						const auto *src = rows[cy];
+						for (size_t x = 0; x < width; ++x)
+							acc[x] += src[x] * k;
 					}
-				pixels[x + y * width] = pixel_type(sum);
-			}
+					for (size_t x = 0; x < width; ++x)
+						pixels[x + y * width] = pixel_type(acc[x]);
+				}, nthreads);
 	}
 
 	/*! Gaussian blur
@@ -1131,232 +1201,10 @@ namespace crn
 	 */
 	template<typename T> void Image<T>::GaussianBlur(double sigma)
 	{
-        // Backup... Just in case...
-        /*
 		auto gauss = MatrixDouble::NewGaussianLine(sigma);
 		gauss.NormalizeForConvolution();
-		Convolve(gauss); // may throw
-		gauss.Transpose();
-		Convolve(gauss); // may throw
-        */
-        
-        auto kernel = MatrixDouble::NewGaussianLine(sigma);
-        
-        kernel.NormalizeForConvolution();
-        
-        const auto kernel_size(kernel.GetCols());
-        const auto radius(kernel_size / 2);
-        std::vector<double> coeffs(radius + 1);
-        auto index = size_t(0);
-        
-        for (auto k = radius; k < kernel_size; ++k)
-        {
-            coeffs[index] = kernel[0][k];
-            ++index;
-        }
-        
-        /********* "Horizontal" convolution *********/
-        
-        index = 0;
-        auto left_bound = size_t(0);
-        auto right_bound = width - 1;
-        
-        std::vector<pixel_type> tmp_row(width, pixels.front());
-        auto back_shifted_index = size_t(0);
-        
-        for (auto r = 0; r < height; ++r)
-        {
-            auto tmp_id = 0;
-            
-            // Left margin
-            
-            for (auto c = size_t(0); c < radius; ++c)
-            {
-                auto weight = coeffs[0];
-                auto local_cumul = pixels[index] * weight;
-                
-                auto index_left = int(index); // Because of "--"
-                auto index_right = index_left;
-                
-                for (auto offset = size_t(1); offset <= radius; ++offset)
-                {
-                    --index_left;
-                    index_left = Max(int(left_bound), index_left);
-                    ++index_right;
-                    weight = coeffs[offset];
-                    
-                    local_cumul += (pixels[index_left] + pixels[index_right]) * weight;
-                }
-                
-                tmp_row[tmp_id] = pixel_type(local_cumul);
-                ++tmp_id;
-                ++index;
-            }
-            
-            left_bound += width;
-            
-            // Central region
-            
-            for (auto c = radius; c < width - radius; ++c)
-            {
-                auto weight = coeffs[0];
-                auto local_cumul = pixels[index] * weight;
-                
-                auto index_left = int(index); // Because of "--"
-                auto index_right = index_left;
-                
-                for (auto offset = size_t(1); offset <= radius; ++offset)
-                {
-                    --index_left;
-                    ++index_right;
-                    weight = coeffs[offset];
-                    
-                    local_cumul += (pixels[index_left] + pixels[index_right]) * weight;
-                }
-                
-                tmp_row[tmp_id] = pixel_type(local_cumul);
-                ++tmp_id;
-                ++index;
-            }
-            
-            // Right margin
-            
-            for (auto c = width - radius; c < width; ++c)
-            {
-                auto weight = coeffs[0];
-                auto local_cumul = pixels[index] * weight;
-                
-                auto index_left = int(index); // Because of "--"
-                auto index_right = index_left;
-                
-                for (auto offset = 1; offset <= radius; ++offset)
-                {
-                    --index_left;
-                    ++index_right;
-                    index_right = Min(int(right_bound), int(index_right));
-                    weight = coeffs[offset];
-                    
-                    local_cumul += (pixels[index_left] + pixels[index_right]) * weight;
-                }
-                
-                tmp_row[tmp_id] = pixel_type(local_cumul);
-                ++tmp_id;
-                ++index;
-            }
-            
-            right_bound += width;
-            
-            // Finalize current row
-            
-            for (auto k = 0; k < width; ++k)
-            {
-                pixels[back_shifted_index] = tmp_row[k];
-                ++back_shifted_index;
-            }
-        }
-        
-        /********* "Vertical" convolution *********/
-        
-        std::vector<size_t> indices(kernel_size, 0);
-        std::vector<pixel_type> tmp_col(height, pixels.front());
-        auto weight = 0.0;
-        
-        for (auto c = 0; c < width; ++c)
-        {
-            index = 0;
-            
-            // Upper margin
-            
-            for (auto k = size_t(0); k <= radius; ++k)
-                indices[k] = c;
-            
-            for (auto k = radius + 1; k < kernel_size; ++k)
-                indices[k] = indices[k - 1] + width;
-            
-            for (auto r = size_t(0); r < radius; ++r)
-            {
-                weight = coeffs[0];
-                auto local_cumul = pixels[indices[radius]] * weight;
-                
-                for (auto offset = 1; offset <= radius; ++offset)
-                {
-                    auto id_upper = indices[radius - offset];
-                    auto id_lower = indices[radius + offset];
-                    
-                    weight = coeffs[offset];
-                    local_cumul += (pixels[id_upper] + pixels[id_lower]) * weight;
-                }
-                
-                tmp_col[index] = pixel_type(local_cumul);
-                ++index;
-                
-                for (auto k = 0; k < kernel_size - 1; ++k)
-                    indices[k] = indices[k + 1];
-                
-                indices[kernel_size - 1] += width;
-                
-            }
-            
-            // Central region
-            
-            for (auto r = radius; r < height - radius; ++r)
-            {
-                weight = coeffs[0];
-                auto local_cumul = pixels[indices[radius]] * weight;
-                
-                for (auto offset = size_t(1); offset <= radius; ++offset)
-                {
-                    auto id_upper = indices[radius - offset];
-                    auto id_lower = indices[radius + offset];
-                    
-                    weight = coeffs[offset];
-                    local_cumul += (pixels[id_upper] + pixels[id_lower]) * weight;
-                }
-                
-                tmp_col[index] = pixel_type(local_cumul);
-                ++index;
-                
-                for (auto k = 0; k < kernel_size - 1; ++k)
-                    indices[k] = indices[k + 1];
-                
-                indices[kernel_size - 1] += width;
-            }
-            
-            // Lower margin
-            
-            indices[kernel_size - 1] = c + (height - 1) * width;
-            
-            for (auto r = height - radius; r < height; ++r)
-            {
-                weight = coeffs[0];
-                auto local_cumul = pixels[indices[radius]] * weight;
-                
-                for (auto offset = size_t(1); offset <= radius; ++offset)
-                {
-                    auto id_upper = indices[radius - offset];
-                    auto id_lower = indices[radius + offset];
-                    
-                    weight = coeffs[offset];
-                    local_cumul += (pixels[id_upper] + pixels[id_lower]) * weight;
-                }
-                
-                tmp_col[index] = pixel_type(local_cumul);
-                ++index;
-                
-                for (auto k = size_t(0); k < kernel_size - 1; ++k)
-                    indices[k] = indices[k + 1];
-            }
-            
-            // Finalize current column
-            
-            index = c;
-            
-            for (auto k = size_t(0); k < height; ++k)
-            {
-                pixels[index] = tmp_col[k];
-                index += width;
-            }
-        }
+		const auto kernel = std::vector<double>(gauss[0], gauss[0] + gauss.GetCols());
+		ConvolveSeparable(kernel, kernel); // may throw
 	}
 }
 
@@ -1631,115 +1479,11 @@ namespace crn
 
 	namespace impl
 	{
-		/*! \brief Copies a row with a shift
-		 * \param[in]	dest	the image to modify
-		 * \param[in]	src	the source image
-		 * \param[in]	row	the ordinate of the row to copy
-		 * \param[in]	offset	the shift
-		 * \param[in]	prevWeight	the weight of the previous pixel (for smoothing)
-		 * \param[in]	bgColor	the fill color for the corners
-		 */
-		template<typename T> void ShiftCopyRow(Image<T> &dest, const Image<T> &src, size_t row, int offset, double prevWeight, const T &bgColor)
-		{
-			size_t rowoffset = row * dest.GetWidth();
-
-			// fill the possible left gap
-			for (int x = 0; x < offset; ++x)
-				dest.At(x + rowoffset) = bgColor;
-
-			auto oldPrevPix = DecimalType<T>(bgColor) * prevWeight;
-			auto srcrowoffset = row * src.GetWidth();
-			for (size_t x = 0; x < src.GetWidth(); ++x)
-			{ // scan original pixels
-				T pix = src.At(x + srcrowoffset); // do not use auto because of vector<bool>!
-				auto prevPix = DecimalType<T>(pix) * prevWeight;
-				// compute value to copy
-				auto tmp = DecimalType<T>(pix);
-				tmp += oldPrevPix;
-				tmp -= prevPix;
-				pix = T(tmp);
-				// copy the new value
-				if ((x + offset >= 0) && (x + offset < dest.GetWidth()))
-				{
-					dest.At(x + offset + rowoffset) = pix;
-				}
-				// remember the weighted previous pixel
-				oldPrevPix = prevPix;
-			}
-			// fill the possible right gap
-			size_t x = src.GetWidth() + offset;
-			if (x < dest.GetWidth())
-			{
-				auto prevPix = DecimalType<T>(bgColor) * prevWeight;
-				auto pix = bgColor;
-				auto tmp = DecimalType<T>(pix);
-				tmp += oldPrevPix;
-				tmp -= prevPix;
-				pix = T(tmp);
-				dest.At(x + rowoffset) = pix;
-			}
-			for (++x; x < dest.GetWidth(); ++x)
-			{
-				dest.At(x + rowoffset) = bgColor;
-			}
-		}
-
-		/*! \brief Copies a column with a shift
-		 * \param[in]	dest	the image to modify
-		 * \param[in]	src	the source image
-		 * \param[in]	col	the abscissa of the column to copy
-		 * \param[in]	offset	the shift
-		 * \param[in]	prevWeight	the weight of the previous pixel (for smoothing)
-		 * \param[in]	bgColor	the fill color for the corners
-		 */
-		template<typename T> void ShiftCopyColumn(Image<T> &dest, const Image<T> &src, size_t col, int offset, double prevWeight, const T &bgColor)
-		{
-			// fill the possible upper gap
-			for (int y = 0; y < offset; ++y)
-			{
-				dest.At(col, y) = bgColor;
-			}
-
-			auto oldPrevPix = DecimalType<T>(bgColor) * prevWeight;
-			for (size_t y = 0; y < src.GetHeight(); ++y)
-			{ // scan original pixels
-				T pix = src.At(col, y); // do not use auto because of vector<bool>!
-				auto prevPix = DecimalType<T>(pix) * prevWeight;
-				// compute value to copy
-				auto tmp = DecimalType<T>(pix);
-				tmp -= prevPix;
-				tmp += oldPrevPix;
-				pix = T(tmp);
-				// copy the new value
-				if ((y + offset >= 0) && (y + offset < dest.GetHeight()))
-				{
-					dest.At(col, y + offset) = pix;
-				}
-				// remember the weighted previous pixel
-				oldPrevPix = prevPix;
-			}
-			// fill the possible bottom gap
-			size_t y = src.GetHeight() + offset;
-			if (y < dest.GetHeight())
-			{
-				auto prevPix = DecimalType<T>(bgColor) * prevWeight;
-				auto pix = bgColor;
-				auto tmp = DecimalType<T>(pix);
-				tmp += oldPrevPix;
-				tmp -= prevPix;
-				pix = T(tmp);
-				dest.At(col, y) = pix;
-			}
-			for (++y; y < dest.GetHeight(); ++y)
-			{
-				dest.At(col, y) = bgColor;
-			}
-		}
-
-		/*! Performs a fast small rotation
+		/*! Performs a small rotation around the center of the image, with a bilinear interpolation
+		 * \param[in]	img	the image to rotate
 		 * \param[in]	angle	the angle of the rotation
 		 * \param[in]	bgColor	the fill color for the corners
-		 * \return	a new rotated table
+		 * \return	a new rotated image, large enough to contain the whole source image
 		 */
 		template<typename T> Image<T> MakeSmallRotation(const Image<T> &img, const Angle<Degree> &angle, const T &bgColor)
 		{
@@ -1750,57 +1494,19 @@ namespace crn
 			const auto radAngle = angle.Get<Radian>();
 			const auto rotCos = cos(radAngle);
 			const auto rotSin = sin(radAngle);
-			const auto rotTan = tan(radAngle / 2.0);
-
-			// first shear (horizontal)
-			auto shear1 = Image<T>(img.GetWidth() + int(double(img.GetHeight()) * Abs(rotTan)), img.GetHeight());
-			for (size_t y = 0; y < shear1.GetHeight(); ++y)
-			{
-				auto shear = 0.0;
-				if (rotTan >= 0.0)
-				{ // angle >= 0
-					shear = (double(y) + 0.5) * rotTan;
-				}
-				else
-				{ // angle < 0
-					shear = (double(y) - double(shear1.GetHeight()) + 0.5) * rotTan;
-				}
-				ShiftCopyRow(shear1, img, y, int(floor(shear)), shear - floor(shear), bgColor);
-			}
-
-			// second shear (vertical)
-			auto shear2 = Image<T>(shear1.GetWidth(), size_t(double(img.GetWidth()) * Abs(rotSin) + double(img.GetHeight()) * rotCos) + 1);
-			auto shear = 0.0;
-			if (rotSin > 0.0)
-			{ // angle > 0
-				shear = (double(img.GetWidth()) - 1.0) * rotSin;
-			}
-			else
-			{ // angle <= 0
-				shear = double(shear1.GetWidth() - img.GetWidth()) * rotSin;
-			}
-			for (size_t x = 0; x < shear2.GetWidth(); ++x, shear -= rotSin)
-			{
-				ShiftCopyColumn(shear2, shear1, x, int(floor(shear)), shear - floor(shear), bgColor);
-			}
-			shear1 = Image<T>{}; // free a bit of memory
-
-			// third sear (horizontal)
-			auto shear3 = Image<T>(size_t(double(img.GetHeight()) * Abs(rotSin) + double(img.GetWidth()) * rotCos) + 1, shear2.GetHeight());
-			if (rotSin >= 0.0)
-			{ // angle >= 0
-				shear = (1.0 - double(img.GetWidth())) * rotSin * rotTan;
-			}
-			else
-			{
-				shear = ((1.0 - double(img.GetWidth())) * rotSin + 1.0 - double(shear3.GetHeight())) * rotTan;
-			}
-			for (size_t y = 0; y < shear3.GetHeight(); ++y, shear += rotTan)
-			{
-				ShiftCopyRow(shear3, shear2, y, int(floor(shear)), shear - floor(shear), bgColor);
-			}
-
-			return shear3;
+			const auto w = size_t(double(img.GetHeight()) * Abs(rotSin) + double(img.GetWidth()) * rotCos) + 1;
+			const auto h = size_t(double(img.GetWidth()) * Abs(rotSin) + double(img.GetHeight()) * rotCos) + 1;
+			// rotation around the center of the source, translated to the center of the new image
+			const auto cx = (double(img.GetWidth()) - 1.0) / 2.0;
+			const auto cy = (double(img.GetHeight()) - 1.0) / 2.0;
+			auto transform = MatrixDouble(2, 3, 0.0);
+			transform[0][0] = rotCos;
+			transform[0][1] = rotSin;
+			transform[0][2] = (double(w) - 1.0) / 2.0 - (rotCos * cx + rotSin * cy);
+			transform[1][0] = -rotSin;
+			transform[1][1] = rotCos;
+			transform[1][2] = (double(h) - 1.0) / 2.0 - (rotCos * cy - rotSin * cx);
+			return MakeAffineWarp(img, transform, w, h, bgColor, Interpolation::BILINEAR);
 		}
 	}
 
@@ -1887,6 +1593,212 @@ namespace crn
 		return newi;
 	}
 
+	namespace impl
+	{
+		/*! Number of fractional bits of the source coordinates of affine warps */
+		constexpr int WarpFixedPointBits = 16;
+		/*! Size of the square tiles of the warped images */
+		constexpr size_t WarpTileSize = 64;
+
+		/*! Computes the weights of the Keys cubic interpolation (a = -0.5)
+		 * \param[in]	f	the fractional position in [0, 1[
+		 * \param[out]	w	the weights of the samples at -1, 0, 1 and 2
+		 */
+		inline void CubicWeights(double f, double w[4]) noexcept
+		{
+			const auto f2 = f * f;
+			const auto f3 = f2 * f;
+			w[0] = -0.5 * f3 + f2 - 0.5 * f;
+			w[1] = 1.5 * f3 - 2.5 * f2 + 1.0;
+			w[2] = -1.5 * f3 + 2.0 * f2 + 0.5 * f;
+			w[3] = 0.5 * f3 - 0.5 * f2;
+		}
+
+		/*! Samples an image at a fractional position. The pixels outside the image have the background color.
+		 * \param[in]	img	the source image
+		 * \param[in]	x	the integer part of the abscissa (the rounded abscissa for Interpolation::NEAREST)
+		 * \param[in]	y	the integer part of the ordinate (the rounded ordinate for Interpolation::NEAREST)
+		 * \param[in]	fx	the fractional part of the abscissa
+		 * \param[in]	fy	the fractional part of the ordinate
+		 * \param[in]	interp	the interpolation
+		 * \param[in]	bgColor	the background color
+		 * \return	the interpolated value
+		 */
+		template<typename T> T Interpolate(const Image<T> &img, int x, int y, double fx, double fy, Interpolation interp, const T &bgColor)
+		{
+			using decimal_type = DecimalType<T>;
+			const auto w = int(img.GetWidth());
+			const auto h = int(img.GetHeight());
+			if (interp == Interpolation::NEAREST)
+				return ((x >= 0) && (y >= 0) && (x < w) && (y < h)) ? T(img.At(x, y)) : bgColor;
+			const auto margin = (interp == Interpolation::BICUBIC) ? 2 : 1;
+			if ((x < -margin) || (y < -margin) || (x >= w + margin - 1) || (y >= h + margin - 1))
+				return bgColor;
+			auto get = [&img, &bgColor, w, h](int px, int py)
+				{
+					return ((px >= 0) && (py >= 0) && (px < w) && (py < h)) ? decimal_type(img.At(px, py)) : decimal_type(bgColor);
+				};
+			if (interp == Interpolation::BILINEAR)
+			{
+				auto acc = get(x, y) * ((1.0 - fx) * (1.0 - fy));
+				acc += get(x + 1, y) * (fx * (1.0 - fy));
+				acc += get(x, y + 1) * ((1.0 - fx) * fy);
+				acc += get(x + 1, y + 1) * (fx * fy);
+				return Saturate<T>::Cast(acc);
+			}
+			double wx[4], wy[4];
+			CubicWeights(fx, wx);
+			CubicWeights(fy, wy);
+			auto acc = get(x - 1, y - 1) * (wx[0] * wy[0]);
+			for (int j = 0; j < 4; ++j)
+				for (int i = 0; i < 4; ++i)
+					if (i || j)
+						acc += get(x + i - 1, y + j - 1) * (wx[i] * wy[j]);
+			return Saturate<T>::Cast(acc);
+		}
+
+		/*! Processes the tiles of an image in parallel. Images of booleans are processed serially, since two rows may share a storage word.
+		 * \param[in]	w	the width of the image
+		 * \param[in]	h	the height of the image
+		 * \param[in]	fun	the function (size_t x0, size_t x1, size_t y) to call on each row of each tile
+		 */
+		template<typename T, typename FUNC> void ForEachTileRow(size_t w, size_t h, FUNC fun)
+		{
+			const auto ntx = (w + WarpTileSize - 1) / WarpTileSize;
+			const auto nty = (h + WarpTileSize - 1) / WarpTileSize;
+			const auto nthreads = std::is_same<T, bool>::value ? size_t(1) : size_t(0);
+			ParallelFor(0, ntx * nty, [&fun, w, h, ntx](size_t b, size_t e)
+				{
+					for (auto tile = b; tile < e; ++tile)
+					{
+						const auto x0 = (tile % ntx) * WarpTileSize;
+						const auto y0 = (tile / ntx) * WarpTileSize;
+						const auto x1 = Min(x0 + WarpTileSize, w);
+						const auto y1 = Min(y0 + WarpTileSize, h);
+						for (auto y = y0; y < y1; ++y)
+							fun(x0, x1, y);
+					}
+				}, nthreads);
+		}
+	}
+
+	/*! Creates an image by applying an affine transform to an image
+	 *
+	 * Each pixel of the new image is sampled in the source image at the position given by the inverse transform.
+	 * The source positions are stepped along the rows in fixed point arithmetics and the new image is computed tile by tile in parallel.
+	 *
+	 * \throws	ExceptionDimension	the matrix is neither 2×3 nor 3×3
+	 * \throws	ExceptionInvalidArgument	the transform is not affine
+	 * \throws	ExceptionDomain	the transform cannot be inverted
+	 * \param[in]	img	the source image
+	 * \param[in]	transform	a 2×3 or 3×3 matrix that transforms the coordinates in the source image to coordinates in the new image
+	 * \param[in]	w	the width of the new image
+	 * \param[in]	h	the height of the new image
+	 * \param[in]	bgColor	the color of the pixels that do not come from the source image
+	 * \param[in]	interp	the interpolation
+	 * \return	a new image
+	 */
+	template<typename T> Image<T> MakeAffineWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp)
+	{
+		if (((transform.GetRows() != 2) && (transform.GetRows() != 3)) || (transform.GetCols() != 3))
+			throw ExceptionDimension("Image<T> MakeAffineWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp): the matrix must be 2×3 or 3×3.");
+		if ((transform.GetRows() == 3) && ((transform[2][0] != 0.0) || (transform[2][1] != 0.0) || (transform[2][2] != 1.0)))
+			throw ExceptionInvalidArgument("Image<T> MakeAffineWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp): not an affine transform.");
+		const auto det = transform[0][0] * transform[1][1] - transform[0][1] * transform[1][0];
+		if (det == 0.0)
+			throw ExceptionDomain("Image<T> MakeAffineWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp): the transform cannot be inverted.");
+		// inverse transform
+		const auto a = transform[1][1] / det, b = -transform[0][1] / det;
+		const auto d = -transform[1][0] / det, e = transform[0][0] / det;
+		const auto c = -(a * transform[0][2] + b * transform[1][2]);
+		const auto f = -(d * transform[0][2] + e * transform[1][2]);
+		// nearest pixel = integer part of the position + 0.5
+		const auto round = (interp == Interpolation::NEAREST) ? 0.5 : 0.0;
+		const auto one = double(int64_t(1) << impl::WarpFixedPointBits);
+		const auto mask = (int64_t(1) << impl::WarpFixedPointBits) - 1;
+		const auto dx = int64_t(floor(a * one + 0.5));
+		const auto dy = int64_t(floor(d * one + 0.5));
+
+		auto out = Image<T>(w, h, bgColor);
+		impl::ForEachTileRow<T>(w, h, [&](size_t x0, size_t x1, size_t y)
+			{
+				// the position is computed exactly at the beginning of each row of a tile
+				auto sx = int64_t(floor((a * double(x0) + b * double(y) + c + round) * one));
+				auto sy = int64_t(floor((d * double(x0) + e * double(y) + f + round) * one));
+				for (auto x = x0; x < x1; ++x, sx += dx, sy += dy)
+				{
+					const auto ix = sx >> impl::WarpFixedPointBits;
+					const auto iy = sy >> impl::WarpFixedPointBits;
+					if ((ix < std::numeric_limits<int>::min() + 2) || (ix > std::numeric_limits<int>::max() - 2) || (iy < std::numeric_limits<int>::min() + 2) || (iy > std::numeric_limits<int>::max() - 2))
+						continue;
+					out.At(x, y) = impl::Interpolate(img, int(ix), int(iy), double(sx & mask) / one, double(sy & mask) / one, interp, bgColor);
+				}
+			});
+		return out;
+	}
+
+	/*! Creates an image by applying a projective transform to an image
+	 *
+	 * Each pixel of the new image is sampled in the source image at the position given by the inverse transform.
+	 * The homogeneous source positions are stepped along the rows and the new image is computed tile by tile in parallel.
+	 *
+	 * \throws	ExceptionDimension	the matrix is not 3×3
+	 * \throws	ExceptionDomain	the transform cannot be inverted
+	 * \param[in]	img	the source image
+	 * \param[in]	transform	a 3×3 matrix that transforms the homogeneous coordinates in the source image to homogeneous coordinates in the new image
+	 * \param[in]	w	the width of the new image
+	 * \param[in]	h	the height of the new image
+	 * \param[in]	bgColor	the color of the pixels that do not come from the source image
+	 * \param[in]	interp	the interpolation
+	 * \return	a new image
+	 */
+	template<typename T> Image<T> MakeProjectiveWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp)
+	{
+		if ((transform.GetRows() != 3) || (transform.GetCols() != 3))
+			throw ExceptionDimension("Image<T> MakeProjectiveWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp): the matrix must be 3×3.");
+		// inverse transform (adjugate, the scale does not matter)
+		const auto &m = transform;
+		double inv[3][3];
+		inv[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+		inv[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+		inv[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+		inv[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+		inv[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+		inv[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+		inv[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+		inv[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+		inv[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+		const auto det = m[0][0] * inv[0][0] + m[0][1] * inv[1][0] + m[0][2] * inv[2][0];
+		if (det == 0.0)
+			throw ExceptionDomain("Image<T> MakeProjectiveWarp(const Image<T> &img, const MatrixDouble &transform, size_t w, size_t h, const T &bgColor, Interpolation interp): the transform cannot be inverted.");
+		if (det < 0.0) // keep a positive homogeneous coordinate for the points in front
+			for (auto &row : inv)
+				for (auto &v : row)
+					v = -v;
+		const auto round = (interp == Interpolation::NEAREST) ? 0.5 : 0.0;
+
+		auto out = Image<T>(w, h, bgColor);
+		impl::ForEachTileRow<T>(w, h, [&](size_t x0, size_t x1, size_t y)
+			{
+				auto px = inv[0][0] * double(x0) + inv[0][1] * double(y) + inv[0][2];
+				auto py = inv[1][0] * double(x0) + inv[1][1] * double(y) + inv[1][2];
+				auto pw = inv[2][0] * double(x0) + inv[2][1] * double(y) + inv[2][2];
+				for (auto x = x0; x < x1; ++x, px += inv[0][0], py += inv[1][0], pw += inv[2][0])
+				{
+					if (pw <= 0.0)
+						continue;
+					const auto sx = px / pw + round;
+					const auto sy = py / pw + round;
+					if ((Abs(sx) > 1e9) || (Abs(sy) > 1e9))
+						continue;
+					const auto ix = floor(sx);
+					const auto iy = floor(sy);
+					out.At(x, y) = impl::Interpolate(img, int(ix), int(iy), sx - ix, sy - iy, interp, bgColor);
+				}
+			});
+		return out;
+	}
+
 
 }
 
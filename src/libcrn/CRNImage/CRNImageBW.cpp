@@ -25,6 +25,9 @@
 #include <CRNException.h>
 #include <CRNIO/CRNFileShield.h>
 #include <CRNi18n.h>
+#include <atomic>
+#include <limits>
+#include <mutex>
 
 #ifdef CRN_USING_GDKPB
 #	include <gdk-pixbuf/gdk-pixbuf.h>
@@ -500,20 +503,55 @@ void crn::impl::SaveJPEG(const ImageBW &img, const Path &fname, unsigned int qua
 				_("No library for saving image found or write permissions on the file or directory are not granted. No image will be saved.") + StringUTF8(error));
 }
 
+/*! Computes the left profile of an image or view */
+template<typename IMG> static Histogram left_profile(const IMG &img)
+{
+	auto h = Histogram(img.GetHeight());
+	ParallelFor(0, img.GetHeight(), [&img, &h](size_t b, size_t e)
+		{
+			for (auto y = b; y < e; y++)
+			{
+				size_t x;
+				for (x = 0; x < img.GetWidth(); x++)
+					if (!img.At(x, y))
+						break;
+				h.SetBin(y, (unsigned int)x);
+			}
+		});
+	return h;
+}
+
 /*! Computes the left profile
  * \return	an histogram containing the profile
  */
 Histogram crn::LeftProfile(const ImageBW &img)
+{
+	return left_profile(img);
+}
+
+/*! Computes the left profile
+ * \return	an histogram containing the profile
+ */
+Histogram crn::LeftProfile(const ImageViewBW &img)
+{
+	return left_profile(img);
+}
+
+/*! Computes the right profile of an image or view */
+template<typename IMG> static Histogram right_profile(const IMG &img)
 {
 	auto h = Histogram(img.GetHeight());
-	for (size_t y = 0; y < img.GetHeight(); y++)
-	{
-		size_t x;
-		for (x = 0; x < img.GetWidth(); x++)
-			if (!img.At(x, y))
-				break;
-		h.SetBin(y, (unsigned int)x);
-	}
+	ParallelFor(0, img.GetHeight(), [&img, &h](size_t b, size_t e)
+		{
+			for (auto y = b; y < e; y++)
+			{
+				int x;
+				for (x = int(img.GetWidth()) - 1; x >= 0; --x)
+					if (!img.At(x, y))
+						break;
+				h.SetBin(y, (unsigned int)(img.GetWidth() - 1 - x));
+			}
+		});
 	return h;
 }
 
@@ -522,15 +560,32 @@ Histogram crn::LeftProfile(const ImageBW &img)
  */
 Histogram crn::RightProfile(const ImageBW &img)
 {
-	auto h = Histogram(img.GetHeight());
-	for (size_t y = 0; y < img.GetHeight(); y++)
-	{
-		int x;
-		for (x = int(img.GetWidth()) - 1; x >= 0; --x)
-			if (!img.At(x, y))
-				break;
-		h.SetBin(y, (unsigned int)(img.GetWidth() - 1 - x));
-	}
+	return right_profile(img);
+}
+
+/*! Computes the right profile
+ * \return	an histogram containing the profile
+ */
+Histogram crn::RightProfile(const ImageViewBW &img)
+{
+	return right_profile(img);
+}
+
+/*! Computes the top profile of an image or view */
+template<typename IMG> static Histogram top_profile(const IMG &img)
+{
+	auto h = Histogram(img.GetWidth());
+	ParallelFor(0, img.GetWidth(), [&img, &h](size_t b, size_t e)
+		{
+			for (auto x = b; x < e; x++)
+			{
+				size_t y;
+				for (y = 0; y < img.GetHeight(); y++)
+					if (!img.At(x, y))
+						break;
+				h.SetBin(x, (unsigned int)y);
+			}
+		});
 	return h;
 }
 
@@ -538,16 +593,33 @@ Histogram crn::RightProfile(const ImageBW &img)
  * \return	an histogram containing the profile
  */
 Histogram crn::TopProfile(const ImageBW &img)
+{
+	return top_profile(img);
+}
+
+/*! Computes the top profile
+ * \return	an histogram containing the profile
+ */
+Histogram crn::TopProfile(const ImageViewBW &img)
+{
+	return top_profile(img);
+}
+
+/*! Computes the bottom profile of an image or view */
+template<typename IMG> static Histogram bottom_profile(const IMG &img)
 {
 	auto h = Histogram(img.GetWidth());
-	for (size_t x = 0; x < img.GetWidth(); x++)
-	{
-		size_t y;
-		for (y = 0; y < img.GetHeight(); y++)
-			if (!img.At(x, y))
-				break;
-		h.SetBin(x, (unsigned int)y);
-	}
+	ParallelFor(0, img.GetWidth(), [&img, &h](size_t b, size_t e)
+		{
+			for (auto x = b; x < e; x++)
+			{
+				int y;
+				for (y = int(img.GetHeight()) - 1; y >= 0; --y)
+					if (!img.At(x, y))
+						break;
+				h.SetBin(x, (unsigned int)(img.GetHeight() - 1 - y));
+			}
+		});
 	return h;
 }
 
@@ -556,15 +628,32 @@ Histogram crn::TopProfile(const ImageBW &img)
  */
 Histogram crn::BottomProfile(const ImageBW &img)
 {
-	auto h = Histogram(img.GetWidth());
-	for (size_t x = 0; x < img.GetWidth(); x++)
-	{
-		int y;
-		for (y = int(img.GetHeight()) - 1; y >= 0; --y)
-			if (!img.At(x, y))
-				break;
-		h.SetBin(x, (unsigned int)(img.GetHeight() - 1 - y));
-	}
+	return bottom_profile(img);
+}
+
+/*! Computes the bottom profile
+ * \return	an histogram containing the profile
+ */
+Histogram crn::BottomProfile(const ImageViewBW &img)
+{
+	return bottom_profile(img);
+}
+
+/*! Computes the horizontal projection of an image or view */
+template<typename IMG> static Histogram horizontal_projection(const IMG &img)
+{
+	auto h = Histogram(img.GetHeight());
+	ParallelFor(0, img.GetHeight(), [&img, &h](size_t b, size_t e)
+		{
+			for (auto y = b; y < e; y++)
+			{
+				unsigned int cnt = 0;
+				for (size_t x = 0; x < img.GetWidth(); x++)
+					if (!img.At(x, y))
+						cnt += 1;
+				h.SetBin(y, cnt);
+			}
+		});
 	return h;
 }
 
@@ -573,15 +662,37 @@ Histogram crn::BottomProfile(const ImageBW &img)
  */
 Histogram crn::HorizontalProjection(const ImageBW &img)
 {
-	auto h = Histogram(img.GetHeight());
-	for (size_t y = 0; y < img.GetHeight(); y++)
-	{
-		unsigned int cnt = 0;
-		for (size_t x = 0; x < img.GetWidth(); x++)
-			if (!img.At(x, y))
-				cnt += 1;
-		h.SetBin(y, cnt);
-	}
+	return horizontal_projection(img);
+}
+
+/*! Computes the horizontal projection
+ * \return	an histogram containing the projection
+ */
+Histogram crn::HorizontalProjection(const ImageViewBW &img)
+{
+	return horizontal_projection(img);
+}
+
+/*! Computes the vertical projection of an image or view */
+template<typename IMG> static Histogram vertical_projection(const IMG &img)
+{
+	// the rows of each band are accumulated in contiguous counts, then the bands are merged
+	const auto w = img.GetWidth();
+	auto h = Histogram(w);
+	if (!w)
+		return h;
+	std::mutex mutex;
+	ParallelFor(0, img.GetHeight(), [&img, &h, &mutex, w](size_t b, size_t e)
+		{
+			auto cnt = std::vector<unsigned int>(w, 0);
+			for (auto y = b; y < e; ++y)
+				for (size_t x = 0; x < w; ++x)
+					cnt[x] += img.At(x, y) ? 0 : 1;
+			std::lock_guard<std::mutex> lock(mutex);
+			auto *bins = h.GetBins();
+			for (size_t x = 0; x < w; ++x)
+				bins[x] += cnt[x];
+		}, 0, Max(size_t(1), impl::ParallelPixelGrain / Max(w, size_t(1))));
 	return h;
 }
 
@@ -590,16 +701,15 @@ Histogram crn::HorizontalProjection(const ImageBW &img)
  */
 Histogram crn::VerticalProjection(const ImageBW &img)
 {
-	auto h = Histogram(img.GetWidth());
-	for (size_t x = 0; x < img.GetWidth(); x++)
-	{
-		unsigned int cnt = 0;
-		for (size_t y = 0; y < img.GetHeight(); y++)
-			if (!img.At(x, y))
-				cnt += 1;
-		h.SetBin(x, cnt);
-	}
-	return h;
+	return vertical_projection(img);
+}
+
+/*! Computes the vertical projection
+ * \return	an histogram containing the projection
+ */
+Histogram crn::VerticalProjection(const ImageViewBW &img)
+{
+	return vertical_projection(img);
 }
 
 /*! Computes the vertical projection after rotation
@@ -650,6 +760,61 @@ Histogram crn::VerticalSlantedProjection(const ImageBW &img, const Angle<Radian>
 	return hist;
 }
 
+/*! Rotates a bitonal image by a small angle around its center
+ *
+ * The rotation is approximated by a vertical shear followed by a horizontal shear, with integer shifts, so each row of the result is made of segments of the source rows that are copied without resampling.
+ * The approximation is good for angles of a few degrees, for example to correct the skew of a page.
+ *
+ * \param[in]	img	the source image
+ * \param[in]	angle	the angle of the rotation (in the same direction as MakeRotation())
+ * \return	a new image of the same size, whose corners are white
+ */
+ImageBW crn::MakeShearRotation(const ImageBW &img, const Angle<Radian> &angle)
+{
+	const auto w = img.GetWidth();
+	const auto h = img.GetHeight();
+	auto out = ImageBW(w, h, pixel::BWWhite);
+	const auto s = angle.Sin();
+	const auto cx = (double(w) - 1.0) / 2.0;
+	const auto cy = (double(h) - 1.0) / 2.0;
+
+	// vertical shear: runs of columns that are read from the same row offset
+	struct Segment
+	{
+		int begin, end, shift;
+	};
+	auto segments = std::vector<Segment>{};
+	for (int x = 0; x < int(w); ++x)
+	{
+		const auto shift = int(floor(s * (double(x) - cx) + 0.5));
+		if (segments.empty() || (segments.back().shift != shift))
+			segments.push_back(Segment{x, x + 1, shift});
+		else
+			segments.back().end = x + 1;
+	}
+
+	// horizontal shear: each row is shifted as a whole
+	for (int y = 0; y < int(h); ++y)
+	{
+		const auto shift = int(floor(s * (double(y) - cy) + 0.5));
+		const auto dst = out.begin() + y * int(w);
+		for (const auto &seg : segments)
+		{
+			const auto srcy = y + seg.shift;
+			if ((srcy < 0) || (srcy >= int(h)))
+				continue;
+			const auto b = Max(0, seg.begin + shift);
+			const auto e = Min(int(w), seg.end + shift);
+			if (b < e)
+			{
+				const auto src = img.begin() + (srcy * int(w) + b - shift);
+				std::copy(src, src + (e - b), dst + b);
+			}
+		}
+	}
+	return out;
+}
+
 /*!
  * Gets the mean horizontal black run
  *
@@ -770,6 +935,23 @@ size_t crn::CountBlackPixels(const ImageBW &img) noexcept
 	return cnt;
 }
 
+/*****************************************************************************/
+/*!
+ * \param[in]	img	the source view
+ * Returns the number of black pixels
+ */
+size_t crn::CountBlackPixels(const ImageViewBW &img) noexcept
+{
+	auto cnt = size_t(0);
+	FOREACHPIXEL(x, y, img)
+	{
+		const auto p = img.At(x, y);
+		if (!p)
+			cnt += 1;
+	}
+	return cnt;
+}
+
 /*****************************************************************************/
 /*!
  * \param[in]	img	the source image
@@ -784,6 +966,23 @@ size_t crn::CountWhitePixels(const ImageBW &img) noexcept
 	return cnt;
 }
 
+/*****************************************************************************/
+/*!
+ * \param[in]	img	the source view
+ * Returns the number of white pixels
+ */
+size_t crn::CountWhitePixels(const ImageViewBW &img) noexcept
+{
+	auto cnt = size_t(0);
+	FOREACHPIXEL(x, y, img)
+	{
+		const auto p = img.At(x, y);
+		if (p)
+			cnt += 1;
+	}
+	return cnt;
+}
+
 /*****************************************************************************/
 /*!
  * Removes isolated pixels
@@ -801,37 +1000,46 @@ size_t crn::Regularize(ImageBW &img, size_t min_neighbors)
 		throw ExceptionDomain(crn::StringUTF8("Cleanup(ImageBW &img, size_t min_neighbors): ") + _("Min neighbors must be < 8."));
 	}
 
-	auto nb = size_t(0);
+	std::atomic<size_t> nb(0);
 	auto npix = img;
-	for (auto y = size_t(1); y < img.GetHeight() - 1; ++y)
-		for (auto x = size_t(1); x < img.GetWidth() - 1; ++x)
+	// bands of pixels rather than rows, so that two threads never write the same word of npix
+	impl::ForEachPixelBand(img.Size(), [&img, &npix, &nb, min_neighbors](size_t b, size_t e)
 		{
-			if (!img.At(x, y))
+			auto lnb = size_t(0);
+			for (auto tmp = b; tmp < e; ++tmp)
 			{
-				size_t n = 0;
-				if (!img.At(x - 1, y - 1))
-					n += 1;
-				if (!img.At(x, y - 1))
-					n += 1;
-				if (!img.At(x + 1, y - 1))
-					n += 1;
-				if (!img.At(x + 1, y))
-					n += 1;
-				if (!img.At(x + 1, y + 1))
-					n += 1;
-				if (!img.At(x, y + 1))
-					n += 1;
-				if (!img.At(x - 1, y + 1))
-					n += 1;
-				if (!img.At(x - 1, y))
-					n += 1;
-				if (n <= min_neighbors)
+				const auto x = tmp % img.GetWidth();
+				const auto y = tmp / img.GetWidth();
+				if ((x < 1) || (y < 1) || (x >= img.GetWidth() - 1) || (y >= img.GetHeight() - 1))
+					continue;
+				if (!img.At(x, y))
 				{
-					npix.At(x, y) = pixel::BWWhite;
-					nb += 1;
+					size_t n = 0;
+					if (!img.At(x - 1, y - 1))
+						n += 1;
+					if (!img.At(x, y - 1))
+						n += 1;
+					if (!img.At(x + 1, y - 1))
+						n += 1;
+					if (!img.At(x + 1, y))
+						n += 1;
+					if (!img.At(x + 1, y + 1))
+						n += 1;
+					if (!img.At(x, y + 1))
+						n += 1;
+					if (!img.At(x - 1, y + 1))
+						n += 1;
+					if (!img.At(x - 1, y))
+						n += 1;
+					if (n <= min_neighbors)
+					{
+						npix.At(x, y) = pixel::BWWhite;
+						lnb += 1;
+					}
 				}
 			}
-		}
+			nb += lnb;
+		});
 
 	img = std::move(npix);
 	return nb;
@@ -907,3 +1115,492 @@ ImageIntGray crn::DistanceTransform(const ImageBW &img, const MatrixInt &m1, con
 	return dt;
 }
 
+/*! Exact squared Euclidean distance transform (Felzenszwalb & Huttenlocher), in two separable passes.
+ *
+ * The first pass computes the distance to the nearest white pixel of the column with two sweeps along the rows, by bands of columns in parallel.
+ * The second pass computes the lower envelope of the parabolas of each row, by bands of rows in parallel.
+ *
+ * \param[in]	img	the source image
+ * \param[out]	nearest	if not null, the offset (x + y * width) of the nearest white pixel of each pixel
+ * \return	the squared distances, std::numeric_limits<int>::max() if the image has no white pixel
+ */
+static ImageIntGray squared_edt(const ImageBW &img, ImageIntGray *nearest)
+{
+	const auto w = img.GetWidth();
+	const auto h = img.GetHeight();
+	const auto inf = std::numeric_limits<int>::max();
+	// vertical distance to the nearest white pixel of the column and ordinate of this pixel
+	auto g = ImageIntGray(w, h, inf);
+	auto gy = nearest ? ImageIntGray(w, h, -1) : ImageIntGray{};
+	ParallelFor(0, w, [&img, &g, &gy, nearest, h, inf](size_t b, size_t e)
+		{
+			for (size_t y = 0; y < h; ++y)
+				for (auto x = b; x < e; ++x)
+				{
+					if (img.At(x, y))
+					{
+						g.At(x, y) = 0;
+						if (nearest)
+							gy.At(x, y) = int(y);
+					}
+					else if (y && (g.At(x, y - 1) != inf))
+					{
+						g.At(x, y) = g.At(x, y - 1) + 1;
+						if (nearest)
+							gy.At(x, y) = gy.At(x, y - 1);
+					}
+				}
+			for (auto y = h - 1; y > 0; --y)
+				for (auto x = b; x < e; ++x)
+					if ((g.At(x, y) != inf) && (g.At(x, y) + 1 < g.At(x, y - 1)))
+					{
+						g.At(x, y - 1) = g.At(x, y) + 1;
+						if (nearest)
+							gy.At(x, y - 1) = gy.At(x, y);
+					}
+		}, 0, Max(size_t(1), impl::ParallelPixelGrain / Max(h, size_t(1))));
+
+	// lower envelope of the parabolas (x - q)² + g(q)² of each row
+	auto dt = ImageIntGray(w, h, inf);
+	if (nearest)
+		*nearest = ImageIntGray(w, h, -1);
+	ParallelFor(0, h, [&g, &gy, &dt, nearest, w, inf](size_t b, size_t e)
+		{
+			auto v = std::vector<size_t>(w); // abscissas of the parabolas in the envelope
+			auto z = std::vector<double>(w + 1); // boundaries between the parabolas
+			auto f = std::vector<int64_t>(w); // squared vertical distances
+			for (auto y = b; y < e; ++y)
+			{
+				auto k = size_t(0);
+				auto found = false;
+				for (size_t q = 0; q < w; ++q)
+				{
+					if (g.At(q, y) == inf)
+						continue;
+					f[q] = int64_t(g.At(q, y)) * int64_t(g.At(q, y));
+					if (!found)
+					{
+						v[0] = q;
+						z[0] = -std::numeric_limits<double>::infinity();
+						z[1] = std::numeric_limits<double>::infinity();
+						found = true;
+						continue;
+					}
+					while (true)
+					{
+						const auto p = v[k];
+						const auto s = double((f[q] + int64_t(q * q)) - (f[p] + int64_t(p * p))) / double(2 * int64_t(q - p));
+						if (s > z[k])
+						{
+							k += 1;
+							v[k] = q;
+							z[k] = s;
+							z[k + 1] = std::numeric_limits<double>::infinity();
+							break;
+						}
+						if (k == 0)
+						{ // q hides all the previous parabolas
+							v[0] = q;
+							z[1] = std::numeric_limits<double>::infinity();
+							break;
+						}
+						k -= 1;
+					}
+				}
+				if (!found)
+					continue;
+				k = 0;
+				for (size_t x = 0; x < w; ++x)
+				{
+					while (z[k + 1] < double(x))
+						k += 1;
+					const auto q = v[k];
+					const auto dx = int64_t(x) - int64_t(q);
+					dt.At(x, y) = int(Min(dx * dx + f[q], int64_t(inf)));
+					if (nearest)
+						nearest->At(x, y) = int(q) + gy.At(q, y) * int(w);
+				}
+			}
+		}, 0, Max(size_t(1), impl::ParallelPixelGrain / Max(w, size_t(1))));
+	return dt;
+}
+
+/*****************************************************************************/
+/*!
+ * Computes the exact squared Euclidean distance of each pixel to the nearest white pixel, in linear time
+ *
+ * \param[in]	img	the source image
+ * \return	a new image containing the squared distances (0 for white pixels, std::numeric_limits<int>::max() if the image has no white pixel)
+ */
+ImageIntGray crn::SquaredDistanceTransform(const ImageBW &img)
+{
+	return squared_edt(img, nullptr);
+}
+
+/*****************************************************************************/
+/*!
+ * Computes the exact squared Euclidean distance of each pixel to the nearest white pixel, in linear time
+ *
+ * \param[in]	img	the source image
+ * \param[out]	nearest	the offset (x + y * width) of the nearest white pixel of each pixel, -1 if the image has no white pixel
+ * \return	a new image containing the squared distances (0 for white pixels, std::numeric_limits<int>::max() if the image has no white pixel)
+ */
+ImageIntGray crn::SquaredDistanceTransform(const ImageBW &img, ImageIntGray &nearest)
+{
+	return squared_edt(img, &nearest);
+}
+
+/*****************************************************************************/
+/*!
+ * Computes the exact Euclidean distance of each pixel to the nearest white pixel, in linear time
+ *
+ * \param[in]	img	the source image
+ * \return	a new image containing the distances (0 for white pixels, infinity if the image has no white pixel)
+ */
+ImageDoubleGray crn::EuclideanDistanceTransform(const ImageBW &img)
+{
+	const auto sq = squared_edt(img, nullptr);
+	auto dt = ImageDoubleGray(img.GetWidth(), img.GetHeight());
+	impl::ForEachPixelBand(sq.Size(), [&sq, &dt](size_t b, size_t e)
+		{
+			for (auto tmp = b; tmp < e; ++tmp)
+				dt.At(tmp) = (sq.At(tmp) == std::numeric_limits<int>::max()) ? std::numeric_limits<double>::infinity() : sqrt(double(sq.At(tmp)));
+		});
+	return dt;
+}
+
+/*! Shifts a bit-packed row towards the lower indices: dst[x] = src[x + s]
+ * \param[in]	src	the source words
+ * \param[out]	dst	the destination words
+ * \param[in]	nwords	the number of words in the row
+ * \param[in]	s	the shift in bits
+ * \param[in]	fill	the word used beyond the end of the row
+ */
+static void packed_shift(const uint64_t *src, uint64_t *dst, size_t nwords, size_t s, uint64_t fill)
+{
+	const auto ws = s / 64;
+	const auto bs = s % 64;
+	for (size_t i = 0; i < nwords; ++i)
+	{
+		const auto lo = (i + ws < nwords) ? src[i + ws] : fill;
+		if (!bs)
+		{
+			dst[i] = lo;
+			continue;
+		}
+		const auto hi = (i + ws + 1 < nwords) ? src[i + ws + 1] : fill;
+		dst[i] = (lo >> bs) | (hi << (64 - bs));
+	}
+}
+
+/*! Morphology with a rectangular structuring element on bit-packed rows.
+ *
+ * The local minimum of booleans is a logical and, the maximum is a logical or, so 64 pixels are processed at once.
+ * The horizontal pass combines shifted rows in log(window width) steps, the vertical pass is a word-wise van Herk/Gil-Werman.
+ * The unnamed std::less argument only selects this overload for images of booleans.
+ *
+ * \param[in,out]	pixels	the pixels
+ * \param[in]	w	the width of the image
+ * \param[in]	h	the height of the image
+ * \param[in]	halfw	the half width of the window
+ * \param[in]	halfh	the half height of the window
+ * \param[in]	maximum	false to compute local minima (dilatation), true for local maxima (erosion)
+ */
+void crn::impl::RectMorphology(std::vector<bool> &pixels, size_t w, size_t h, size_t halfw, size_t halfh, std::less<bool>, bool maximum)
+{
+	if (!w || !h || (!halfw && !halfh))
+		return;
+	const auto identity = maximum ? uint64_t(0) : ~uint64_t(0);
+	auto combine = [maximum](uint64_t a, uint64_t b) { return maximum ? (a | b) : (a & b); };
+	const auto nw = (w + 63) / 64;
+	auto packed = std::vector<uint64_t>(nw * h, identity);
+
+	// pack and horizontal pass
+	const auto kw = 2 * halfw + 1;
+	const auto nbuf = (w + 2 * halfw + 63) / 64;
+	ParallelFor(0, h, [&](size_t by, size_t ey)
+		{
+			auto acc = std::vector<uint64_t>(nbuf);
+			auto tmp = std::vector<uint64_t>(nbuf);
+			for (auto y = by; y < ey; ++y)
+			{
+				std::fill(acc.begin(), acc.end(), identity);
+				for (size_t x = 0; x < w; ++x)
+				{
+					const auto pos = x + halfw;
+					const auto bit = uint64_t(1) << (pos % 64);
+					if (pixels[x + y * w])
+						acc[pos / 64] |= bit;
+					else
+						acc[pos / 64] &= ~bit;
+				}
+				auto span = size_t(1);
+				while (2 * span <= kw)
+				{
+					packed_shift(acc.data(), tmp.data(), nbuf, span, identity);
+					for (size_t i = 0; i < nbuf; ++i)
+						acc[i] = combine(acc[i], tmp[i]);
+					span *= 2;
+				}
+				if (span < kw)
+				{
+					packed_shift(acc.data(), tmp.data(), nbuf, kw - span, identity);
+					for (size_t i = 0; i < nbuf; ++i)
+						acc[i] = combine(acc[i], tmp[i]);
+				}
+				std::copy_n(acc.begin(), nw, packed.begin() + y * nw);
+			}
+		});
+
+	// vertical pass
+	if (halfh)
+	{
+		const auto kh = 2 * halfh + 1;
+		ParallelFor(0, nw, [&](size_t bx, size_t ex)
+			{
+				const auto bw = ex - bx;
+				auto pre = std::vector<uint64_t>(bw * h);
+				auto suf = std::vector<uint64_t>(bw * h);
+				for (size_t y = 0; y < h; ++y)
+					for (size_t x = 0; x < bw; ++x)
+						pre[y * bw + x] = (y % kh == 0) ? packed[y * nw + bx + x] : combine(pre[(y - 1) * bw + x], packed[y * nw + bx + x]);
+				for (auto y = h; y > 0; --y)
+					for (size_t x = 0; x < bw; ++x)
+						suf[(y - 1) * bw + x] = ((y == h) || (y % kh == 0)) ? packed[(y - 1) * nw + bx + x] : combine(suf[y * bw + x], packed[(y - 1) * nw + bx + x]);
+				for (size_t y = 0; y < h; ++y)
+				{
+					const auto a = (y >= halfh) ? y - halfh : 0;
+					const auto b = Min(y + halfh, h - 1);
+					for (size_t x = 0; x < bw; ++x)
+					{
+						auto &dst = packed[y * nw + bx + x];
+						if (a / kh != b / kh)
+							dst = combine(suf[a * bw + x], pre[b * bw + x]);
+						else if (a % kh == 0)
+							dst = pre[b * bw + x];
+						else
+							dst = suf[a * bw + x];
+					}
+				}
+			});
+	}
+
+	// unpack
+	impl::ForEachPixelBand(w * h, [&](size_t b, size_t e)
+		{
+			for (auto i = b; i < e; ++i)
+			{
+				const auto x = i % w;
+				pixels[i] = (packed[(i / w) * nw + x / 64] >> (x % 64)) & 1;
+			}
+		});
+}
+
+/*! \cond Internal */
+namespace
+{
+	/*! A horizontal run of black pixels */
+	struct BlackRun
+	{
+		int xb; /*!< first pixel */
+		int xe; /*!< last pixel */
+	};
+
+	/*! Finds the root of a label in a flat union-find array, with path halving */
+	inline int uf_find(std::vector<int> &parent, int i) noexcept
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+	/*! Merges two labels of a flat union-find array. The smallest index becomes the root. */
+	inline void uf_unite(std::vector<int> &parent, int a, int b) noexcept
+	{
+		a = uf_find(parent, a);
+		b = uf_find(parent, b);
+		if (a < b)
+			parent[b] = a;
+		else if (b < a)
+			parent[a] = b;
+	}
+
+	/*! Merges the runs of a row with the 8-connected runs of the previous row. Both rows are sorted. */
+	inline void connect_rows(const std::vector<BlackRun> &runs, std::vector<int> &parent, size_t pb, size_t pe, size_t cb, size_t ce) noexcept
+	{
+		auto i = pb;
+		for (auto j = cb; j < ce; ++j)
+		{
+			// the previous runs that end before the current one are not connected to the next current runs either
+			while ((i < pe) && (runs[i].xe + 1 < runs[j].xb))
+				++i;
+			for (auto k = i; (k < pe) && (runs[k].xb <= runs[j].xe + 1); ++k)
+				uf_unite(parent, int(k), int(j));
+		}
+	}
+
+	/*! Runs and partial labeling of a stripe of rows */
+	struct Stripe
+	{
+		std::vector<BlackRun> runs; /*!< the runs, sorted by row then abscissa */
+		std::vector<size_t> rowstart; /*!< the index of the first run of each row, plus the number of runs */
+		std::vector<int> parent; /*!< union-find array on the runs */
+	};
+}
+
+/*! Labels the 8-connected black components of an image or view
+ * \param[in]	img	the image or view
+ * \param[out]	components	the statistics of the components, the label of components[i] is i + 1
+ * \return	the map of labels, 0 for white pixels
+ */
+template<typename IMG> static ImageIntGray label_connected_components(const IMG &img, std::vector<ConnectedComponent> &components)
+{
+	const auto w = img.GetWidth();
+	const auto h = img.GetHeight();
+	components.clear();
+	auto labels = ImageIntGray(w, h, 0);
+	if (!w || !h)
+		return labels;
+
+	// 1. runs and labeling in each stripe
+	const auto nstripes = Max(size_t(1), Min(GetConcurrency(), h / 64));
+	const auto stripeh = (h + nstripes - 1) / nstripes;
+	auto stripes = std::vector<Stripe>(nstripes);
+	ParallelFor(0, nstripes, [&](size_t sb, size_t se)
+		{
+			for (auto s = sb; s < se; ++s)
+			{
+				auto &stripe = stripes[s];
+				const auto y0 = s * stripeh;
+				const auto y1 = Min(y0 + stripeh, h);
+				for (auto y = y0; y < y1; ++y)
+				{
+					stripe.rowstart.push_back(stripe.runs.size());
+					for (size_t x = 0; x < w; ++x)
+					{
+						if (img.At(x, y) != pixel::BWBlack)
+							continue;
+						const auto xb = x;
+						while ((x + 1 < w) && (img.At(x + 1, y) == pixel::BWBlack))
+							++x;
+						stripe.runs.push_back(BlackRun{int(xb), int(x)});
+						stripe.parent.push_back(int(stripe.parent.size()));
+					}
+					if (y > y0)
+					{
+						const auto r = stripe.rowstart.size() - 1;
+						connect_rows(stripe.runs, stripe.parent, stripe.rowstart[r - 1], stripe.rowstart[r], stripe.rowstart[r], stripe.runs.size());
+					}
+				}
+				stripe.rowstart.push_back(stripe.runs.size());
+			}
+		}, nstripes);
+
+	// 2. concatenate the stripes and merge their borders
+	auto runs = std::vector<BlackRun>{};
+	auto parent = std::vector<int>{};
+	auto rowstart = std::vector<size_t>{};
+	for (auto &stripe : stripes)
+	{
+		const auto offset = runs.size();
+		runs.insert(runs.end(), stripe.runs.begin(), stripe.runs.end());
+		for (auto p : stripe.parent)
+			parent.push_back(p + int(offset));
+		for (auto r = size_t(0); r + 1 < stripe.rowstart.size(); ++r)
+			rowstart.push_back(stripe.rowstart[r] + offset);
+		if (offset && (stripe.rowstart.size() > 1))
+		{ // first row of the stripe with the last row of the previous stripe
+			const auto y = rowstart.size() - (stripe.rowstart.size() - 1);
+			const auto prevb = rowstart[y - 1];
+			const auto curb = rowstart[y];
+			const auto cure = (y + 1 < rowstart.size()) ? rowstart[y + 1] : runs.size();
+			connect_rows(runs, parent, prevb, curb, curb, cure);
+		}
+		stripe = Stripe{};
+	}
+	rowstart.push_back(runs.size());
+
+	// 3. final labels in the order of the first pixel of each component, and statistics
+	struct Accumulator
+	{
+		int l, t, r, b;
+		size_t area;
+		double sx, sy;
+	};
+	auto acc = std::vector<Accumulator>{};
+	auto runlabel = std::vector<int>(runs.size(), 0);
+	for (size_t y = 0; y < h; ++y)
+		for (auto i = rowstart[y]; i < rowstart[y + 1]; ++i)
+		{
+			const auto root = uf_find(parent, int(i));
+			if (root == int(i))
+			{ // the root is the first run of the component
+				acc.push_back(Accumulator{runs[i].xb, int(y), runs[i].xe, int(y), 0, 0.0, 0.0});
+				runlabel[i] = int(acc.size());
+			}
+			else
+				runlabel[i] = runlabel[root];
+			auto &a = acc[runlabel[i] - 1];
+			const auto len = size_t(runs[i].xe - runs[i].xb + 1);
+			a.l = Min(a.l, runs[i].xb);
+			a.r = Max(a.r, runs[i].xe);
+			a.b = int(y);
+			a.area += len;
+			a.sx += double(runs[i].xb + runs[i].xe) * double(len) / 2.0;
+			a.sy += double(y) * double(len);
+		}
+	components.reserve(acc.size());
+	for (const auto &a : acc)
+	{
+		components.emplace_back();
+		components.back().bbox = Rect(a.l, a.t, a.r, a.b);
+		components.back().area = a.area;
+		components.back().centroid = Point2DDouble(a.sx / double(a.area), a.sy / double(a.area));
+	}
+
+	// 4. paint the labels
+	impl::ForEachRowBand<int>(w, h, [&labels, &runs, &rowstart, &runlabel, w](size_t by, size_t ey)
+		{
+			for (auto y = by; y < ey; ++y)
+				for (auto i = rowstart[y]; i < rowstart[y + 1]; ++i)
+					std::fill_n(labels.begin() + y * w + runs[i].xb, runs[i].xe - runs[i].xb + 1, runlabel[i]);
+		});
+	return labels;
+}
+/*! \endcond */
+
+/*****************************************************************************/
+/*!
+ * Labels the 8-connected black components.
+ *
+ * Horizontal runs of black pixels are labeled with a flat union-find array, by stripes of rows processed in parallel, then the borders of the stripes are merged.
+ * The labels are numbered from 1 in the order of the first pixel (in raster order) of each component.
+ *
+ * \param[in]	img	the source image
+ * \param[out]	components	the statistics of the components, the label of components[i] is i + 1
+ * \return	the map of labels, 0 for white pixels
+ */
+ImageIntGray crn::LabelConnectedComponents(const ImageBW &img, std::vector<ConnectedComponent> &components)
+{
+	return label_connected_components(img, components);
+}
+
+/*****************************************************************************/
+/*!
+ * Labels the 8-connected black components.
+ *
+ * Horizontal runs of black pixels are labeled with a flat union-find array, by stripes of rows processed in parallel, then the borders of the stripes are merged.
+ * The labels are numbered from 1 in the order of the first pixel (in raster order) of each component.
+ *
+ * \param[in]	img	the source view
+ * \param[out]	components	the statistics of the components, the label of components[i] is i + 1
+ * \return	the map of labels, 0 for white pixels
+ */
+ImageIntGray crn::LabelConnectedComponents(const ImageViewBW &img, std::vector<ConnectedComponent> &components)
+{
+	return label_connected_components(img, components);
+}
+
@@ -23,6 +23,9 @@
 #define CRNIMAGEBW_HEADER
 
 #include <CRNImage/CRNImage.h>
+#include <CRNImage/CRNImageView.h>
+#include <CRNGeometry/CRNRect.h>
+#include <CRNGeometry/CRNPoint2DDouble.h>
 
 /*! \defgroup imagebw Bitonal images
  * \ingroup image
@@ -36,20 +39,35 @@ namespace crn
 	/*@{*/
 	/*! \brief Computes the left profile */
 	Histogram LeftProfile(const ImageBW &img);
+	/*! \brief Computes the left profile */
+	Histogram LeftProfile(const ImageViewBW &img);
 	/*! \brief Computes the right profile */
 	Histogram RightProfile(const ImageBW &img);
+	/*! \brief Computes the right profile */
+	Histogram RightProfile(const ImageViewBW &img);
 	/*! \brief Computes the top profile */
 	Histogram TopProfile(const ImageBW &img);
+	/*! \brief Computes the top profile */
+	Histogram TopProfile(const ImageViewBW &img);
 	/*! \brief Computes the bottom profile */
 	Histogram BottomProfile(const ImageBW &img);
+	/*! \brief Computes the bottom profile */
+	Histogram BottomProfile(const ImageViewBW &img);
 	/*! \brief Computes the horizontal projection */
 	Histogram HorizontalProjection(const ImageBW &img);
+	/*! \brief Computes the horizontal projection */
+	Histogram HorizontalProjection(const ImageViewBW &img);
 	/*! \brief Computes the vertical projection */
 	Histogram VerticalProjection(const ImageBW &img);
+	/*! \brief Computes the vertical projection */
+	Histogram VerticalProjection(const ImageViewBW &img);
 
 	/*! \brief Computes the vertical projection after rotation */
 	Histogram VerticalSlantedProjection(const ImageBW &img, const Angle<Radian> &theta);
 
+	/*! \brief Rotates by a small angle without resampling */
+	ImageBW MakeShearRotation(const ImageBW &img, const Angle<Radian> &angle);
+
 	/*! \brief Gets the mean horizontal black run */
 	double MeanBlackRun(const ImageBW &img) noexcept;
 	/*! \brief Gets the mean horizontal white run */
@@ -58,14 +76,36 @@ namespace crn
 	double MeanBlackVRun(const ImageBW &img) noexcept;
 	/*! \brief Returns the number of black pixels */
 	size_t CountBlackPixels(const ImageBW &img) noexcept;
+	/*! \brief Returns the number of black pixels */
+	size_t CountBlackPixels(const ImageViewBW &img) noexcept;
 	/*! \brief Returns the number of white pixels */
 	size_t CountWhitePixels(const ImageBW &img) noexcept;
+	/*! \brief Returns the number of white pixels */
+	size_t CountWhitePixels(const ImageViewBW &img) noexcept;
 	
 	/*! \brief Removes isolated pixels and smooths edges */
 	size_t Regularize(ImageBW &img, size_t min_neighbors = 0);
 
+	/*! \brief Statistics of a connected component */
+	struct ConnectedComponent
+	{
+		Rect bbox; /*!< the bounding box */
+		size_t area = 0; /*!< the number of pixels */
+		Point2DDouble centroid; /*!< the center of mass */
+	};
+	/*! \brief Labels the 8-connected black components */
+	ImageIntGray LabelConnectedComponents(const ImageBW &img, std::vector<ConnectedComponent> &components);
+	/*! \brief Labels the 8-connected black components */
+	ImageIntGray LabelConnectedComponents(const ImageViewBW &img, std::vector<ConnectedComponent> &components);
+
 	/*! \brief Creates an image containing the distance transform */
 	ImageIntGray DistanceTransform(const ImageBW &img, const MatrixInt &m1, const MatrixInt &m2);
+	/*! \brief Computes the exact squared Euclidean distance to the nearest white pixel */
+	ImageIntGray SquaredDistanceTransform(const ImageBW &img);
+	/*! \brief Computes the exact squared Euclidean distance to the nearest white pixel and the position of this pixel */
+	ImageIntGray SquaredDistanceTransform(const ImageBW &img, ImageIntGray &nearest);
+	/*! \brief Computes the exact Euclidean distance to the nearest white pixel */
+	ImageDoubleGray EuclideanDistanceTransform(const ImageBW &img);
 	/*@}*/
 
 }
@@ -0,0 +1,219 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNImageCache.cpp
+ * \author Yann LEYDIER
+ */
+
+#include <CRNImage/CRNImageCache.h>
+#include <CRNImage/CRNImageBW.h>
+
+using namespace crn;
+
+/*! Constructor */
+ImageCache::ImageCache():
+	budget(0),
+	usage(0),
+	hits(0),
+	misses(0),
+	evictions(0)
+{
+}
+
+/*! Singleton instance
+ * \return	the single instance
+ */
+ImageCache& ImageCache::getInstance()
+{
+	static ImageCache cache;
+	return cache;
+}
+
+/*! Sets the maximal number of bytes used by the registered buffers. Buffers are evicted immediately if needed.
+ * \param[in]	bytes	the new budget, 0 for unlimited
+ */
+void ImageCache::SetBudget(size_t bytes)
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	c.budget = bytes;
+	c.shrink(nullptr);
+}
+
+/*! Returns the maximal number of bytes used by the registered buffers
+ * \return	the budget, 0 for unlimited
+ */
+size_t ImageCache::GetBudget()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	return c.budget;
+}
+
+/*! Returns the number of bytes used by the registered buffers
+ * \return	the sum of the sizes of the registered buffers
+ */
+size_t ImageCache::GetUsage()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	return c.usage;
+}
+
+/*! Returns the number of buffers registered
+ * \return	the number of buffers registered
+ */
+size_t ImageCache::GetCount()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	return c.index.size();
+}
+
+/*! Returns the number of accesses to a registered buffer
+ * \return	the number of calls to Touch() that found their buffer
+ */
+size_t ImageCache::GetHits()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	return c.hits;
+}
+
+/*! Returns the number of buffers that had to be computed
+ * \return	the number of calls to Register()
+ */
+size_t ImageCache::GetMisses()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	return c.misses;
+}
+
+/*! Returns the number of buffers freed to respect the budget
+ * \return	the number of evictions
+ */
+size_t ImageCache::GetEvictions()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	return c.evictions;
+}
+
+/*! Resets the hit, miss and eviction counters */
+void ImageCache::ResetStatistics()
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	c.hits = c.misses = c.evictions = 0;
+}
+
+/*! Registers a newly computed buffer. If the key is already registered, its size and priority are updated.
+ *
+ * The eviction callback is called with the cache locked, it must not register nor unregister other buffers.
+ *
+ * \param[in]	key	the identifier of the buffer, typically the address of the pointer that holds it
+ * \param[in]	bytes	the size of the buffer
+ * \param[in]	priority	the buffers of lowest priority are evicted first (e.g.: the cheapest to recompute)
+ * \param[in]	evict	frees the buffer and returns true, or returns false if the buffer cannot be freed now
+ */
+void ImageCache::Register(const void *key, size_t bytes, int priority, std::function<bool()> evict)
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	auto it = c.index.find(key);
+	if (it != c.index.end())
+	{
+		c.usage -= it->second->bytes;
+		c.lru[it->second->priority].erase(it->second);
+		c.index.erase(it);
+	}
+	c.misses += 1;
+	auto &l = c.lru[priority];
+	c.index.emplace(key, l.insert(l.end(), entry{key, bytes, priority, std::move(evict)}));
+	c.usage += bytes;
+	c.shrink(key);
+}
+
+/*! Marks a buffer as recently used
+ * \param[in]	key	the identifier of the buffer
+ * \return	true if the buffer is registered
+ */
+bool ImageCache::Touch(const void *key)
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	auto it = c.index.find(key);
+	if (it == c.index.end())
+		return false;
+	auto &l = c.lru[it->second->priority];
+	l.splice(l.end(), l, it->second);
+	c.hits += 1;
+	return true;
+}
+
+/*! Forgets a buffer that was freed by its owner. Does nothing if the buffer is not registered.
+ * \param[in]	key	the identifier of the buffer
+ */
+void ImageCache::Unregister(const void *key)
+{
+	auto &c = getInstance();
+	std::lock_guard<std::recursive_mutex> lock(c.mutex);
+	auto it = c.index.find(key);
+	if (it == c.index.end())
+		return;
+	c.usage -= it->second->bytes;
+	c.lru[it->second->priority].erase(it->second);
+	c.index.erase(it);
+}
+
+/*! Evicts the least recently used buffers of lowest priority until the usage fits in the budget
+ * \param[in]	keep	a buffer that must not be evicted
+ */
+void ImageCache::shrink(const void *keep)
+{
+	if (!budget)
+		return;
+	for (auto &level : lru)
+	{
+		auto &l = level.second;
+		auto it = l.begin();
+		while ((usage > budget) && (it != l.end()))
+		{
+			if (it->key == keep)
+			{
+				++it;
+				continue;
+			}
+			// the entry is removed before the callback is called since the owner may unregister it
+			auto e = std::move(*it);
+			index.erase(e.key);
+			usage -= e.bytes;
+			it = l.erase(it);
+			if (e.evict())
+				evictions += 1;
+			else
+			{ // in use: keep it
+				const auto key = e.key;
+				usage += e.bytes;
+				index.emplace(key, l.insert(it, std::move(e)));
+			}
+		}
+		if (usage <= budget)
+			return;
+	}
+}
@@ -0,0 +1,117 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNImageCache.h
+ * \author Yann LEYDIER
+ */
+
+#ifndef CRNImageCache_HEADER
+#define CRNImageCache_HEADER
+
+#include <CRNImage/CRNImagePyramid.h>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace crn
+{
+	/****************************************************************************/
+	/*! \brief A memory budget for the image buffers that can be recomputed
+	 *
+	 * Process-wide manager of the image buffers that their owner can free and recompute on demand (e.g.: the buffers and sources of the Blocks).
+	 * When the total size of the registered buffers exceeds the budget, the least recently used buffers of the lowest priority are evicted.
+	 *
+	 * The budget is 0 (unlimited) by default, so that no buffer is ever evicted unless the application sets a budget.
+	 *
+	 * Usage:
+	 * \code
+	 * crn::ImageCache::SetBudget(512 * 1024 * 1024); // 512 MB
+	 * \endcode
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date		Oct 2016
+	 * \version 0.1
+	 * \ingroup image
+	 */
+	class ImageCache
+	{
+		public:
+			/*! \brief Sets the maximal number of bytes used by the registered buffers (0 = unlimited) */
+			static void SetBudget(size_t bytes);
+			/*! \brief Returns the maximal number of bytes used by the registered buffers (0 = unlimited) */
+			static size_t GetBudget();
+			/*! \brief Returns the number of bytes used by the registered buffers */
+			static size_t GetUsage();
+			/*! \brief Returns the number of buffers registered */
+			static size_t GetCount();
+
+			/*! \brief Returns the number of accesses to a registered buffer */
+			static size_t GetHits();
+			/*! \brief Returns the number of buffers that had to be computed */
+			static size_t GetMisses();
+			/*! \brief Returns the number of buffers freed to respect the budget */
+			static size_t GetEvictions();
+			/*! \brief Resets the hit, miss and eviction counters */
+			static void ResetStatistics();
+
+			/*! \brief Registers a newly computed buffer (counts a miss) */
+			static void Register(const void *key, size_t bytes, int priority, std::function<bool()> evict);
+			/*! \brief Marks a buffer as recently used (counts a hit) */
+			static bool Touch(const void *key);
+			/*! \brief Forgets a buffer that was freed by its owner */
+			static void Unregister(const void *key);
+
+			/*! \brief Returns the number of bytes used by the pixels of an image */
+			template<typename T> static size_t GetBytes(const Image<T> &img) noexcept { return img.Size() * sizeof(T); }
+			/*! \brief Returns the number of bytes used by the pixels of an image */
+			static size_t GetBytes(const ImageBW &img) noexcept { return (img.Size() + 7) / 8; }
+			/*! \brief Returns the number of bytes used by all the levels of a pyramid */
+			template<typename T> static size_t GetBytes(const ImagePyramid<T> &pyr) noexcept { return pyr.GetBytes() + GetBytes(pyr.GetLevel(0)); }
+
+		private:
+			/*! \brief Singleton instance */
+			static ImageCache& getInstance();
+
+			/*! \brief Constructor */
+			ImageCache();
+			/*! \brief Evicts buffers until the usage fits in the budget */
+			void shrink(const void *keep);
+
+			/*! \internal */
+			struct entry
+			{
+				const void *key; /*!< the identifier given by the owner */
+				size_t bytes; /*!< the size of the buffer */
+				int priority; /*!< the buffers of lowest priority are evicted first */
+				std::function<bool()> evict; /*!< frees the buffer, returns false if the buffer is in use */
+			};
+			using entry_list = std::list<entry>;
+
+			std::recursive_mutex mutex; /*!< protects the whole cache, recursive so that an eviction callback may unregister its own buffer */
+			std::map<int, entry_list> lru; /*!< the buffers by priority, the least recently used first */
+			std::unordered_map<const void*, entry_list::iterator> index; /*!< the buffers by key */
+			size_t budget; /*!< maximal number of bytes */
+			size_t usage; /*!< current number of bytes */
+			size_t hits; /*!< number of accesses to a registered buffer */
+			size_t misses; /*!< number of buffers computed */
+			size_t evictions; /*!< number of buffers freed */
+	};
+}
+
+#endif
@@ -86,7 +86,21 @@ namespace crn
 	 */
 	using ImageDoubleGray = Image<double>;
 	CRN_ALIAS_SMART_PTR(ImageDoubleGray);
-	
+
+	/****************************************************************************/
+	/*! \brief float Grayscale image class
+	 *
+	 * This class is for grayscale images that need half the memory of ImageDoubleGray.
+	 * Values in pixels' vector represent values for luminosity.
+	 *
+	 * \author  Yann LEYDIER
+	 * \date    Oct 2016
+	 * \version 0.1
+	 * \ingroup imagegray
+	 */
+	using ImageFloatGray = Image<float>;
+	CRN_ALIAS_SMART_PTR(ImageFloatGray);
+
 	/****************************************************************************/
 	/*! \brief Color image class
 	 *
@@ -223,6 +237,32 @@ namespace crn
 	 */
 	using ImageLuv = Image<pixel::Luv>;
 	CRN_ALIAS_SMART_PTR(ImageLuv);
+
+	/****************************************************************************/
+	/*! \brief Compact color image class
+	 *
+	 * Three channels of a color space stored as single precision floats.
+	 *
+	 * \author  Yann LEYDIER
+	 * \date    Oct 2016
+	 * \version 0.1
+	 * \ingroup imageother
+	 */
+	using ImageFloat3 = Image<pixel::Triplet<float>>;
+	CRN_ALIAS_SMART_PTR(ImageFloat3);
+
+	/****************************************************************************/
+	/*! \brief Compact color image class
+	 *
+	 * Three channels of a color space stored as 16 bits fixed point values.
+	 *
+	 * \author  Yann LEYDIER
+	 * \date    Oct 2016
+	 * \version 0.1
+	 * \ingroup imageother
+	 */
+	using ImageShort3 = Image<pixel::Triplet<int16_t>>;
+	CRN_ALIAS_SMART_PTR(ImageShort3);
 	
 }
 
@@ -26,6 +26,7 @@
 #include <CRNException.h>
 #include <CRNIO/CRNFileShield.h>
 #include <CRNi18n.h>
+#include <mutex>
 
 #ifdef CRN_USING_GDKPB
 #	include <gdk-pixbuf/gdk-pixbuf.h>
@@ -567,13 +568,16 @@ void crn::AutoContrast(ImageGray &img)
 Histogram crn::HorizontalProjection(const ImageGray &img)
 {
 	auto h = Histogram(img.GetHeight());
-	for (size_t y = 0; y < img.GetHeight(); y++)
-	{
-		unsigned int cnt = 0;
-		for (size_t x = 0; x < img.GetWidth(); x++)
-			cnt += img.At(x, y);
-		h.SetBin(y, cnt / 255);
-	}
+	ParallelFor(0, img.GetHeight(), [&img, &h](size_t b, size_t e)
+		{
+			for (auto y = b; y < e; y++)
+			{
+				unsigned int cnt = 0;
+				for (size_t x = 0; x < img.GetWidth(); x++)
+					cnt += img.At(x, y);
+				h.SetBin(y, cnt / 255);
+			}
+		});
 	return h;
 }
 
@@ -582,28 +586,99 @@ Histogram crn::HorizontalProjection(const ImageGray &img)
  */
 Histogram crn::VerticalProjection(const ImageGray &img)
 {
-	auto h = Histogram(img.GetWidth());
-	for (size_t x = 0; x < img.GetWidth(); x++)
+	// the rows of each band are accumulated in contiguous sums, then the bands are merged
+	const auto w = img.GetWidth();
+	auto sums = std::vector<unsigned int>(w, 0);
+	std::mutex mutex;
+	ParallelFor(0, img.GetHeight(), [&img, &sums, &mutex, w](size_t b, size_t e)
+		{
+			auto lsums = std::vector<unsigned int>(w, 0);
+			for (auto y = b; y < e; ++y)
+			{
+				const auto *row = &img.At(0, y);
+				for (size_t x = 0; x < w; ++x)
+					lsums[x] += row[x];
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			for (size_t x = 0; x < w; ++x)
+				sums[x] += lsums[x];
+		}, 0, Max(size_t(1), impl::ParallelPixelGrain / Max(w, size_t(1))));
+	auto h = Histogram(w);
+	for (size_t x = 0; x < w; ++x)
+		h[x] = sums[x] / 255;
+	return h;
+}
+
+/*! Counts the values of a band of pixels in four banks, so that consecutive equal values do not wait for each other's increment
+ * \param[in]	pix	the first pixel
+ * \param[in]	n	the number of pixels
+ * \param[in]	offset	the value of the first bin
+ * \param[out]	bins	the bins to increment
+ */
+template<typename T> static void banked_count(const T *pix, size_t n, T offset, std::vector<unsigned int> &bins)
+{
+	const auto nbins = bins.size();
+	auto banks = std::vector<unsigned int>(3 * nbins, 0);
+	auto *b0 = bins.data();
+	auto *b1 = banks.data();
+	auto *b2 = b1 + nbins;
+	auto *b3 = b2 + nbins;
+	auto tmp = size_t(0);
+	for (; tmp + 4 <= n; tmp += 4)
 	{
-		unsigned int cnt = 0;
-		for (size_t y = 0; y < img.GetHeight(); y++)
-			cnt += img.At(x, y);
-		h.SetBin(x, cnt / 255);
+		b0[pix[tmp] - offset] += 1;
+		b1[pix[tmp + 1] - offset] += 1;
+		b2[pix[tmp + 2] - offset] += 1;
+		b3[pix[tmp + 3] - offset] += 1;
 	}
-	return h;
+	for (; tmp < n; ++tmp)
+		b0[pix[tmp] - offset] += 1;
+	for (size_t b = 0; b < nbins; ++b)
+		b0[b] += b1[b] + b2[b] + b3[b];
 }
 
+/*! Creates an histogram of the values of an integer image, by bands of pixels in parallel
+ * \param[in]	img	the image
+ * \param[in]	offset	the value of the first bin
+ * \param[in]	nbins	the number of bins
+ * \return	the histogram
+ */
+template<typename T> static Histogram banked_histogram(const Image<T> &img, T offset, size_t nbins)
+{
+	auto h = Histogram(nbins);
+	std::mutex mutex;
+	impl::ForEachPixelBand(img.Size(), [&img, &h, &mutex, offset, nbins](size_t b, size_t e)
+		{
+			auto lbins = std::vector<unsigned int>(nbins, 0);
+			banked_count(&img.At(b), e - b, offset, lbins);
+			// integer sums, so the order of the merges does not matter
+			std::lock_guard<std::mutex> lock(mutex);
+			auto *bins = h.GetBins();
+			for (size_t tmp = 0; tmp < nbins; ++tmp)
+				bins[tmp] += lbins[tmp];
+		});
+	return h;
+}
 
 /*! Creates an histogram from the pixels
- * \param[in]	img	the image to binarize
- * \return	the histogram
+ * \param[in]	img	the image
+ * \return	the histogram (256 bins)
  */
 Histogram crn::MakeHistogram(const ImageGray &img)
 {
-	auto h = Histogram(256);
-	for (auto v : img)
-		h.IncBin(v);
-	return h;
+	return banked_histogram(img, uint8_t(0), 256);
+}
+
+/*! Creates an histogram from the pixels
+ * \param[in]	img	the image
+ * \return	the histogram, whose first bin is the minimal value of the image
+ */
+Histogram crn::MakeHistogram(const Image<uint16_t> &img)
+{
+	if (!img.Size())
+		return Histogram(1);
+	const auto mM = MinMax(img);
+	return banked_histogram(img, mM.first, size_t(mM.second - mM.first + 1));
 }
 
 /*****************************************************************************/
@@ -719,14 +794,13 @@ size_t crn::EstimateLeading(const ImageGray &img)
 	return histo.MedianValue();
 }
 
-/*!
- * Estimates the mean skew of the document's lines
+/*! Estimates the mean skew of the document's lines
  * \param[in]	img	the source image
+ * \param[in]	xh	the x-height of the lines
  * \return	the mean angle of the document's lines
  */
-Angle<Radian> crn::EstimateSkew(const ImageGray &img)
+static Angle<Radian> estimate_skew(const ImageGray &img, size_t xh)
 {
-	size_t xh = EstimateLinesXHeight(img);
 	size_t div = xh / 2;
 	if (div == 0)
 		return 0;
@@ -812,6 +886,151 @@ Angle<Radian> crn::EstimateSkew(const ImageGray &img)
 	return Angle<Radian>::Atan(double(-V), double(U)); // Y axis is inverted
 }
 
+/*!
+ * Estimates the mean skew of the document's lines
+ * \param[in]	img	the source image
+ * \return	the mean angle of the document's lines
+ */
+Angle<Radian> crn::EstimateSkew(const ImageGray &img)
+{
+	return estimate_skew(img, EstimateLinesXHeight(img));
+}
+
+/*! \internal Minimal x-height (in pixels) for the estimations at a reduced resolution */
+static constexpr size_t PyramidMinXHeight = 8;
+/*! \internal Number of angles tested on each side of the current estimation when refining the skew */
+static constexpr int SkewRefinementSteps = 8;
+
+/*! Finds the coarsest level of a pyramid where the text is large enough to be measured
+ * \param[in]	pyr	the pyramid
+ * \param[in]	xdiv	the horizontal reduction of the x-height estimation, at full resolution
+ * \param[out]	xh	the x-height at the level
+ * \return	the level
+ */
+static size_t text_level(const ImagePyramidGray &pyr, unsigned int xdiv, size_t &xh)
+{
+	for (auto l = pyr.GetLevelCount() - 1; l > 0; --l)
+	{
+		const auto ldiv = Max(1u, xdiv >> l);
+		if (pyr.GetLevel(l).GetWidth() < 16 * ldiv)
+			continue;
+		xh = EstimateLinesXHeight(pyr.GetLevel(l), ldiv);
+		if (xh >= PyramidMinXHeight)
+			return l;
+	}
+	xh = EstimateLinesXHeight(pyr.GetLevel(0), xdiv);
+	return 0;
+}
+
+/*! Refines a skew angle by maximizing the energy of the slanted projections of the dark pixels
+ * \param[in]	img	the source image
+ * \param[in]	theta	the initial angle (in radians)
+ * \param[in]	range	the maximal error on the initial angle (in radians)
+ * \param[in]	thresh	the maximal value of the dark pixels
+ * \param[in]	xstep	the step between two sampled columns
+ * \return	the refined angle (in radians)
+ */
+static double refine_skew(const ImageGray &img, double theta, double range, uint8_t thresh, size_t xstep)
+{
+	const auto w = img.GetWidth();
+	const auto h = img.GetHeight();
+	const auto nslopes = size_t(2 * SkewRefinementSteps + 1);
+	auto slopes = std::vector<double>(nslopes);
+	for (auto k = size_t(0); k < nslopes; ++k)
+		slopes[k] = tan(theta + range * double(int(k) - SkewRefinementSteps) / double(SkewRefinementSteps));
+	// a line with a positive angle goes up to the right, so y + x * tan(angle) is constant along the line
+	const auto offset = size_t(double(w) * Max(Abs(slopes.front()), Abs(slopes.back()))) + 1;
+	const auto nbins = h + 2 * offset;
+	auto profiles = std::vector<std::vector<uint32_t>>{};
+	std::mutex mutex;
+	ParallelFor(0, h, [&](size_t b, size_t e)
+		{
+			auto lprofiles = std::vector<uint32_t>(nslopes * nbins, 0);
+			for (auto y = b; y < e; ++y)
+				for (size_t x = 0; x < w; x += xstep)
+					if (img.At(x, y) <= thresh)
+						for (auto k = size_t(0); k < nslopes; ++k)
+							lprofiles[k * nbins + size_t(double(y + offset) + double(x) * slopes[k])] += 1;
+			std::lock_guard<std::mutex> lock(mutex);
+			profiles.push_back(std::move(lprofiles));
+		}, 0, Max(size_t(1), impl::ParallelPixelGrain * xstep / Max(w, size_t(1))));
+	auto best = size_t(SkewRefinementSteps);
+	auto bestenergy = 0.0;
+	for (auto k = size_t(0); k < nslopes; ++k)
+	{
+		auto energy = 0.0;
+		for (auto bin = size_t(0); bin < nbins; ++bin)
+		{
+			auto v = 0.0;
+			for (const auto &p : profiles)
+				v += double(p[k * nbins + bin]);
+			energy += v * v;
+		}
+		if (energy > bestenergy)
+		{
+			bestenergy = energy;
+			best = k;
+		}
+	}
+	return theta + range * double(int(best) - SkewRefinementSteps) / double(SkewRefinementSteps);
+}
+
+/*!
+ * Computes the mean text line x-height at the coarsest resolution where the text is large enough (at least 8 pixels)
+ *
+ * \param[in]	pyr	the pyramid of the source image
+ * \param[in]	xdiv	the horizontal reduction, in full resolution pixels
+ * \return	the mean text line x-height, in full resolution pixels
+ */
+size_t crn::EstimateLinesXHeight(const ImagePyramidGray &pyr, unsigned int xdiv)
+{
+	auto xh = size_t(0);
+	const auto level = text_level(pyr, xdiv, xh);
+	return xh * ImagePyramidGray::GetFactor(level);
+}
+
+/*!
+ * Computes the median distance between two baselines at the coarsest resolution where the text is large enough (at least 8 pixels)
+ *
+ * \param[in]	pyr	the pyramid of the source image
+ * \return	the median distance between two baselines, in full resolution pixels
+ */
+size_t crn::EstimateLeading(const ImagePyramidGray &pyr)
+{
+	auto xh = size_t(0);
+	const auto level = text_level(pyr, 16, xh);
+	return EstimateLeading(pyr.GetLevel(level)) * ImagePyramidGray::GetFactor(level);
+}
+
+/*!
+ * Estimates the mean skew of the document's lines, coarse to fine.
+ *
+ * The skew is estimated at the coarsest resolution where the text is large enough (at least 8 pixels), then refined at full resolution by maximizing the energy of the slanted projections of the dark pixels.
+ * Only one column out of 2^level is used for the refinement.
+ *
+ * \param[in]	pyr	the pyramid of the source image
+ * \return	the mean angle of the document's lines
+ */
+Angle<Radian> crn::EstimateSkew(const ImagePyramidGray &pyr)
+{
+	auto xh = size_t(0);
+	const auto level = text_level(pyr, 16, xh);
+	const auto &coarse = pyr.GetLevel(level);
+	auto theta = estimate_skew(coarse, xh).value;
+	if (level == 0)
+		return theta;
+	// refinement at full resolution: a coarse pixel over the width of the coarse image, then a tenth of it
+	const auto &img = pyr.GetLevel(0);
+	const auto thresh = uint8_t(MakeHistogram(coarse).Fisher());
+	auto range = Max(2.0 / double(coarse.GetWidth()), 0.5 * M_PI / 180.0);
+	for (auto pass = 0; pass < 2; ++pass)
+	{
+		theta = refine_skew(img, theta, range, thresh, ImagePyramidGray::GetFactor(level));
+		range /= double(SkewRefinementSteps);
+	}
+	return theta;
+}
+
 /*! Default constructor
  * \param[in]  t  the threshold to use in [0..255]
  */
@@ -857,6 +1076,54 @@ ImageBW Gray2BWSauvola::Binarize(const ImageGray &img)
 			*std::static_pointer_cast<Real>(UserData[U"k"]));
 }
 
+/*! Default constructor
+ * \param[in]  halfwin  the half size of the window. Real size will be 2 * halfwin + 1
+ * \param[in]  k  the parameter k
+ */
+Gray2BWWolf::Gray2BWWolf(size_t halfwin, double k)
+{
+	UserData.Set(U"halfwin", std::make_shared<Int>(int(halfwin)));
+	UserData.Set(U"k", std::make_shared<Real>(k));
+}
+
+ImageBW Gray2BWWolf::Binarize(const ImageGray &img)
+{
+	return Wolf(img, *std::static_pointer_cast<Int>(UserData[U"halfwin"]), 
+			*std::static_pointer_cast<Real>(UserData[U"k"]));
+}
+
+/*! Default constructor
+ * \param[in]  halfwin  the half size of the window. Real size will be 2 * halfwin + 1
+ * \param[in]  k  the parameter k
+ */
+Gray2BWNICK::Gray2BWNICK(size_t halfwin, double k)
+{
+	UserData.Set(U"halfwin", std::make_shared<Int>(int(halfwin)));
+	UserData.Set(U"k", std::make_shared<Real>(k));
+}
+
+ImageBW Gray2BWNICK::Binarize(const ImageGray &img)
+{
+	return NICK(img, *std::static_pointer_cast<Int>(UserData[U"halfwin"]), 
+			*std::static_pointer_cast<Real>(UserData[U"k"]));
+}
+
+/*! Default constructor
+ * \param[in]  halfwin  the half size of the window. Real size will be 2 * halfwin + 1
+ * \param[in]  mincontrast  the minimal contrast of a window to contain foreground pixels
+ */
+Gray2BWBernsen::Gray2BWBernsen(size_t halfwin, uint8_t mincontrast)
+{
+	UserData.Set(U"halfwin", std::make_shared<Int>(int(halfwin)));
+	UserData.Set(U"mincontrast", std::make_shared<Int>(mincontrast));
+}
+
+ImageBW Gray2BWBernsen::Binarize(const ImageGray &img)
+{
+	return Bernsen(img, *std::static_pointer_cast<Int>(UserData[U"halfwin"]), 
+			uint8_t(*std::static_pointer_cast<Int>(UserData[U"mincontrast"])));
+}
+
 /*! Default constructor
  * \param[in]  classes  the total number of classes
  * \param[in]  black_classes  the number of classes that will be labelled black
@@ -955,6 +1222,18 @@ CRN_BEGIN_CLASS_CONSTRUCTOR(Gray2BWSauvola)
 	CRN_DATA_FACTORY_REGISTER(U"Gray2BWSauvola", Gray2BWSauvola)
 CRN_END_CLASS_CONSTRUCTOR(Gray2BWSauvola)
 
+CRN_BEGIN_CLASS_CONSTRUCTOR(Gray2BWWolf)
+	CRN_DATA_FACTORY_REGISTER(U"Gray2BWWolf", Gray2BWWolf)
+CRN_END_CLASS_CONSTRUCTOR(Gray2BWWolf)
+
+CRN_BEGIN_CLASS_CONSTRUCTOR(Gray2BWNICK)
+	CRN_DATA_FACTORY_REGISTER(U"Gray2BWNICK", Gray2BWNICK)
+CRN_END_CLASS_CONSTRUCTOR(Gray2BWNICK)
+
+CRN_BEGIN_CLASS_CONSTRUCTOR(Gray2BWBernsen)
+	CRN_DATA_FACTORY_REGISTER(U"Gray2BWBernsen", Gray2BWBernsen)
+CRN_END_CLASS_CONSTRUCTOR(Gray2BWBernsen)
+
 CRN_BEGIN_CLASS_CONSTRUCTOR(Gray2BWkMeansHisto)
 	CRN_DATA_FACTORY_REGISTER(U"Gray2BWkMeansHisto", Gray2BWkMeansHisto)
 CRN_END_CLASS_CONSTRUCTOR(Gray2BWkMeansHisto)
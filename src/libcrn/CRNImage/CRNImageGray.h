@@ -23,9 +23,11 @@
 #define CRNIMAGEGRAY_HEADER
 
 #include <CRNImage/CRNImage.h>
+#include <CRNImage/CRNImagePyramid.h>
 #include <CRNStatistics/CRNHistogram.h>
 #include <CRNAI/CRNkMeans.h>
 #include <CRNUtils/CRNDefaultAction.h>
+#include <mutex>
 
 /*! \defgroup imagegray Gray images 
  * \ingroup	image
@@ -72,16 +74,149 @@ namespace crn
 
 	/*! \brief Creates an histogram from the pixels */
 	Histogram MakeHistogram(const ImageGray &img);
+	/*! \brief Creates an histogram from the pixels */
+	Histogram MakeHistogram(const Image<uint16_t> &img);
 
 	/*! \brief Computes the horizontal projection */
 	Histogram HorizontalProjection(const ImageGray &img);
 	/*! \brief Computes the vertical projection */
 	Histogram VerticalProjection(const ImageGray &img);
 
+	namespace impl
+	{
+		/*! \brief Number of shifts computed in one pass over the image by StrokesWidth() and StrokesHeight() */
+		constexpr size_t StrokesShiftBatch = 8;
+
+		/*! Sums the absolute differences between an image and its circular shifts, for consecutive shifts, in one pass over the image by bands of rows in parallel
+		 * \param[in]	img	the image
+		 * \param[in]	first	the first shift (smaller than the length of the shifted dimension)
+		 * \param[in]	count	the number of shifts
+		 * \param[in]	horizontal	shift the rows (true) or the columns (false)
+		 * \return	the sums for the shifts first to first + count - 1
+		 */
+		template<typename T> std::vector<SumType<T>> ShiftedDifferences(const Image<T> &img, size_t first, size_t count, bool horizontal)
+		{
+			const auto w = img.GetWidth();
+			const auto h = img.GetHeight();
+			auto sums = std::vector<SumType<T>>(count, SumType<T>(0));
+			std::mutex mutex;
+			ParallelFor(0, h, [&img, &sums, &mutex, first, count, horizontal, w, h](size_t b, size_t e)
+				{
+					auto lsums = std::vector<SumType<T>>(count, SumType<T>(0));
+					for (auto y = b; y < e; ++y)
+					{
+						const auto row = y * w;
+						for (size_t i = 0; i < count; ++i)
+						{
+							const auto s = first + i;
+							auto tacc = SumType<T>(0);
+							if (horizontal)
+							{
+								for (size_t x = 0; x < s; ++x)
+									tacc += Abs(img.At(row + x) - img.At(row + x + w - s));
+								for (auto x = s; x < w; ++x)
+									tacc += Abs(img.At(row + x) - img.At(row + x - s));
+							}
+							else
+							{
+								const auto srow = ((y >= s) ? y - s : y + h - s) * w;
+								for (size_t x = 0; x < w; ++x)
+									tacc += Abs(img.At(row + x) - img.At(srow + x));
+							}
+							lsums[i] += tacc;
+						}
+					}
+					std::lock_guard<std::mutex> lock(mutex);
+					for (size_t i = 0; i < count; ++i)
+						sums[i] += lsums[i];
+				}, 0, Max(size_t(1), ParallelPixelGrain / Max(w * count, size_t(1))));
+			return sums;
+		}
+
+		/*! Sums the absolute differences between a two-level image and its circular shifts, from the autocorrelations of its rows or columns in the frequency domain
+		 * \param[in]	img	the image
+		 * \param[in]	count	the number of shifts
+		 * \param[in]	horizontal	shift the rows (true) or the columns (false)
+		 * \return	the sums for the shifts 0 to count - 1, or an empty vector if the image has more than two levels
+		 */
+		template<typename T> std::vector<SumType<T>> ShiftedDifferencesFFT(const Image<T> &img, size_t count, bool horizontal)
+		{
+			const auto mM = MinMax(img);
+			for (const auto &px : img)
+				if ((px != mM.first) && (px != mM.second))
+					return {};
+			// |a - b| = (max - min)·(a' + b' - 2·a'·b') with a', b' in {0, 1}
+			const auto len = horizontal ? img.GetWidth() : img.GetHeight();
+			const auto nrows = horizontal ? img.GetHeight() : img.GetWidth();
+			auto bin = std::vector<double>(img.Size());
+			auto ones = size_t(0);
+			for (size_t y = 0; y < img.GetHeight(); ++y)
+				for (size_t x = 0; x < img.GetWidth(); ++x)
+				{
+					const auto one = img.At(x, y) != mM.first;
+					bin[horizontal ? x + y * len : y + x * len] = one ? 1.0 : 0.0;
+					ones += one ? 1 : 0;
+				}
+			const auto corr = FFTRowAutoCorrelation(bin, len, nrows);
+			const auto range = double(mM.second - mM.first);
+			auto sums = std::vector<SumType<T>>(count, SumType<T>(0));
+			for (size_t s = 1; s < count; ++s)
+			{ // circular autocorrelation = linear autocorrelation at s and len - s
+				const auto cnt = std::round(2.0 * (double(ones) - corr[s] - corr[len - s]));
+				sums[s] = SumType<T>(cnt * range);
+			}
+			return sums;
+		}
+
+		/*! Finds the first shift after which the differences between an image and its shifts stop growing
+		 * \param[in]	img	the image
+		 * \param[in]	maxval	the maximal shift
+		 * \param[in]	defaultval	the value returned if no shift is found
+		 * \param[in]	horizontal	shift the rows (true) or the columns (false)
+		 * \return	the shift
+		 */
+		template<typename T> size_t StrokesPeriod(const Image<T> &img, size_t maxval, size_t defaultval, bool horizontal)
+		{
+			const auto len = horizontal ? img.GetWidth() : img.GetHeight();
+			const auto last = Min(maxval, len);
+			if (last < 2)
+				return defaultval;
+			auto diffs = std::vector<SumType<T>>{};
+			// all the shifts of two-level images in the frequency domain, when cheaper than the direct sums
+			const auto n = double(FFTSize(2 * len));
+			if (6.0 * double(img.Size() / len) * n * log2(n) < double(img.Size()) * double(last - 1))
+				diffs = ShiftedDifferencesFFT(img, last, horizontal);
+			if (diffs.empty())
+				diffs.push_back(SumType<T>(0)); // shift 0
+			auto pacc = SumType<T>(0);
+			for (size_t s = 1; s < last; ++s)
+			{
+				if (s >= diffs.size())
+				{
+					const auto batch = ShiftedDifferences(img, s, Min(StrokesShiftBatch, last - s), horizontal);
+					diffs.insert(diffs.end(), batch.begin(), batch.end());
+				}
+				const auto acc = diffs[s];
+				if (pacc != 0)
+				{
+					if ((DecimalType<T>(Abs(acc - pacc)) / DecimalType<T>(pacc)) < 0.1)
+					{
+						return s;
+					}
+				}
+				pacc = acc;
+			}
+			return defaultval;
+		}
+	}
+
 	/*****************************************************************************/
 	/*!
 	 * Computes the mean stroke width
 	 *
+	 * The differences between the image and its horizontal shifts are computed for several shifts in each pass over the image.
+	 * The shifts of two-level images are all computed in the frequency domain when it is cheaper.
+	 *
 	 * \param[in]	img	the image to binarize
 	 * \param[in]	maxval	if the mean stroke width is > maxval, then defaultval is returned
 	 * \param[in]	defaultval	the value returned if no mean stroke width can be computed
@@ -89,40 +224,16 @@ namespace crn
 	 */
 	template<typename T> size_t StrokesWidth(const Image<T> &img, size_t maxval = 50, size_t defaultval = 0, typename std::enable_if<std::is_arithmetic<T>::value>::type *dummy = nullptr)
 	{
-		auto strokeswidth = size_t(0);
-		auto pacc = SumType<T>(0);
-		for (strokeswidth = 1; strokeswidth < Min(maxval, img.GetWidth()); strokeswidth++)
-		{
-			auto acc = SumType<T>(0);
-			for (size_t y = 0; y < img.GetHeight(); y++)
-			{
-				auto yoffset = y * img.GetWidth();
-				auto tacc = SumType<T>(0);
-				for (size_t x = 0; x < img.GetWidth(); x++)
-				{
-					auto tx = int(x) - int(strokeswidth);
-					if (tx < 0) tx += int(img.GetWidth());
-					if (tx >= int(img.GetWidth())) tx -= int(img.GetWidth());
-					tacc += Abs(img.At(x + yoffset) - img.At(tx + yoffset));
-				}
-				acc += tacc;
-			}
-			if (pacc != 0)
-			{
-				if ((DecimalType<T>(Abs(acc - pacc)) / DecimalType<T>(pacc)) < 0.1)
-				{
-					return strokeswidth;
-				}
-			}
-			pacc = acc;
-		}
-		return defaultval;
+		return impl::StrokesPeriod(img, maxval, defaultval, true);
 	}
 
 	/*****************************************************************************/
 	/*!
 	 * Computes the mean stroke height
 	 *
+	 * The differences between the image and its vertical shifts are computed for several shifts in each pass over the image.
+	 * The shifts of two-level images are all computed in the frequency domain when it is cheaper.
+	 *
 	 * \param[in]	img	the image to binarize
 	 * \param[in]	maxval	if the mean stroke height is > maxval, then defaultval is returned
 	 * \param[in]	defaultval	the value returned if no mean stroke height can be computed
@@ -130,41 +241,21 @@ namespace crn
 	 */
 	template<typename T> size_t StrokesHeight(const Image<T> &img, size_t maxval = 50, size_t defaultval = 0, typename std::enable_if<std::is_arithmetic<T>::value>::type *dummy = nullptr)
 	{
-		auto strokesheight = size_t(0);
-		auto pacc = SumType<T>(0);
-		for (strokesheight = 1; strokesheight < Min(maxval, img.GetHeight()); strokesheight++)
-		{
-			auto acc = SumType<T>(0);
-			for (size_t y = 0; y < img.GetHeight(); y++)
-			{
-				auto tacc = SumType<T>(0);
-				for (size_t x = 0; x < img.GetWidth(); x++)
-				{
-					auto ty = int(y) - int(strokesheight);
-					if (ty < 0) ty += int(img.GetHeight());
-					if (ty >= int(img.GetHeight())) ty -= int(img.GetHeight());
-					tacc += Abs(img.At(x, y) - img.At(x, ty));
-				}
-				acc += tacc;
-			}
-			if (pacc != 0)
-			{
-				if ((DecimalType<T>(Abs(acc - pacc)) / DecimalType<T>(pacc)) < 0.1)
-				{
-					return strokesheight;
-				}
-			}
-			pacc = acc;
-		}
-		return defaultval;
+		return impl::StrokesPeriod(img, maxval, defaultval, false);
 	}
 
 	/*! \brief Computes the mean text line x-height */
 	size_t EstimateLinesXHeight(const ImageGray &img, unsigned int xdiv = 16);
+	/*! \brief Computes the mean text line x-height at a reduced resolution */
+	size_t EstimateLinesXHeight(const ImagePyramidGray &pyr, unsigned int xdiv = 16);
 	/*! \brief Computes the median distance between two baselines */
 	size_t EstimateLeading(const ImageGray &img);
+	/*! \brief Computes the median distance between two baselines at a reduced resolution */
+	size_t EstimateLeading(const ImagePyramidGray &pyr);
 	/*! \brief Estimates the mean skew of the document's lines */
 	Angle<Radian> EstimateSkew(const ImageGray &img);
+	/*! \brief Estimates the mean skew of the document's lines, coarse to fine */
+	Angle<Radian> EstimateSkew(const ImagePyramidGray &pyr);
 
 	/*************************************************************************************
 	 * Conversion
@@ -204,11 +295,110 @@ namespace crn
 	template<typename T, typename CMP = std::less<T>> ImageBW Threshold(const Image<T> &img, T thresh, CMP cmp = std::less<T>{})
 	{
 		auto out = ImageBW(img.GetWidth(), img.GetHeight());
-		for (auto i : Range(img))
-			out.At(i) = cmp(img.At(i), thresh) ? pixel::BWBlack : pixel::BWWhite;
+		impl::ForEachPixelBand(img.Size(), [&img, &out, thresh, &cmp](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+					out.At(i) = cmp(img.At(i), thresh) ? pixel::BWBlack : pixel::BWWhite;
+			});
 		return out;
 	}
 
+	namespace impl
+	{
+		/*! \brief Local sums of pixels and squared pixels
+		 *
+		 * Two summed area tables that give the sum and the squared sum of the pixels in any window in constant time.
+		 * Integer images are summed with 64 bits integers, so the sums are exact.
+		 *
+		 * \author	Yann LEYDIER
+		 * \date	Oct 2016
+		 * \version	0.1
+		 * \ingroup	imagegray
+		 */
+		template<typename T> class LocalMoments
+		{
+			public:
+				using sum_type = typename std::conditional<std::is_integral<T>::value, int64_t, double>::type;
+
+				/*! Constructor
+				 * \param[in]	img	the source image
+				 * \param[in]	hw	the half size of the windows
+				 */
+				LocalMoments(const Image<T> &img, size_t hw):
+					halfwin(hw),
+					width(img.GetWidth()),
+					height(img.GetHeight()),
+					sum(img.GetWidth(), img.GetHeight()),
+					sqrsum(img.GetWidth(), img.GetHeight())
+				{
+					// cumulate rows
+					ParallelFor(0, height, [this, &img](size_t b, size_t e)
+						{
+							for (auto y = b; y < e; ++y)
+							{
+								auto acc = sum_type(0);
+								auto sqracc = sum_type(0);
+								for (size_t x = 0; x < width; ++x)
+								{
+									const auto p = sum_type(img.At(x, y));
+									acc += p;
+									sqracc += p * p;
+									sum.SetValue(x, y, acc);
+									sqrsum.SetValue(x, y, sqracc);
+								}
+							}
+						});
+					// cumulate columns, on bands of columns read row by row
+					ParallelFor(0, width, [this](size_t b, size_t e)
+						{
+							for (size_t y = 1; y < height; ++y)
+								for (auto x = b; x < e; ++x)
+								{
+									sum.SetValue(x, y, sum.GetValue(x, y) + sum.GetValue(x, y - 1));
+									sqrsum.SetValue(x, y, sqrsum.GetValue(x, y) + sqrsum.GetValue(x, y - 1));
+								}
+						}, 0, 64);
+				}
+
+				/*! Computes the statistics of the window centered on a pixel. The window is cropped at the borders of the image.
+				 * \param[in]	x	the abscissa of the center of the window
+				 * \param[in]	y	the ordinate of the center of the window
+				 * \param[out]	s	the sum of the pixels in the window
+				 * \param[out]	s2	the sum of the squared pixels in the window
+				 * \return	the number of pixels in the window
+				 */
+				size_t GetSums(size_t x, size_t y, double &s, double &s2) const
+				{
+					const auto x1 = (x < halfwin) ? 0 : x - halfwin;
+					const auto y1 = (y < halfwin) ? 0 : y - halfwin;
+					const auto x2 = Min(x + halfwin, width - 1);
+					const auto y2 = Min(y + halfwin, height - 1);
+					s = double(sum.GetSum(x1, y1, x2, y2));
+					s2 = double(sqrsum.GetSum(x1, y1, x2, y2));
+					return (x2 - x1 + 1) * (y2 - y1 + 1);
+				}
+
+				/*! Computes the mean and standard deviation of the window centered on a pixel. The window is cropped at the borders of the image.
+				 * \param[in]	x	the abscissa of the center of the window
+				 * \param[in]	y	the ordinate of the center of the window
+				 * \param[out]	m	the mean of the pixels in the window
+				 * \param[out]	sd	the standard deviation of the pixels in the window
+				 */
+				void GetMeanDeviation(size_t x, size_t y, double &m, double &sd) const
+				{
+					auto s = 0.0, s2 = 0.0;
+					const auto size = double(GetSums(x, y, s, s2));
+					m = s / size;
+					sd = sqrt(Max(0.0, s2 / size - Sqr(m)));
+				}
+
+			private:
+				size_t halfwin, width, height;
+				SummedAreaTable<sum_type> sum;
+				SummedAreaTable<sum_type> sqrsum;
+		};
+	}
+
 	/****************************************************************************/
 	/*!
 	 * Creates a BW image using Niblack's algorithm
@@ -221,6 +411,8 @@ namespace crn
 	 *
 	 * <i>t</i> = <i>m</i> + <i>k</i>*<i>s</i>
 	 *
+	 * The local statistics are computed with summed area tables, so the cost does not depend on the size of the window.
+	 *
 	 * \param[in]	img	the image to binarize
 	 * \param[in] halfwin	size of the square window of neighbouring pixels, from the border of the window to the central pixel
 	 * \param[in] k				parameter <i>k</i>
@@ -229,35 +421,17 @@ namespace crn
 	template<typename T> ImageBW Niblack(const Image<T> &img, size_t halfwin, double k = 0.5, typename std::enable_if<std::is_arithmetic<T>::value>::type *dummy = nullptr)
 	{
 		auto out = ImageBW(img.GetWidth(), img.GetHeight());
-		FOREACHPIXEL(x, y, img)
-		{
-			// adjust window
-			auto x1 = (x < halfwin) ? 0 : x - halfwin;
-			auto y1 = (y < halfwin) ? 0 : y - halfwin;
-			auto x2 = x + halfwin;
-			if (x2 >= img.GetWidth()) x2 = img.GetWidth() - 1;
-			auto y2 = y + halfwin;
-			if (y2 >= img.GetHeight()) y2 = img.GetHeight() - 1;
-
-			// compute stats
-			auto sum = DecimalType<T>(0.0);
-			auto sqrsum = DecimalType<T>(0.0);
-			for (auto ty = y1; ty <= y2; ty++)
-				for (auto tx = x1; tx <= x2; tx++)
+		const auto moments = impl::LocalMoments<T>(img, halfwin);
+		impl::ForEachPixelBand(img.Size(), [&img, &out, &moments, k](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
 				{
-					auto p = DecimalType<T>(img.At(tx, ty));
-					sum += p;
-					sqrsum += Sqr(p);
+					auto m = 0.0, sd = 0.0;
+					moments.GetMeanDeviation(i % img.GetWidth(), i / img.GetWidth(), m, sd);
+					const auto t = m  + k * sd ; // original formula
+					out.At(i) = (img.At(i) < T(t)) ? pixel::BWBlack : pixel::BWWhite;
 				}
-			auto size = (x2 - x1 + 1) * (y2 - y1 + 1);
-			auto m = sum / double(size); // mean
-			auto sd = sqrt(sqrsum / double(size) - Sqr(m)); // std deviation
-
-			// compute threshold
-			auto t = m  + k * sd ; // original formula
-
-			out.At(x, y) = (img.At(x, y) < T(t)) ? pixel::BWBlack : pixel::BWWhite;
-		}
+			});
 		return out;
 	}
 
@@ -274,6 +448,8 @@ namespace crn
 	 *
 	 * <i>t</i> = <i>m</i> * (1 + <i>k</i> * (<i>s</i> / <i>R</i> - 1))
 	 *
+	 * The local statistics are computed with summed area tables, so the cost does not depend on the size of the window.
+	 *
 	 * \param[in]	img	the image to binarize
 	 * \param[in] halfwin	size of the square window of neighbouring pixels, from the border of the window to the central pixel
 	 * \param[in] k				parameter <i>k</i>
@@ -286,39 +462,148 @@ namespace crn
 		const auto dynRge = (DecimalType<T>(mM.second) - DecimalType<T>(mM.first)) * 0.5;
 
 		auto out = ImageBW(img.GetWidth(), img.GetHeight());
-		FOREACHPIXEL(x, y, img)
-		{
-			// adjust window
-			auto x1 = (x < halfwin) ? 0 : x - halfwin;
-			auto y1 = (y < halfwin) ? 0 : y - halfwin;
-			auto x2 = x + halfwin;
-			if (x2 >= img.GetWidth()) x2 = img.GetWidth() - 1;
-			auto y2 = y + halfwin;
-			if (y2 >= img.GetHeight()) y2 = img.GetHeight() - 1;
-
-			// compute stats
-			//auto mGL = std::numeric_limits<double>::max(); // min gray
-			auto sum = DecimalType<T>(0.0);
-			auto sqrsum = DecimalType<T>(0.0);
-			for (auto ty = y1; ty <= y2; ty++)
-				for (auto tx = x1; tx <= x2; tx++)
+		const auto moments = impl::LocalMoments<T>(img, halfwin);
+		impl::ForEachPixelBand(img.Size(), [&img, &out, &moments, k, dynRge](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
 				{
-					auto p = DecimalType<T>(img.At(tx, ty));
-					sum += p;
-					sqrsum += Sqr(p);
-					//if (p < mGL) mGL = p;
+					auto m = 0.0, sd = 0.0;
+					moments.GetMeanDeviation(i % img.GetWidth(), i / img.GetWidth(), m, sd);
+					const auto t = m * (1 + k * (sd / dynRge - 1)); // original formula
+					out.At(i) = (img.At(i) < T(t)) ? pixel::BWBlack : pixel::BWWhite;
 				}
-			auto size = (x2 - x1 + 1) * (y2 - y1 + 1);
-			auto m = sum / double(size); // mean
-			auto sd = sqrt(sqrsum / double(size) - Sqr(m)); // std deviation
+			});
+		return out;
+	}
 
-			// compute threshold
-			//auto t = m - k * (1 - sd / dynRge) * (m - mGL); // Wolf's formula
-			auto t = m * (1 + k * (sd / dynRge - 1)); // original formula
+	/****************************************************************************/
+	/*!
+	 * Creates a BW image using Wolf's algorithm
+	 * the binarisation use a threshold on a square window of neighbouring pixels
+	 * the threshold <i>t</i> is calculated by
+	 * 		- mean <i>m</i>
+	 * 		- standard deviation <i>s</i>
+	 * 		- maximal standard deviation of all windows <i>R</i>
+	 * 		- minimal gray level of the image <i>M</i>
+	 * 		- parameter <i>k</i>
+	 * Pixels strictly inferior to the threshold become black, the others white.
+	 *
+	 * <i>t</i> = <i>m</i> - <i>k</i> * (1 - <i>s</i> / <i>R</i>) * (<i>m</i> - <i>M</i>)
+	 *
+	 * \param[in]	img	the image to binarize
+	 * \param[in] halfwin	size of the square window of neighbouring pixels, from the border of the window to the central pixel
+	 * \param[in] k				parameter <i>k</i>
+	 * \return	the newly created image
+	 */
+	template<typename T> ImageBW Wolf(const Image<T> &img, size_t halfwin, double k = 0.5, typename std::enable_if<std::is_arithmetic<T>::value>::type *dummy = nullptr)
+	{
+		const auto mingray = double(MinMax(img).first);
+		const auto moments = impl::LocalMoments<T>(img, halfwin);
 
-			out.At(x, y) = (img.At(x, y) < T(t)) ? pixel::BWBlack : pixel::BWWhite;
-		}
+		// maximal standard deviation
+		auto maxsd = 0.0;
+		std::mutex mutex;
+		ParallelFor(0, img.GetHeight(), [&img, &moments, &maxsd, &mutex](size_t b, size_t e)
+			{
+				auto lmax = 0.0;
+				for (auto y = b; y < e; ++y)
+					for (size_t x = 0; x < img.GetWidth(); ++x)
+					{
+						auto m = 0.0, sd = 0.0;
+						moments.GetMeanDeviation(x, y, m, sd);
+						lmax = Max(lmax, sd);
+					}
+				std::lock_guard<std::mutex> lock(mutex);
+				maxsd = Max(maxsd, lmax);
+			});
+		if (maxsd == 0.0)
+			maxsd = 1.0; // flat image
+
+		auto out = ImageBW(img.GetWidth(), img.GetHeight());
+		impl::ForEachPixelBand(img.Size(), [&img, &out, &moments, k, mingray, maxsd](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+				{
+					auto m = 0.0, sd = 0.0;
+					moments.GetMeanDeviation(i % img.GetWidth(), i / img.GetWidth(), m, sd);
+					const auto t = m - k * (1 - sd / maxsd) * (m - mingray);
+					out.At(i) = (img.At(i) < T(t)) ? pixel::BWBlack : pixel::BWWhite;
+				}
+			});
+		return out;
+	}
+
+	/****************************************************************************/
+	/*!
+	 * Creates a BW image using the NICK algorithm (Khurshid et al.)
+	 * the binarisation use a threshold on a square window of neighbouring pixels
+	 * the threshold <i>t</i> is calculated by
+	 * 		- mean <i>m</i>
+	 * 		- sum of the squared pixels <i>B</i>
+	 * 		- number of pixels <i>N</i>
+	 * 		- parameter <i>k</i> (usually in [-0.2, -0.1])
+	 * Pixels strictly inferior to the threshold become black, the others white.
+	 *
+	 * <i>t</i> = <i>m</i> + <i>k</i> * sqrt((<i>B</i> - <i>m</i>²) / <i>N</i>)
+	 *
+	 * \param[in]	img	the image to binarize
+	 * \param[in] halfwin	size of the square window of neighbouring pixels, from the border of the window to the central pixel
+	 * \param[in] k				parameter <i>k</i>
+	 * \return	the newly created image
+	 */
+	template<typename T> ImageBW NICK(const Image<T> &img, size_t halfwin, double k = -0.1, typename std::enable_if<std::is_arithmetic<T>::value>::type *dummy = nullptr)
+	{
+		auto out = ImageBW(img.GetWidth(), img.GetHeight());
+		const auto moments = impl::LocalMoments<T>(img, halfwin);
+		impl::ForEachPixelBand(img.Size(), [&img, &out, &moments, k](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+				{
+					auto s = 0.0, s2 = 0.0;
+					const auto size = double(moments.GetSums(i % img.GetWidth(), i / img.GetWidth(), s, s2));
+					const auto m = s / size;
+					const auto t = m + k * sqrt(Max(0.0, (s2 - Sqr(m)) / size));
+					out.At(i) = (img.At(i) < T(t)) ? pixel::BWBlack : pixel::BWWhite;
+				}
+			});
+		return out;
+	}
+
+	/****************************************************************************/
+	/*!
+	 * Creates a BW image using Bernsen's algorithm
+	 * the binarisation use a threshold on a square window of neighbouring pixels
+	 * the threshold <i>t</i> is the mid-range of the window: (<i>min</i> + <i>max</i>) / 2.
+	 * Pixels strictly inferior to the threshold become black, the others white.
+	 * Pixels in a window whose contrast (<i>max</i> - <i>min</i>) is lower than the minimal contrast are considered as background and become white.
+	 *
+	 * The local extrema are computed with FastDilate and FastErode.
+	 *
+	 * \param[in]	img	the image to binarize
+	 * \param[in] halfwin	size of the square window of neighbouring pixels, from the border of the window to the central pixel
+	 * \param[in] mincontrast	the minimal contrast of a window to contain foreground pixels
+	 * \return	the newly created image
+	 */
+	template<typename T> ImageBW Bernsen(const Image<T> &img, size_t halfwin, T mincontrast = T(15), typename std::enable_if<std::is_arithmetic<T>::value>::type *dummy = nullptr)
+	{
+		auto minimg = img;
+		minimg.FastDilate(halfwin);
+		auto maximg = img;
+		maximg.FastErode(halfwin);
 
+		auto out = ImageBW(img.GetWidth(), img.GetHeight());
+		impl::ForEachPixelBand(img.Size(), [&img, &out, &minimg, &maximg, mincontrast](size_t b, size_t e)
+			{
+				for (auto i = b; i < e; ++i)
+				{
+					const auto mi = DecimalType<T>(minimg.At(i));
+					const auto ma = DecimalType<T>(maximg.At(i));
+					if (ma - mi < DecimalType<T>(mincontrast))
+						out.At(i) = pixel::BWWhite;
+					else
+						out.At(i) = (img.At(i) < T((mi + ma) / 2)) ? pixel::BWBlack : pixel::BWWhite;
+				}
+			});
 		return out;
 	}
 
@@ -681,6 +966,51 @@ namespace crn
 				CRN_SERIALIZATION_CONSTRUCTOR(Gray2BWSauvola)
 	};
 
+	/*! \brief Wolf binarization action
+	 * \ingroup action
+	 */
+	class Gray2BWWolf: public Gray2BW
+	{
+		public:
+			/*! \brief Default constructor */
+			Gray2BWWolf(size_t halfwin = 3, double k = 0.5);
+			virtual ~Gray2BWWolf() override { }
+			virtual StringUTF8 GetClassName() const override { return "Gray2BWWolf"; }
+			virtual ImageBW Binarize(const ImageGray &img) override;
+			CRN_DECLARE_CLASS_CONSTRUCTOR(Gray2BWWolf)
+				CRN_SERIALIZATION_CONSTRUCTOR(Gray2BWWolf)
+	};
+
+	/*! \brief NICK binarization action
+	 * \ingroup action
+	 */
+	class Gray2BWNICK: public Gray2BW
+	{
+		public:
+			/*! \brief Default constructor */
+			Gray2BWNICK(size_t halfwin = 3, double k = -0.1);
+			virtual ~Gray2BWNICK() override { }
+			virtual StringUTF8 GetClassName() const override { return "Gray2BWNICK"; }
+			virtual ImageBW Binarize(const ImageGray &img) override;
+			CRN_DECLARE_CLASS_CONSTRUCTOR(Gray2BWNICK)
+				CRN_SERIALIZATION_CONSTRUCTOR(Gray2BWNICK)
+	};
+
+	/*! \brief Bernsen binarization action
+	 * \ingroup action
+	 */
+	class Gray2BWBernsen: public Gray2BW
+	{
+		public:
+			/*! \brief Default constructor */
+			Gray2BWBernsen(size_t halfwin = 3, uint8_t mincontrast = 15);
+			virtual ~Gray2BWBernsen() override { }
+			virtual StringUTF8 GetClassName() const override { return "Gray2BWBernsen"; }
+			virtual ImageBW Binarize(const ImageGray &img) override;
+			CRN_DECLARE_CLASS_CONSTRUCTOR(Gray2BWBernsen)
+				CRN_SERIALIZATION_CONSTRUCTOR(Gray2BWBernsen)
+	};
+
 	/*! \brief k-means histo binarization action
 	 * \ingroup action
 	 */
@@ -775,6 +1105,9 @@ namespace crn
 	template<> struct IsSerializable<Gray2BWThreshold> : public std::true_type {};
 	template<> struct IsSerializable<Gray2BWNiblack> : public std::true_type {};
 	template<> struct IsSerializable<Gray2BWSauvola> : public std::true_type {};
+	template<> struct IsSerializable<Gray2BWWolf> : public std::true_type {};
+	template<> struct IsSerializable<Gray2BWNICK> : public std::true_type {};
+	template<> struct IsSerializable<Gray2BWBernsen> : public std::true_type {};
 	template<> struct IsSerializable<Gray2BWkMeansHisto> : public std::true_type {};
 	template<> struct IsSerializable<Gray2BWLocalMin> : public std::true_type {};
 	template<> struct IsSerializable<Gray2BWLocalMax> : public std::true_type {};
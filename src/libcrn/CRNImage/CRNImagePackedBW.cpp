@@ -0,0 +1,501 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNImagePackedBW.cpp
+ * \author Yann LEYDIER
+ */
+
+#include <CRNImage/CRNImagePackedBW.h>
+#include <CRNStatistics/CRNHistogram.h>
+#include <CRNException.h>
+#include <CRNStringUTF8.h>
+#include <CRNi18n.h>
+#include <algorithm>
+
+using namespace crn;
+
+using word_type = ImagePackedBW::word_type;
+
+/*! \return	the number of set bits */
+static inline size_t popcount(word_type w) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return size_t(__builtin_popcountll(w));
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return size_t((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/*! \return	the index of the lowest set bit (w must not be null) */
+static inline size_t lowest_bit(word_type w) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return size_t(__builtin_ctzll(w));
+#else
+	auto n = size_t(0);
+	while (!(w & 1))
+	{
+		w >>= 1;
+		n += 1;
+	}
+	return n;
+#endif
+}
+
+/*! \return	the index of the highest set bit (w must not be null) */
+static inline size_t highest_bit(word_type w) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return size_t(63 - __builtin_clzll(w));
+#else
+	auto n = size_t(63);
+	while (!(w >> 63))
+	{
+		w <<= 1;
+		n -= 1;
+	}
+	return n;
+#endif
+}
+
+/*! Calls a function on each set bit of a word
+ * \param[in]	w	the word
+ * \param[in]	base	the index of the first bit of the word
+ * \param[in]	fun	a function (size_t index)
+ */
+template<typename FUNC> static inline void for_each_bit(word_type w, size_t base, FUNC &&fun)
+{
+	while (w)
+	{
+		fun(base + lowest_bit(w));
+		w &= w - 1;
+	}
+}
+
+/*! Constructor
+ * \param[in]	w	the width of the image
+ * \param[in]	h	the height of the image
+ * \param[in]	val	the initial value of the pixels
+ */
+ImagePackedBW::ImagePackedBW(size_t w, size_t h, pixel::BW val):
+	width(w),
+	height(h),
+	stride((w + WordBits - 1) / WordBits),
+	words(stride * h, val ? ~word_type(0) : word_type(0))
+{
+	clearPadding();
+}
+
+/*! Conversion from an ImageBW
+ * \param[in]	img	the image to pack
+ */
+ImagePackedBW::ImagePackedBW(const ImageBW &img):
+	ImagePackedBW(img.GetWidth(), img.GetHeight(), pixel::BWBlack)
+{
+	ParallelFor(0, height, [this, &img](size_t b, size_t e)
+		{
+			for (auto y = b; y < e; ++y)
+			{
+				auto *row = GetRow(y);
+				for (size_t x = 0; x < width; ++x)
+					if (img.At(x, y))
+						row[x / WordBits] |= word_type(1) << (x % WordBits);
+			}
+		});
+}
+
+/*! \return	the mask of the bits of the last word of a row that are pixels */
+word_type ImagePackedBW::GetLastWordMask() const noexcept
+{
+	const auto r = width % WordBits;
+	return r ? (word_type(1) << r) - 1 : ~word_type(0);
+}
+
+void ImagePackedBW::clearPadding() noexcept
+{
+	if (!stride)
+		return;
+	const auto mask = GetLastWordMask();
+	for (size_t y = 0; y < height; ++y)
+		words[y * stride + stride - 1] &= mask;
+}
+
+/*!
+ * \param[in]	other	the image to compare
+ * \return	true if both images have the same dimensions and pixels
+ */
+bool ImagePackedBW::operator==(const ImagePackedBW &other) const noexcept
+{
+	return (width == other.width) && (height == other.height) && (words == other.words);
+}
+
+/*!
+ * \throws	ExceptionDimension	images do not have the same size
+ * \param[in]	other	the image to combine with
+ * \return	a reference to the image
+ */
+ImagePackedBW& ImagePackedBW::operator&=(const ImagePackedBW &other)
+{
+	if ((width != other.width) || (height != other.height))
+		throw ExceptionDimension(StringUTF8("ImagePackedBW& ImagePackedBW::operator&=(const ImagePackedBW &other): ") + _("images do not have the same size."));
+	for (auto tmp : Range(words))
+		words[tmp] &= other.words[tmp];
+	return *this;
+}
+
+/*!
+ * \throws	ExceptionDimension	images do not have the same size
+ * \param[in]	other	the image to combine with
+ * \return	a reference to the image
+ */
+ImagePackedBW& ImagePackedBW::operator|=(const ImagePackedBW &other)
+{
+	if ((width != other.width) || (height != other.height))
+		throw ExceptionDimension(StringUTF8("ImagePackedBW& ImagePackedBW::operator|=(const ImagePackedBW &other): ") + _("images do not have the same size."));
+	for (auto tmp : Range(words))
+		words[tmp] |= other.words[tmp];
+	return *this;
+}
+
+/*!
+ * \throws	ExceptionDimension	images do not have the same size
+ * \param[in]	other	the image to combine with
+ * \return	a reference to the image
+ */
+ImagePackedBW& ImagePackedBW::operator^=(const ImagePackedBW &other)
+{
+	if ((width != other.width) || (height != other.height))
+		throw ExceptionDimension(StringUTF8("ImagePackedBW& ImagePackedBW::operator^=(const ImagePackedBW &other): ") + _("images do not have the same size."));
+	for (auto tmp : Range(words))
+		words[tmp] ^= other.words[tmp];
+	return *this;
+}
+
+void ImagePackedBW::Negative() noexcept
+{
+	for (auto &w : words)
+		w = ~w;
+	clearPadding();
+}
+
+/*! Converts to an ImageBW
+ * \param[in]	img	the packed image
+ * \return	a new image
+ */
+ImageBW crn::MakeImageBW(const ImagePackedBW &img)
+{
+	auto res = ImageBW(img.GetWidth(), img.GetHeight());
+	const auto w = img.GetWidth();
+	impl::ForEachPixelBand(res.Size(), [&img, &res, w](size_t b, size_t e)
+		{
+			for (auto i = b; i < e; ++i)
+				res.At(i) = img.At(i % w, i / w);
+		});
+	return res;
+}
+
+/*! Computes the left profile
+ * \param[in]	img	the source image
+ * \return	an histogram containing the profile
+ */
+Histogram crn::LeftProfile(const ImagePackedBW &img)
+{
+	auto h = Histogram(img.GetHeight(), (unsigned int)img.GetWidth());
+	const auto last = img.GetStride() - 1;
+	const auto mask = img.GetLastWordMask();
+	for (size_t y = 0; y < img.GetHeight(); ++y)
+	{
+		const auto *row = img.GetRow(y);
+		for (size_t i = 0; i < img.GetStride(); ++i)
+		{
+			const auto black = ~row[i] & (i == last ? mask : ~word_type(0));
+			if (black)
+			{
+				h.SetBin(y, (unsigned int)(i * ImagePackedBW::WordBits + lowest_bit(black)));
+				break;
+			}
+		}
+	}
+	return h;
+}
+
+/*! Computes the right profile
+ * \param[in]	img	the source image
+ * \return	an histogram containing the profile
+ */
+Histogram crn::RightProfile(const ImagePackedBW &img)
+{
+	auto h = Histogram(img.GetHeight(), (unsigned int)img.GetWidth());
+	const auto last = img.GetStride() - 1;
+	const auto mask = img.GetLastWordMask();
+	for (size_t y = 0; y < img.GetHeight(); ++y)
+	{
+		const auto *row = img.GetRow(y);
+		for (auto i = img.GetStride(); i > 0; --i)
+		{
+			const auto black = ~row[i - 1] & (i - 1 == last ? mask : ~word_type(0));
+			if (black)
+			{
+				h.SetBin(y, (unsigned int)(img.GetWidth() - 1 - ((i - 1) * ImagePackedBW::WordBits + highest_bit(black))));
+				break;
+			}
+		}
+	}
+	return h;
+}
+
+/*! Computes the top or bottom profile
+ * \param[in]	img	the source image
+ * \param[in]	top	true for the top profile, false for the bottom profile
+ * \return	an histogram containing the profile
+ */
+static Histogram vertical_profile(const ImagePackedBW &img, bool top)
+{
+	auto h = Histogram(img.GetWidth(), (unsigned int)img.GetHeight());
+	// the columns where a black pixel was already found
+	auto found = std::vector<word_type>(img.GetStride(), word_type(0));
+	found.back() = ~img.GetLastWordMask();
+	for (size_t tmp = 0; tmp < img.GetHeight(); ++tmp)
+	{
+		const auto y = top ? tmp : img.GetHeight() - 1 - tmp;
+		const auto *row = img.GetRow(y);
+		auto done = true;
+		for (size_t i = 0; i < img.GetStride(); ++i)
+		{
+			const auto black = ~row[i] & ~found[i];
+			for_each_bit(black, i * ImagePackedBW::WordBits, [&h, tmp](size_t x) { h.SetBin(x, (unsigned int)tmp); });
+			found[i] |= black;
+			done = done && (found[i] == ~word_type(0));
+		}
+		if (done)
+			break;
+	}
+	return h;
+}
+
+/*! Computes the top profile
+ * \param[in]	img	the source image
+ * \return	an histogram containing the profile
+ */
+Histogram crn::TopProfile(const ImagePackedBW &img)
+{
+	if (!img.GetStride())
+		return Histogram(0);
+	return vertical_profile(img, true);
+}
+
+/*! Computes the bottom profile
+ * \param[in]	img	the source image
+ * \return	an histogram containing the profile
+ */
+Histogram crn::BottomProfile(const ImagePackedBW &img)
+{
+	if (!img.GetStride())
+		return Histogram(0);
+	return vertical_profile(img, false);
+}
+
+/*! Computes the horizontal projection
+ * \param[in]	img	the source image
+ * \return	an histogram containing the projection
+ */
+Histogram crn::HorizontalProjection(const ImagePackedBW &img)
+{
+	auto h = Histogram(img.GetHeight());
+	for (size_t y = 0; y < img.GetHeight(); ++y)
+	{
+		const auto *row = img.GetRow(y);
+		auto white = size_t(0);
+		for (size_t i = 0; i < img.GetStride(); ++i)
+			white += popcount(row[i]);
+		h.SetBin(y, (unsigned int)(img.GetWidth() - white));
+	}
+	return h;
+}
+
+/*! Computes the vertical projection
+ * \param[in]	img	the source image
+ * \return	an histogram containing the projection
+ */
+Histogram crn::VerticalProjection(const ImagePackedBW &img)
+{
+	auto h = Histogram(img.GetWidth());
+	if (!img.GetStride())
+		return h;
+	const auto last = img.GetStride() - 1;
+	const auto mask = img.GetLastWordMask();
+	for (size_t y = 0; y < img.GetHeight(); ++y)
+	{
+		const auto *row = img.GetRow(y);
+		for (size_t i = 0; i < img.GetStride(); ++i)
+			for_each_bit(~row[i] & (i == last ? mask : ~word_type(0)), i * ImagePackedBW::WordBits, [&h](size_t x) { h.IncBin(x); });
+	}
+	return h;
+}
+
+/*! Calls a function on each horizontal transition of a row
+ * \param[in]	img	the image
+ * \param[in]	y	the row
+ * \param[in]	fun	a function (size_t x) called for each x > 0 such as pixel x differs from pixel x - 1
+ */
+template<typename FUNC> static inline void for_each_transition(const ImagePackedBW &img, size_t y, FUNC &&fun)
+{
+	const auto *row = img.GetRow(y);
+	const auto last = img.GetStride() - 1;
+	auto carry = row[0] & 1;
+	for (size_t i = 0; i < img.GetStride(); ++i)
+	{
+		const auto prev = (row[i] << 1) | carry;
+		carry = row[i] >> (ImagePackedBW::WordBits - 1);
+		auto diff = row[i] ^ prev;
+		if (i == last)
+			diff &= img.GetLastWordMask();
+		if (i == 0)
+			diff &= ~word_type(1); // no transition on the first pixel
+		for_each_bit(diff, i * ImagePackedBW::WordBits, fun);
+	}
+}
+
+/*!
+ * Gets the mean horizontal black run
+ *
+ * \param[in]	img	the source image
+ * \return The mean black run
+ */
+double crn::MeanBlackRun(const ImagePackedBW &img) noexcept
+{
+	auto sum = 0L;
+	auto cnt = 0L;
+	if (!img.GetStride())
+		return double(sum) / double(cnt);
+	for (size_t y = 0; y < img.GetHeight(); y++)
+	{
+		auto beg = size_t(0);
+		for_each_transition(img, y, [&img, &sum, &cnt, &beg, y](size_t x)
+			{
+				if (!img.At(x, y))
+					beg = x;
+				else
+				{
+					sum += long(x) - long(beg);
+					cnt += 1;
+				}
+			});
+	}
+	return double(sum) / double(cnt);
+}
+
+/*!
+ * Gets the mean horizontal white run.
+ * This functions uses the mean black run in order to filter the page runs and only keep the intra-word runs.
+ *
+ * \param[in]	img	the source image
+ * \param[in]	blackrun	The mean black run. If -1, then computes it. default = -1.
+ * \return The mean white run
+ */
+double crn::MeanWhiteRun(const ImagePackedBW &img, int blackrun) noexcept
+{
+	const auto RUNFACT = 2;
+	if (blackrun == -1)
+		blackrun = int(MeanBlackRun(img));
+	auto sum = 0L;
+	auto cnt = 0L;
+	if (img.GetStride())
+		for (size_t y = 0; y < img.GetHeight(); y++)
+		{
+			auto beg = size_t(0);
+			for_each_transition(img, y, [&img, &sum, &cnt, &beg, blackrun, RUNFACT, y](size_t x)
+				{
+					if (img.At(x, y))
+						beg = x;
+					else if (int(x - beg) < blackrun * RUNFACT)
+					{
+						sum += long(x) - long(beg);
+						cnt += 1;
+					}
+				});
+		}
+	if (!cnt)
+		return 0.0;
+	else
+		return double(sum) / double(cnt);
+}
+
+/*!
+ * Gets the mean vertical black run
+ *
+ * \param[in]	img	the source image
+ * \return The mean vertical black run
+ */
+double crn::MeanBlackVRun(const ImagePackedBW &img)
+{
+	auto sum = 0L;
+	auto cnt = 0L;
+	auto beg = std::vector<size_t>(img.GetWidth(), 0);
+	// the columns in a black run that started with a transition
+	auto in = std::vector<word_type>(img.GetStride(), word_type(0));
+	for (size_t y = 1; y < img.GetHeight(); y++)
+	{
+		const auto *prev = img.GetRow(y - 1);
+		const auto *row = img.GetRow(y);
+		for (size_t i = 0; i < img.GetStride(); ++i)
+		{
+			const auto diff = row[i] ^ prev[i];
+			// white to black
+			for_each_bit(diff & ~row[i], i * ImagePackedBW::WordBits, [&beg, y](size_t x) { beg[x] = y; });
+			// black to white
+			for_each_bit(diff & row[i] & in[i], i * ImagePackedBW::WordBits, [&beg, &sum, &cnt, y](size_t x)
+				{
+					sum += long(y) - long(beg[x]);
+					cnt += 1;
+				});
+			in[i] = (in[i] & ~diff) | (diff & ~row[i]);
+		}
+	}
+	if (!cnt)
+		return 0.0;
+	return double(sum) / double(cnt);
+}
+
+/*! Returns the number of black pixels
+ * \param[in]	img	the source image
+ * \return	the number of black pixels
+ */
+size_t crn::CountBlackPixels(const ImagePackedBW &img) noexcept
+{
+	return img.Size() - CountWhitePixels(img);
+}
+
+/*! Returns the number of white pixels
+ * \param[in]	img	the source image
+ * \return	the number of white pixels
+ */
+size_t crn::CountWhitePixels(const ImagePackedBW &img) noexcept
+{
+	auto cnt = size_t(0);
+	for (size_t y = 0; y < img.GetHeight(); ++y)
+	{
+		const auto *row = img.GetRow(y);
+		for (size_t i = 0; i < img.GetStride(); ++i)
+			cnt += popcount(row[i]);
+	}
+	return cnt;
+}
+
@@ -0,0 +1,156 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNImagePackedBW.h
+ * \author Yann LEYDIER
+ */
+
+#ifndef CRNImagePackedBW_HEADER
+#define CRNImagePackedBW_HEADER
+
+#include <CRNImage/CRNImageBW.h>
+#include <cstdint>
+
+namespace crn
+{
+	class Histogram;
+
+	/****************************************************************************/
+	/*! \brief Bitonal image with one bit per pixel
+	 *
+	 * Bitonal image stored as 64 bits words. Each row starts on a new word and the bits past the width of the image are always 0.
+	 * Bit x % 64 of word x / 64 of a row is the pixel x. A set bit is a white pixel.
+	 *
+	 * The analysis functions process a whole word at once (population count, leading and trailing zeros).
+	 *
+	 * \author  Yann LEYDIER
+	 * \date    Oct 2016
+	 * \version 0.1
+	 * \ingroup imagebw
+	 */
+	class ImagePackedBW
+	{
+		public:
+			using word_type = uint64_t;
+			/*! \brief Number of pixels in a word */
+			static constexpr size_t WordBits = 64;
+
+			/*! \brief Constructor */
+			ImagePackedBW(size_t w = 0, size_t h = 0, pixel::BW val = pixel::BWWhite);
+			/*! \brief Conversion from an ImageBW */
+			explicit ImagePackedBW(const ImageBW &img);
+
+			ImagePackedBW(const ImagePackedBW &) = default;
+			ImagePackedBW(ImagePackedBW &&) = default;
+			ImagePackedBW& operator=(const ImagePackedBW &) = default;
+			ImagePackedBW& operator=(ImagePackedBW &&) = default;
+
+			/*! \brief Returns the width of the image */
+			size_t GetWidth() const noexcept { return width; }
+			/*! \brief Returns the height of the image */
+			size_t GetHeight() const noexcept { return height; }
+			/*! \brief Returns the number of pixels */
+			size_t Size() const noexcept { return width * height; }
+			/*! \brief Returns the number of words in a row */
+			size_t GetStride() const noexcept { return stride; }
+
+			/*! \brief Returns a pixel
+			 * \warning	no bound checking
+			 * \param[in]	x	the abscissa
+			 * \param[in]	y	the ordinate
+			 * \return	the value of the pixel
+			 */
+			pixel::BW At(size_t x, size_t y) const noexcept { return (words[y * stride + x / WordBits] >> (x % WordBits)) & 1; }
+			/*! \brief Sets a pixel
+			 * \warning	no bound checking
+			 * \param[in]	x	the abscissa
+			 * \param[in]	y	the ordinate
+			 * \param[in]	val	the new value of the pixel
+			 */
+			void Set(size_t x, size_t y, pixel::BW val) noexcept
+			{
+				const auto mask = word_type(1) << (x % WordBits);
+				auto &w = words[y * stride + x / WordBits];
+				if (val)
+					w |= mask;
+				else
+					w &= ~mask;
+			}
+
+			/*! \brief Returns a pointer to the words of a row */
+			word_type* GetRow(size_t y) noexcept { return words.data() + y * stride; }
+			/*! \brief Returns a pointer to the words of a row */
+			const word_type* GetRow(size_t y) const noexcept { return words.data() + y * stride; }
+			/*! \brief Returns the mask of the valid bits of the last word of a row */
+			word_type GetLastWordMask() const noexcept;
+
+			/*! \brief Tests if two images are identical */
+			bool operator==(const ImagePackedBW &other) const noexcept;
+			/*! \brief Tests if two images are different */
+			bool operator!=(const ImagePackedBW &other) const noexcept { return !(*this == other); }
+
+			/*! \brief Logical and (union of black pixels) */
+			ImagePackedBW& operator&=(const ImagePackedBW &other);
+			/*! \brief Logical or (intersection of black pixels) */
+			ImagePackedBW& operator|=(const ImagePackedBW &other);
+			/*! \brief Exclusive or */
+			ImagePackedBW& operator^=(const ImagePackedBW &other);
+			/*! \brief Swaps black and white */
+			void Negative() noexcept;
+
+		private:
+			/*! \brief Resets the bits past the width of the image */
+			void clearPadding() noexcept;
+
+			size_t width; /*!< the width of the image */
+			size_t height; /*!< the height of the image */
+			size_t stride; /*!< the number of words in a row */
+			std::vector<word_type> words; /*!< the pixels */
+	};
+
+	/*! \addtogroup imagebw */
+	/*@{*/
+	/*! \brief Converts to an ImageBW */
+	ImageBW MakeImageBW(const ImagePackedBW &img);
+
+	/*! \brief Computes the left profile */
+	Histogram LeftProfile(const ImagePackedBW &img);
+	/*! \brief Computes the right profile */
+	Histogram RightProfile(const ImagePackedBW &img);
+	/*! \brief Computes the top profile */
+	Histogram TopProfile(const ImagePackedBW &img);
+	/*! \brief Computes the bottom profile */
+	Histogram BottomProfile(const ImagePackedBW &img);
+	/*! \brief Computes the horizontal projection */
+	Histogram HorizontalProjection(const ImagePackedBW &img);
+	/*! \brief Computes the vertical projection */
+	Histogram VerticalProjection(const ImagePackedBW &img);
+
+	/*! \brief Gets the mean horizontal black run */
+	double MeanBlackRun(const ImagePackedBW &img) noexcept;
+	/*! \brief Gets the mean horizontal white run */
+	double MeanWhiteRun(const ImagePackedBW &img, int blackrun = -1) noexcept;
+	/*! \brief Gets the mean vertical black run */
+	double MeanBlackVRun(const ImagePackedBW &img);
+	/*! \brief Returns the number of black pixels */
+	size_t CountBlackPixels(const ImagePackedBW &img) noexcept;
+	/*! \brief Returns the number of white pixels */
+	size_t CountWhitePixels(const ImagePackedBW &img) noexcept;
+	/*@}*/
+}
+
+#endif
@@ -0,0 +1,100 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNImagePyramid.h
+ * \author Yann LEYDIER
+ */
+
+#ifndef CRNImagePyramid_HEADER
+#define CRNImagePyramid_HEADER
+
+#include <CRNImage/CRNImage.h>
+
+namespace crn
+{
+	/****************************************************************************/
+	/*! \brief Multi-resolution representation of an image
+	 *
+	 * Level 0 is the source image, that is shared and not copied. Each following level is half the size of the previous one (mean of 2×2 pixels).
+	 * The levels are computed once at construction, until the smallest dimension of the image is smaller than twice the minimal size.
+	 *
+	 * A coordinate x at level l is roughly x << l at level 0.
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date		Oct 2016
+	 * \version 0.1
+	 * \ingroup image
+	 */
+	template<typename T> class ImagePyramid
+	{
+		public:
+			/*! \brief Constructor
+			 * \throws	ExceptionInvalidArgument	null image
+			 * \param[in]	img	the full resolution image
+			 * \param[in]	minsize	the minimal width and height of the levels
+			 */
+			explicit ImagePyramid(std::shared_ptr<const Image<T>> img, size_t minsize = 64)
+			{
+				if (!img)
+					throw ExceptionInvalidArgument("ImagePyramid::ImagePyramid(std::shared_ptr<const Image<T>> img, size_t minsize): null image.");
+				levels.push_back(std::move(img));
+				while ((levels.back()->GetWidth() / 2 >= Max(minsize, size_t(1))) && (levels.back()->GetHeight() / 2 >= Max(minsize, size_t(1))))
+				{
+					auto next = std::make_shared<Image<T>>(*levels.back());
+					next->ScaleToSize(levels.back()->GetWidth() / 2, levels.back()->GetHeight() / 2, Resampling::AREA);
+					levels.push_back(std::move(next));
+				}
+			}
+
+			ImagePyramid(const ImagePyramid &) = default;
+			ImagePyramid(ImagePyramid &&) = default;
+			ImagePyramid& operator=(const ImagePyramid &) = default;
+			ImagePyramid& operator=(ImagePyramid &&) = default;
+
+			/*! \brief Returns the number of levels (at least 1) */
+			size_t GetLevelCount() const noexcept { return levels.size(); }
+			/*! \brief Returns a level
+			 * \throws	ExceptionDomain	no such level
+			 * \param[in]	level	the index of the level, 0 being the full resolution
+			 * \return	the image at the level
+			 */
+			const Image<T>& GetLevel(size_t level) const
+			{
+				if (level >= levels.size())
+					throw ExceptionDomain("const Image<T>& ImagePyramid::GetLevel(size_t level) const: no such level.");
+				return *levels[level];
+			}
+			/*! \brief Returns the reduction factor of a level (2^level) */
+			static size_t GetFactor(size_t level) noexcept { return size_t(1) << level; }
+			/*! \brief Returns the number of bytes used by the reduced levels (the full resolution image is not counted) */
+			size_t GetBytes() const noexcept
+			{
+				auto bytes = size_t(0);
+				for (size_t l = 1; l < levels.size(); ++l)
+					bytes += levels[l]->Size() * sizeof(T);
+				return bytes;
+			}
+
+		private:
+			std::vector<std::shared_ptr<const Image<T>>> levels; /*!< the levels, from the finest to the coarsest */
+	};
+
+	using ImagePyramidGray = ImagePyramid<uint8_t>;
+	CRN_ALIAS_SMART_PTR(ImagePyramidGray);
+}
+
+#endif
@@ -0,0 +1,141 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNImageView.h
+ * \author Yann LEYDIER
+ */
+
+#ifndef CRNImageView_HEADER
+#define CRNImageView_HEADER
+
+#include <CRNImage/CRNImage.h>
+#include <CRNGeometry/CRNRect.h>
+
+namespace crn
+{
+	/****************************************************************************/
+	/*! \brief Read-only view on a rectangle of an image
+	 *
+	 * A view shares the pixels of an image instead of copying them. It keeps the image alive, so it remains valid after the owner of the image released it.
+	 * The pixels are not copied until Copy() is called.
+	 *
+	 * \warning	the view reflects the modifications of the viewed image and is invalidated if the image is resized
+	 *
+	 * \author  Yann LEYDIER
+	 * \date    Oct 2016
+	 * \version 0.1
+	 * \ingroup image
+	 */
+	template<typename T> class ImageView
+	{
+		public:
+			using pixel_type = T;
+
+			/*! \brief Null view */
+			ImageView() noexcept: x0(0), y0(0), width(0), height(0) {}
+			/*! \brief View on a whole image
+			 * \param[in]	img	the image to view
+			 */
+			explicit ImageView(std::shared_ptr<const Image<T>> img) noexcept:
+				storage(std::move(img)), x0(0), y0(0),
+				width(storage ? storage->GetWidth() : 0), height(storage ? storage->GetHeight() : 0)
+			{}
+			/*! \brief View on a rectangle of an image
+			 * \throws	ExceptionDimension	the rectangle is not inside the image
+			 * \param[in]	img	the image to view
+			 * \param[in]	bbox	the rectangle to view
+			 */
+			ImageView(std::shared_ptr<const Image<T>> img, const Rect &bbox):
+				storage(std::move(img)), x0(0), y0(0), width(0), height(0)
+			{
+				if (!storage || !bbox.IsValid() || (bbox.GetLeft() < 0) || (bbox.GetTop() < 0) ||
+						(bbox.GetRight() >= int(storage->GetWidth())) || (bbox.GetBottom() >= int(storage->GetHeight())))
+					throw ExceptionDimension("ImageView::ImageView(std::shared_ptr<const Image<T>> img, const Rect &bbox): the rectangle is not inside the image.");
+				x0 = size_t(bbox.GetLeft());
+				y0 = size_t(bbox.GetTop());
+				width = size_t(bbox.GetWidth());
+				height = size_t(bbox.GetHeight());
+			}
+
+			ImageView(const ImageView&) = default;
+			ImageView(ImageView&&) = default;
+			ImageView& operator=(const ImageView&) = default;
+			ImageView& operator=(ImageView&&) = default;
+
+			/*! \brief Is the view valid? */
+			explicit operator bool() const noexcept { return bool(storage); }
+
+			/*! \brief Returns the width of the view */
+			size_t GetWidth() const noexcept { return width; }
+			/*! \brief Returns the height of the view */
+			size_t GetHeight() const noexcept { return height; }
+			/*! \brief Returns the number of pixels of the view */
+			size_t Size() const noexcept { return width * height; }
+			/*! \brief Returns the rectangle of the viewed image */
+			Rect GetBBox() const { return Rect(int(x0), int(y0), int(x0 + width) - 1, int(y0 + height) - 1); }
+			/*! \brief Returns the viewed image */
+			const std::shared_ptr<const Image<T>>& GetStorage() const noexcept { return storage; }
+			/*! \brief Returns the offset of a pixel in the viewed image's pixel array */
+			size_t GetOffset(size_t x, size_t y) const noexcept { return x0 + x + (y0 + y) * storage->GetWidth(); }
+
+			/*! \brief Returns a reference to a pixel
+			 * \warning	no bound checking
+			 * \param[in]	x	the abscissa in the view
+			 * \param[in]	y	the ordinate in the view
+			 * \return	a reference to the pixel in the viewed image
+			 */
+			typename std::vector<T>::const_reference At(size_t x, size_t y) const noexcept { return storage->At(x0 + x, y0 + y); }
+
+			/*! \brief Creates a view on a rectangle of the view
+			 * \throws	ExceptionDimension	the rectangle is not inside the view
+			 * \param[in]	bbox	the rectangle in the view's coordinates
+			 * \return	a view on the same image
+			 */
+			ImageView Sub(const Rect &bbox) const
+			{
+				if (!bbox.IsValid() || (bbox.GetLeft() < 0) || (bbox.GetTop() < 0) || (bbox.GetRight() >= int(width)) || (bbox.GetBottom() >= int(height)))
+					throw ExceptionDimension("ImageView ImageView::Sub(const Rect &bbox) const: the rectangle is not inside the view.");
+				auto r = bbox;
+				r.Translate(int(x0), int(y0));
+				return ImageView(storage, r);
+			}
+
+			/*! \brief Copies the viewed pixels to a new image
+			 * \throws	ExceptionUninitialized	null view
+			 * \return	a new image
+			 */
+			Image<T> Copy() const
+			{
+				if (!storage)
+					throw ExceptionUninitialized("Image<T> ImageView::Copy() const: null view.");
+				return Image<T>(*storage, GetBBox());
+			}
+
+		private:
+			std::shared_ptr<const Image<T>> storage; /*!< the viewed image */
+			size_t x0; /*!< the abscissa of the view in the image */
+			size_t y0; /*!< the ordinate of the view in the image */
+			size_t width; /*!< the width of the view */
+			size_t height; /*!< the height of the view */
+	};
+
+	using ImageViewBW = ImageView<pixel::BW>;
+	using ImageViewGray = ImageView<uint8_t>;
+	using ImageViewRGB = ImageView<pixel::RGB<uint8_t>>;
+}
+
+#endif
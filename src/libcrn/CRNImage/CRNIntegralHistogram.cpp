@@ -0,0 +1,95 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNIntegralHistogram.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include <CRNImage/CRNIntegralHistogram.h>
+#include <CRNStatistics/CRNHistogram.h>
+#include <CRNStringUTF8.h>
+#include <CRNException.h>
+#include <CRNi18n.h>
+
+using namespace crn;
+
+/*****************************************************************************/
+/*!
+ * Constructor. The rows are accumulated in parallel, then the columns by bands in parallel.
+ *
+ * \throws	ExceptionDomain	the number of bins is not a power of 2 between 1 and 256
+ *
+ * \param[in]	img	the source image
+ * \param[in]	nb	the number of bins (each bin covers 256 / nb gray levels)
+ */
+IntegralHistogram::IntegralHistogram(const ImageGray &img, size_t nb):
+	width(img.GetWidth()),
+	height(img.GetHeight()),
+	nbins(nb),
+	shift(0)
+{
+	if (!nbins || (nbins > 256) || (nbins & (nbins - 1)))
+		throw ExceptionDomain(StringUTF8("IntegralHistogram::IntegralHistogram(const ImageGray &img, size_t nb): ") + _("the number of bins must be a power of 2 between 1 and 256."));
+	while ((size_t(256) >> shift) > nbins)
+		shift += 1;
+	const auto stride = (width + 1) * nbins;
+	data.resize(stride * (height + 1), 0);
+
+	// cumulative histograms of each row
+	impl::ForEachRowBand<unsigned int>(width, height, [this, &img, stride](size_t b, size_t e)
+		{
+			for (auto y = b; y < e; ++y)
+			{
+				auto *c = data.data() + (y + 1) * stride + nbins;
+				for (size_t x = 0; x < width; ++x, c += nbins)
+				{
+					std::copy(c - nbins, c, c);
+					c[img.At(x, y) >> shift] += 1;
+				}
+			}
+		});
+	// sum of the rows above, by bands of columns
+	ParallelFor(0, stride, [this, stride](size_t b, size_t e)
+		{
+			for (size_t y = 2; y <= height; ++y)
+			{
+				auto *row = data.data() + y * stride;
+				const auto *prev = row - stride;
+				for (auto x = b; x < e; ++x)
+					row[x] += prev[x];
+			}
+		}, 0, Max(size_t(1), impl::ParallelPixelGrain / Max(height, size_t(1))));
+}
+
+/*****************************************************************************/
+/*!
+ * Gets the histogram of a rectangle
+ *
+ * \throws	ExceptionDimension	the rectangle is not inside the image
+ *
+ * \param[in]	r	the rectangle
+ * \return	the histogram of the rectangle, with GetBinCount() bins
+ */
+Histogram IntegralHistogram::GetHistogram(const Rect &r) const
+{
+	if (!r.IsValid() || (r.GetLeft() < 0) || (r.GetTop() < 0) || (r.GetRight() >= int(width)) || (r.GetBottom() >= int(height)))
+		throw ExceptionDimension(StringUTF8("Histogram IntegralHistogram::GetHistogram(const Rect &r) const: ") + _("the rectangle is not inside the image."));
+	auto h = Histogram(nbins);
+	GetBins(size_t(r.GetLeft()), size_t(r.GetTop()), size_t(r.GetRight()), size_t(r.GetBottom()), h.GetBins());
+	return h;
+}
@@ -0,0 +1,99 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNIntegralHistogram.h
+ * \author Yann LEYDIER
+ */
+
+
+#ifndef CRNIntegralHistogram_HEADER
+#define CRNIntegralHistogram_HEADER
+
+#include <CRNImage/CRNImage.h>
+
+namespace crn
+{
+	class Histogram;
+
+	/****************************************************************************/
+	/*! \brief Integral histogram of a gray image
+	 *
+	 * Summed area tables of the quantized gray levels, used to compute the histogram of any rectangle in O(bins).
+	 * The bins of each position are contiguous so that a query reads four contiguous arrays.
+	 *
+	 * \warning	uses (width + 1) × (height + 1) × bins × 4 bytes
+	 *
+	 * \author  Yann LEYDIER
+	 * \date    Oct 2016
+	 * \version 0.1
+	 * \ingroup image
+	 */
+	class IntegralHistogram
+	{
+		public:
+			/*! \brief Constructor */
+			IntegralHistogram(const ImageGray &img, size_t nbins = 16);
+
+			IntegralHistogram(const IntegralHistogram&) = default;
+			IntegralHistogram(IntegralHistogram&&) = default;
+			IntegralHistogram& operator=(const IntegralHistogram&) = default;
+			IntegralHistogram& operator=(IntegralHistogram&&) = default;
+
+			/*! \brief Returns the width of the image */
+			size_t GetWidth() const noexcept { return width; }
+			/*! \brief Returns the height of the image */
+			size_t GetHeight() const noexcept { return height; }
+			/*! \brief Returns the number of bins */
+			size_t GetBinCount() const noexcept { return nbins; }
+			/*! \brief Returns the bin of a gray level */
+			size_t GetBin(uint8_t v) const noexcept { return v >> shift; }
+			/*! \brief Returns the number of bytes used */
+			size_t GetBytes() const noexcept { return data.size() * sizeof(unsigned int); }
+
+			/*! \brief Gets the histogram of a rectangle
+			 * \warning	no bound checking
+			 * \param[in]	x1	left border
+			 * \param[in]	y1	top border
+			 * \param[in]	x2	right border
+			 * \param[in]	y2	bottom border
+			 * \param[out]	bins	an array of GetBinCount() values
+			 */
+			void GetBins(size_t x1, size_t y1, size_t x2, size_t y2, unsigned int *bins) const noexcept
+			{
+				const auto *br = cell(x2 + 1, y2 + 1);
+				const auto *tl = cell(x1, y1);
+				const auto *bl = cell(x1, y2 + 1);
+				const auto *tr = cell(x2 + 1, y1);
+				for (size_t b = 0; b < nbins; ++b)
+					bins[b] = br[b] + tl[b] - bl[b] - tr[b];
+			}
+			/*! \brief Gets the histogram of a rectangle */
+			Histogram GetHistogram(const Rect &r) const;
+
+		private:
+			/*! \brief Returns the bins summed over [0, x) × [0, y) */
+			const unsigned int* cell(size_t x, size_t y) const noexcept { return data.data() + (x + y * (width + 1)) * nbins; }
+
+			size_t width; /*!< the width of the image */
+			size_t height; /*!< the height of the image */
+			size_t nbins; /*!< the number of bins */
+			size_t shift; /*!< the shift from a gray level to its bin */
+			std::vector<unsigned int> data; /*!< the summed bins, with a leading row and column of zeros */
+	};
+}
+
+#endif
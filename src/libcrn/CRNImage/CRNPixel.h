@@ -479,6 +479,9 @@ namespace crn
 			XYZ(const Lab &p);
 			XYZ(const Luv &p);
 
+			XYZ& operator+=(const XYZ &other) { x += other.x; y += other.y; z += other.z; return *this; }
+			XYZ& operator-=(const XYZ &other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+
 			double x = 0.0, y = 0.0, z = 0.0;
 		};
 
@@ -509,7 +512,38 @@ namespace crn
 			g = T(Cap((int)(var_G * 255), 0, 255));
 			b = T(Cap((int)(var_B * 255), 0, 255));
 		}
-	}
+	} // namespace pixel
+
+	template<> struct TypeInfo<pixel::XYZ>
+	{
+		using SumType = pixel::XYZ;
+		using DiffType = pixel::XYZ;
+		using DecimalType = pixel::XYZ;
+	};
+
+	namespace pixel
+	{
+		constexpr crn::pixel::XYZ operator+(const crn::pixel::XYZ &p1, const crn::pixel::XYZ &p2)
+		{
+			return crn::pixel::XYZ{p1.x + p2.x, p1.y + p2.y, p1.z + p2.z};
+		}
+		constexpr crn::pixel::XYZ operator-(const crn::pixel::XYZ &p1, const crn::pixel::XYZ &p2)
+		{
+			return crn::pixel::XYZ{p1.x - p2.x, p1.y - p2.y, p1.z - p2.z};
+		}
+		constexpr crn::pixel::XYZ operator*(const crn::pixel::XYZ &p, double d)
+		{
+			return crn::pixel::XYZ{p.x * d, p.y * d, p.z * d};
+		}
+		constexpr crn::pixel::XYZ operator*(double d, const crn::pixel::XYZ &p)
+		{
+			return crn::pixel::XYZ{p.x * d, p.y * d, p.z * d};
+		}
+		constexpr crn::pixel::XYZ operator/(const crn::pixel::XYZ &p, double d)
+		{
+			return crn::pixel::XYZ{p.x / d, p.y / d, p.z / d};
+		}
+	} // namespace pixel
 	/*@}*/
 
 } // namespace crn
@@ -680,6 +714,64 @@ namespace crn
 } // namespace crn
 /*@}*/
 
+/*************************************************************
+ * Compact three-channel storage
+ ************************************************************/
+namespace crn
+{
+	/*! \addtogroup pixel */
+	/*@{*/
+	namespace pixel
+	{
+		/*! \brief Three channels of a colour space (XYZ, YUV, L*a*b* or L*u*v*) stored in a smaller type than double */
+		template<typename T> struct Triplet
+		{
+			constexpr Triplet() {}
+			constexpr Triplet(T c0_, T c1_ = 0, T c2_ = 0): c0(c0_), c1(c1_), c2(c2_) {}
+			template<typename Y> constexpr Triplet(const Triplet<Y> &p): c0(T(p.c0)), c1(T(p.c1)), c2(T(p.c2)) {}
+
+			constexpr bool operator==(const Triplet &other) const noexcept { return (c0 == other.c0) && (c1 == other.c1) && (c2 == other.c2); }
+			constexpr bool operator!=(const Triplet &other) const noexcept { return !(*this == other); }
+			Triplet& operator+=(const Triplet &other) { c0 += other.c0; c1 += other.c1; c2 += other.c2; return *this; }
+			Triplet& operator-=(const Triplet &other) { c0 -= other.c0; c1 -= other.c1; c2 -= other.c2; return *this; }
+
+			T c0 = 0, c1 = 0, c2 = 0;
+		};
+	} // namespace pixel
+
+	template<typename I> struct TypeInfo<pixel::Triplet<I>>
+	{
+		using SumType = pixel::Triplet<typename TypeInfo<I>::SumType>;
+		using DiffType = pixel::Triplet<typename TypeInfo<I>::DiffType>;
+		using DecimalType = pixel::Triplet<typename TypeInfo<I>::DecimalType>;
+	};
+
+	namespace pixel
+	{
+		template<typename T> constexpr crn::SumType<crn::pixel::Triplet<T>> operator+(const crn::pixel::Triplet<T> &p1, const crn::pixel::Triplet<T> &p2)
+		{
+			return crn::SumType<crn::pixel::Triplet<T>>{p1.c0 + p2.c0, p1.c1 + p2.c1, p1.c2 + p2.c2};
+		}
+		template<typename T> constexpr crn::DiffType<crn::pixel::Triplet<T>> operator-(const crn::pixel::Triplet<T> &p1, const crn::pixel::Triplet<T> &p2)
+		{
+			return crn::DiffType<crn::pixel::Triplet<T>>{p1.c0 - p2.c0, p1.c1 - p2.c1, p1.c2 - p2.c2};
+		}
+		template<typename T> constexpr crn::DecimalType<crn::pixel::Triplet<T>> operator*(const crn::pixel::Triplet<T> &p, double d)
+		{
+			return crn::DecimalType<crn::pixel::Triplet<T>>{p.c0 * d, p.c1 * d, p.c2 * d};
+		}
+		template<typename T> constexpr crn::DecimalType<crn::pixel::Triplet<T>> operator*(double d, const crn::pixel::Triplet<T> &p)
+		{
+			return crn::DecimalType<crn::pixel::Triplet<T>>{p.c0 * d, p.c1 * d, p.c2 * d};
+		}
+		template<typename T> constexpr crn::DecimalType<crn::pixel::Triplet<T>> operator/(const crn::pixel::Triplet<T> &p, double d)
+		{
+			return crn::DecimalType<crn::pixel::Triplet<T>>{p.c0 / d, p.c1 / d, p.c2 / d};
+		}
+	} // namespace pixel
+} // namespace crn
+/*@}*/
+
 #endif
 
 
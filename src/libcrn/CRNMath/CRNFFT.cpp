@@ -0,0 +1,393 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNFFT.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include <CRNMath/CRNFFT.h>
+#include <CRNMath/CRNMatrixDouble.h>
+#include <CRNUtils/CRNThreadPool.h>
+#include <CRNException.h>
+#include <CRNStringUTF8.h>
+#include <CRNi18n.h>
+#include <map>
+#include <mutex>
+
+using namespace crn;
+
+/*! Number of columns gathered together by the column pass of the 2D transforms */
+static constexpr size_t FFTColumnBlock = 8;
+
+/*! Complex product without the NaN checks of std::complex */
+static inline std::complex<double> cmul(const std::complex<double> &a, const std::complex<double> &b) noexcept
+{
+	return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+/*! Is a size a power of 2? */
+static inline bool is_power_of_2(size_t n) noexcept
+{
+	return n && !(n & (n - 1));
+}
+
+/*****************************************************************************/
+/*!
+ * Computes the tables for a size
+ *
+ * \throws	ExceptionDimension	the size is not a power of 2
+ *
+ * \param[in]	n	the size of the transforms
+ */
+FFTPlan::FFTPlan(size_t n):
+	size(n)
+{
+	if (!is_power_of_2(n))
+		throw ExceptionDimension(StringUTF8("FFTPlan::FFTPlan(size_t n): ") + _("signal size is not a power of 2."));
+	twiddles.reserve(n / 2);
+	for (size_t k = 0; k < n / 2; ++k)
+	{
+		const auto a = -2.0 * M_PI * double(k) / double(n);
+		twiddles.emplace_back(cos(a), sin(a));
+	}
+}
+
+/*! Iterative radix-2 transform
+ * \param[in,out]	sig	the signal
+ * \param[in]	n	the size of the signal, that divides the size of the plan
+ * \param[in]	inverse	use the conjugate twiddles
+ */
+void FFTPlan::transform(std::complex<double> *sig, size_t n, bool inverse) const noexcept
+{
+	if (n < 2)
+		return;
+	// bit reversal
+	for (size_t i = 1, j = 0; i < n; ++i)
+	{
+		auto bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(sig[i], sig[j]);
+	}
+	// butterflies
+	const auto sign = inverse ? -1.0 : 1.0;
+	for (size_t len = 2; len <= n; len <<= 1)
+	{
+		const auto half = len / 2;
+		const auto step = size / len;
+		for (size_t i = 0; i < n; i += len)
+		{
+			auto *a = sig + i;
+			auto *b = a + half;
+			for (size_t j = 0; j < half; ++j)
+			{
+				const auto &w = twiddles[j * step];
+				const auto wi = sign * w.imag();
+				const auto t = std::complex<double>{w.real() * b[j].real() - wi * b[j].imag(), w.real() * b[j].imag() + wi * b[j].real()};
+				b[j] = a[j] - t;
+				a[j] += t;
+			}
+		}
+	}
+}
+
+/*****************************************************************************/
+/*!
+ * Transform of a real signal, computed with a complex transform of half the size
+ *
+ * \throws	ExceptionDimension	the size of the plan is smaller than 2
+ *
+ * \param[in]	sig	GetSize() real values
+ * \param[out]	spectrum	GetSize() / 2 + 1 coefficients (the others are their conjugates)
+ */
+void FFTPlan::ForwardReal(const double *sig, std::complex<double> *spectrum) const
+{
+	if (size < 2)
+		throw ExceptionDimension(StringUTF8("void FFTPlan::ForwardReal(const double *sig, std::complex<double> *spectrum) const: ") + _("signal size is smaller than 2."));
+	const auto m = size / 2;
+	auto z = std::vector<std::complex<double>>(m);
+	for (size_t k = 0; k < m; ++k)
+		z[k] = {sig[2 * k], sig[2 * k + 1]};
+	transform(z.data(), m, false);
+	for (size_t k = 0; k <= m; ++k)
+	{
+		const auto zk = z[k % m];
+		const auto zmk = std::conj(z[(m - k) % m]);
+		const auto e = 0.5 * (zk + zmk);
+		const auto d = 0.5 * (zk - zmk);
+		const auto o = std::complex<double>{d.imag(), -d.real()}; // d / i
+		const auto w = (k < m) ? twiddles[k] : std::complex<double>{-1.0, 0.0};
+		spectrum[k] = e + cmul(w, o);
+	}
+}
+
+/*****************************************************************************/
+/*!
+ * Inverse transform of the coefficients of a real signal, computed with a complex transform of half the size
+ *
+ * \throws	ExceptionDimension	the size of the plan is smaller than 2
+ *
+ * \param[in]	spectrum	GetSize() / 2 + 1 coefficients
+ * \param[out]	sig	GetSize() real values
+ */
+void FFTPlan::InverseReal(const std::complex<double> *spectrum, double *sig) const
+{
+	if (size < 2)
+		throw ExceptionDimension(StringUTF8("void FFTPlan::InverseReal(const std::complex<double> *spectrum, double *sig) const: ") + _("signal size is smaller than 2."));
+	const auto m = size / 2;
+	auto z = std::vector<std::complex<double>>(m);
+	for (size_t k = 0; k < m; ++k)
+	{
+		const auto xk = spectrum[k];
+		const auto xmk = std::conj(spectrum[m - k]);
+		const auto e = 0.5 * (xk + xmk);
+		const auto o = cmul(0.5 * (xk - xmk), std::conj(twiddles[k]));
+		z[k] = e + std::complex<double>{-o.imag(), o.real()}; // e + i·o
+	}
+	transform(z.data(), m, true);
+	for (size_t k = 0; k < m; ++k)
+	{
+		sig[2 * k] = 2.0 * z[k].real();
+		sig[2 * k + 1] = 2.0 * z[k].imag();
+	}
+}
+
+/*****************************************************************************/
+/*!
+ * Returns a plan from the shared cache. The plans are created on the first request and never freed.
+ *
+ * \throws	ExceptionDimension	the size is not a power of 2
+ *
+ * \param[in]	n	the size of the transforms
+ * \return	the plan
+ */
+std::shared_ptr<const FFTPlan> crn::GetFFTPlan(size_t n)
+{
+	static std::mutex mutex;
+	static std::map<size_t, std::shared_ptr<const FFTPlan>> plans;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto &plan = plans[n];
+	if (!plan)
+		plan = std::make_shared<const FFTPlan>(n); // may throw
+	return plan;
+}
+
+/*! \param[in]	n	a size
+ * \return	the smallest power of 2 greater or equal to n, at least 2
+ */
+size_t crn::FFTSize(size_t n) noexcept
+{
+	auto s = size_t(2);
+	while (s < n)
+		s <<= 1;
+	return s;
+}
+
+/*! Transforms the columns of a row-major array in place, by blocks of columns in parallel
+ * \param[in,out]	data	the array
+ * \param[in]	rows	the number of rows, a power of 2
+ * \param[in]	cols	the number of columns
+ * \param[in]	inverse	inverse transform?
+ */
+static void column_pass(std::complex<double> *data, size_t rows, size_t cols, bool inverse)
+{
+	if (rows < 2)
+		return;
+	const auto plan = GetFFTPlan(rows);
+	ParallelFor(0, (cols + FFTColumnBlock - 1) / FFTColumnBlock, [data, rows, cols, inverse, &plan](size_t b, size_t e)
+		{
+			auto buff = std::vector<std::complex<double>>(FFTColumnBlock * rows);
+			for (auto blk = b; blk < e; ++blk)
+			{
+				const auto c0 = blk * FFTColumnBlock;
+				const auto nc = Min(FFTColumnBlock, cols - c0);
+				for (size_t r = 0; r < rows; ++r)
+					for (size_t c = 0; c < nc; ++c)
+						buff[c * rows + r] = data[r * cols + c0 + c];
+				for (size_t c = 0; c < nc; ++c)
+					if (inverse)
+						plan->Inverse(buff.data() + c * rows);
+					else
+						plan->Forward(buff.data() + c * rows);
+				for (size_t r = 0; r < rows; ++r)
+					for (size_t c = 0; c < nc; ++c)
+						data[r * cols + c0 + c] = buff[c * rows + r];
+			}
+		});
+}
+
+/*****************************************************************************/
+/*!
+ * 2D complex transform in place (not scaled), rows in parallel then blocks of columns in parallel
+ *
+ * \throws	ExceptionDimension	a dimension is not a power of 2
+ *
+ * \param[in,out]	data	the row-major array
+ * \param[in]	rows	the number of rows
+ * \param[in]	cols	the number of columns
+ * \param[in]	inverse	inverse transform?
+ */
+void crn::FFT2D(std::complex<double> *data, size_t rows, size_t cols, bool inverse)
+{
+	if (!is_power_of_2(rows) || !is_power_of_2(cols))
+		throw ExceptionDimension(StringUTF8("void FFT2D(std::complex<double> *data, size_t rows, size_t cols, bool inverse): ") + _("signal size is not a power of 2."));
+	const auto plan = GetFFTPlan(cols);
+	ParallelFor(0, rows, [data, cols, inverse, &plan](size_t b, size_t e)
+		{
+			for (auto r = b; r < e; ++r)
+				if (inverse)
+					plan->Inverse(data + r * cols);
+				else
+					plan->Forward(data + r * cols);
+		});
+	column_pass(data, rows, cols, inverse);
+}
+
+/*! Forward 2D transform of a zero padded real signal
+ * \param[in]	sig	the signal
+ * \param[in]	w	the width of the signal
+ * \param[in]	h	the height of the signal
+ * \param[in]	rows	the number of rows of the transform (power of 2 ≥ h)
+ * \param[in]	cols	the number of columns of the transform (power of 2 ≥ w, at least 2)
+ * \return	rows × (cols / 2 + 1) coefficients
+ */
+static std::vector<std::complex<double>> forward_real_2d(const double *sig, size_t w, size_t h, size_t rows, size_t cols)
+{
+	const auto hcols = cols / 2 + 1;
+	auto spec = std::vector<std::complex<double>>(rows * hcols);
+	const auto plan = GetFFTPlan(cols);
+	ParallelFor(0, h, [sig, w, cols, hcols, &spec, &plan](size_t b, size_t e)
+		{
+			auto row = std::vector<double>(cols, 0.0);
+			for (auto r = b; r < e; ++r)
+			{
+				std::copy_n(sig + r * w, w, row.begin());
+				plan->ForwardReal(row.data(), spec.data() + r * hcols);
+			}
+		});
+	column_pass(spec.data(), rows, hcols, false);
+	return spec;
+}
+
+namespace crn
+{
+	namespace impl
+	{
+		/*! Estimates if a correlation is faster in the frequency domain
+		 * \param[in]	w	the width of the signal
+		 * \param[in]	h	the height of the signal
+		 * \param[in]	kw	the width of the kernel
+		 * \param[in]	kh	the height of the kernel
+		 * \return	true if the three transforms cost less than the direct products
+		 */
+		bool IsFFTCorrelationFaster(size_t w, size_t h, size_t kw, size_t kh) noexcept
+		{
+			const auto n = double(FFTSize(w)) * double(FFTSize(h));
+			const auto fft = 6.0 * n * log2(n);
+			const auto direct = double(w) * double(h) * double(kw) * double(kh);
+			return fft < direct;
+		}
+
+		/*! Correlates a real 2D signal with a kernel in the frequency domain
+		 * \throws	ExceptionDimension	the kernel is bigger than the signal
+		 * \param[in]	sig	the signal, row-major
+		 * \param[in]	w	the width of the signal
+		 * \param[in]	h	the height of the signal
+		 * \param[in]	kernel	the kernel
+		 * \return	(w - kernel columns + 1) × (h - kernel rows + 1) values: out(x, y) = Σ sig(x + i, y + j)·kernel[j][i]
+		 */
+		std::vector<double> FFTCorrelateValid(const std::vector<double> &sig, size_t w, size_t h, const MatrixDouble &kernel)
+		{
+			const auto kw = kernel.GetCols();
+			const auto kh = kernel.GetRows();
+			if ((kw > w) || (kh > h) || (sig.size() < w * h))
+				throw ExceptionDimension(StringUTF8("std::vector<double> impl::FFTCorrelateValid(const std::vector<double> &sig, size_t w, size_t h, const MatrixDouble &kernel): ") + _("the kernel is bigger than the signal."));
+			// no wrapping for the valid positions: x + i < w <= cols
+			const auto cols = FFTSize(w);
+			const auto rows = FFTSize(h);
+			const auto hcols = cols / 2 + 1;
+			auto spec = forward_real_2d(sig.data(), w, h, rows, cols);
+			auto k = std::vector<double>(kw * kh);
+			for (size_t r = 0; r < kh; ++r)
+				for (size_t c = 0; c < kw; ++c)
+					k[c + r * kw] = kernel[r][c];
+			const auto kspec = forward_real_2d(k.data(), kw, kh, rows, cols);
+			const auto scale = 1.0 / (double(rows) * double(cols));
+			for (size_t tmp = 0; tmp < spec.size(); ++tmp)
+				spec[tmp] = cmul(spec[tmp], std::conj(kspec[tmp])) * scale;
+			column_pass(spec.data(), rows, hcols, true);
+			const auto ow = w - kw + 1;
+			const auto oh = h - kh + 1;
+			auto out = std::vector<double>(ow * oh);
+			const auto plan = GetFFTPlan(cols);
+			ParallelFor(0, oh, [&spec, &out, &plan, cols, hcols, ow](size_t b, size_t e)
+				{
+					auto row = std::vector<double>(cols);
+					for (auto r = b; r < e; ++r)
+					{
+						plan->InverseReal(spec.data() + r * hcols, row.data());
+						std::copy_n(row.begin(), ow, out.begin() + r * ow);
+					}
+				});
+			return out;
+		}
+
+		/*! Sums the linear autocorrelations of the rows of a real 2D signal in the frequency domain
+		 * \param[in]	sig	the signal, row-major
+		 * \param[in]	w	the width of the signal
+		 * \param[in]	h	the height of the signal
+		 * \return	w values: out(d) = Σ sig(x, y)·sig(x + d, y)
+		 */
+		std::vector<double> FFTRowAutoCorrelation(const std::vector<double> &sig, size_t w, size_t h)
+		{
+			// no wrapping: x + d < 2w <= n
+			const auto n = FFTSize(2 * w);
+			const auto hn = n / 2 + 1;
+			const auto plan = GetFFTPlan(n);
+			auto power = std::vector<double>(hn, 0.0);
+			std::mutex mutex;
+			ParallelFor(0, h, [&sig, &power, &mutex, &plan, w, n, hn](size_t b, size_t e)
+				{
+					auto row = std::vector<double>(n, 0.0);
+					auto spec = std::vector<std::complex<double>>(hn);
+					auto lpower = std::vector<double>(hn, 0.0);
+					for (auto r = b; r < e; ++r)
+					{
+						std::copy_n(sig.begin() + r * w, w, row.begin());
+						plan->ForwardReal(row.data(), spec.data());
+						for (size_t k = 0; k < hn; ++k)
+							lpower[k] += std::norm(spec[k]);
+					}
+					std::lock_guard<std::mutex> lock(mutex);
+					for (size_t k = 0; k < hn; ++k)
+						power[k] += lpower[k];
+				});
+			auto spec = std::vector<std::complex<double>>(hn);
+			for (size_t k = 0; k < hn; ++k)
+				spec[k] = power[k];
+			auto corr = std::vector<double>(n);
+			plan->InverseReal(spec.data(), corr.data());
+			corr.resize(w);
+			for (auto &c : corr)
+				c /= double(n);
+			return corr;
+		}
+	}
+}
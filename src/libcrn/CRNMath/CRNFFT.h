@@ -0,0 +1,90 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNFFT.h
+ * \author Yann LEYDIER
+ */
+
+
+#ifndef CRNFFT_HEADER
+#define CRNFFT_HEADER
+
+#include <CRNMath/CRNMath.h>
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace crn
+{
+	class MatrixDouble;
+
+	/****************************************************************************/
+	/*! \brief Precomputed tables of a power of 2 fast Fourier transform
+	 *
+	 * The transforms are not scaled: Inverse(Forward(x)) = n·x.
+	 * A plan is immutable and can be used by several threads at once. GetFFTPlan() shares the plans of each size.
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date	Oct 2016
+	 * \version	0.1
+	 * \ingroup	math
+	 */
+	class FFTPlan
+	{
+		public:
+			/*! \brief Computes the tables for a size */
+			explicit FFTPlan(size_t n);
+
+			/*! \brief Returns the size of the transforms */
+			size_t GetSize() const noexcept { return size; }
+
+			/*! \brief Complex transform in place */
+			void Forward(std::complex<double> *sig) const noexcept { transform(sig, size, false); }
+			/*! \brief Inverse complex transform in place */
+			void Inverse(std::complex<double> *sig) const noexcept { transform(sig, size, true); }
+			/*! \brief Transform of a real signal of GetSize() values into GetSize() / 2 + 1 coefficients */
+			void ForwardReal(const double *sig, std::complex<double> *spectrum) const;
+			/*! \brief Inverse transform of GetSize() / 2 + 1 coefficients of a real signal */
+			void InverseReal(const std::complex<double> *spectrum, double *sig) const;
+
+		private:
+			/*! \brief Radix-2 transform of a size that divides the size of the plan */
+			void transform(std::complex<double> *sig, size_t n, bool inverse) const noexcept;
+
+			size_t size; /*!< size of the transforms */
+			std::vector<std::complex<double>> twiddles; /*!< exp(-2iπk/size), k < size / 2 */
+	};
+
+	/*! \brief Returns a plan from the shared cache */
+	std::shared_ptr<const FFTPlan> GetFFTPlan(size_t n);
+	/*! \brief Returns the smallest power of 2 greater or equal to a size (at least 2) */
+	size_t FFTSize(size_t n) noexcept;
+	/*! \brief 2D complex transform in place */
+	void FFT2D(std::complex<double> *data, size_t rows, size_t cols, bool inverse);
+
+	namespace impl
+	{
+		/*! \brief Estimates if a correlation with a kernel is faster in the frequency domain */
+		bool IsFFTCorrelationFaster(size_t w, size_t h, size_t kw, size_t kh) noexcept;
+		/*! \brief Correlates a real 2D signal with a kernel where the kernel fits in the signal */
+		std::vector<double> FFTCorrelateValid(const std::vector<double> &sig, size_t w, size_t h, const MatrixDouble &kernel);
+		/*! \brief Sums the autocorrelations of the rows of a real 2D signal */
+		std::vector<double> FFTRowAutoCorrelation(const std::vector<double> &sig, size_t w, size_t h);
+	}
+}
+
+#endif
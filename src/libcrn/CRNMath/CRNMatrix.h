@@ -26,10 +26,106 @@
 #include <CRNException.h>
 #include <CRNMath/CRNMath.h>
 #include <CRNString.h>
+#include <CRNUtils/CRNThreadPool.h>
 #include <vector>
 
 namespace crn
 {
+	namespace impl
+	{
+		/*! Number of rows of op(B) kept in cache by the matrix product */
+		constexpr size_t MatrixProductDepthBlock = 128;
+		/*! Number of columns of op(B) kept in cache by the matrix product */
+		constexpr size_t MatrixProductWidthBlock = 256;
+		/*! Minimal number of multiply-adds for the matrix product to be processed in parallel */
+		constexpr size_t ParallelMatrixProductGrain = 1 << 18;
+
+		/*! Computes C = op(A)·op(B), where op(X) is X or its transpose. All matrices are stored by rows.
+		 *
+		 * op(B) is processed by blocks that fit in the cache and the rows of C are accumulated four at a time along contiguous rows of op(B), so that the inner loop is vectorized. Bands of rows of C are processed in parallel for large products.
+		 *
+		 * \param[in]	a	the elements of A
+		 * \param[in]	lda	the number of columns of A
+		 * \param[in]	ta	shall A be transposed?
+		 * \param[in]	b	the elements of B
+		 * \param[in]	ldb	the number of columns of B
+		 * \param[in]	tb	shall B be transposed?
+		 * \param[out]	c	the elements of C (m×n), must not overlap A nor B
+		 * \param[in]	m	the number of rows of op(A) and C
+		 * \param[in]	n	the number of columns of op(B) and C
+		 * \param[in]	k	the number of columns of op(A) and rows of op(B)
+		 */
+		template<typename T> void MatrixProduct(const T *a, size_t lda, bool ta, const T *b, size_t ldb, bool tb, T *c, size_t m, size_t n, size_t k)
+		{
+			auto band = [&](size_t r0, size_t r1)
+			{
+				std::fill(c + r0 * n, c + r1 * n, T(0));
+				const auto ael = [&](size_t i, size_t p) { return ta ? a[p * lda + i] : a[i * lda + p]; };
+				auto pack = std::vector<T>{};
+				if (tb)
+					pack.resize(Min(MatrixProductDepthBlock, k) * Min(MatrixProductWidthBlock, n));
+				for (size_t j0 = 0; j0 < n; j0 += MatrixProductWidthBlock)
+				{
+					const auto nb = Min(MatrixProductWidthBlock, n - j0);
+					for (size_t p0 = 0; p0 < k; p0 += MatrixProductDepthBlock)
+					{
+						const auto kb = Min(MatrixProductDepthBlock, k - p0);
+						// rows of op(B) in the block
+						auto bstride = ldb;
+						auto bblock = b + p0 * ldb + j0;
+						if (tb)
+						{
+							for (size_t p = 0; p < kb; ++p)
+								for (size_t j = 0; j < nb; ++j)
+									pack[p * nb + j] = b[(j0 + j) * ldb + p0 + p];
+							bstride = nb;
+							bblock = pack.data();
+						}
+						auto i = r0;
+						for (; i + 4 <= r1; i += 4)
+						{
+							auto c0 = c + i * n + j0;
+							auto c1 = c0 + n;
+							auto c2 = c1 + n;
+							auto c3 = c2 + n;
+							for (size_t p = 0; p < kb; ++p)
+							{
+								const auto a0 = ael(i, p0 + p);
+								const auto a1 = ael(i + 1, p0 + p);
+								const auto a2 = ael(i + 2, p0 + p);
+								const auto a3 = ael(i + 3, p0 + p);
+								const auto brow = bblock + p * bstride;
+								for (size_t j = 0; j < nb; ++j)
+								{
+									const auto bv = brow[j];
+									c0[j] += a0 * bv;
+									c1[j] += a1 * bv;
+									c2[j] += a2 * bv;
+									c3[j] += a3 * bv;
+								}
+							}
+						}
+						for (; i < r1; ++i)
+						{
+							auto c0 = c + i * n + j0;
+							for (size_t p = 0; p < kb; ++p)
+							{
+								const auto a0 = ael(i, p0 + p);
+								const auto brow = bblock + p * bstride;
+								for (size_t j = 0; j < nb; ++j)
+									c0[j] += a0 * brow[j];
+							}
+						}
+					}
+				}
+			};
+			if ((m < 8) || (m * n * k < ParallelMatrixProductGrain))
+				band(0, m);
+			else
+				ParallelFor(0, m, band, 0, Max(size_t(4), (ParallelMatrixProductGrain / Max(n * k, size_t(1)) + 3) / 4 * 4));
+		}
+	}
+
 	/****************************************************************************/
 	/*! \brief Base matrix class
 	 *
@@ -280,13 +376,40 @@ namespace crn
 			{ 
 				if (cols != m.GetRows())
 					throw ExceptionDimension("Matrix::*=(): incompatible dimensions");
-				auto p = datatype(rows * m.GetCols());
-				for (size_t r = 0; r < rows; r++)
-					for (size_t c = 0; c < m.GetCols(); c++)
-						for (size_t k = 0; k < cols; k++)
-							p[r * m.GetCols() + c] += At(r, k) * m[k][c];							
-				cols = m.GetCols();
-				data.swap(p);
+				return SetProduct(*this, m);
+			}
+
+			/*! \brief Stores the product of two matrices in the current matrix
+			 *
+			 * The storage of the current matrix is reused if it is not one of the operands.
+			 *
+			 * \throws	ExceptionDimension	incompatible dimensions
+			 * \param[in]	a	the left operand
+			 * \param[in]	b	the right operand
+			 * \param[in]	transpose_a	shall the transpose of a be used?
+			 * \param[in]	transpose_b	shall the transpose of b be used?
+			 * \return	a reference to the current matrix, that contains op(a)·op(b)
+			 */
+			Matrix& SetProduct(const Matrix &a, const Matrix &b, bool transpose_a = false, bool transpose_b = false)
+			{
+				const auto m = transpose_a ? a.cols : a.rows;
+				const auto k = transpose_a ? a.rows : a.cols;
+				const auto n = transpose_b ? b.rows : b.cols;
+				if (k != (transpose_b ? b.cols : b.rows))
+					throw ExceptionDimension("Matrix::SetProduct(): incompatible dimensions");
+				if ((&a == this) || (&b == this))
+				{
+					auto p = datatype(m * n);
+					impl::MatrixProduct(a.data.data(), a.cols, transpose_a, b.data.data(), b.cols, transpose_b, p.data(), m, n, k);
+					data.swap(p);
+				}
+				else
+				{
+					data.resize(m * n);
+					impl::MatrixProduct(a.data.data(), a.cols, transpose_a, b.data.data(), b.cols, transpose_b, data.data(), m, n, k);
+				}
+				rows = m;
+				cols = n;
 				return *this;
 			}
 			bool operator==(const Matrix &m) const
@@ -623,20 +746,12 @@ namespace crn
 			/*! \return the covariance matrix */
 			Matrix MakeCovariance() const
 			{
-				auto cov = Matrix(cols, cols);
-				for (size_t i = 0; i < cols; ++i)
-					for (size_t j = i; j < cols; ++j)
-					{
-						auto product = T(0);
-						for (size_t k = 0; k < rows; ++k)
-							product += At(k, i) * At(k, j);
-						// Each pattern in supposed equiprobable
-						// and thus weighted with 1/nbPatterns.
-						product /= T(rows);
-						cov[i][j] = product;
-						if (i != j)
-							cov[j][i] = product;
-					}
+				auto cov = Matrix(1, 1);
+				cov.SetProduct(*this, *this, true, false);
+				// Each pattern in supposed equiprobable
+				// and thus weighted with 1/nbPatterns.
+				for (auto &v : cov.data)
+					v /= T(rows);
 				return cov;
 			}
 
@@ -730,6 +845,31 @@ namespace crn
 	template<typename T> Matrix<T> operator*(Matrix<T> &&m1, const Matrix<T> &m2)
 	{ return std::move(m1 *= m2); }
 
+	/*! \brief Computes the product of the transpose of a matrix by another matrix, without transposing
+	 * \throws	ExceptionDimension	incompatible dimensions
+	 * \param[in]	m1	the left operand
+	 * \param[in]	m2	the right operand
+	 * \return	m1ᵀ·m2
+	 */
+	template<typename T> Matrix<T> TransposeProduct(const Matrix<T> &m1, const Matrix<T> &m2)
+	{
+		auto m = Matrix<T>(1, 1);
+		m.SetProduct(m1, m2, true, false);
+		return m;
+	}
+	/*! \brief Computes the product of a matrix by the transpose of another matrix, without transposing
+	 * \throws	ExceptionDimension	incompatible dimensions
+	 * \param[in]	m1	the left operand
+	 * \param[in]	m2	the right operand
+	 * \return	m1·m2ᵀ
+	 */
+	template<typename T> Matrix<T> ProductTranspose(const Matrix<T> &m1, const Matrix<T> &m2)
+	{
+		auto m = Matrix<T>(1, 1);
+		m.SetProduct(m1, m2, false, true);
+		return m;
+	}
+
 	template<typename I> struct TypeInfo<Matrix<I>>
 	{
 		using SumType = Matrix<typename TypeInfo<I>::SumType>;
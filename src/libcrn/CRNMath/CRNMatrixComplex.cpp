@@ -21,72 +21,13 @@
 
 #include <CRNMath/CRNMatrixComplex.h>
 #include <CRNMath/CRNMatrixDouble.h>
+#include <CRNMath/CRNFFT.h>
 #include <CRNGeometry/CRNPoint2DInt.h>
 #include <CRNProtocols.h> 
 #include <CRNi18n.h> 
 
 using namespace crn;
 
-/*! \internal */
-static void doFFT(std::complex<double> *sig, int n, bool direct)
-{
-	// dimensions
-	double logsize = log2(n);
-	if (logsize != ceil(logsize))
-		throw ExceptionDimension(_("FFT: signal size is not a power of 2."));
-	int m = int(logsize);
-
-	// bit reversal
-	int i2 = n >> 1;
-	int j = 0;
-	for (int i = 0; i < n-1 ; i++)
-	{
-		if (i < j)
-			swap(sig[i], sig[j]);
-		int k = i2;
-		while (k <= j) 
-		{
-			j -= k;
-			k >>= 1;
-		}
-		j += k;
-	}
-
-	// compute the FFT
-	std::complex<double> c(-1.0, 0.0);
-	int l2 = 1;
-	for (int l = 0; l < m; l++) 
-	{
-		int l1 = l2;
-		l2 <<= 1;
-		std::complex<double> u(1.0, 0.0);
-		for (j = 0; j < l1; j++) 
-		{
-			for (int i = j; i < n; i += l2) 
-			{
-				int i1 = i + l1;
-				std::complex<double> t1 = u * sig[i1];
-				sig[i1] = sig[i] - t1; 
-				sig[i] += t1;
-			}
-
-			u = u * c;
-		}
-
-		double ima = sqrt((1.0 - c.real()) / 2.0);
-		if (direct)
-			ima = -ima;
-		c = std::complex<double>(sqrt((1.0 + c.real()) / 2.0), ima);
-	}
-
-	// scaling for forward transform
-	if (direct)
-	{
-		for (int i = 0; i < n; i++)
-			sig[i] /= n;      
-	}	
-}
-
 /*! Fast Fourier transform
  * \date		April 2013
  * \version 0.1
@@ -97,7 +38,18 @@ static void doFFT(std::complex<double> *sig, int n, bool direct)
  */
 void crn::FFT(std::vector<std::complex<double> > &sig, bool direct)
 {
-	doFFT(sig.data(), int(sig.size()), direct);
+	const auto n = sig.size();
+	if (!n || (n & (n - 1)))
+		throw ExceptionDimension(_("FFT: signal size is not a power of 2."));
+	const auto plan = GetFFTPlan(n);
+	if (direct)
+	{
+		plan->Forward(sig.data());
+		for (auto &v : sig)
+			v /= double(n);
+	}
+	else
+		plan->Inverse(sig.data());
 }
 
 /*! Grows the matrix to power of 2 sizes (for FFT) 
@@ -147,7 +99,7 @@ MatrixDouble MatrixComplex::MakeModule() const
 	return m;
 }
 
-/* Inplace fast Fourier transform
+/* Inplace fast Fourier transform, with cached plans and the rows and columns processed in parallel
  *
  * \warning	Sizes must be power of 2
  *
@@ -161,22 +113,13 @@ void MatrixComplex::FFT(bool direct)
 		crn::FFT(data, direct);
 	}
 	else
-	{ // 2D transform
-		// lines
-		for (size_t r = 0; r < rows; ++r)
-			doFFT(data.data() + r * cols, int(cols), direct);
-		// columns
-		Transpose();
-		try
+	{ // 2D transform, the direct transform is scaled
+		FFT2D(data.data(), rows, cols, !direct);
+		if (direct)
 		{
-			for (size_t r = 0; r < rows; ++r)
-				doFFT(data.data() + r * cols, int(cols), direct);
-			Transpose();
-		}
-		catch (...)
-		{ // transpose back to ensure exception safety
-			Transpose();
-			throw;
+			const auto n = double(rows * cols);
+			for (auto &v : data)
+				v /= n;
 		}
 	}
 }
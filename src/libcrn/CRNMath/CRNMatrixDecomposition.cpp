@@ -0,0 +1,403 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNMatrixDecomposition.cpp
+ * \author Yann LEYDIER
+ */
+
+#include <CRNMath/CRNMatrixDecomposition.h>
+#include <CRNException.h>
+#include <CRNStringUTF8.h>
+#include <CRNi18n.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace crn;
+
+/*****************************************************************************/
+/*!
+ * Factorizes a matrix. The factorization never fails: a singular matrix can be tested with IsSingular().
+ *
+ * \param[in]	m	the matrix to factorize
+ */
+LUDecomposition::LUDecomposition(const SquareMatrixDouble &m):
+	dim(m.GetRows()),
+	lu(m.Std()),
+	perm(dim),
+	sign(1),
+	logdet(0),
+	singular(false)
+{
+	for (auto tmp = size_t(0); tmp < dim; ++tmp)
+		perm[tmp] = tmp;
+	for (auto c = size_t(0); c < dim; ++c)
+	{
+		// partial pivoting
+		auto p = c;
+		auto maxval = std::fabs(lu[c * dim + c]);
+		for (auto r = c + 1; r < dim; ++r)
+			if (std::fabs(lu[r * dim + c]) > maxval)
+			{
+				maxval = std::fabs(lu[r * dim + c]);
+				p = r;
+			}
+		if (maxval == 0.0)
+		{
+			singular = true;
+			continue;
+		}
+		if (p != c)
+		{
+			std::swap_ranges(lu.begin() + c * dim, lu.begin() + (c + 1) * dim, lu.begin() + p * dim);
+			std::swap(perm[c], perm[p]);
+			sign = -sign;
+		}
+		const auto pivot = lu[c * dim + c];
+		if (pivot < 0)
+			sign = -sign;
+		logdet += std::log(maxval);
+		// elimination, row by row so that the inner loop is contiguous
+		const auto *prow = lu.data() + c * dim;
+		for (auto r = c + 1; r < dim; ++r)
+		{
+			auto *row = lu.data() + r * dim;
+			const auto f = row[c] / pivot;
+			row[c] = f;
+			if (f != 0.0)
+				for (auto k = c + 1; k < dim; ++k)
+					row[k] -= f * prow[k];
+		}
+	}
+	if (singular)
+		logdet = -std::numeric_limits<double>::infinity();
+}
+
+/*! 
+ * Returns the determinant of the matrix
+ *
+ * \return	the determinant, may overflow for large matrices (see GetLogAbsDeterminant())
+ */
+double LUDecomposition::GetDeterminant() const noexcept
+{
+	if (singular)
+		return 0.0;
+	auto det = double(sign);
+	for (auto tmp = size_t(0); tmp < dim; ++tmp)
+		det *= std::fabs(lu[tmp * dim + tmp]);
+	return det;
+}
+
+/*! 
+ * Solves in place for a right-hand side
+ *
+ * \param[in,out]	b	the permuted right-hand side, replaced by the solution
+ * \param[in]	stride	the distance between two values of b
+ */
+void LUDecomposition::solve(double *b, size_t stride) const noexcept
+{
+	// L·y = P·b
+	for (auto r = size_t(1); r < dim; ++r)
+	{
+		const auto *row = lu.data() + r * dim;
+		auto s = b[r * stride];
+		for (auto k = size_t(0); k < r; ++k)
+			s -= row[k] * b[k * stride];
+		b[r * stride] = s;
+	}
+	// U·x = y
+	for (auto r = dim; r > 0; --r)
+	{
+		const auto *row = lu.data() + (r - 1) * dim;
+		auto s = b[(r - 1) * stride];
+		for (auto k = r; k < dim; ++k)
+			s -= row[k] * b[k * stride];
+		b[(r - 1) * stride] = s / row[r - 1];
+	}
+}
+
+/*! 
+ * Solves M·X = B
+ *
+ * \throws	ExceptionDimension	B does not have as many rows as M
+ * \throws	ExceptionRuntime	the matrix is singular
+ *
+ * \param[in]	b	the right-hand sides, one per column
+ * \return	the solutions, one per column
+ */
+MatrixDouble LUDecomposition::Solve(const MatrixDouble &b) const
+{
+	if (b.GetRows() != dim)
+		throw ExceptionDimension(StringUTF8("MatrixDouble LUDecomposition::Solve(const MatrixDouble &b) const: ") +
+				_("invalid or incompatible matrix dimensions"));
+	if (singular)
+		throw ExceptionRuntime(StringUTF8("MatrixDouble LUDecomposition::Solve(const MatrixDouble &b) const: ") +
+				_("Equation has either no solution or an infinity of solutions."));
+	const auto ncols = b.GetCols();
+	auto x = MatrixDouble(dim, ncols);
+	for (auto r = size_t(0); r < dim; ++r)
+		for (auto c = size_t(0); c < ncols; ++c)
+			x.At(r, c) = b.At(perm[r], c);
+	for (auto c = size_t(0); c < ncols; ++c)
+		solve(&x.At(0, c), ncols);
+	return x;
+}
+
+/*! 
+ * Solves M·x = b
+ *
+ * \throws	ExceptionDimension	b does not have as many elements as M has rows
+ * \throws	ExceptionRuntime	the matrix is singular
+ *
+ * \param[in]	b	the right-hand side
+ * \return	the solution
+ */
+std::vector<double> LUDecomposition::Solve(std::vector<double> b) const
+{
+	if (b.size() != dim)
+		throw ExceptionDimension(StringUTF8("std::vector<double> LUDecomposition::Solve(std::vector<double> b) const: ") +
+				_("invalid or incompatible matrix dimensions"));
+	if (singular)
+		throw ExceptionRuntime(StringUTF8("std::vector<double> LUDecomposition::Solve(std::vector<double> b) const: ") +
+				_("Equation has either no solution or an infinity of solutions."));
+	auto x = std::vector<double>(dim);
+	for (auto r = size_t(0); r < dim; ++r)
+		x[r] = b[perm[r]];
+	solve(x.data(), 1);
+	return x;
+}
+
+/*! 
+ * Computes the inverse of the matrix
+ *
+ * \throws	ExceptionRuntime	the matrix is singular
+ *
+ * \return	the inverse matrix
+ */
+SquareMatrixDouble LUDecomposition::MakeInverse() const
+{
+	if (singular)
+		throw ExceptionRuntime(StringUTF8("SquareMatrixDouble LUDecomposition::MakeInverse() const: ") +
+				_("The matrix cannot be inversed."));
+	auto inv = SquareMatrixDouble(dim, 0.0);
+	for (auto r = size_t(0); r < dim; ++r)
+		inv.At(r, perm[r]) = 1.0;
+	for (auto c = size_t(0); c < dim; ++c)
+		solve(&inv.At(0, c), dim);
+	return inv;
+}
+
+/*****************************************************************************/
+/*!
+ * Factorizes a matrix. The factorization never fails: a matrix that is not positive definite can be tested with IsPositiveDefinite().
+ *
+ * \param[in]	m	the matrix to factorize (only its lower triangle is read)
+ */
+CholeskyDecomposition::CholeskyDecomposition(const SquareMatrixDouble &m):
+	dim(m.GetRows()),
+	l(dim * dim, 0.0),
+	logdet(0),
+	positive(true)
+{
+	for (auto j = size_t(0); j < dim; ++j)
+	{
+		const auto *lj = l.data() + j * dim;
+		auto d = m.At(j, j);
+		for (auto k = size_t(0); k < j; ++k)
+			d -= lj[k] * lj[k];
+		if (!(d > 0.0))
+		{
+			positive = false;
+			logdet = std::numeric_limits<double>::quiet_NaN();
+			return;
+		}
+		const auto ljj = std::sqrt(d);
+		l[j * dim + j] = ljj;
+		logdet += 2.0 * std::log(ljj);
+		for (auto i = j + 1; i < dim; ++i)
+		{
+			auto *li = l.data() + i * dim;
+			auto s = m.At(i, j);
+			for (auto k = size_t(0); k < j; ++k)
+				s -= li[k] * lj[k];
+			li[j] = s / ljj;
+		}
+	}
+}
+
+/*! 
+ * Returns the determinant of the matrix
+ *
+ * \return	the determinant, may overflow for large matrices (see GetLogDeterminant()), NaN if the matrix is not positive definite
+ */
+double CholeskyDecomposition::GetDeterminant() const noexcept
+{
+	return std::exp(logdet);
+}
+
+/*! 
+ * Returns the lower triangular factor
+ *
+ * \throws	ExceptionRuntime	the matrix is not positive definite
+ *
+ * \return	L such that M = L·Lᵗ
+ */
+SquareMatrixDouble CholeskyDecomposition::GetL() const
+{
+	check("SquareMatrixDouble CholeskyDecomposition::GetL() const: ");
+	auto L = SquareMatrixDouble(dim, 0.0);
+	for (auto r = size_t(0); r < dim; ++r)
+		for (auto c = size_t(0); c <= r; ++c)
+			L.At(r, c) = l[r * dim + c];
+	return L;
+}
+
+/*! 
+ * Throws if the matrix is not positive definite
+ *
+ * \throws	ExceptionRuntime	the matrix is not positive definite
+ *
+ * \param[in]	fun	the signature of the calling method
+ */
+void CholeskyDecomposition::check(const char *fun) const
+{
+	if (!positive)
+		throw ExceptionRuntime(StringUTF8(fun) + _("The matrix is not positive definite."));
+}
+
+/*! 
+ * Solves L·y = b in place
+ *
+ * \param[in,out]	b	the right-hand side, replaced by the solution
+ * \param[in]	stride	the distance between two values of b
+ */
+void CholeskyDecomposition::forward(double *b, size_t stride) const noexcept
+{
+	for (auto r = size_t(0); r < dim; ++r)
+	{
+		const auto *row = l.data() + r * dim;
+		auto s = b[r * stride];
+		for (auto k = size_t(0); k < r; ++k)
+			s -= row[k] * b[k * stride];
+		b[r * stride] = s / row[r];
+	}
+}
+
+/*! 
+ * Solves Lᵗ·x = y in place
+ *
+ * \param[in,out]	b	the right-hand side, replaced by the solution
+ * \param[in]	stride	the distance between two values of b
+ */
+void CholeskyDecomposition::backward(double *b, size_t stride) const noexcept
+{
+	for (auto r = dim; r > 0; --r)
+	{
+		const auto x = b[(r - 1) * stride] / l[(r - 1) * dim + r - 1];
+		b[(r - 1) * stride] = x;
+		// column r - 1 of Lᵗ is row r - 1 of L
+		const auto *row = l.data() + (r - 1) * dim;
+		for (auto k = size_t(0); k < r - 1; ++k)
+			b[k * stride] -= row[k] * x;
+	}
+}
+
+/*! 
+ * Solves M·X = B
+ *
+ * \throws	ExceptionDimension	B does not have as many rows as M
+ * \throws	ExceptionRuntime	the matrix is not positive definite
+ *
+ * \param[in]	b	the right-hand sides, one per column
+ * \return	the solutions, one per column
+ */
+MatrixDouble CholeskyDecomposition::Solve(const MatrixDouble &b) const
+{
+	if (b.GetRows() != dim)
+		throw ExceptionDimension(StringUTF8("MatrixDouble CholeskyDecomposition::Solve(const MatrixDouble &b) const: ") +
+				_("invalid or incompatible matrix dimensions"));
+	check("MatrixDouble CholeskyDecomposition::Solve(const MatrixDouble &b) const: ");
+	auto x = b;
+	for (auto c = size_t(0); c < x.GetCols(); ++c)
+	{
+		forward(&x.At(0, c), x.GetCols());
+		backward(&x.At(0, c), x.GetCols());
+	}
+	return x;
+}
+
+/*! 
+ * Solves M·x = b
+ *
+ * \throws	ExceptionDimension	b does not have as many elements as M has rows
+ * \throws	ExceptionRuntime	the matrix is not positive definite
+ *
+ * \param[in]	b	the right-hand side
+ * \return	the solution
+ */
+std::vector<double> CholeskyDecomposition::Solve(std::vector<double> b) const
+{
+	if (b.size() != dim)
+		throw ExceptionDimension(StringUTF8("std::vector<double> CholeskyDecomposition::Solve(std::vector<double> b) const: ") +
+				_("invalid or incompatible matrix dimensions"));
+	check("std::vector<double> CholeskyDecomposition::Solve(std::vector<double> b) const: ");
+	forward(b.data(), 1);
+	backward(b.data(), 1);
+	return b;
+}
+
+/*! 
+ * Computes xᵗ·M⁻¹·x without inverting M
+ *
+ * \throws	ExceptionDimension	x does not have as many elements as M has rows
+ * \throws	ExceptionRuntime	the matrix is not positive definite
+ *
+ * \param[in]	x	a vector
+ * \return	the squared Mahalanobis norm of x
+ */
+double CholeskyDecomposition::SquaredMahalanobis(const std::vector<double> &x) const
+{
+	if (x.size() != dim)
+		throw ExceptionDimension(StringUTF8("double CholeskyDecomposition::SquaredMahalanobis(const std::vector<double> &x) const: ") +
+				_("invalid or incompatible matrix dimensions"));
+	check("double CholeskyDecomposition::SquaredMahalanobis(const std::vector<double> &x) const: ");
+	auto y = x;
+	forward(y.data(), 1); // xᵗ·M⁻¹·x = |L⁻¹·x|²
+	auto d = 0.0;
+	for (auto v : y)
+		d += v * v;
+	return d;
+}
+
+/*! 
+ * Computes the inverse of the matrix
+ *
+ * \throws	ExceptionRuntime	the matrix is not positive definite
+ *
+ * \return	the inverse matrix
+ */
+SquareMatrixDouble CholeskyDecomposition::MakeInverse() const
+{
+	check("SquareMatrixDouble CholeskyDecomposition::MakeInverse() const: ");
+	auto inv = SquareMatrixDouble::NewIdentity(dim);
+	for (auto c = size_t(0); c < dim; ++c)
+	{
+		forward(&inv.At(0, c), dim);
+		backward(&inv.At(0, c), dim);
+	}
+	return inv;
+}
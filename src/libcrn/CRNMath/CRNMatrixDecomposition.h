@@ -0,0 +1,133 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNMatrixDecomposition.h
+ * \author Yann LEYDIER
+ */
+
+#ifndef CRNMATRIXDECOMPOSITION_HEADER
+#define CRNMATRIXDECOMPOSITION_HEADER
+
+#include <CRNMath/CRNSquareMatrixDouble.h>
+#include <vector>
+
+namespace crn
+{
+	/****************************************************************************/
+	/*! \brief LU decomposition with partial pivoting
+	 *
+	 * Factorizes P·M = L·U once in O(n³), then computes the determinant in O(1) and solves linear systems in O(n²) per right-hand side.
+	 *
+	 * \code
+	 * auto lu = crn::LUDecomposition(m);
+	 * auto x = lu.Solve(b); // instead of m.MakeInverse() * b
+	 * \endcode
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date	Oct 2016
+	 * \version	0.1
+	 * \ingroup	math
+	 */
+	class LUDecomposition
+	{
+		public:
+			/*! \brief Factorizes a matrix */
+			explicit LUDecomposition(const SquareMatrixDouble &m);
+
+			/*! \brief Returns the dimension of the matrix */
+			size_t GetDimension() const noexcept { return dim; }
+			/*! \brief Is the matrix singular? */
+			bool IsSingular() const noexcept { return singular; }
+			/*! \brief Returns the determinant of the matrix */
+			double GetDeterminant() const noexcept;
+			/*! \brief Returns the logarithm of the absolute value of the determinant (-inf if singular) */
+			double GetLogAbsDeterminant() const noexcept { return logdet; }
+			/*! \brief Returns the sign of the determinant (0 if singular) */
+			int GetDeterminantSign() const noexcept { return singular ? 0 : sign; }
+
+			/*! \brief Solves M·X = B */
+			MatrixDouble Solve(const MatrixDouble &b) const;
+			/*! \brief Solves M·x = b */
+			std::vector<double> Solve(std::vector<double> b) const;
+			/*! \brief Computes the inverse of the matrix */
+			SquareMatrixDouble MakeInverse() const;
+
+		private:
+			/*! \brief Solves in place for a right-hand side stored with a stride */
+			void solve(double *b, size_t stride) const noexcept;
+
+			size_t dim; /*!< dimension of the matrix */
+			std::vector<double> lu; /*!< L (below the diagonal, unit diagonal) and U, row-major */
+			std::vector<size_t> perm; /*!< row i of P·M is row perm[i] of M */
+			int sign; /*!< sign of the permutation times the signs of the pivots */
+			double logdet; /*!< log of |det| */
+			bool singular; /*!< a pivot is null */
+	};
+
+	/****************************************************************************/
+	/*! \brief Cholesky decomposition of a symmetric positive definite matrix
+	 *
+	 * Factorizes M = L·Lᵗ once in O(n³/3), then computes the (log-)determinant in O(1) and solves linear systems in O(n²) per right-hand side.
+	 * Only the lower triangle of the matrix is read.
+	 *
+	 * \author 	Yann LEYDIER
+	 * \date	Oct 2016
+	 * \version	0.1
+	 * \ingroup	math
+	 */
+	class CholeskyDecomposition
+	{
+		public:
+			/*! \brief Factorizes a matrix */
+			explicit CholeskyDecomposition(const SquareMatrixDouble &m);
+
+			/*! \brief Returns the dimension of the matrix */
+			size_t GetDimension() const noexcept { return dim; }
+			/*! \brief Was the matrix symmetric positive definite? */
+			bool IsPositiveDefinite() const noexcept { return positive; }
+			/*! \brief Returns the determinant of the matrix */
+			double GetDeterminant() const noexcept;
+			/*! \brief Returns the logarithm of the determinant */
+			double GetLogDeterminant() const noexcept { return logdet; }
+			/*! \brief Returns the lower triangular factor */
+			SquareMatrixDouble GetL() const;
+
+			/*! \brief Solves M·X = B */
+			MatrixDouble Solve(const MatrixDouble &b) const;
+			/*! \brief Solves M·x = b */
+			std::vector<double> Solve(std::vector<double> b) const;
+			/*! \brief Computes xᵗ·M⁻¹·x */
+			double SquaredMahalanobis(const std::vector<double> &x) const;
+			/*! \brief Computes the inverse of the matrix */
+			SquareMatrixDouble MakeInverse() const;
+
+		private:
+			/*! \brief Solves L·y = b in place */
+			void forward(double *b, size_t stride) const noexcept;
+			/*! \brief Solves Lᵗ·x = y in place */
+			void backward(double *b, size_t stride) const noexcept;
+			/*! \brief Throws if the matrix was not positive definite */
+			void check(const char *fun) const;
+
+			size_t dim; /*!< dimension of the matrix */
+			std::vector<double> l; /*!< L, row-major */
+			double logdet; /*!< log of det */
+			bool positive; /*!< the factorization succeeded */
+	};
+}
+
+#endif
@@ -24,6 +24,7 @@
 #include <CRNException.h>
 #include <CRNMath/CRNMatrixDouble.h>
 #include <CRNMath/CRNSquareMatrixDouble.h>
+#include <CRNMath/CRNMatrixDecomposition.h>
 #include <CRNMath/CRNMultivariateGaussianPDF.h>
 #include <CRNStringUTF8.h>
 #include <CRNProtocols.h>
@@ -172,8 +173,17 @@ double MultivariateGaussianPDF::ValueAt(const std::vector<double> &x) const
  */
 void MultivariateGaussianPDF::updateAuxiliaryAttributes()
 {
-	scale_factor = 1.0 / (pow(2.0 * M_PI, double(dimension) / 2.0) *  sqrt(variance.Determinant()));
-	inverse_variance = variance.MakeInverse();
+	auto chol = CholeskyDecomposition(variance);
+	if (chol.IsPositiveDefinite())
+	{ // the log-determinant does not overflow in high dimension
+		scale_factor = exp(-0.5 * (double(dimension) * log(2.0 * M_PI) + chol.GetLogDeterminant()));
+		inverse_variance = chol.MakeInverse();
+	}
+	else
+	{ // degenerated covariance
+		scale_factor = 1.0 / (pow(2.0 * M_PI, double(dimension) / 2.0) *  sqrt(variance.Determinant()));
+		inverse_variance = variance.MakeInverse();
+	}
 }
 
 /*! 
@@ -22,6 +22,7 @@
 
 #include <CRNException.h>
 #include <CRNMath/CRNSquareMatrixDouble.h>
+#include <CRNMath/CRNMatrixDecomposition.h>
 #include <CRNMath/CRNMath.h>
 #include <CRNMath/CRNEquationSolver.h>
 #include <CRNData/CRNDataFactory.h>
@@ -494,87 +495,23 @@ double SquareMatrixDouble::Determinant() const
 	if (IsUpperTriangular() || IsLowerTriangular())
 		return DiagonalProduct();
 
-	//////////////////
-	// General case //
-	//////////////////
-
-	double det = 0.0;
-
-	size_t r = 0;
-	size_t c = 0;
-	size_t MaxNullInRow = 0;
-	size_t MaxNullInColumn = 0;					
-
-	// Search most sparse row (r) and most sparse column (c)
-
-	for (size_t k = 0; k < rows; ++k)
-	{
-		size_t nr = CountNullCellsInRow(k);
-		size_t nc = CountNullCellsInColumn(k);
-
-		if (nr > MaxNullInRow)
-		{
-			MaxNullInRow = nr;
-			r = k;
-		}
-
-		if (nc > MaxNullInColumn)
-		{
-			MaxNullInColumn = nc;
-			c = k;
-		}
-	}
-
-	// Expansion by minors
-
-	if (MaxNullInRow > MaxNullInColumn)
-	{		
-		for (size_t k = 0; k < cols; ++k)
-		{
-			double Erk = At(r, k);
-
-			if (Erk != 0.0)
-				det += Erk * Cofactor(r, k);
-		}
-	}
-	else
-	{
-		for (size_t k = 0; k < rows; k++)
-		{
-			double Ekc = At(k, c);
-
-			if (Ekc != 0.0)
-				det += Ekc * Cofactor(k, c);
-		}
-	}
-
-	return det;
+	// General case
+	return LUDecomposition(*this).GetDeterminant();
 }
 
 /*! 
- * Inversion using determinants computation
+ * Inversion using a LU decomposition
+ *
+ * \throws	ExceptionRuntime	matrix cannot be inversed
  *
  * \return	the inverse matrix
  */
 SquareMatrixDouble SquareMatrixDouble::MakeInverse() const
 {
-	double dt = Determinant();
-
-	if (dt != 0.0)
-	{				
-		SquareMatrixDouble C(rows);
-
-		for (size_t r = 0; r < rows; ++r)
-			for (size_t c = 0; c < cols; ++c)
-				C[r][c] = Cofactor(r, c);
-
-		C.Transpose();
-		C *= 1.0 / dt;
-
-		return C;
-	}
-
-	throw ExceptionRuntime(_("The matrix cannot be inversed."));
+	auto lu = LUDecomposition(*this);
+	if (lu.IsSingular())
+		throw ExceptionRuntime(StringUTF8("SquareMatrixDouble SquareMatrixDouble::MakeInverse() const: ") + _("The matrix cannot be inversed."));
+	return lu.MakeInverse();
 }
 
 /*! 
@@ -609,94 +546,11 @@ SquareMatrixDouble SquareMatrixDouble::NewIdentity(size_t n)
  */
 SquareMatrixDouble SquareMatrixDouble::MakeGaussJordanInverse() const
 {
-	size_t n = rows;
-	SquareMatrixDouble Id = NewIdentity(n);
-	SquareMatrixDouble M = *this;
-
-	// Transform this matrix to triangular matrix
-
-	for (size_t c = 0; c < n - 1; ++c)
-	{
-		// Search the greatest pivot in column
-
-		double Pivot = M[c][c];
-		double AbsMaxPivot = fabs(Pivot);
-		size_t RowIndex = c;
-
-		for (size_t r = c + 1 ; r < n; ++r)
-		{
-			double Candidate = M[r][c];
-
-			if (fabs(Candidate) > AbsMaxPivot)
-			{
-				Pivot = Candidate;
-				AbsMaxPivot = fabs(Pivot);
-				RowIndex = r;
-			}
-		}
-
-		// If no non-null pivot found, matrix is non inversible
-
-		if (Pivot == 0.0)
-			throw ExceptionRuntime(crn::StringUTF8(_("Matrix cannot be inversed. Null pivot at column: ")) + c);
-
-		if (RowIndex != c)
-		{
-			M.SwapRows(c, RowIndex);
-			Id.SwapRows(c, RowIndex);
-		}
-
-		// Elimination
-
-		for (size_t r = c + 1; r < n; ++r)
-		{
-			double Coeff = M[r][c];
-
-			if (Coeff != 0.0)
-			{
-				double Scale = - Coeff / Pivot;
-
-				for (size_t k = 0; k < n; ++k)
-				{
-					M[r][k] += M[c][k] * Scale;
-					Id[r][k] += Id[c][k] * Scale;
-				}					
-			}
-		}
-	}
-
-	// Transform this matrix to diagonal
-
-	for (int c = int(n) - 1; c > 0; --c)
-	{
-		double DCoeff = M[c][c];
-
-		if (DCoeff != 0.0)
-		{
-			for (int r = c - 1; r >= 0; --r)
-			{
-				double Coeff = M[r][c];
-
-				if (Coeff != 0.0)
-				{
-					double Scale = - Coeff / DCoeff;
-
-					for (size_t k = 0; k < n; ++k)
-					{
-						Id[r][k] += Id[c][k] * Scale;
-						M[r][k] += M[c][k] * Scale;
-					}
-				}
-			}
-		}
-	}
-
-	// Transform to id
-
-	for (size_t r = 0; r < n; r++)
-		Id.MultRow(r, 1.0 / M[r][r]);
-
-	return Id;
+	// same partial pivoting as the Gauss-Jordan elimination, without the explicit reduction of the identity
+	auto lu = LUDecomposition(*this);
+	if (lu.IsSingular())
+		throw ExceptionRuntime(StringUTF8("SquareMatrixDouble SquareMatrixDouble::MakeGaussJordanInverse() const: ") + _("The matrix cannot be inversed."));
+	return lu.MakeInverse();
 }
 
 /*! 
@@ -87,7 +87,7 @@ namespace crn
 			double Cofactor(size_t r, size_t c) const;
 			/*! \brief Determinant */		
 			double Determinant() const;
-			/*! \brief Invert using determinants */
+			/*! \brief Invert using a LU decomposition */
 			SquareMatrixDouble MakeInverse() const;
 			/*! \brief Invert using Gauss-Jordan elimination */
 			SquareMatrixDouble MakeGaussJordanInverse() const;
@@ -24,6 +24,7 @@
 #include <CRNException.h>
 #include <CRNData/CRNMap.h>
 #include <CRNXml/CRNXml.h>
+#include <CRNData/CRNBinary.h>
 
 using namespace crn;
 
@@ -70,7 +71,7 @@ bool Savable::IsUserData(const String &key) const
 
 /*****************************************************************************/
 /*!
- * Gets a user data by key
+ * Gets a user data by key. The lookup does not mark the object as modified: a caller that edits the value in place must signal it (see Block::SetModified()).
  *
  * \param[in]	key	The data key
  * \return	the value or nullptr if key does not exist
@@ -134,6 +135,7 @@ void Savable::DeleteUserData(const String &key)
 	if (!user_data)
 		throw ExceptionNotFound(_("No user data to remove."));
 	user_data->Remove(key); // may throw
+	internalDataChanged();
 }
 
 /*!
@@ -147,6 +149,7 @@ void Savable::SetUserData(const String &key, SObject value)
 	if (!user_data)
 		user_data.reset(new Map());
 	user_data->Set(key, value);
+	internalDataChanged();
 }
 
 /*! 
@@ -155,7 +158,10 @@ void Savable::SetUserData(const String &key, SObject value)
 void Savable::ClearUserData()
 {
 	if (user_data)
+	{
 		user_data->Clear();
+		internalDataChanged();
+	}
 }
 
 /***************************************************************************/
@@ -324,3 +330,35 @@ void Savable::serialize_internal_data(xml::Element &el) const
 }
 
 
+
+/*****************************************************************************/
+/*! 
+ * Internal. Initializes some internal data from a binary stream. The name is not stored.
+ *
+ * \throws	ExceptionIO	truncated or invalid data
+ * \param[in]	r	the stream that contains the serialized object
+ */
+void Savable::deserialize_internal_data(binary::Reader &r)
+{
+	if (!r.ReadU8())
+		return;
+	auto m = std::dynamic_pointer_cast<Map>(r.ReadObject());
+	if (!m)
+		throw ExceptionIO(StringUTF8("void Savable::deserialize_internal_data(binary::Reader &r): ") + _("Invalid user data."));
+	if (!user_data)
+		user_data.reset(new Map());
+	*user_data = std::move(*m);
+}
+
+/*****************************************************************************/
+/*! 
+ * Internal. Dumps some internal data to a binary stream. The name is not stored.
+ *
+ * \param[in]	w	the stream that will contain the serialized object
+ */
+void Savable::serialize_internal_data(binary::Writer &w) const
+{
+	w.WriteU8(user_data ? 1 : 0);
+	if (user_data)
+		w.WriteObject(*user_data);
+}
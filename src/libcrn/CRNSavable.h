@@ -33,6 +33,11 @@ namespace crn
 {
 	class Savable;
 	CRN_ALIAS_SMART_PTR(Savable)
+	namespace binary
+	{
+		class Writer;
+		class Reader;
+	}
 }
 namespace crn
 {
@@ -77,9 +82,9 @@ namespace crn
 			/*! \brief Returns the name of the object */
 			const String& GetName() const { return name; }
 			/*! \brief Sets the name of the object */
-			void SetName(const String &s) { name = s; }
+			void SetName(const String &s) { name = s; internalDataChanged(); }
 			/*! \brief Sets the name of the object */
-			void SetName(String &&s) noexcept { name = std::move(s); }
+			void SetName(String &&s) noexcept { name = std::move(s); internalDataChanged(); }
 
 			/*! \brief Adds or replaces a user data */
 			void SetUserData(const String &key, SObject value);
@@ -96,6 +101,10 @@ namespace crn
 			/*! \brief Deletes all user data entries */
 			void ClearUserData();
 
+		protected:
+			/*! \brief Called when the name or the user data may have been modified */
+			virtual void internalDataChanged() noexcept {}
+
 		private:
 			String name; /*!< The name of the object */
 			std::unique_ptr<Map> user_data; /*!< A map of user-set objects */
@@ -134,6 +143,10 @@ namespace crn
 			void deserialize_internal_data(xml::Element &el);
 			/*! \brief Dumps some internal data to an XML element. */
 			void serialize_internal_data(xml::Element &el) const;
+			/*! \brief Initializes some internal data from a binary stream. */
+			void deserialize_internal_data(binary::Reader &r);
+			/*! \brief Dumps some internal data to a binary stream. */
+			void serialize_internal_data(binary::Writer &w) const;
 	};
 }
 
@@ -0,0 +1,239 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNThreadPool.cpp
+ * \author Yann LEYDIER
+ */
+
+#include <CRNUtils/CRNThreadPool.h>
+#include <CRNStringUTF8.h>
+#include <CRNException.h>
+#include <CRNMath/CRNMath.h>
+#include <CRNi18n.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace crn;
+
+/*! true in the threads owned by a ThreadPool */
+static thread_local bool in_worker = false;
+/*! concurrency override set by ConcurrencyScope, 0 if none */
+static thread_local size_t local_concurrency = 0;
+/*! global concurrency, 0 for the hardware concurrency */
+static std::atomic<size_t> global_concurrency{0};
+
+/*! \return	the number of hardware threads, at least 1 */
+static size_t hardware_concurrency() noexcept
+{
+	const auto n = size_t(std::thread::hardware_concurrency());
+	return n ? n : 1;
+}
+
+struct ThreadPool::internal_data
+{
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool stop = false;
+};
+
+/*! Constructor
+ * \param[in]	nthreads	the number of worker threads, 0 for the hardware concurrency
+ */
+ThreadPool::ThreadPool(size_t nthreads):
+	data(std::make_unique<internal_data>())
+{
+	if (!nthreads)
+		nthreads = hardware_concurrency();
+	for (auto tmp = size_t(0); tmp < nthreads; ++tmp)
+		data->workers.emplace_back([this]()
+				{
+					in_worker = true;
+					while (true)
+					{
+						auto task = std::function<void()>{};
+						{
+							auto lock = std::unique_lock<std::mutex>(data->mutex);
+							data->cond.wait(lock, [this](){ return data->stop || !data->tasks.empty(); });
+							if (data->tasks.empty())
+								return; // stopped and nothing left to do
+							task = std::move(data->tasks.front());
+							data->tasks.pop_front();
+						}
+						task();
+					}
+				});
+}
+
+/*! Destructor (waits for pending tasks) */
+ThreadPool::~ThreadPool()
+{
+	{
+		auto lock = std::unique_lock<std::mutex>(data->mutex);
+		data->stop = true;
+	}
+	data->cond.notify_all();
+	for (auto &th : data->workers)
+		th.join();
+}
+
+/*! \return	the number of worker threads */
+size_t ThreadPool::GetNbThreads() const noexcept
+{
+	return data->workers.size();
+}
+
+/*! Adds a task to the queue. If the current thread is a worker, the task is executed immediately.
+ * \throws	ExceptionLogic	the pool is being destroyed
+ * \param[in]	task	the function to execute
+ * \return	a future that becomes ready when the task is done and rethrows its exception if any
+ */
+std::future<void> ThreadPool::Push(std::function<void()> task)
+{
+	auto ptask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+	auto fut = ptask->get_future();
+	if (in_worker)
+	{
+		(*ptask)();
+		return fut;
+	}
+	{
+		auto lock = std::unique_lock<std::mutex>(data->mutex);
+		if (data->stop)
+			throw ExceptionLogic(StringUTF8("std::future<void> ThreadPool::Push(std::function<void()> task): ") + _("the pool is stopped."));
+		data->tasks.emplace_back([ptask](){ (*ptask)(); });
+	}
+	data->cond.notify_one();
+	return fut;
+}
+
+/*! \return	true if the current thread belongs to a ThreadPool */
+bool ThreadPool::IsWorkerThread() noexcept
+{
+	return in_worker;
+}
+
+/*! Gets the pool used by the library's parallel algorithms. It has as many workers as the hardware has threads.
+ * \return	a reference to the default pool
+ */
+ThreadPool& ThreadPool::GetDefault()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+/*! Gets the number of threads used by parallel algorithms
+ * \return	the value set by the innermost ConcurrencyScope of the current thread, or by SetConcurrency, or the hardware concurrency
+ */
+size_t crn::GetConcurrency() noexcept
+{
+	if (local_concurrency)
+		return local_concurrency;
+	const auto g = global_concurrency.load();
+	return g ? g : hardware_concurrency();
+}
+
+/*! Sets the number of threads used by parallel algorithms
+ * \param[in]	nthreads	the number of threads, 1 to disable parallelism, 0 for the hardware concurrency
+ */
+void crn::SetConcurrency(size_t nthreads)
+{
+	global_concurrency = nthreads;
+}
+
+/*! Sets the local concurrency
+ * \param[in]	nthreads	the number of threads, 1 to disable parallelism, 0 to use the global setting
+ */
+ConcurrencyScope::ConcurrencyScope(size_t nthreads):
+	previous(local_concurrency)
+{
+	local_concurrency = nthreads;
+}
+
+/*! Restores the previous concurrency */
+ConcurrencyScope::~ConcurrencyScope()
+{
+	local_concurrency = previous;
+}
+
+/*! Splits a range into contiguous bands and processes them in parallel.
+ *
+ * The calling thread processes the first band. When called from a worker thread, the whole range is processed serially.
+ *
+ * \param[in]	b	the beginning of the range
+ * \param[in]	e	the end of the range (excluded)
+ * \param[in]	fun	the function to call on each band [begin, end)
+ * \param[in]	nthreads	the maximal number of bands, 0 to use GetConcurrency()
+ * \param[in]	grain	the minimal size of a band. Band limits are always multiples of grain (relatively to b).
+ */
+void crn::ParallelFor(size_t b, size_t e, const std::function<void(size_t, size_t)> &fun, size_t nthreads, size_t grain)
+{
+	if (e <= b)
+		return;
+	if (!grain)
+		grain = 1;
+	if (!nthreads)
+		nthreads = GetConcurrency();
+	if (ThreadPool::IsWorkerThread())
+		nthreads = 1;
+	const auto nchunks = (e - b + grain - 1) / grain;
+	const auto nbands = Min(nthreads, nchunks);
+	if (nbands <= 1)
+	{
+		fun(b, e);
+		return;
+	}
+	const auto bandsize = ((nchunks + nbands - 1) / nbands) * grain;
+
+	auto &pool = ThreadPool::GetDefault();
+	auto futures = std::vector<std::future<void>>{};
+	for (auto band = b + bandsize; band < e; band += bandsize)
+	{
+		const auto bandend = Min(band + bandsize, e);
+		futures.push_back(pool.Push([&fun, band, bandend](){ fun(band, bandend); }));
+	}
+	auto error = std::exception_ptr{};
+	try
+	{
+		fun(b, Min(b + bandsize, e));
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	// wait for all bands since they reference fun
+	for (auto &f : futures)
+	{
+		try
+		{
+			f.get();
+		}
+		catch (...)
+		{
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
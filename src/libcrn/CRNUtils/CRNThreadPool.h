@@ -0,0 +1,110 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: CRNThreadPool.h
+ * \author Yann LEYDIER
+ */
+
+#ifndef CRNThreadPool_HEADER
+#define CRNThreadPool_HEADER
+
+#include <CRN.h>
+#include <functional>
+#include <future>
+
+namespace crn
+{
+	/*! \brief A pool of worker threads
+	 *
+	 * A fixed set of worker threads that execute tasks in FIFO order.
+	 *
+	 * Tasks pushed from a worker thread (of any pool) are executed immediately in the calling thread, so that nested parallel calls cannot deadlock.
+	 *
+	 * \ingroup utils
+	 * \date	Oct 2016
+	 * \author Yann LEYDIER
+	 */
+	class ThreadPool
+	{
+		public:
+			/*! \brief Constructor */
+			explicit ThreadPool(size_t nthreads = 0);
+			/*! \brief Destructor (waits for pending tasks) */
+			~ThreadPool();
+			ThreadPool(const ThreadPool &) = delete;
+			ThreadPool(ThreadPool&&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+			ThreadPool& operator=(ThreadPool&&) = delete;
+
+			/*! \brief Returns the number of worker threads */
+			size_t GetNbThreads() const noexcept;
+
+			/*! \brief Adds a task to the queue */
+			std::future<void> Push(std::function<void()> task);
+
+			/*! \brief Tells if the current thread is a worker of a pool */
+			static bool IsWorkerThread() noexcept;
+
+			/*! \brief Gets the pool used by the library's parallel algorithms */
+			static ThreadPool& GetDefault();
+
+		private:
+			struct internal_data;
+			std::unique_ptr<internal_data> data;
+	};
+
+	/*! \brief Gets the number of threads used by parallel algorithms */
+	size_t GetConcurrency() noexcept;
+	/*! \brief Sets the number of threads used by parallel algorithms */
+	void SetConcurrency(size_t nthreads);
+
+	/*! \brief Overrides the number of threads used by parallel algorithms in the current thread
+	 *
+	 * Overrides the number of threads used by parallel algorithms called from the current thread, until the object is destroyed.
+	 *
+	 * \code
+	 * {
+	 * 	crn::ConcurrencyScope serial(1);
+	 * 	img.Convolve(mat); // runs in the current thread only
+	 * }
+	 * \endcode
+	 *
+	 * \ingroup utils
+	 * \date	Oct 2016
+	 * \author Yann LEYDIER
+	 */
+	class ConcurrencyScope
+	{
+		public:
+			/*! \brief Sets the local concurrency (0 for the global setting) */
+			explicit ConcurrencyScope(size_t nthreads);
+			/*! \brief Restores the previous concurrency */
+			~ConcurrencyScope();
+			ConcurrencyScope(const ConcurrencyScope &) = delete;
+			ConcurrencyScope(ConcurrencyScope&&) = delete;
+			ConcurrencyScope& operator=(const ConcurrencyScope&) = delete;
+			ConcurrencyScope& operator=(ConcurrencyScope&&) = delete;
+		private:
+			size_t previous; /*!< the overridden value */
+	};
+
+	/*! \brief Splits a range into bands and processes them in parallel */
+	void ParallelFor(size_t b, size_t e, const std::function<void(size_t, size_t)> &fun, size_t nthreads = 0, size_t grain = 1);
+}
+
+#endif
+
@@ -0,0 +1,132 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: binarization.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+
+static crn::ImageGray make_page(size_t w, size_t h)
+{
+	auto img = crn::ImageGray(w, h);
+	auto rnd = TestRandom(4321u);
+	for (size_t y = 0; y < h; ++y)
+		for (size_t x = 0; x < w; ++x)
+		{
+			const auto ink = ((x / 7 + y / 5) % 4 == 0) ? 120 : 0;
+			img.At(x, y) = uint8_t(200 - ink + int(rnd.Next() >> 28));
+		}
+	return img;
+}
+
+/*! Statistics of a window, computed directly */
+struct Window
+{
+	double sum = 0.0, sqrsum = 0.0, size = 0.0;
+	uint8_t min = 255, max = 0;
+	double Mean() const { return sum / size; }
+	double Deviation() const { return sqrt(sqrsum / size - crn::Sqr(Mean())); }
+};
+
+static Window window(const crn::ImageGray &img, size_t x, size_t y, size_t halfwin)
+{
+	const auto x1 = (x < halfwin) ? 0 : x - halfwin;
+	const auto y1 = (y < halfwin) ? 0 : y - halfwin;
+	const auto x2 = crn::Min(x + halfwin, img.GetWidth() - 1);
+	const auto y2 = crn::Min(y + halfwin, img.GetHeight() - 1);
+	auto win = Window{};
+	for (auto ty = y1; ty <= y2; ++ty)
+		for (auto tx = x1; tx <= x2; ++tx)
+		{
+			const auto v = img.At(tx, ty);
+			win.sum += v;
+			win.sqrsum += crn::Sqr(double(v));
+			win.min = crn::Min(win.min, v);
+			win.max = crn::Max(win.max, v);
+		}
+	win.size = double((x2 - x1 + 1) * (y2 - y1 + 1));
+	return win;
+}
+
+/*! Brute force local threshold, as Niblack and Sauvola used to be computed */
+template<typename F> static crn::ImageBW brute_force(const crn::ImageGray &img, size_t halfwin, F threshold)
+{
+	auto out = crn::ImageBW(img.GetWidth(), img.GetHeight());
+	FOREACHPIXEL(x, y, img)
+	{
+		const auto t = threshold(window(img, x, y, halfwin));
+		out.At(x, y) = (img.At(x, y) < uint8_t(t)) ? crn::pixel::BWBlack : crn::pixel::BWWhite;
+	}
+	return out;
+}
+
+TEST_CASE("Local thresholds with summed area tables", "[binarization]")
+{
+	const auto img = make_page(97, 61);
+	const auto halfwin = size_t(6);
+
+	SECTION("Niblack")
+	{
+		const auto k = -0.2;
+		REQUIRE(crn::Niblack(img, halfwin, k) == brute_force(img, halfwin, [k](const Window &w) { return w.Mean() + k * w.Deviation(); }));
+	}
+	SECTION("Sauvola")
+	{
+		const auto k = 0.3;
+		const auto mM = crn::MinMax(img);
+		const auto r = (double(mM.second) - double(mM.first)) * 0.5;
+		REQUIRE(crn::Sauvola(img, halfwin, k) == brute_force(img, halfwin, [k, r](const Window &w) { return w.Mean() * (1 + k * (w.Deviation() / r - 1)); }));
+	}
+	SECTION("Wolf")
+	{
+		const auto k = 0.5;
+		const auto mingray = double(crn::MinMax(img).first);
+		auto maxsd = 0.0;
+		FOREACHPIXEL(x, y, img)
+			maxsd = crn::Max(maxsd, window(img, x, y, halfwin).Deviation());
+		const auto bw = crn::Wolf(img, halfwin, k);
+		REQUIRE(crn::CountBlackPixels(bw) > 0);
+		REQUIRE(bw == brute_force(img, halfwin, [k, mingray, maxsd](const Window &w)
+					{ return w.Mean() - k * (1 - w.Deviation() / maxsd) * (w.Mean() - mingray); }));
+	}
+	SECTION("NICK")
+	{
+		const auto k = -0.1;
+		const auto bw = crn::NICK(img, halfwin, k);
+		REQUIRE(crn::CountBlackPixels(bw) > 0);
+		REQUIRE(bw == brute_force(img, halfwin, [k](const Window &w)
+					{ return w.Mean() + k * sqrt((w.sqrsum - crn::Sqr(w.Mean())) / w.size); }));
+	}
+	SECTION("Bernsen")
+	{
+		const auto mincontrast = uint8_t(15);
+		const auto bw = crn::Bernsen(img, halfwin, mincontrast);
+		REQUIRE(crn::CountBlackPixels(bw) > 0);
+		auto ref = crn::ImageBW(img.GetWidth(), img.GetHeight());
+		FOREACHPIXEL(x, y, img)
+		{
+			const auto w = window(img, x, y, halfwin);
+			const auto t = (double(w.min) + double(w.max)) / 2;
+			ref.At(x, y) = ((w.max - w.min >= mincontrast) && (img.At(x, y) < uint8_t(t))) ? crn::pixel::BWBlack : crn::pixel::BWWhite;
+		}
+		REQUIRE(bw == ref);
+	}
+}
@@ -0,0 +1,264 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: blockfile.cpp
+ * \author Yann LEYDIER
+ */
+
+
+
+#include "catch.hpp"
+#include <CRNBlock.h>
+#include <CRNDocument.h>
+#include <CRNData/CRNInt.h>
+#include <CRNData/CRNReal.h>
+#include <CRNData/CRNMap.h>
+#include <CRNData/CRNVector.h>
+#include <CRNGeometry/CRNPoint2DInt.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNIO/CRNIO.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+static std::string read_file(const char *fname)
+{
+	std::ifstream in(fname, std::ios::binary);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+static crn::SBlock make_page(const crn::SImage &img)
+{
+	auto page = crn::Block::New(img);
+	auto v = std::make_shared<crn::Vector>();
+	v->PushBack(std::make_shared<crn::Int>(-3));
+	v->PushBack(std::make_shared<crn::Point2DInt>(4, 5));
+	v->PushBack(std::make_shared<crn::String>(U"été"));
+	page->SetUserData(U"list", v);
+	for (auto l = 0; l < 5; ++l)
+	{
+		auto line = page->AddChildAbsolute(U"lines", crn::Rect(2, 10 * l, 90, 10 * l + 8), crn::String(l));
+		line->SetUserData(U"score", std::make_shared<crn::Real>(0.1 * l - 1e-9));
+		for (auto w = 0; w < 4; ++w)
+		{
+			auto word = line->AddChildAbsolute(U"words", crn::Rect(2 + 20 * w, 10 * l, 18 + 20 * w, 10 * l + 8));
+			auto m = std::make_shared<crn::Map>();
+			m->Set(U"text", std::make_shared<crn::StringUTF8>("w" + crn::StringUTF8(w)));
+			m->Set(U"bbox", std::make_shared<crn::Rect>(w, l, w + 1, l + 1));
+			m->Set(U"invalid", std::make_shared<crn::Rect>());
+			word->SetUserData(U"data", m);
+		}
+	}
+	page->AddChildAbsolute(U"zones", crn::Rect(0, 0, 50, 50), U"z");
+	return page;
+}
+
+TEST_CASE("Binary block files", "[blockfile]")
+{
+	auto img = std::make_shared<crn::ImageGray>(100, 60, uint8_t(255));
+	REQUIRE(crn::Block::IsBinaryFilename("page.crnb"));
+	REQUIRE_FALSE(crn::Block::IsBinaryFilename("page.xml"));
+
+	auto page = make_page(img);
+	page->Save("blockfile_ref.xml");
+	page->Save("blockfile_test.crnb");
+	REQUIRE(read_file("blockfile_test.crnb").size() < read_file("blockfile_ref.xml").size());
+
+	SECTION("Round trip with XML")
+	{
+		auto loaded = crn::Block::New(img);
+		REQUIRE(loaded->Append("blockfile_test.crnb"));
+		REQUIRE(loaded->GetNbChildren(U"lines") == 5);
+		REQUIRE(loaded->GetChild(U"lines", 3)->GetNbChildren(U"words") == 4);
+		REQUIRE(loaded->GetChild(U"lines", 3)->GetName() == U"3");
+		loaded->Save("blockfile_test.xml");
+		REQUIRE(read_file("blockfile_test.xml") == read_file("blockfile_ref.xml"));
+
+		auto fromxml = crn::Block::New(img);
+		REQUIRE(fromxml->Append("blockfile_ref.xml"));
+		fromxml->Save("blockfile_test2.crnb");
+		REQUIRE(read_file("blockfile_test2.crnb") == read_file("blockfile_test.crnb"));
+		std::remove("blockfile_test.xml");
+		std::remove("blockfile_test2.crnb");
+	}
+	SECTION("Corrupted files are rejected")
+	{
+		const auto data = read_file("blockfile_test.crnb");
+		std::ofstream("blockfile_cut.crnb", std::ios::binary) << data.substr(0, data.size() / 2);
+		{ // the blocks are saved to the file they tried to read when destroyed
+			auto loaded = crn::Block::New(img);
+			REQUIRE_THROWS_AS(loaded->Append("blockfile_cut.crnb"), const crn::ExceptionIO&);
+			auto other = crn::Block::New(std::make_shared<crn::ImageGray>(10, 10));
+			REQUIRE_THROWS_AS(other->Append("blockfile_test.crnb"), const crn::ExceptionRuntime&);
+		}
+		std::remove("blockfile_cut.crnb");
+	}
+	std::remove("blockfile_ref.xml");
+	std::remove("blockfile_test.crnb");
+}
+
+TEST_CASE("Unmodified blocks are not saved again", "[blockfile]")
+{
+	auto img = std::make_shared<crn::ImageGray>(100, 60, uint8_t(255));
+	{
+		auto page = make_page(img);
+		REQUIRE(page->IsModified());
+		page->SaveAs("blockfile_dirty.crnb");
+		REQUIRE_FALSE(page->IsModified());
+		REQUIRE_FALSE(page->GetChild(U"lines", 2)->IsModified());
+
+		std::ofstream("blockfile_dirty.crnb", std::ios::binary) << "unchanged";
+		page->Save();
+		REQUIRE(read_file("blockfile_dirty.crnb") == "unchanged");
+
+		page->GetChild(U"lines", 2)->GetChild(U"words", 1)->SetUserData(U"text", std::make_shared<crn::String>(U"modified"));
+		REQUIRE(page->IsModified());
+		REQUIRE(page->GetChild(U"lines", 2)->IsModified());
+		REQUIRE_FALSE(page->GetChild(U"lines", 1)->IsModified());
+		page->Save();
+		REQUIRE_FALSE(page->IsModified());
+		page->Save("blockfile_dirty_ref.xml");
+	}
+	{
+		auto loaded = crn::Block::New(img);
+		REQUIRE(loaded->Append("blockfile_dirty.crnb"));
+		REQUIRE_FALSE(loaded->IsModified());
+		REQUIRE(loaded->GetChild(U"lines", 2)->GetChild(U"words", 1)->IsUserData(U"text"));
+		loaded->Save("blockfile_dirty.xml");
+		REQUIRE(read_file("blockfile_dirty.xml") == read_file("blockfile_dirty_ref.xml"));
+
+		loaded->GetChild(U"lines", 4)->RemoveChild(U"words", 0);
+		REQUIRE(loaded->IsModified());
+	} // saved when destroyed
+	{
+		auto loaded = crn::Block::New(img);
+		REQUIRE(loaded->Append("blockfile_dirty.crnb"));
+		REQUIRE(loaded->GetChild(U"lines", 4)->GetNbChildren(U"words") == 3);
+		REQUIRE(loaded->GetChild(U"lines", 2)->GetChild(U"words", 1)->IsUserData(U"text"));
+	}
+	std::remove("blockfile_dirty.crnb");
+	std::remove("blockfile_dirty.xml");
+	std::remove("blockfile_dirty_ref.xml");
+}
+
+TEST_CASE("Reading user data and trees does not mark blocks as modified", "[blockfile]")
+{
+	auto img = std::make_shared<crn::ImageGray>(100, 60, uint8_t(255));
+	{
+		auto page = make_page(img);
+		page->GetChild(U"lines", 2)->SetUserData(U"text", std::make_shared<crn::String>(U"line"));
+		page->SaveAs("blockfile_lookup.crnb");
+		REQUIRE_FALSE(page->IsModified());
+
+		auto line = page->GetChild(U"lines", 2);
+		auto text = std::static_pointer_cast<crn::String>(line->GetUserData(U"text"));
+		REQUIRE(*text == U"line");
+		REQUIRE(line->GetUserData(U"missing") == nullptr);
+		REQUIRE(line->GetTree(U"words")->Size() == 4);
+		auto cnt = size_t(0);
+		for (auto b = line->BlockBegin(U"words"); b != line->BlockEnd(U"words"); ++b)
+			cnt += b->IsUserData(U"data") ? 1 : 0;
+		REQUIRE(cnt == 4);
+		REQUIRE_FALSE(line->IsModified());
+		REQUIRE_FALSE(page->IsModified());
+
+		*text = U"edited";
+		line->SetModified();
+		REQUIRE(page->IsModified());
+		page->Save();
+		REQUIRE_FALSE(page->IsModified());
+	}
+	{
+		auto loaded = crn::Block::New(img);
+		REQUIRE(loaded->Append("blockfile_lookup.crnb"));
+		REQUIRE(*std::static_pointer_cast<crn::String>(loaded->GetChild(U"lines", 2)->GetUserData(U"text")) == U"edited");
+	}
+	std::remove("blockfile_lookup.crnb");
+}
+
+TEST_CASE("A failed save does not leave stale records", "[blockfile]")
+{
+	auto img = std::make_shared<crn::ImageGray>(100, 60, uint8_t(255));
+	{
+		auto page = make_page(img);
+		page->SaveAs("blockfile_stale.crnb");
+		page->GetChild(U"lines", 2)->SetName(U"first");
+		// a directory cannot be overwritten
+		std::remove("blockfile_stale.crnb");
+		crn::IO::Mkdir("blockfile_stale.crnb");
+		REQUIRE_THROWS_AS(page->Save(), const crn::ExceptionIO&);
+		crn::IO::Rmdir("blockfile_stale.crnb");
+		page->GetChild(U"lines", 2)->SetName(U"second");
+		page->SaveAs("blockfile_stale2.crnb");
+		page->GetChild(U"lines", 0)->SetName(U"other");
+		page->Save();
+	}
+	{
+		auto loaded = crn::Block::New(img);
+		REQUIRE(loaded->Append("blockfile_stale2.crnb"));
+		REQUIRE(loaded->GetChild(U"lines", 0)->GetName() == U"other");
+		REQUIRE(loaded->GetChild(U"lines", 2)->GetName() == U"second");
+	}
+	std::remove("blockfile_stale2.crnb");
+}
+
+#ifdef CRN_USING_LIBPNG
+TEST_CASE("Documents convert their views to the selected format", "[blockfile]")
+{
+	crn::ImageGray(100, 60, uint8_t(255)).SavePNG("blockfile_view.png");
+	crn::IO::Mkdir("blockfile_doc_data");
+	{
+		auto doc = crn::Document{};
+		doc.SetBasename("blockfile_doc_data");
+		doc.AddView("blockfile_view.png");
+		const auto base = doc.GetBasename() + crn::Path::Separator() + crn::Path(doc.GetViewId(0));
+		{
+			auto view = doc.GetView(0);
+			view->AddChildAbsolute(U"zones", crn::Rect(1, 2, 30, 40), U"z");
+		} // saved as XML
+		REQUIRE(crn::IO::Access(base + ".xml", crn::IO::EXISTS));
+
+		doc.SetBinaryViews(true);
+		{ // reading does not convert
+			auto view = doc.GetView(0);
+			REQUIRE(view->GetNbChildren(U"zones") == 1);
+			REQUIRE(view->GetChild(U"zones", 0)->GetAbsoluteBBox() == crn::Rect(1, 2, 30, 40));
+			view->AddChildAbsolute(U"zones", crn::Rect(5, 5, 10, 10));
+		} // saved to its own file
+		REQUIRE(crn::IO::Access(base + ".xml", crn::IO::EXISTS));
+		REQUIRE_FALSE(crn::IO::Access(base + ".crnb", crn::IO::EXISTS));
+
+		doc.ConvertViews();
+		REQUIRE(crn::IO::Access(base + ".crnb", crn::IO::EXISTS));
+		REQUIRE_FALSE(crn::IO::Access(base + ".xml", crn::IO::EXISTS));
+		{
+			auto view = doc.GetView(0);
+			REQUIRE(view->GetNbChildren(U"zones") == 2);
+			view->AddChildAbsolute(U"zones", crn::Rect(5, 5, 10, 10));
+			doc.ConvertViews(); // nothing to convert
+		} // saved to the new file
+		REQUIRE_FALSE(crn::IO::Access(base + ".xml", crn::IO::EXISTS));
+		REQUIRE(doc.GetView(0)->GetNbChildren(U"zones") == 3);
+		doc.RemoveView(0);
+		REQUIRE_FALSE(crn::IO::Access(base + ".crnb", crn::IO::EXISTS));
+	}
+	crn::IO::Rmdir("blockfile_doc_data");
+	std::remove("blockfile_view.png");
+}
+#endif
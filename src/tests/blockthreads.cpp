@@ -0,0 +1,163 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: blockthreads.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include "catch.hpp"
+#include <CRNBlock.h>
+#include <CRNImage/CRNImageCache.h>
+#include <CRNImage/CRNImageRGB.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNIO/CRNPath.h>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+TEST_CASE("Block buffers are computed once when accessed concurrently", "[blockthreads]")
+{
+	crn::ImageCache::SetBudget(0);
+	auto img = std::make_shared<crn::ImageRGB>(200, 100, crn::pixel::RGB<uint8_t>(255, 255, 255));
+	for (auto y = 20; y < 80; ++y)
+		for (auto x = 30; x < 170; ++x)
+			img->At(x, y) = crn::pixel::RGB<uint8_t>(uint8_t(x), 0, uint8_t(y));
+	auto page = crn::Block::New(img);
+	std::vector<crn::SBlock> children;
+	for (auto l = 0; l < 4; ++l)
+		children.push_back(page->AddChildAbsolute(U"lines", crn::Rect(0, 25 * l, 199, 25 * l + 24)));
+
+	const auto nthreads = size_t(8);
+	std::vector<crn::SImageGray> grays(nthreads);
+	std::vector<crn::SImageBW> bws(nthreads);
+	std::vector<std::vector<crn::SImageGray>> childgrays(nthreads, std::vector<crn::SImageGray>(children.size()));
+	std::vector<std::thread> threads;
+	for (auto t = size_t(0); t < nthreads; ++t)
+		threads.emplace_back([&, t]()
+				{
+					// half the threads start from the children, so that the parent is created from them
+					if (t % 2)
+						for (auto c = size_t(0); c < children.size(); ++c)
+							childgrays[t][c] = children[(c + t) % children.size()]->GetGray();
+					bws[t] = page->GetBW();
+					grays[t] = page->GetGray();
+					if (!(t % 2))
+						for (auto c = size_t(0); c < children.size(); ++c)
+							childgrays[t][c] = children[(c + t) % children.size()]->GetGray();
+				});
+	for (auto &th : threads)
+		th.join();
+
+	for (auto t = size_t(0); t < nthreads; ++t)
+	{
+		REQUIRE(grays[t] == page->GetGray(false));
+		REQUIRE(bws[t] == page->GetBW(false));
+		for (auto c = size_t(0); c < children.size(); ++c)
+			REQUIRE(childgrays[t][c] == children[(c + t) % children.size()]->GetGray(false));
+	}
+	REQUIRE(children[2]->GetGray()->At(100, 0) == page->GetGray()->At(100, 50));
+}
+
+TEST_CASE("Block buffers can be flushed while being read", "[blockthreads]")
+{
+	crn::ImageCache::SetBudget(0);
+	auto img = std::make_shared<crn::ImageGray>(100, 100, uint8_t(128));
+	auto page = crn::Block::New(img);
+	auto child = page->AddChildAbsolute(U"zones", crn::Rect(10, 10, 59, 59));
+
+	std::atomic<int> errors(0);
+	std::vector<std::thread> threads;
+	for (auto t = 0; t < 4; ++t)
+		threads.emplace_back([&]()
+				{
+					for (auto i = 0; i < 200; ++i)
+					{
+						auto g = child->GetGray(); // a buffer that is in use is never freed
+						if ((g->GetWidth() != 50) || (g->At(20, 20) != 128))
+							errors += 1;
+					}
+				});
+	for (auto i = 0; i < 200; ++i)
+		page->FlushAll(true);
+	for (auto &th : threads)
+		th.join();
+	REQUIRE(errors == 0);
+	REQUIRE(child->GetGray()->GetHeight() == 50);
+}
+
+#ifdef CRN_USING_LIBPNG
+TEST_CASE("Block sources can be evicted while being read", "[blockthreads]")
+{
+	auto gray = crn::ImageGray(120, 80);
+	for (auto tmp : crn::Range(gray))
+		gray.At(tmp) = uint8_t(tmp % 251);
+	const auto fname = crn::Path("blockthreads_source.png");
+	gray.SavePNG(fname);
+	crn::ImageCache::SetBudget(1); // every unused buffer or source is freed as soon as something else is registered
+	crn::ImageCache::ResetStatistics();
+	{
+		auto page = crn::Block::New(fname, "");
+		page->FlushAll();
+		std::vector<crn::SBlock> children;
+		for (auto l = 0; l < 4; ++l)
+			children.push_back(page->AddChildAbsolute(U"lines", crn::Rect(0, 20 * l, 119, 20 * l + 19)));
+
+		std::atomic<int> errors(0);
+		std::atomic<int> running(4);
+		std::vector<std::thread> threads;
+		for (auto t = 0; t < 4; ++t)
+			threads.emplace_back([&, t]()
+					{
+						for (auto i = 0; i < 500; ++i)
+						{
+							const auto c = size_t(i + t) % children.size();
+							const auto y = int(20 * c + 5);
+							if (t % 2)
+							{ // reads the source without copying it
+								const auto view = children[c]->GetGrayView(false);
+								if (!view || (view.At(7, 5) != gray.At(7, y)))
+									errors += 1;
+							}
+							const auto g = children[c]->GetGray();
+							if (!g || (g->At(9, 5) != gray.At(9, y)))
+								errors += 1;
+							children[c]->FlushAll();
+							std::this_thread::yield();
+						}
+						running -= 1;
+					});
+		while (running)
+		{
+			page->FlushAll(true);
+			crn::ImageCache::SetBudget(0);
+			crn::ImageCache::SetBudget(1);
+			std::this_thread::yield();
+		}
+		for (auto &th : threads)
+			th.join();
+		REQUIRE(errors == 0);
+		REQUIRE(*children[1]->GetGray() == crn::ImageGray(gray, crn::Rect(0, 20, 119, 39)));
+		crn::ImageCache::SetBudget(0);
+		crn::ImageCache::SetBudget(1);
+		REQUIRE(crn::ImageCache::GetEvictions() > 0);
+	}
+	crn::ImageCache::SetBudget(0);
+	std::remove(fname.CStr());
+}
+#endif
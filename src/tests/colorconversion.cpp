@@ -0,0 +1,67 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: colorconversion.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNColorConversion.h>
+#include <CRNImage/CRNPixel.h>
+
+TEST_CASE("Batch color space conversions", "[color]")
+{
+	auto img = crn::ImageRGB(83, 41);
+	auto rnd = TestRandom(31337u);
+	for (auto &px : img)
+	{
+		const auto v = rnd.Next();
+		px = crn::pixel::RGB8(uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8));
+	}
+	img.At(0, 0) = crn::pixel::RGB8(0, 0, 0);
+	img.At(1, 0) = crn::pixel::RGB8(255, 255, 255);
+
+	const auto hsv = crn::MakeImageHSV(img);
+	const auto xyz = crn::MakeImageXYZ(img);
+	const auto yuv = crn::MakeImageYUV(img);
+	const auto lab = crn::MakeImageLab(img);
+	const auto luv = crn::MakeImageLuv(img);
+	const auto lab32 = crn::MakeImageFloat3(img, crn::ColorSpace::Lab);
+	const auto lab16 = crn::MakeImageShort3(img, crn::ColorSpace::Lab);
+	const auto luv16 = crn::MakeImageShort3(img, crn::ColorSpace::Luv);
+	auto ok = true;
+	for (size_t tmp = 0; tmp < img.Size(); ++tmp)
+	{
+		// reference: per pixel conversions
+		const auto rxyz = crn::pixel::XYZ(img.At(tmp));
+		const auto ryuv = crn::pixel::YUV(img.At(tmp));
+		const auto rlab = crn::pixel::Lab(rxyz);
+		const auto rluv = crn::pixel::Luv(rxyz);
+		ok = ok && (hsv.At(tmp) == crn::pixel::HSV(img.At(tmp)));
+		ok = ok && (fabs(xyz.At(tmp).x - rxyz.x) < 1e-9) && (fabs(xyz.At(tmp).y - rxyz.y) < 1e-9) && (fabs(xyz.At(tmp).z - rxyz.z) < 1e-9);
+		ok = ok && (fabs(yuv.At(tmp).y - ryuv.y) < 1e-9) && (fabs(yuv.At(tmp).u - ryuv.u) < 1e-9) && (fabs(yuv.At(tmp).v - ryuv.v) < 1e-9);
+		ok = ok && (fabs(lab.At(tmp).l - rlab.l) < 1e-6) && (fabs(lab.At(tmp).a - rlab.a) < 1e-6) && (fabs(lab.At(tmp).b - rlab.b) < 1e-6);
+		ok = ok && (fabs(luv.At(tmp).l - rluv.l) < 1e-6) && (fabs(luv.At(tmp).u - rluv.u) < 1e-6) && (fabs(luv.At(tmp).v - rluv.v) < 1e-6);
+		ok = ok && (fabs(lab32.At(tmp).c0 - rlab.l) < 1e-3) && (fabs(lab32.At(tmp).c1 - rlab.a) < 1e-3) && (fabs(lab32.At(tmp).c2 - rlab.b) < 1e-3);
+		ok = ok && (fabs(lab16.At(tmp).c0 / crn::ShortColorScale - rlab.l) < 0.01) && (fabs(lab16.At(tmp).c1 / crn::ShortColorScale - rlab.a) < 0.01) && (fabs(lab16.At(tmp).c2 / crn::ShortColorScale - rlab.b) < 0.01);
+		ok = ok && (fabs(luv16.At(tmp).c0 / crn::ShortColorScale - rluv.l) < 0.01) && (fabs(luv16.At(tmp).c1 / crn::ShortColorScale - rluv.u) < 0.01) && (fabs(luv16.At(tmp).c2 / crn::ShortColorScale - rluv.v) < 0.01);
+	}
+	REQUIRE(ok);
+	REQUIRE(sizeof(crn::ImageShort3::pixel_type) == 6);
+}
@@ -0,0 +1,85 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: components.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNBlock.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNUtils/CRNThreadPool.h>
+
+/*! Brute force 8-connected labeling with a flood fill, labels in raster order */
+static crn::ImageIntGray flood_fill(const crn::ImageBW &img)
+{
+	auto labels = crn::ImageIntGray(img.GetWidth(), img.GetHeight(), 0);
+	auto num = 0;
+	FOREACHPIXEL(x, y, img)
+	{
+		if ((img.At(x, y) != crn::pixel::BWBlack) || labels.At(x, y))
+			continue;
+		num += 1;
+		auto stack = std::vector<std::pair<int, int>>{ {int(x), int(y)} };
+		labels.At(x, y) = num;
+		while (!stack.empty())
+		{
+			const auto p = stack.back();
+			stack.pop_back();
+			for (auto dy = -1; dy <= 1; ++dy)
+				for (auto dx = -1; dx <= 1; ++dx)
+				{
+					const auto tx = p.first + dx, ty = p.second + dy;
+					if ((tx < 0) || (ty < 0) || (tx >= int(img.GetWidth())) || (ty >= int(img.GetHeight())))
+						continue;
+					if ((img.At(tx, ty) == crn::pixel::BWBlack) && !labels.At(tx, ty))
+					{
+						labels.At(tx, ty) = num;
+						stack.emplace_back(tx, ty);
+					}
+				}
+		}
+	}
+	return labels;
+}
+
+TEST_CASE("Connected components", "[components]")
+{
+	auto gray = std::make_shared<crn::ImageGray>(random_gray(211, 301, 17u));
+	const auto bw = crn::Threshold(*gray, uint8_t(90));
+	const auto ref = flood_fill(bw);
+
+	crn::ConcurrencyScope scope(4);
+	auto ccs = std::vector<crn::ConnectedComponent>{};
+	const auto labels = crn::LabelConnectedComponents(bw, ccs);
+	REQUIRE(labels == ref);
+	auto area = size_t(0);
+	for (const auto &cc : ccs)
+		area += cc.area;
+	REQUIRE(area == crn::CountBlackPixels(bw));
+
+	auto page = crn::Block::New(std::make_shared<crn::ImageBW>(bw));
+	const auto imap = page->ExtractCC(U"cc");
+	REQUIRE(*imap == ref);
+	REQUIRE(page->GetNbChildren(U"cc") == ccs.size());
+	const auto b = page->GetChild(U"cc", 4);
+	REQUIRE(b->GetName() == U"5");
+	REQUIRE(b->GetAbsoluteBBox() == ccs[4].bbox);
+}
+
@@ -0,0 +1,92 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: convolution.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNMath/CRNMatrixDouble.h>
+
+/*! Brute force convolution with clamped borders */
+static crn::ImageDoubleGray brute_force(const crn::ImageDoubleGray &img, const crn::MatrixDouble &mat)
+{
+	auto out = crn::ImageDoubleGray(img.GetWidth(), img.GetHeight());
+	const auto halfw = int(mat.GetCols() / 2), halfh = int(mat.GetRows() / 2);
+	FOREACHPIXEL(x, y, img)
+	{
+		auto sum = 0.0;
+		for (size_t cy = 0; cy < mat.GetRows(); ++cy)
+			for (size_t cx = 0; cx < mat.GetCols(); ++cx)
+			{
+				const auto tx = crn::Cap(int(x + cx) - halfw, 0, int(img.GetWidth()) - 1);
+				const auto ty = crn::Cap(int(y + cy) - halfh, 0, int(img.GetHeight()) - 1);
+				sum += img.At(tx, ty) * mat[cy][cx];
+			}
+		out.At(x, y) = sum;
+	}
+	return out;
+}
+
+static double max_error(const crn::ImageDoubleGray &i1, const crn::ImageDoubleGray &i2)
+{
+	auto err = 0.0;
+	for (auto tmp : crn::Range(i1))
+		err = crn::Max(err, crn::Abs(i1.At(tmp) - i2.At(tmp)));
+	return err;
+}
+
+TEST_CASE("Separable and 2D convolutions", "[convolution]")
+{
+	auto img = crn::ImageDoubleGray(131, 77);
+	auto rnd = TestRandom(777u);
+	for (auto &px : img)
+		px = double(rnd.Byte());
+
+	SECTION("Separable kernel")
+	{
+		auto mat = crn::MatrixDouble::NewGaussianLine(1.5);
+		mat.NormalizeForConvolution();
+		auto full = crn::MatrixDouble(mat.GetCols(), mat.GetCols());
+		for (size_t r = 0; r < full.GetRows(); ++r)
+			for (size_t c = 0; c < full.GetCols(); ++c)
+				full[r][c] = mat[0][r] * mat[0][c];
+		auto vk = std::vector<double>{}, hk = std::vector<double>{};
+		REQUIRE(crn::impl::SeparateKernel(full, vk, hk));
+		auto res = img;
+		res.Convolve(full);
+		REQUIRE(max_error(res, brute_force(img, full)) < 1e-9);
+		res = img;
+		res.GaussianBlur(1.5);
+		REQUIRE(max_error(res, brute_force(img, full)) < 1e-9);
+	}
+	SECTION("Non separable kernel")
+	{
+		auto mat = crn::MatrixDouble(5, 7, 0.0);
+		for (size_t r = 0; r < mat.GetRows(); ++r)
+			for (size_t c = 0; c < mat.GetCols(); ++c)
+				mat[r][c] = double(int(r * 3 + c * 5) % 7) - 3.0;
+		auto vk = std::vector<double>{}, hk = std::vector<double>{};
+		REQUIRE_FALSE(crn::impl::SeparateKernel(mat, vk, hk));
+		auto res = img;
+		res.Convolve(mat);
+		REQUIRE(max_error(res, brute_force(img, mat)) < 1e-9);
+	}
+}
+
@@ -0,0 +1,158 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: differential.cpp
+ * \author Yann LEYDIER
+ */
+
+
+
+#include "catch.hpp"
+#include <CRNImage/CRNDifferential.h>
+#include <CRNMath/CRNMatrixDouble.h>
+#include <CRNException.h>
+
+static crn::ImageGray make_page()
+{
+	auto img = crn::ImageGray(61, 47, uint8_t(255));
+	FOREACHPIXEL(x, y, img)
+	{
+		if (((x / 7 + y / 5) % 3 == 0) || ((x * x + 3 * y) % 17 == 0))
+			img.At(x, y) = uint8_t((x * 13 + y * 7) % 120);
+	}
+	return img;
+}
+
+template<typename T> static double max_error(const crn::ImageFloatGray &f, const crn::Image<T> &d)
+{
+	auto err = 0.0;
+	for (auto tmp : crn::Range(d))
+		err = crn::Max(err, crn::Abs(double(f.At(tmp)) - double(d.At(tmp))));
+	return err;
+}
+
+TEST_CASE("Lazy differential computes the derivatives on demand", "[differential]")
+{
+	const auto img = make_page();
+	auto lazy = crn::LazyDifferential(img, 1.5);
+	using D = crn::LazyDifferential::Derivative;
+	for (auto d : {D::X, D::Y, D::XX, D::XY, D::YY})
+		REQUIRE_FALSE(lazy.IsComputed(d));
+	REQUIRE(lazy.GetMemoryUsage() == img.Size() * sizeof(float));
+
+	lazy.GetLx();
+	REQUIRE(lazy.IsComputed(D::X));
+	REQUIRE_FALSE(lazy.IsComputed(D::Y));
+	REQUIRE(lazy.GetMemoryUsage() == 2 * img.Size() * sizeof(float));
+
+	auto corner = lazy.MakeCorner();
+	REQUIRE(lazy.GetMemoryUsage() == 6 * img.Size() * sizeof(float));
+	lazy.Free(D::XY);
+	REQUIRE_FALSE(lazy.IsComputed(D::XY));
+	lazy.Free();
+	REQUIRE(lazy.GetMemoryUsage() == img.Size() * sizeof(float));
+	// recomputed identically
+	auto corner2 = lazy.MakeCorner();
+	REQUIRE(max_error(corner, corner2) == 0.0);
+
+	REQUIRE_THROWS_AS(crn::LazyDifferential(img, -1.0), const crn::ExceptionDomain&);
+}
+
+TEST_CASE("Lazy differential matches the eager Gaussian differential", "[differential]")
+{
+	const auto img = make_page();
+	for (auto sigma : {0.0, 1.0, 2.0})
+	{
+		auto eager = crn::Differential::NewGaussian(img, sigma);
+		auto lazy = crn::LazyDifferential(img, sigma);
+		REQUIRE(max_error(lazy.GetLx(), eager.GetLx()) < 1e-3);
+		REQUIRE(max_error(lazy.GetLy(), eager.GetLy()) < 1e-3);
+		REQUIRE(max_error(lazy.GetLxx(), eager.GetLxx()) < 1e-3);
+		REQUIRE(max_error(lazy.GetLyy(), eager.GetLyy()) < 1e-3);
+
+		// Lxy is the outer product of the first derivative kernel with itself
+		auto diff = std::vector<double>{-1, 0, 1};
+		if (sigma != 0.0)
+		{
+			auto mat = crn::MatrixDouble::NewGaussianLineDerivative(sigma);
+			mat.NormalizeForConvolution();
+			diff = std::vector<double>(mat[0], mat[0] + mat.GetCols());
+		}
+		auto lxy = crn::ImageDoubleGray(img);
+		lxy.ConvolveSeparable(diff, diff);
+		REQUIRE(max_error(lazy.GetLxy(), lxy) < 1e-3);
+
+		// invariants
+		auto lap = lazy.MakeLaplacian();
+		auto elap = eager.MakeLaplacian();
+		REQUIRE(max_error(lap, elap) < 1e-3);
+		auto iso = lazy.MakeIsophoteCurvature();
+		const auto &lx = lazy.GetLx();
+		const auto &ly = lazy.GetLy();
+		const auto lvv = lazy.MakeLvv();
+		for (auto tmp : crn::Range(iso))
+		{
+			const auto n = crn::Sqr(double(lx.At(tmp))) + crn::Sqr(double(ly.At(tmp)));
+			if (n > 1e-3)
+				REQUIRE(iso.At(tmp) == Approx(lvv.At(tmp) / sqrt(n)).epsilon(1e-4));
+		}
+	}
+}
+
+TEST_CASE("Lazy and eager differentials produce the same invariants", "[differential]")
+{
+	const auto img = make_page();
+	auto close = [](double a, double b) { return crn::Abs(a - b) <= 1e-3 * crn::Max(1.0, crn::Abs(b)); };
+
+	// without smoothing, both classes use the same kernels
+	auto eager = crn::Differential::NewGaussian(img, 0.0);
+	auto lazy = crn::LazyDifferential(img, 0.0);
+	REQUIRE(max_error(lazy.GetLxy(), eager.GetLxy()) < 1e-3);
+	const auto lww = lazy.MakeLww();
+	const auto elww = eager.MakeLww();
+	const auto lvv = lazy.MakeLvv();
+	const auto elvv = eager.MakeLvv();
+	const auto edge = lazy.MakeEdge();
+	const auto eedge = eager.MakeEdge();
+	auto errors = size_t(0);
+	for (auto tmp : crn::Range(img))
+	{
+		if (!close(lww.At(tmp), elww.At(tmp)) || !close(lvv.At(tmp), elvv.At(tmp)) || !close(edge.At(tmp), eedge.At(tmp)))
+			errors += 1;
+	}
+	REQUIRE(errors == 0);
+
+	// Lvv + Lww is the Laplacian wherever the gradient is not null
+	for (auto sigma : {0.0, 2.0})
+	{
+		auto e = crn::Differential::NewGaussian(img, sigma);
+		auto l = crn::LazyDifferential(img, sigma);
+		const auto ew = e.MakeLww(), ev = e.MakeLvv(), elap = e.MakeLaplacian();
+		const auto lw = l.MakeLww(), lv = l.MakeLvv(), llap = l.MakeLaplacian();
+		const auto &lx = l.GetLx();
+		const auto &ly = l.GetLy();
+		errors = 0;
+		for (auto tmp : crn::Range(img))
+		{
+			if (crn::Sqr(double(lx.At(tmp))) + crn::Sqr(double(ly.At(tmp))) < 1e-3)
+				continue;
+			if (!close(ew.At(tmp) + ev.At(tmp), elap.At(tmp)) || !close(double(lw.At(tmp)) + lv.At(tmp), llap.At(tmp)))
+				errors += 1;
+		}
+		REQUIRE(errors == 0);
+	}
+}
@@ -0,0 +1,66 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: distancetransform.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageBW.h>
+#include <limits>
+
+TEST_CASE("Exact Euclidean distance transform", "[distancetransform]")
+{
+	auto img = crn::ImageBW(97, 61, crn::pixel::BWBlack);
+	auto rnd = TestRandom(4242u);
+	for (size_t tmp = 0; tmp < 40; ++tmp)
+	{
+		const auto x = rnd.Below(unsigned(img.GetWidth()));
+		const auto y = rnd.Below(unsigned(img.GetHeight()));
+		img.At(x, y) = crn::pixel::BWWhite;
+	}
+
+	auto nearest = crn::ImageIntGray{};
+	const auto sq = crn::SquaredDistanceTransform(img, nearest);
+	const auto dt = crn::EuclideanDistanceTransform(img);
+	REQUIRE(sq == crn::SquaredDistanceTransform(img));
+	auto ok = true;
+	FOREACHPIXEL(x, y, img)
+	{
+		// brute force
+		auto best = std::numeric_limits<int>::max();
+		FOREACHPIXEL(fx, fy, img)
+			if (img.At(fx, fy))
+			{
+				const auto dx = int(x) - int(fx), dy = int(y) - int(fy);
+				best = crn::Min(best, dx * dx + dy * dy);
+			}
+		const auto n = nearest.At(x, y);
+		const auto nx = int(n % img.GetWidth()), ny = int(n / img.GetWidth());
+		ok = ok && (sq.At(x, y) == best) && (dt.At(x, y) == Approx(sqrt(double(best)))) && img.At(nx, ny) &&
+			((int(x) - nx) * (int(x) - nx) + (int(y) - ny) * (int(y) - ny) == best);
+	}
+	REQUIRE(ok);
+
+	// no white pixel
+	auto black = crn::ImageBW(10, 5, crn::pixel::BWBlack);
+	const auto inf = crn::SquaredDistanceTransform(black, nearest);
+	REQUIRE(inf.At(3, 2) == std::numeric_limits<int>::max());
+	REQUIRE(nearest.At(3, 2) == -1);
+	REQUIRE(std::isinf(crn::EuclideanDistanceTransform(black).At(3, 2)));
+}
@@ -0,0 +1,71 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: document.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include <CRNDocument.h>
+#include <CRNImage/CRNImageGray.h>
+#include <cstdio>
+#include <mutex>
+
+#ifdef CRN_USING_LIBPNG
+TEST_CASE("Views are processed in parallel", "[document]")
+{
+	auto doc = crn::Document{};
+	auto files = std::vector<crn::Path>{};
+	for (auto tmp : {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})
+	{
+		files.emplace_back("document_test_" + crn::Path(tmp) + ".png");
+		crn::ImageGray(20 + tmp, 10, uint8_t(tmp)).SavePNG(files.back());
+		doc.AddView(files.back());
+	}
+
+	SECTION("Each view is processed once")
+	{
+		std::mutex mutex;
+		auto seen = std::vector<int>(10, 0);
+		auto widths = std::vector<int>(10, 0);
+		auto values = std::vector<int>(10, 0);
+		doc.ForEachView([&](const crn::SBlock &b, size_t num)
+				{
+					std::lock_guard<std::mutex> lock(mutex); // Catch is not thread safe
+					seen[num] += 1;
+					widths[num] = b->GetAbsoluteBBox().GetWidth();
+					values[num] = b->GetGrayView().At(0, 0);
+				}, nullptr, 4, 5);
+		REQUIRE(seen == std::vector<int>(10, 1));
+		for (auto tmp : {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})
+		{
+			REQUIRE(widths[tmp] == 20 + tmp);
+			REQUIRE(values[tmp] == tmp);
+		}
+	}
+	SECTION("Errors are propagated")
+	{
+		REQUIRE_THROWS_AS(doc.ForEachView([](const crn::SBlock &, size_t num)
+				{
+					if (num == 3)
+						throw crn::ExceptionRuntime("test");
+				}, nullptr, 3), const crn::ExceptionRuntime&);
+	}
+	for (const auto &f : files)
+		std::remove(f.CStr());
+}
+#endif
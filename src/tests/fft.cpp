@@ -0,0 +1,160 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: fft.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNMath/CRNFFT.h>
+#include <CRNMath/CRNMatrixComplex.h>
+#include <CRNMath/CRNMatrixDouble.h>
+#include <CRNImage/CRNImageGray.h>
+
+/*! Reference implementation of StrokesWidth (h = true) and StrokesHeight (h = false) */
+static size_t brute_strokes(const crn::ImageGray &img, size_t maxval, bool h)
+{
+	const auto len = h ? img.GetWidth() : img.GetHeight();
+	auto pacc = 0u;
+	for (size_t s = 1; s < crn::Min(maxval, len); ++s)
+	{
+		auto acc = 0u;
+		FOREACHPIXEL(x, y, img)
+		{
+			const auto tx = h ? (x + len - s) % len : x;
+			const auto ty = h ? y : (y + len - s) % len;
+			acc += crn::Abs(img.At(x, y) - img.At(tx, ty));
+		}
+		if ((pacc != 0) && (double(crn::Abs(int(acc) - int(pacc))) / double(pacc) < 0.1))
+			return s;
+		pacc = acc;
+	}
+	return 0;
+}
+
+TEST_CASE("Fast Fourier transform", "[fft]")
+{
+	auto gen = TestRandom(2016u);
+	auto rnd = [&gen]() { return gen.Real(); };
+
+	SECTION("1D transforms")
+	{
+		const auto n = size_t(32);
+		auto sig = std::vector<std::complex<double>>(n);
+		auto real = std::vector<double>(n);
+		for (size_t k = 0; k < n; ++k)
+		{
+			real[k] = rnd();
+			sig[k] = {real[k], rnd()};
+		}
+		const auto plan = crn::GetFFTPlan(n);
+		REQUIRE(plan == crn::GetFFTPlan(n));
+		REQUIRE_THROWS_AS(crn::GetFFTPlan(12), const crn::ExceptionDimension&);
+		auto spec = sig;
+		plan->Forward(spec.data());
+		auto rspec = std::vector<std::complex<double>>(n / 2 + 1);
+		plan->ForwardReal(real.data(), rspec.data());
+		auto ok = true;
+		for (size_t k = 0; k < n; ++k)
+		{ // naive DFT
+			auto dft = std::complex<double>{};
+			auto rdft = std::complex<double>{};
+			for (size_t t = 0; t < n; ++t)
+			{
+				const auto w = std::polar(1.0, -2.0 * M_PI * double(k * t) / double(n));
+				dft += sig[t] * w;
+				rdft += real[t] * w;
+			}
+			ok = ok && (std::abs(dft - spec[k]) < 1e-9);
+			if (k <= n / 2)
+				ok = ok && (std::abs(rdft - rspec[k]) < 1e-9);
+		}
+		REQUIRE(ok);
+		plan->Inverse(spec.data());
+		auto back = std::vector<double>(n);
+		plan->InverseReal(rspec.data(), back.data());
+		for (size_t k = 0; k < n; ++k)
+			ok = ok && (std::abs(spec[k] / double(n) - sig[k]) < 1e-12) && (fabs(back[k] / double(n) - real[k]) < 1e-12);
+		REQUIRE(ok);
+	}
+
+	SECTION("2D transforms")
+	{
+		auto m = crn::MatrixComplex(16, 8);
+		for (size_t r = 0; r < 16; ++r)
+			for (size_t c = 0; c < 8; ++c)
+				m[r][c] = {rnd(), rnd()};
+		auto f = m;
+		f.FFT(true);
+		// DC component of the scaled direct transform is the mean
+		auto mean = std::complex<double>{};
+		for (size_t r = 0; r < 16; ++r)
+			for (size_t c = 0; c < 8; ++c)
+				mean += m[r][c] / 128.0;
+		REQUIRE(std::abs(f[0][0] - mean) < 1e-12);
+		f.FFT(false);
+		auto ok = true;
+		for (size_t r = 0; r < 16; ++r)
+			for (size_t c = 0; c < 8; ++c)
+				ok = ok && (std::abs(f[r][c] - m[r][c]) < 1e-12);
+		REQUIRE(ok);
+	}
+
+	SECTION("Convolution in the frequency domain")
+	{
+		auto img = crn::ImageDoubleGray(200, 150);
+		for (auto &px : img)
+			px = rnd();
+		auto k = crn::MatrixDouble(21, 21);
+		for (size_t r = 0; r < 21; ++r)
+			for (size_t c = 0; c < 21; ++c)
+				k[r][c] = rnd();
+		REQUIRE(crn::impl::IsFFTCorrelationFaster(220, 170, 21, 21));
+		auto conv = img;
+		conv.Convolve(k);
+		auto ok = true;
+		FOREACHPIXEL(x, y, img)
+		{
+			auto acc = 0.0;
+			for (int j = 0; j < 21; ++j)
+				for (int i = 0; i < 21; ++i)
+					acc += img.At(crn::Cap(int(x) + i - 10, 0, 199), crn::Cap(int(y) + j - 10, 0, 149)) * k[j][i];
+			ok = ok && (fabs(acc - conv.At(x, y)) < 1e-9);
+		}
+		REQUIRE(ok);
+	}
+
+	SECTION("Strokes")
+	{
+		// gray stripes with noise
+		auto img = crn::ImageGray(300, 200);
+		FOREACHPIXEL(x, y, img)
+			img.At(x, y) = uint8_t(((x / 4) % 3 == 0 ? 200 : 20) + ((y / 5) % 4 == 0 ? 30 : 0) + int(rnd() * 20));
+		REQUIRE(crn::StrokesWidth(img) == brute_strokes(img, 50, true));
+		REQUIRE(crn::StrokesHeight(img) == brute_strokes(img, 50, false));
+		// two levels, with enough shifts to use the frequency domain
+		FOREACHPIXEL(x, y, img)
+			img.At(x, y) = (((x / 7) % 3 == 0) || ((y / 3) % 5 == 0)) ? 255 : 0;
+		const auto dir = crn::impl::ShiftedDifferences(img, 1, 40, true);
+		const auto fft = crn::impl::ShiftedDifferencesFFT(img, 41, true);
+		REQUIRE(std::equal(dir.begin(), dir.end(), fft.begin() + 1));
+		REQUIRE(crn::StrokesWidth(img, 1000) == brute_strokes(img, 1000, true));
+		REQUIRE(crn::StrokesHeight(img, 1000) == brute_strokes(img, 1000, false));
+	}
+}
@@ -0,0 +1,129 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: flatblocktree.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNFlatBlockTree.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNData/CRNReal.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static crn::SImageBW random_page()
+{
+	const auto gray = random_gray(211, 301, 23u);
+	return std::make_shared<crn::ImageBW>(crn::Threshold(gray, uint8_t(60)));
+}
+
+TEST_CASE("Flat block trees match block trees", "[flatblocktree]")
+{
+	const auto img = random_page();
+	auto page = crn::Block::New(img);
+	auto line = page->AddChildAbsolute(U"lines", crn::Rect(10, 20, 150, 220));
+	const auto refmap = line->ExtractCC(U"cc");
+	const auto ncc = line->GetNbChildren(U"cc");
+	REQUIRE(ncc > 100);
+
+	auto labels = crn::ImageIntGray{};
+	auto flat = crn::FlatBlockTree::FromConnectedComponents(line, U"flatcc", &labels);
+	REQUIRE(flat.Size() == ncc);
+	REQUIRE(std::equal(labels.begin(), labels.end(), refmap->begin()));
+	auto area = 0.0;
+	for (auto tmp : crn::Range(flat.GetBBoxes()))
+	{
+		const auto ref = line->GetChild(U"cc", tmp);
+		REQUIRE(flat.GetBBox(tmp) == ref->GetAbsoluteBBox());
+		REQUIRE(flat.GetLabel(tmp) == ref->GetName());
+		area += flat.GetAttribute(U"area", tmp);
+	}
+	REQUIRE(area == double(std::count_if(labels.begin(), labels.end(), [](int l) { return l != 0; })));
+	REQUIRE_FALSE(flat.IsMaterialized(0));
+
+	SECTION("Iteration materializes only the accessed blocks")
+	{
+		auto big = size_t(0);
+		for (auto it = flat.BlockBegin(); it != flat.BlockEnd(); ++it)
+			if (it.GetBBox().GetArea() > 20)
+			{
+				REQUIRE(it->GetAbsoluteBBox() == it.GetBBox());
+				REQUIRE(it->GetParentTree() == U"flatcc");
+				big += 1;
+			}
+		REQUIRE(big > 0);
+		REQUIRE(std::count_if(flat.BlockBegin(), flat.BlockEnd(), [](const crn::SObject &) { return true; }) == ptrdiff_t(ncc));
+		REQUIRE(flat.GetBlock(3) == flat.GetBlock(3));
+		REQUIRE_FALSE(line->HasTree(U"flatcc"));
+	}
+	SECTION("Filtering and storing in the parent block")
+	{
+		const auto b5 = flat.GetBlock(5);
+		const auto kept = flat.GetBBox(5);
+		flat.RemoveIf([&flat](size_t i) { return (i < 5) || (flat.GetBBox(i).GetArea() < 4); });
+		REQUIRE(flat.Size() < ncc);
+		REQUIRE(flat.GetBBox(0) == kept);
+		REQUIRE(flat.GetBlock(0) == b5);
+		flat.SetAttribute(U"kept", 0, 1.5);
+		REQUIRE(std::isnan(flat.GetAttribute(U"kept", 1)));
+		flat.AddToParent();
+		REQUIRE(line->GetNbChildren(U"flatcc") == flat.Size());
+		for (auto tmp : crn::Range(flat.GetBBoxes()))
+		{
+			const auto b = line->GetChild(U"flatcc", tmp);
+			REQUIRE(b == flat.GetBlock(tmp));
+			REQUIRE(b->GetAbsoluteBBox() == flat.GetBBox(tmp));
+			REQUIRE(double(*std::static_pointer_cast<crn::Real>(b->GetUserData(U"area"))) == flat.GetAttribute(U"area", tmp));
+		}
+		REQUIRE(double(*std::static_pointer_cast<crn::Real>(b5->GetUserData(U"kept"))) == 1.5);
+		REQUIRE_FALSE(line->GetChild(U"flatcc", 1)->IsUserData(U"kept"));
+
+		// a second call replaces the tree
+		const auto removed = flat.GetBlock(1);
+		flat.RemoveIf([](size_t index) { return index == 1; });
+		flat.SetAttribute(U"kept", 0, std::numeric_limits<double>::quiet_NaN());
+		flat.AddToParent();
+		REQUIRE(line->GetNbChildren(U"flatcc") == flat.Size());
+		for (auto tmp : crn::Range(flat.GetBBoxes()))
+			REQUIRE(line->GetChild(U"flatcc", tmp) == flat.GetBlock(tmp));
+		REQUIRE(removed->GetParent().expired());
+		REQUIRE(b5->GetParent().lock() == line);
+		REQUIRE_FALSE(b5->IsUserData(U"kept"));
+	}
+	SECTION("Manual construction")
+	{
+		auto tree = crn::FlatBlockTree(page, U"zones");
+		REQUIRE(tree.PushBack(crn::Rect(-5, -5, 20, 30), U"a") == 0);
+		REQUIRE(tree.GetBBox(0) == crn::Rect(0, 0, 20, 30));
+		REQUIRE_THROWS_AS(tree.PushBack(crn::Rect(500, 500, 600, 600)), const crn::ExceptionDomain&);
+		tree.PushBack(crn::Rect(1, 1, 2, 2));
+		REQUIRE(tree.GetBlock(1)->GetName() == U"zones");
+		tree.SetLabel(1, U"b");
+		REQUIRE(tree.GetBlock(1)->GetName() == U"b");
+		tree.SetLabel(1, U"");
+		REQUIRE(tree.GetBlock(1)->GetName() == U"zones");
+		tree.SetBBox(1, crn::Rect(3, 3, 8, 8));
+		REQUIRE(tree.GetBlock(1)->GetAbsoluteBBox() == crn::Rect(3, 3, 8, 8));
+		REQUIRE_THROWS_AS(tree.GetAttributes(U"none"), const crn::ExceptionNotFound&);
+		REQUIRE(tree.GetMemoryUsage() > 0);
+	}
+}
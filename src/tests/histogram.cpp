@@ -0,0 +1,109 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: histogram.cpp
+ * \author Yann LEYDIER
+ */
+
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNImage/CRNIntegralHistogram.h>
+#include <CRNStatistics/CRNHistogram.h>
+
+TEST_CASE("Image histograms and projections", "[histogram]")
+{
+	auto img = crn::ImageGray(301, 97);
+	auto img16 = crn::Image<uint16_t>(301, 97);
+	auto rnd = TestRandom(123u);
+	for (size_t tmp = 0; tmp < img.Size(); ++tmp)
+	{
+		const auto v = rnd.Next();
+		img.At(tmp) = uint8_t(v >> 24);
+		img16.At(tmp) = uint16_t(1000 + (v >> 20) % 3000);
+	}
+
+	auto h = crn::MakeHistogram(img);
+	auto ref = std::vector<unsigned int>(256, 0);
+	for (auto px : img)
+		ref[px] += 1;
+	REQUIRE(h.Size() == 256);
+	REQUIRE(std::equal(ref.begin(), ref.end(), h.GetBins()));
+
+	const auto mM = crn::MinMax(img16);
+	h = crn::MakeHistogram(img16);
+	REQUIRE(h.Size() == size_t(mM.second - mM.first + 1));
+	ref = std::vector<unsigned int>(h.Size(), 0);
+	for (auto px : img16)
+		ref[px - mM.first] += 1;
+	REQUIRE(std::equal(ref.begin(), ref.end(), h.GetBins()));
+
+	auto vp = crn::VerticalProjection(img);
+	auto ok = true;
+	for (size_t x = 0; x < img.GetWidth(); ++x)
+	{
+		auto cnt = 0u;
+		for (size_t y = 0; y < img.GetHeight(); ++y)
+			cnt += img.At(x, y);
+		ok = ok && (vp[x] == cnt / 255);
+	}
+	REQUIRE(ok);
+
+	auto bw = crn::ImageBW(img.GetWidth(), img.GetHeight());
+	for (size_t tmp = 0; tmp < img.Size(); ++tmp)
+		bw.At(tmp) = img.At(tmp) > 100;
+	vp = crn::VerticalProjection(bw);
+	for (size_t x = 0; x < img.GetWidth(); ++x)
+	{
+		auto cnt = 0u;
+		for (size_t y = 0; y < img.GetHeight(); ++y)
+			cnt += bw.At(x, y) ? 0 : 1;
+		ok = ok && (vp[x] == cnt);
+	}
+	REQUIRE(ok);
+}
+
+TEST_CASE("Integral histogram", "[histogram]")
+{
+	const auto img = random_gray(123, 77, 456u);
+	auto rnd = TestRandom(789u);
+	REQUIRE_THROWS_AS(crn::IntegralHistogram(img, 12), const crn::ExceptionDomain&);
+	const auto ih = crn::IntegralHistogram(img, 32);
+	REQUIRE(ih.GetBinCount() == 32);
+	REQUIRE_THROWS_AS(ih.GetHistogram(crn::Rect(0, 0, 123, 10)), const crn::ExceptionDimension&);
+
+	auto ok = true;
+	for (size_t tmp = 0; tmp < 50; ++tmp)
+	{
+		const auto x1 = int(rnd.Below(unsigned(img.GetWidth())));
+		const auto x2 = int(rnd.Below(unsigned(img.GetWidth())));
+		const auto y1 = int(rnd.Below(unsigned(img.GetHeight())));
+		const auto y2 = int(rnd.Below(unsigned(img.GetHeight())));
+		const auto r = crn::Rect(crn::Min(x1, x2), crn::Min(y1, y2), crn::Max(x1, x2), crn::Max(y1, y2));
+		const auto h = ih.GetHistogram(r);
+		auto ref = std::vector<unsigned int>(32, 0);
+		for (auto y = r.GetTop(); y <= r.GetBottom(); ++y)
+			for (auto x = r.GetLeft(); x <= r.GetRight(); ++x)
+				ref[ih.GetBin(img.At(x, y))] += 1;
+		ok = ok && std::equal(ref.begin(), ref.end(), h.GetBins());
+	}
+	REQUIRE(ok);
+	const auto all = ih.GetHistogram(crn::Rect(0, 0, 122, 76));
+	REQUIRE(all.CumulateBins() == img.Size());
+}
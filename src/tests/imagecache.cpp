@@ -0,0 +1,138 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: imagecache.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include <CRNBlock.h>
+#include <CRNImage/CRNImageCache.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNIO/CRNPath.h>
+#include <cstdio>
+
+TEST_CASE("The image cache evicts the least recently used buffers of lowest priority", "[imagecache]")
+{
+	crn::ImageCache::SetBudget(0);
+	crn::ImageCache::ResetStatistics();
+	const auto usage = crn::ImageCache::GetUsage();
+	auto evicted = std::vector<int>{};
+	auto keys = std::vector<int>(4);
+	auto in_use = false;
+	for (auto k : {0, 1, 2})
+		crn::ImageCache::Register(&keys[k], 100, 0, [&evicted, k]() { evicted.push_back(k); return true; });
+	crn::ImageCache::Register(&keys[3], 100, 1, [&evicted, &in_use]() { if (in_use) return false; evicted.push_back(3); return true; });
+	REQUIRE(crn::ImageCache::GetUsage() == usage + 400);
+	REQUIRE(crn::ImageCache::GetMisses() == 4);
+
+	REQUIRE(crn::ImageCache::Touch(&keys[0]));
+	REQUIRE(crn::ImageCache::GetHits() == 1);
+	crn::ImageCache::SetBudget(usage + 250);
+	REQUIRE(evicted == std::vector<int>({1, 2}));
+	REQUIRE_FALSE(crn::ImageCache::Touch(&keys[1]));
+
+	in_use = true;
+	crn::ImageCache::SetBudget(usage + 150);
+	REQUIRE(evicted == std::vector<int>({1, 2, 0}));
+	crn::ImageCache::SetBudget(usage + 50);
+	REQUIRE(evicted == std::vector<int>({1, 2, 0}));
+	REQUIRE(crn::ImageCache::GetEvictions() == 3);
+
+	crn::ImageCache::Unregister(&keys[3]);
+	REQUIRE(crn::ImageCache::GetUsage() == usage);
+	crn::ImageCache::SetBudget(0);
+}
+
+TEST_CASE("Block buffers are recomputed after eviction", "[imagecache]")
+{
+	auto gray = std::make_shared<crn::ImageGray>(100, 100);
+	for (auto tmp : crn::Range(*gray))
+		gray->At(tmp) = uint8_t(tmp);
+	auto b = crn::Block::New(gray);
+	auto c = b->AddChildRelative(U"t", crn::Rect(10, 10, 59, 59));
+	crn::ImageCache::SetBudget(0);
+	crn::ImageCache::ResetStatistics();
+
+	auto bw = b->GetBWView(); // computed from a gray buffer
+	REQUIRE(crn::ImageCache::GetMisses() == 2);
+	REQUIRE(b->GetBWView().GetStorage() == bw.GetStorage());
+	REQUIRE(crn::ImageCache::GetHits() == 1);
+
+	// in use
+	crn::ImageCache::SetBudget(1);
+	REQUIRE(crn::ImageCache::GetEvictions() == 1); // the gray buffer
+	REQUIRE(b->GetBWView().GetStorage() == bw.GetStorage());
+	// not in use anymore
+	const auto copy = bw.Copy();
+	bw = crn::ImageViewBW{};
+	crn::ImageCache::SetBudget(0);
+	crn::ImageCache::SetBudget(1);
+	REQUIRE(crn::ImageCache::GetEvictions() == 2);
+	REQUIRE(b->GetBWView().Copy() == copy);
+	REQUIRE(crn::ImageCache::GetMisses() == 4);
+
+	// buffers handed out for modification are kept
+	crn::ImageCache::SetBudget(0);
+	const auto val = c->GetBWView().At(0, 0); // cached
+	auto cbw = c->GetBW();
+	cbw->At(0, 0) = !val;
+	cbw = nullptr;
+	crn::ImageCache::SetBudget(1);
+	REQUIRE(c->GetBWView().At(0, 0) == !val);
+	REQUIRE(c->GetBW()->At(0, 0) == !val);
+	c->FlushBW();
+	REQUIRE(c->GetBWView().At(0, 0) == val);
+
+	// substituted buffers are kept
+	c->SubstituteGray(std::make_shared<crn::ImageGray>(50, 50, uint8_t(3)));
+	crn::ImageCache::SetBudget(0);
+	crn::ImageCache::SetBudget(1);
+	REQUIRE(c->GetGrayView().At(0, 0) == 3);
+	crn::ImageCache::SetBudget(0);
+}
+
+TEST_CASE("Source images are freed only when unused", "[imagecache]")
+{
+	auto gray = crn::ImageGray(100, 100);
+	for (auto tmp : crn::Range(gray))
+		gray.At(tmp) = uint8_t(tmp);
+	const auto fname = crn::Path("imagecache_test.png");
+	gray.SavePNG(fname);
+	crn::ImageCache::SetBudget(0);
+	crn::ImageCache::ResetStatistics();
+	{
+		auto b = crn::Block::New(fname, "");
+		b->FlushAll(); // only the source is registered
+		auto view = b->GetGrayView(false); // loads the source and holds it
+		REQUIRE(view.GetWidth() == 100);
+		auto c = b->AddChildRelative(U"t", crn::Rect(10, 10, 59, 59));
+
+		// in use
+		crn::ImageCache::SetBudget(1);
+		REQUIRE(crn::ImageCache::GetEvictions() == 0);
+		REQUIRE(c->GetGrayView(false).At(0, 0) == gray.At(10, 10));
+		// not in use anymore: the children read the reloaded source through the topmost block
+		view = crn::ImageViewGray{};
+		crn::ImageCache::SetBudget(0);
+		crn::ImageCache::SetBudget(1);
+		REQUIRE(crn::ImageCache::GetEvictions() == 1);
+		REQUIRE(*c->GetGray() == crn::ImageGray(gray, crn::Rect(10, 10, 59, 59)));
+		crn::ImageCache::SetBudget(0);
+	}
+	std::remove(fname.CStr());
+}
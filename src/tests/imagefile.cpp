@@ -0,0 +1,117 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: imagefile.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageBW.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageRGB.h>
+#include <CRNGeometry/CRNRect.h>
+#include <CRNIO/CRNPath.h>
+#include <cstdio>
+
+#ifdef CRN_USING_LIBPNG
+TEST_CASE("Regions of PNG files are decoded without loading the whole image", "[imagefile]")
+{
+	auto img = crn::ImageRGB(75, 50);
+	auto rnd = TestRandom(7u);
+	for (auto &px : img)
+	{
+		const auto v = rnd.Next();
+		px = { uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8) };
+	}
+	const auto fname = crn::Path("imagefile_test.png");
+	img.SavePNG(fname);
+
+	SECTION("Size")
+	{
+		const auto size = crn::GetImageFileSize(fname);
+		REQUIRE(size.first == 75);
+		REQUIRE(size.second == 50);
+	}
+	SECTION("Whole image")
+	{
+		auto full = crn::NewImageFromFile(fname);
+		auto *rgb = dynamic_cast<crn::ImageRGB*>(full.get());
+		REQUIRE(rgb);
+		REQUIRE(*rgb == img);
+	}
+	SECTION("Region")
+	{
+		const auto roi = crn::Rect(10, 5, 39, 44);
+		auto part = crn::NewImageFromFile(fname, roi);
+		auto *rgb = dynamic_cast<crn::ImageRGB*>(part.get());
+		REQUIRE(rgb);
+		REQUIRE(*rgb == crn::ImageRGB(img, roi));
+	}
+	SECTION("Clipped region at reduced resolution")
+	{
+		auto part = crn::NewImageFromFile(fname, crn::Rect(60, 30, 200, 200), 4);
+		REQUIRE(part->GetWidth() == 4);
+		REQUIRE(part->GetHeight() == 5);
+		auto *rgb = dynamic_cast<crn::ImageRGB*>(part.get());
+		REQUIRE(rgb);
+		// the pixels are averaged over 4×4 boxes, clipped to the image
+		for (auto y : {0, 1, 2, 3, 4})
+			for (auto x : {0, 1, 2, 3})
+			{
+				auto r = 0u, g = 0u, b = 0u, n = 0u;
+				for (auto sy = 30 + 4 * y; sy < crn::Min(34 + 4 * y, 50); ++sy)
+					for (auto sx = 60 + 4 * x; sx < crn::Min(64 + 4 * x, 75); ++sx)
+					{
+						r += img.At(sx, sy).r;
+						g += img.At(sx, sy).g;
+						b += img.At(sx, sy).b;
+						n += 1;
+					}
+				REQUIRE(rgb->At(x, y) == crn::pixel::RGB<uint8_t>(uint8_t((r + n / 2) / n), uint8_t((g + n / 2) / n), uint8_t((b + n / 2) / n)));
+			}
+	}
+	SECTION("Thin strokes are kept at reduced resolution")
+	{
+		auto bw = crn::ImageBW(64, 64, crn::pixel::BWWhite);
+		for (auto tmp = 0; tmp < 64; ++tmp)
+		{
+			bw.At(tmp, 33) = crn::pixel::BWBlack;
+			bw.At(5, tmp) = crn::pixel::BWBlack;
+		}
+		const auto bwname = crn::Path("imagefile_test_bw.png");
+		bw.SavePNG(bwname);
+		auto small = crn::NewImageFromFile(bwname, crn::Rect{}, 8);
+		std::remove(bwname.CStr());
+		auto *ibw = dynamic_cast<crn::ImageBW*>(small.get());
+		REQUIRE(ibw);
+		REQUIRE(ibw->GetWidth() == 8);
+		for (auto tmp = 0; tmp < 8; ++tmp)
+		{
+			REQUIRE(ibw->At(tmp, 4) == crn::pixel::BWBlack);
+			REQUIRE(ibw->At(0, tmp) == crn::pixel::BWBlack);
+		}
+		REQUIRE(ibw->At(3, 2) == crn::pixel::BWWhite);
+	}
+	SECTION("Invalid requests")
+	{
+		REQUIRE_THROWS_AS(crn::NewImageFromFile(fname, crn::Rect(100, 100, 120, 120)), const crn::ExceptionIO&);
+		REQUIRE_THROWS_AS(crn::NewImageFromFile(fname, crn::Rect{}, 3), const crn::ExceptionDomain&);
+	}
+	std::remove(fname.CStr());
+}
+#endif
@@ -0,0 +1,57 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: imageview.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNBlock.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNStatistics/CRNHistogram.h>
+
+static std::vector<unsigned int> bins(const crn::Histogram &h)
+{
+	return std::vector<unsigned int>(h.GetBins(), h.GetBins() + h.Size());
+}
+
+TEST_CASE("Block views share the pixels of the page", "[imageview]")
+{
+	auto gray = std::make_shared<crn::ImageGray>(random_gray(120, 80, 5u));
+	auto page = crn::Block::New(gray);
+	auto zone = page->AddChildAbsolute(U"zones", crn::Rect(10, 20, 99, 69));
+	auto cc = zone->AddChildAbsolute(U"ccs", crn::Rect(15, 25, 40, 31));
+
+	const auto view = cc->GetGrayView();
+	REQUIRE(view.GetStorage() == gray);
+	REQUIRE(view.GetWidth() == 26);
+	REQUIRE(view.GetHeight() == 7);
+	REQUIRE(view.Copy() == *cc->GetGray());
+	REQUIRE(view.Sub(crn::Rect(1, 2, 3, 4)).At(0, 0) == gray->At(16, 27));
+
+	// the b&w buffer of the page is created once and shared by the children
+	const auto bwview = cc->GetBWView();
+	REQUIRE(bwview.GetStorage() == page->GetBW());
+	const auto bw = bwview.Copy();
+	REQUIRE(bins(crn::VerticalProjection(bwview)) == bins(crn::VerticalProjection(bw)));
+	REQUIRE(bins(crn::LeftProfile(bwview)) == bins(crn::LeftProfile(bw)));
+	REQUIRE(crn::CountBlackPixels(bwview) == crn::CountBlackPixels(bw));
+	REQUIRE_THROWS_AS(view.Sub(crn::Rect(0, 0, 26, 3)), const crn::ExceptionDimension&);
+}
+
@@ -0,0 +1,148 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: matrix.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNMath/CRNMatrixDecomposition.h>
+#include <cmath>
+
+TEST_CASE("LU and Cholesky decompositions", "[matrix]")
+{
+	// A·Aᵗ + n·I is symmetric positive definite
+	const auto n = size_t(40);
+	auto a = crn::SquareMatrixDouble(n);
+	auto rnd = TestRandom(3u);
+	for (auto r = size_t(0); r < n; ++r)
+		for (auto c = size_t(0); c < n; ++c)
+			a.At(r, c) = rnd.Real();
+	auto at = a;
+	at.Transpose();
+	auto m = crn::SquareMatrixDouble(a * at);
+	for (auto tmp = size_t(0); tmp < n; ++tmp)
+		m.At(tmp, tmp) += double(n);
+
+	auto b = std::vector<double>(n);
+	for (auto tmp = size_t(0); tmp < n; ++tmp)
+		b[tmp] = double(tmp) - 7.0;
+	auto residual = [&](const std::vector<double> &x)
+		{
+			auto err = 0.0;
+			for (auto r = size_t(0); r < n; ++r)
+			{
+				auto s = -b[r];
+				for (auto c = size_t(0); c < n; ++c)
+					s += m.At(r, c) * x[c];
+				err = std::max(err, std::fabs(s));
+			}
+			return err;
+		};
+
+	const auto lu = crn::LUDecomposition(m);
+	const auto chol = crn::CholeskyDecomposition(m);
+	REQUIRE_FALSE(lu.IsSingular());
+	REQUIRE(chol.IsPositiveDefinite());
+	REQUIRE(lu.GetDeterminantSign() == 1);
+	REQUIRE(lu.GetLogAbsDeterminant() == Approx(chol.GetLogDeterminant()));
+	REQUIRE(residual(lu.Solve(b)) < 1e-9);
+	REQUIRE(residual(chol.Solve(b)) < 1e-9);
+
+	const auto inv = m.MakeInverse();
+	auto id = m * inv;
+	auto err = 0.0;
+	for (auto r = size_t(0); r < n; ++r)
+		for (auto c = size_t(0); c < n; ++c)
+			err = std::max(err, std::fabs(id.At(r, c) - (r == c ? 1.0 : 0.0)));
+	REQUIRE(err < 1e-9);
+
+	auto x = chol.Solve(b);
+	auto xtb = 0.0;
+	for (auto tmp = size_t(0); tmp < n; ++tmp)
+		xtb += x[tmp] * b[tmp];
+	REQUIRE(chol.SquaredMahalanobis(b) == Approx(xtb));
+
+	// small matrices still match the closed forms
+	auto m4 = crn::SquareMatrixDouble({{2, 1, 0, 3}, {1, -1, 4, 0}, {0, 2, 1, 1}, {5, 0, 1, 2}});
+	REQUIRE(m4.Determinant() == Approx(m4.Cofactor(0, 0) * 2 + m4.Cofactor(0, 1) * 1 + m4.Cofactor(0, 3) * 3));
+	REQUIRE(m4.Determinant() == Approx(74.0));
+
+	auto singular = crn::SquareMatrixDouble({{1, 2, 3, 4}, {2, 4, 6, 8}, {0, 1, 0, 1}, {1, 0, 0, 1}});
+	REQUIRE(singular.Determinant() == 0.0);
+	REQUIRE_THROWS_AS(singular.MakeInverse(), const crn::ExceptionRuntime&);
+	REQUIRE_THROWS_AS(crn::LUDecomposition(singular).Solve(b), const crn::ExceptionDimension&);
+	REQUIRE_FALSE(crn::CholeskyDecomposition(singular).IsPositiveDefinite());
+}
+
+TEST_CASE("Blocked matrix product", "[matrix]")
+{
+	// sizes that are not multiples of the blocks nor of the register tile
+	const auto m = size_t(131), k = size_t(301), n = size_t(263);
+	auto a = crn::MatrixDouble(m, k);
+	auto b = crn::MatrixDouble(k, n);
+	for (auto r = size_t(0); r < m; ++r)
+		for (auto c = size_t(0); c < k; ++c)
+			a.At(r, c) = std::sin(double(r * k + c));
+	for (auto r = size_t(0); r < k; ++r)
+		for (auto c = size_t(0); c < n; ++c)
+			b.At(r, c) = std::cos(double(r + 3 * c));
+
+	auto naive = crn::MatrixDouble(m, n);
+	for (auto r = size_t(0); r < m; ++r)
+		for (auto c = size_t(0); c < n; ++c)
+		{
+			auto s = 0.0;
+			for (auto tmp = size_t(0); tmp < k; ++tmp)
+				s += a.At(r, tmp) * b.At(tmp, c);
+			naive.At(r, c) = s;
+		}
+	auto maxerr = [&naive](const crn::MatrixDouble &p)
+	{
+		REQUIRE(p.GetRows() == naive.GetRows());
+		REQUIRE(p.GetCols() == naive.GetCols());
+		auto err = 0.0;
+		for (auto i = size_t(0); i < naive.GetRows() * naive.GetCols(); ++i)
+			err = std::max(err, std::fabs(p.At(i) - naive.At(i)));
+		return err;
+	};
+
+	REQUIRE(maxerr(a * b) < 1e-9);
+	REQUIRE(maxerr(crn::TransposeProduct(a.MakeTranspose(), b)) < 1e-9);
+	REQUIRE(maxerr(crn::ProductTranspose(a, b.MakeTranspose())) < 1e-9);
+	auto out = crn::MatrixDouble(m, n);
+	REQUIRE(maxerr(out.SetProduct(a.MakeTranspose(), b.MakeTranspose(), true, true)) < 1e-9);
+	REQUIRE_THROWS_AS(b * a, const crn::ExceptionDimension&);
+
+	// aliased operands
+	auto sq = crn::MatrixDouble({{1, 2}, {3, 4}});
+	sq *= sq;
+	REQUIRE(sq == crn::MatrixDouble({{7, 10}, {15, 22}}));
+
+	auto cov = a.MakeCovariance();
+	auto err = 0.0;
+	for (auto i = size_t(0); i < k; i += 7)
+		for (auto j = size_t(0); j < k; j += 5)
+		{
+			auto s = 0.0;
+			for (auto r = size_t(0); r < m; ++r)
+				s += a.At(r, i) * a.At(r, j);
+			err = std::max(err, std::fabs(cov.At(i, j) - s / double(m)));
+		}
+	REQUIRE(err < 1e-12);
+}
@@ -0,0 +1,79 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: morphology.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+
+/*! Brute force local extremum in a clipped rectangular window */
+template<typename T> static crn::Image<T> brute_force(const crn::Image<T> &img, size_t halfw, size_t halfh, bool maximum)
+{
+	auto out = img;
+	FOREACHPIXEL(x, y, img)
+	{
+		auto val = img.At(x, y);
+		for (auto ty = (y < halfh) ? 0 : y - halfh; ty <= crn::Min(y + halfh, img.GetHeight() - 1); ++ty)
+			for (auto tx = (x < halfw) ? 0 : x - halfw; tx <= crn::Min(x + halfw, img.GetWidth() - 1); ++tx)
+				val = maximum ? crn::Max(val, T(img.At(tx, ty))) : crn::Min(val, T(img.At(tx, ty)));
+		out.At(x, y) = val;
+	}
+	return out;
+}
+
+TEST_CASE("Constant time rectangular morphology", "[morphology]")
+{
+	const auto gray = random_gray(151, 43, 31u);
+	const auto bw = crn::Threshold(gray, uint8_t(40));
+	const auto sizes = std::vector<std::pair<size_t, size_t>>{ {0, 2}, {3, 0}, {1, 1}, {4, 7}, {40, 3}, {100, 30} };
+
+	SECTION("Gray")
+	{
+		for (const auto &s : sizes)
+		{
+			auto img = gray;
+			img.DilateRect(s.first, s.second);
+			REQUIRE(img == brute_force(gray, s.first, s.second, false));
+			img = gray;
+			img.ErodeRect(s.first, s.second);
+			REQUIRE(img == brute_force(gray, s.first, s.second, true));
+		}
+		auto img = gray;
+		img.Dilate(crn::MatrixInt(5, 9, 1));
+		REQUIRE(img == brute_force(gray, 4, 2, false));
+		img = gray;
+		img.FastErode(12);
+		REQUIRE(img == brute_force(gray, 12, 12, true));
+	}
+	SECTION("BW")
+	{
+		for (const auto &s : sizes)
+		{
+			auto img = bw;
+			img.DilateRect(s.first, s.second);
+			REQUIRE(img == brute_force(bw, s.first, s.second, false));
+			img = bw;
+			img.ErodeRect(s.first, s.second);
+			REQUIRE(img == brute_force(bw, s.first, s.second, true));
+		}
+	}
+}
+
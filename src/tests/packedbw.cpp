@@ -0,0 +1,79 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: packedbw.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImagePackedBW.h>
+#include <CRNImage/CRNImageGray.h>
+#include <CRNStatistics/CRNHistogram.h>
+
+static std::vector<unsigned int> bins(const crn::Histogram &h)
+{
+	return std::vector<unsigned int>(h.GetBins(), h.GetBins() + h.Size());
+}
+
+TEST_CASE("Packed bitonal images", "[packedbw]")
+{
+	const auto gray = random_gray(131, 29, 99u);
+	auto bw = crn::Threshold(gray, uint8_t(70));
+	// a white column and a white row to test the profiles
+	for (size_t y = 0; y < bw.GetHeight(); ++y)
+		bw.At(130, y) = crn::pixel::BWWhite;
+	for (size_t x = 0; x < bw.GetWidth(); ++x)
+		bw.At(x, 3) = crn::pixel::BWWhite;
+	const auto packed = crn::ImagePackedBW(bw);
+
+	SECTION("Conversion")
+	{
+		REQUIRE(crn::MakeImageBW(packed) == bw);
+		REQUIRE(crn::CountBlackPixels(packed) == crn::CountBlackPixels(bw));
+		REQUIRE(crn::CountWhitePixels(packed) == crn::CountWhitePixels(bw));
+	}
+	SECTION("Projections and profiles")
+	{
+		REQUIRE(bins(crn::HorizontalProjection(packed)) == bins(crn::HorizontalProjection(bw)));
+		REQUIRE(bins(crn::VerticalProjection(packed)) == bins(crn::VerticalProjection(bw)));
+		REQUIRE(bins(crn::LeftProfile(packed)) == bins(crn::LeftProfile(bw)));
+		REQUIRE(bins(crn::RightProfile(packed)) == bins(crn::RightProfile(bw)));
+		REQUIRE(bins(crn::TopProfile(packed)) == bins(crn::TopProfile(bw)));
+		REQUIRE(bins(crn::BottomProfile(packed)) == bins(crn::BottomProfile(bw)));
+	}
+	SECTION("Runs")
+	{
+		REQUIRE(crn::MeanBlackRun(packed) == crn::MeanBlackRun(bw));
+		REQUIRE(crn::MeanWhiteRun(packed) == crn::MeanWhiteRun(bw));
+		REQUIRE(crn::MeanBlackVRun(packed) == crn::MeanBlackVRun(bw));
+	}
+	SECTION("Logical operations")
+	{
+		auto neg = packed;
+		neg.Negative();
+		REQUIRE(crn::CountBlackPixels(neg) == crn::CountWhitePixels(bw));
+		auto img = packed;
+		img &= neg;
+		REQUIRE(crn::CountWhitePixels(img) == 0);
+		img = packed;
+		img ^= neg;
+		REQUIRE(crn::CountBlackPixels(img) == 0);
+		REQUIRE_THROWS_AS(img |= crn::ImagePackedBW(3, 3), const crn::ExceptionDimension&);
+	}
+}
+
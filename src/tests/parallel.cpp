@@ -0,0 +1,90 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: parallel.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNUtils/CRNThreadPool.h>
+#include <atomic>
+#include <tuple>
+
+static std::vector<unsigned int> bins(const crn::Histogram &h)
+{
+	return std::vector<unsigned int>(h.GetBins(), h.GetBins() + h.Size());
+}
+
+TEST_CASE("ParallelFor covers the range once", "[parallel]")
+{
+	auto cnt = std::vector<std::atomic<int>>(1000);
+	for (auto &c : cnt)
+		c = 0;
+	crn::ParallelFor(0, cnt.size(), [&cnt](size_t b, size_t e)
+			{
+				for (auto tmp = b; tmp < e; ++tmp)
+					cnt[tmp] += 1;
+			}, 7, 64);
+	for (const auto &c : cnt)
+		REQUIRE(c == 1);
+
+	REQUIRE_THROWS_AS(crn::ParallelFor(0, 100, [](size_t, size_t) { throw crn::ExceptionRuntime("band"); }, 4), const crn::ExceptionRuntime&);
+}
+
+TEST_CASE("Parallel image operations are identical to serial ones", "[parallel]")
+{
+	const auto src = random_gray(317, 211, 12345u);
+	auto run = [&src](size_t nthreads)
+		{
+			crn::ConcurrencyScope scope(nthreads);
+			auto res = std::vector<crn::ImageGray>{};
+			auto img = src;
+			img.Convolve(crn::MatrixDouble(5, 3, 1.0 / 15.0));
+			res.push_back(img);
+			img = src;
+			img.Dilate(crn::MatrixInt(3, 5, 1));
+			res.push_back(img);
+			img = src;
+			img.Erode(crn::MatrixInt(5, 3, 1));
+			res.push_back(img);
+			img = src;
+			img += src;
+			img *= 0.7;
+			res.push_back(img);
+			auto dimg = crn::ImageDoubleGray{};
+			dimg.Assign(src);
+			auto bw = crn::Threshold(src, uint8_t(127));
+			auto pix = std::vector<bool>(bw.begin(), bw.end());
+			const auto removed = crn::Regularize(bw, 3);
+			return std::make_tuple(res, dimg, pix, crn::ImageBW(bw), removed, bins(crn::HorizontalProjection(bw)), bins(crn::MakeHistogram(src)));
+		};
+	const auto serial = run(1);
+	const auto parallel = run(5);
+	REQUIRE(std::get<0>(serial).size() == std::get<0>(parallel).size());
+	for (auto tmp : crn::Range(std::get<0>(serial)))
+		REQUIRE(std::get<0>(serial)[tmp] == std::get<0>(parallel)[tmp]);
+	REQUIRE(std::get<1>(serial) == std::get<1>(parallel));
+	REQUIRE(std::get<2>(serial) == std::get<2>(parallel));
+	REQUIRE(std::get<3>(serial) == std::get<3>(parallel));
+	REQUIRE(std::get<4>(serial) == std::get<4>(parallel));
+	REQUIRE(std::get<5>(serial) == std::get<5>(parallel));
+	REQUIRE(std::get<6>(serial) == std::get<6>(parallel));
+}
+
@@ -0,0 +1,111 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: pyramid.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include <CRNBlock.h>
+#include <CRNImage/CRNImageCache.h>
+#include <CRNImage/CRNImageGray.h>
+
+/*! A page with lines of black rectangles (x-height 24, leading 60) */
+static std::shared_ptr<crn::ImageGray> make_page()
+{
+	auto img = std::make_shared<crn::ImageGray>(1600, 1000, uint8_t(255));
+	for (size_t ly = 80; ly + 40 < 920; ly += 60)
+		for (size_t wx = 80; wx + 80 < 1520; wx += 100)
+			for (size_t cx = wx; cx < wx + 80; cx += 20)
+				for (size_t y = ly; y < ly + 24; ++y)
+					for (size_t x = cx; x < cx + 14; ++x)
+						img->At(x, y) = 0;
+	return img;
+}
+
+TEST_CASE("Image pyramid", "[pyramid]")
+{
+	auto img = std::make_shared<crn::ImageGray>(300, 130, uint8_t(50));
+	auto pyr = crn::ImagePyramidGray(img, 32);
+	REQUIRE(pyr.GetLevelCount() == 3);
+	REQUIRE(&pyr.GetLevel(0) == img.get());
+	REQUIRE(pyr.GetLevel(1).GetWidth() == 150);
+	REQUIRE(pyr.GetLevel(2).GetWidth() == 75);
+	REQUIRE(pyr.GetLevel(2).GetHeight() == 32);
+	REQUIRE(pyr.GetLevel(2).At(10, 10) == 50);
+	REQUIRE(pyr.GetBytes() == 150 * 65 + 75 * 32);
+	REQUIRE_THROWS_AS(pyr.GetLevel(3), const crn::ExceptionDomain&);
+
+	// the pyramid is kept by the block until the gray buffer is flushed
+	auto b = crn::Block::New(img);
+	auto p1 = b->GetGrayPyramid();
+	REQUIRE(p1);
+	REQUIRE(b->GetGrayPyramid() == p1);
+	b->FlushGray();
+	REQUIRE_FALSE(b->GetGrayPyramid(false));
+	REQUIRE(b->GetGrayPyramid() != p1);
+
+	// the pyramid is dropped when the gray buffer is handed out for modification
+	auto p2 = b->GetGrayPyramid();
+	auto ig = b->GetGray();
+	REQUIRE_FALSE(b->GetGrayPyramid(false));
+	ig->At(0, 0) = 200;
+	auto p3 = b->GetGrayPyramid();
+	REQUIRE(p3->GetLevel(0).At(0, 0) == 200);
+	REQUIRE(p2->GetLevel(0).At(0, 0) == 50);
+
+}
+
+TEST_CASE("Block pyramids do not keep the gray buffer from being freed", "[pyramid]")
+{
+	auto b = crn::Block::New(std::make_shared<crn::ImageRGB>(600, 300, crn::pixel::RGB<uint8_t>(50, 50, 50)));
+	auto c = b->AddChildRelative(U"t", crn::Rect(0, 0, 399, 199));
+	crn::ImageCache::SetBudget(0);
+	auto pyr = c->GetGrayPyramid(); // computed from the parent's gray buffer
+	REQUIRE(pyr->GetLevel(1).GetWidth() == 200);
+	REQUIRE(b->GetGrayView(false));
+	crn::ImageCache::ResetStatistics();
+	crn::ImageCache::SetBudget(1);
+	REQUIRE(crn::ImageCache::GetEvictions() == 2); // the parent's RGB and gray buffers
+	pyr = nullptr;
+	crn::ImageCache::SetBudget(0);
+	crn::ImageCache::SetBudget(1);
+	REQUIRE(crn::ImageCache::GetEvictions() == 3);
+	REQUIRE(c->GetGrayPyramid()->GetLevel(1).At(10, 10) == 50);
+	crn::ImageCache::SetBudget(0);
+}
+
+TEST_CASE("Coarse to fine estimators", "[pyramid]")
+{
+	const auto page = make_page();
+	for (auto deg : {1.5, -2.0})
+	{
+		auto img = std::make_shared<crn::ImageGray>(crn::MakeRotation(*page, crn::Angle<crn::Degree>(deg), uint8_t(255)));
+		auto pyr = crn::ImagePyramidGray(img);
+		REQUIRE(pyr.GetLevelCount() > 1);
+
+		const auto xh = crn::EstimateLinesXHeight(pyr);
+		REQUIRE(xh >= 20);
+		REQUIRE(xh <= 28);
+		REQUIRE(crn::Abs(int(crn::EstimateLeading(pyr)) - 60) <= 4);
+
+		auto skew = crn::Angle<crn::Degree>(crn::EstimateSkew(pyr)).value;
+		if (skew > 180.0)
+			skew -= 360.0;
+		REQUIRE(crn::Abs(skew - deg) < 0.1);
+	}
+}
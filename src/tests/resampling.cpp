@@ -0,0 +1,117 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: resampling.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageRGB.h>
+
+static const crn::Resampling filters[] = { crn::Resampling::AREA, crn::Resampling::BOX, crn::Resampling::BILINEAR, crn::Resampling::BICUBIC, crn::Resampling::LANCZOS };
+
+TEST_CASE("Flat images remain flat", "[resampling]")
+{
+	for (auto filter : filters)
+	{
+		auto gray = crn::ImageGray(97, 61, 173);
+		gray.ScaleToSize(40, 150, filter);
+		REQUIRE(gray.GetWidth() == 40);
+		REQUIRE(gray.GetHeight() == 150);
+		auto ok = true;
+		for (auto px : gray)
+			ok = ok && (px == 173);
+		REQUIRE(ok);
+
+		auto rgb = crn::ImageRGB(31, 45, crn::pixel::RGB<uint8_t>(12, 200, 255));
+		rgb.ScaleToSize(70, 20, filter);
+		for (auto &px : rgb)
+			ok = ok && (px.r == 12) && (px.g == 200) && (px.b == 255);
+		REQUIRE(ok);
+	}
+}
+
+TEST_CASE("Resampling filters", "[resampling]")
+{
+	// reducing by 2 with AREA computes the mean of 2×2 blocks
+	auto gray = crn::ImageGray(64, 48);
+	auto dgray = crn::ImageDoubleGray(64, 48);
+	FOREACHPIXEL(x, y, gray)
+	{
+		gray.At(x, y) = uint8_t((x * 7 + y * 13) % 256);
+		dgray.At(x, y) = double(gray.At(x, y));
+	}
+	auto small = gray;
+	small.ScaleToSize(32, 24);
+	dgray.ScaleToSize(32, 24);
+	auto err = 0.0, grayerr = 0.0;
+	FOREACHPIXEL(x, y, small)
+	{
+		const auto mean = (gray.At(2 * x, 2 * y) + gray.At(2 * x + 1, 2 * y) + gray.At(2 * x, 2 * y + 1) + gray.At(2 * x + 1, 2 * y + 1)) / 4.0;
+		err = crn::Max(err, crn::Abs(dgray.At(x, y) - mean));
+		grayerr = crn::Max(grayerr, crn::Abs(double(small.At(x, y)) - mean));
+	}
+	REQUIRE(err < 1e-9);
+	REQUIRE(grayerr <= 1.0); // the horizontal pass is rounded to 8 bits
+
+	// enlarging by 2 with BOX duplicates the pixels
+	auto big = gray;
+	big.ScaleToSize(128, 96, crn::Resampling::BOX);
+	auto same = true;
+	FOREACHPIXEL(x, y, big)
+		same = same && (big.At(x, y) == gray.At(x / 2, y / 2));
+	REQUIRE(same);
+
+	// BILINEAR preserves a horizontal ramp far from the borders
+	auto ramp = crn::ImageDoubleGray(40, 10);
+	FOREACHPIXEL(x, y, ramp)
+		ramp.At(x, y) = double(x);
+	ramp.ScaleToSize(80, 10, crn::Resampling::BILINEAR);
+	err = 0.0;
+	for (size_t x = 2; x < 78; ++x)
+		err = crn::Max(err, crn::Abs(ramp.At(x, 5) - (double(x) + 0.5) / 2.0 + 0.5));
+	REQUIRE(err < 1e-9);
+
+	// ringing filters are clamped on 8 bits images
+	auto edge = crn::ImageGray(20, 4, uint8_t(0));
+	for (size_t y = 0; y < 4; ++y)
+		for (size_t x = 10; x < 20; ++x)
+			edge.At(x, y) = 255;
+	auto dedge = crn::ImageDoubleGray(edge);
+	edge.ScaleToSize(47, 4, crn::Resampling::LANCZOS);
+	dedge.ScaleToSize(47, 4, crn::Resampling::LANCZOS);
+	REQUIRE(crn::MinMax(dedge).second > 255.0); // overshoot
+	FOREACHPIXEL(x, y, edge)
+		err = crn::Max(err, crn::Abs(double(edge.At(x, y)) - crn::Cap(dedge.At(x, y), 0.0, 255.0)));
+	REQUIRE(err <= 1.0);
+
+	// and on other integer images, with rounding
+	auto edge16 = crn::Image<uint16_t>(20, 4, uint16_t(0));
+	for (size_t y = 0; y < 4; ++y)
+		for (size_t x = 10; x < 20; ++x)
+			edge16.At(x, y) = 60000;
+	dedge = crn::ImageDoubleGray(edge16);
+	edge16.ScaleToSize(47, 4, crn::Resampling::LANCZOS);
+	dedge.ScaleToSize(47, 4, crn::Resampling::LANCZOS);
+	auto rounded = true;
+	FOREACHPIXEL(x, y, edge16)
+		rounded = rounded && (edge16.At(x, y) == uint16_t(std::floor(crn::Cap(dedge.At(x, y), 0.0, 65535.0) + 0.5)));
+	REQUIRE(rounded);
+
+	REQUIRE_THROWS_AS(gray.ScaleToSize(0, 10), const crn::ExceptionDomain&);
+}
@@ -0,0 +1,184 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: spatialqueries.cpp
+ * \author Yann LEYDIER
+ */
+
+
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNBlock.h>
+#include <CRNGeometry/CRNRect.h>
+#include <CRNImage/CRNImageGray.h>
+#include <map>
+#include <set>
+
+/*! Pseudo-random rectangles, some of them one pixel wide or high */
+static std::vector<crn::Rect> random_rects(size_t n, int size, int maxdim, unsigned seed)
+{
+	auto rects = std::vector<crn::Rect>{};
+	auto gen = TestRandom(seed);
+	auto rnd = [&gen](int m) { return int(gen.Below(unsigned(m))); };
+	for (size_t tmp = 0; tmp < n; ++tmp)
+	{
+		const auto x = rnd(size), y = rnd(size);
+		rects.emplace_back(x, y, x + rnd(maxdim), y + rnd(maxdim));
+	}
+	return rects;
+}
+
+/*! All-pairs reference of Rect::FindClosestsToBorder */
+static std::vector<crn::Rect> brute_closests(const std::vector<crn::Rect> &rects, crn::Direction drt)
+{
+	auto closest = std::vector<crn::Rect>{};
+	const auto orient = ((drt == crn::Direction::LEFT) || (drt == crn::Direction::RIGHT)) ? crn::Orientation::VERTICAL : crn::Orientation::HORIZONTAL;
+	auto border = [drt](const crn::Rect &r)
+		{
+			switch (drt)
+			{
+				case crn::Direction::LEFT: return r.GetLeft();
+				case crn::Direction::RIGHT: return -r.GetRight();
+				case crn::Direction::TOP: return r.GetTop();
+				default: return -r.GetBottom();
+			}
+		};
+	for (auto i : crn::Range(rects))
+	{
+		auto extremal = true;
+		for (auto j : crn::Range(rects))
+			if ((i != j) && rects[i].Overlap(rects[j], orient) && (border(rects[i]) > border(rects[j])))
+				extremal = false;
+		if (extremal)
+			closest.push_back(rects[i]);
+	}
+	return closest;
+}
+
+/*! All-pairs reference of Block::MergeChildren */
+static bool brute_merge(std::vector<crn::Rect> &rects, double overlap)
+{
+	std::map<size_t, std::map<size_t, size_t>> overlaps;
+	for (size_t b1 = 0; b1 < rects.size(); ++b1)
+	{
+		const auto ov1 = rects[b1].GetArea() * overlap;
+		for (auto b2 = b1 + 1; b2 < rects.size(); ++b2)
+		{
+			const auto rov = rects[b1] & rects[b2];
+			if (!rov.IsValid())
+				continue;
+			const auto rova = double(rov.GetArea());
+			const auto ov2 = rects[b2].GetArea() * overlap;
+			const auto dist = size_t(crn::Min(crn::Abs(rects[b1].GetCenterX() - rects[b2].GetCenterX()), crn::Abs(rects[b1].GetCenterY() - rects[b2].GetCenterY())));
+			if ((rova >= ov1) && (rova >= ov2))
+			{
+				if (ov1 >= ov2)
+					overlaps[b2][dist] = b1;
+				else
+				{
+					overlaps[b1][dist] = b2;
+					break;
+				}
+			}
+			else if (rova >= ov1)
+			{
+				overlaps[b1][dist] = b2;
+				break;
+			}
+			else if (rova >= ov2)
+				overlaps[b2][dist] = b1;
+		}
+	}
+	if (overlaps.empty())
+		return false;
+	auto removed = std::set<size_t>{};
+	for (const auto &o : overlaps)
+	{
+		auto to = o.second.begin()->second;
+		for (auto next = overlaps.find(to); next != overlaps.end(); next = overlaps.find(to))
+			to = next->second.begin()->second;
+		rects[to] = rects[to] | rects[o.first];
+		removed.insert(o.first);
+	}
+	auto kept = std::vector<crn::Rect>{};
+	for (auto tmp : crn::Range(rects))
+		if (!removed.count(tmp))
+			kept.push_back(rects[tmp]);
+	rects.swap(kept);
+	return true;
+}
+
+TEST_CASE("Intersecting pairs of rectangles", "[spatialqueries]")
+{
+	auto rects = random_rects(400, 500, 40, 7);
+	rects.insert(rects.begin() + 10, crn::Rect{});
+	auto ref = std::vector<std::pair<size_t, size_t>>{};
+	for (size_t i = 0; i < rects.size(); ++i)
+		for (auto j = i + 1; j < rects.size(); ++j)
+			if ((rects[i] & rects[j]).IsValid())
+				ref.emplace_back(i, j);
+	REQUIRE(!ref.empty());
+	REQUIRE(crn::Rect::FindIntersectingPairs(rects) == ref);
+}
+
+TEST_CASE("Rectangles closest to border", "[spatialqueries]")
+{
+	for (auto seed : {1u, 2u, 3u})
+	{
+		auto rects = random_rects(150, 60, 6, seed);
+		// touching rectangles have a null overlap
+		rects.emplace_back(0, 70, 5, 72);
+		rects.emplace_back(5, 75, 5, 75);
+		for (auto drt : {crn::Direction::LEFT, crn::Direction::RIGHT, crn::Direction::TOP, crn::Direction::BOTTOM})
+			REQUIRE(crn::Rect::FindClosestsToBorder(rects.begin(), rects.end(), drt) == brute_closests(rects, drt));
+	}
+}
+
+TEST_CASE("Merge overlapping children", "[spatialqueries]")
+{
+	for (auto overlap : {0.0, 0.3, 1.0})
+	{
+		auto ref = random_rects(300, 280, 25, 11);
+		auto page = crn::Block::New(std::make_shared<crn::ImageGray>(320, 320, uint8_t(255)));
+		for (auto tmp : crn::Range(ref))
+			page->AddChildAbsolute(U"w", ref[tmp], crn::StringUTF8(int(tmp)));
+
+		auto merged = true;
+		while (merged)
+		{
+			merged = page->MergeChildren(U"w", overlap);
+			REQUIRE(merged == brute_merge(ref, overlap));
+			REQUIRE(page->GetNbChildren(U"w") == ref.size());
+			for (auto tmp : crn::Range(ref))
+				REQUIRE(page->GetChild(U"w", tmp)->GetAbsoluteBBox() == ref[tmp]);
+		}
+	}
+}
+
+TEST_CASE("Filter children close to the borders", "[spatialqueries]")
+{
+	auto page = crn::Block::New(std::make_shared<crn::ImageGray>(100, 100, uint8_t(255)));
+	page->AddChildAbsolute(U"w", crn::Rect(2, 50, 10, 60));
+	page->AddChildAbsolute(U"w", crn::Rect(20, 20, 30, 30));
+	page->AddChildAbsolute(U"w", crn::Rect(40, 40, 50, 96));
+	page->AddChildAbsolute(U"w", crn::Rect(5, 5, 94, 94));
+	page->FilterBorders(U"w", 5);
+	REQUIRE(page->GetNbChildren(U"w") == 2);
+	REQUIRE(page->GetChild(U"w", 0)->GetAbsoluteBBox() == crn::Rect(20, 20, 30, 30));
+	REQUIRE(page->GetChild(U"w", 1)->GetAbsoluteBBox() == crn::Rect(5, 5, 94, 94));
+}
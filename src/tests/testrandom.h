@@ -0,0 +1,57 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: testrandom.h
+ * \author Yann LEYDIER
+ */
+
+
+#ifndef CRNTESTRANDOM_HEADER
+#define CRNTESTRANDOM_HEADER
+
+#include <CRNImage/CRNImageGray.h>
+
+/*! \brief Reproducible pseudo-random sequence for the tests (linear congruential generator) */
+class TestRandom
+{
+	public:
+		/*! \brief Constructor */
+		TestRandom(unsigned int seed) noexcept:v(seed) {}
+		/*! \brief Returns the next 32 bits value */
+		unsigned int Next() noexcept { v = v * 1103515245u + 12345u; return v; }
+		/*! \brief Returns a value in [0, 255] */
+		uint8_t Byte() noexcept { return uint8_t(Next() >> 24); }
+		/*! \brief Returns a value in [0, m[ */
+		unsigned int Below(unsigned int m) noexcept { return (Next() >> 8) % m; }
+		/*! \brief Returns a value in [-0.5, 0.5[ */
+		double Real() noexcept { return double(Next() >> 16) / 65536.0 - 0.5; }
+
+	private:
+		unsigned int v; /*!< state */
+};
+
+/*! \brief Creates a gray image filled with pseudo-random values */
+inline crn::ImageGray random_gray(size_t w, size_t h, unsigned int seed)
+{
+	auto img = crn::ImageGray(w, h);
+	auto rnd = TestRandom(seed);
+	for (auto &px : img)
+		px = rnd.Byte();
+	return img;
+}
+
+#endif
@@ -0,0 +1,125 @@
+/* Copyright 2016 INSA-Lyon, ENS-Lyon
+ *
+ * This file is part of libcrn.
+ *
+ * libcrn is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libcrn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libcrn.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * file: warp.cpp
+ * \author Yann LEYDIER
+ */
+
+#include "catch.hpp"
+#include "testrandom.h"
+#include <CRNImage/CRNImageGray.h>
+#include <CRNImage/CRNImageBW.h>
+#include <CRNMath/CRNMatrixDouble.h>
+
+static crn::MatrixDouble translation(double tx, double ty)
+{
+	auto m = crn::MatrixDouble(3, 3, 0.0);
+	m[0][0] = m[1][1] = m[2][2] = 1.0;
+	m[0][2] = tx;
+	m[1][2] = ty;
+	return m;
+}
+
+TEST_CASE("Affine and projective warps", "[warp]")
+{
+	const auto img = random_gray(150, 90, 777u);
+	const auto interps = { crn::Interpolation::NEAREST, crn::Interpolation::BILINEAR, crn::Interpolation::BICUBIC };
+
+	// identity
+	for (auto interp : interps)
+	{
+		REQUIRE(crn::MakeAffineWarp(img, translation(0, 0), img.GetWidth(), img.GetHeight(), uint8_t(0), interp) == img);
+		REQUIRE(crn::MakeProjectiveWarp(img, translation(0, 0), img.GetWidth(), img.GetHeight(), uint8_t(0), interp) == img);
+	}
+
+	// integer translation
+	auto moved = crn::MakeAffineWarp(img, translation(2, -3), 100, 100, uint8_t(7), crn::Interpolation::NEAREST);
+	auto ok = true;
+	FOREACHPIXEL(x, y, moved)
+	{
+		const auto sx = int(x) - 2, sy = int(y) + 3;
+		const auto expected = ((sx >= 0) && (sy < int(img.GetHeight()))) ? img.At(sx, sy) : uint8_t(7);
+		ok = ok && (moved.At(x, y) == expected);
+	}
+	REQUIRE(ok);
+
+	// half pixel translation
+	auto dimg = crn::ImageDoubleGray(img);
+	auto half = crn::MakeAffineWarp(dimg, translation(-0.5, 0), 100, 80, 0.0, crn::Interpolation::BILINEAR);
+	auto err = 0.0;
+	FOREACHPIXEL(x, y, half)
+		err = crn::Max(err, crn::Abs(half.At(x, y) - (dimg.At(x, y) + dimg.At(x + 1, y)) / 2.0));
+	REQUIRE(err < 1e-3);
+
+	// a projective warp with an affine matrix is an affine warp
+	auto rot = translation(10, -5);
+	rot[0][0] = rot[1][1] = cos(0.3);
+	rot[0][1] = sin(0.3);
+	rot[1][0] = -sin(0.3);
+	const auto a = crn::MakeAffineWarp(dimg, rot, 170, 140, 0.0, crn::Interpolation::BICUBIC);
+	const auto p = crn::MakeProjectiveWarp(dimg, rot, 170, 140, 0.0, crn::Interpolation::BICUBIC);
+	err = 0.0;
+	FOREACHPIXEL(x, y, a)
+		err = crn::Max(err, crn::Abs(a.At(x, y) - p.At(x, y)));
+	REQUIRE(err < 1.0);
+
+	REQUIRE_THROWS_AS(crn::MakeAffineWarp(img, crn::MatrixDouble(2, 3, 0.0), 10, 10, uint8_t(0)), const crn::ExceptionDomain&);
+	REQUIRE_THROWS_AS(crn::MakeAffineWarp(img, crn::MatrixDouble(3, 3, 1.0), 10, 10, uint8_t(0)), const crn::ExceptionInvalidArgument&);
+	REQUIRE_THROWS_AS(crn::MakeProjectiveWarp(img, crn::MatrixDouble(2, 3, 1.0), 10, 10, uint8_t(0)), const crn::ExceptionDimension&);
+}
+
+TEST_CASE("Rotations", "[warp]")
+{
+	// a black rectangle in the upper right corner
+	auto img = crn::ImageBW(200, 120, crn::pixel::BWWhite);
+	for (size_t y = 10; y < 30; ++y)
+		for (size_t x = 150; x < 190; ++x)
+			img.At(x, y) = crn::pixel::BWBlack;
+
+	auto black_center = [](const crn::ImageBW &i)
+	{
+		auto sx = 0.0, sy = 0.0, n = 0.0;
+		FOREACHPIXEL(x, y, i)
+			if (!i.At(x, y))
+			{
+				sx += double(x);
+				sy += double(y);
+				n += 1.0;
+			}
+		return std::make_pair(sx / n, sy / n);
+	};
+
+	// a positive angle rotates counterclockwise
+	const auto angle = crn::Angle<crn::Degree>(3.0);
+	const auto cx = 99.5, cy = 59.5;
+	const auto r = angle.Get<crn::Radian>();
+	const auto ex = cx + cos(r) * (169.5 - cx) + sin(r) * (19.5 - cy);
+	const auto ey = cy - sin(r) * (169.5 - cx) + cos(r) * (19.5 - cy);
+	const auto sheared = crn::MakeShearRotation(img, angle);
+	REQUIRE(sheared.GetWidth() == img.GetWidth());
+	REQUIRE(sheared.GetHeight() == img.GetHeight());
+	auto c = black_center(sheared);
+	REQUIRE(crn::Abs(c.first - ex) < 1.0);
+	REQUIRE(crn::Abs(c.second - ey) < 1.0);
+
+	const auto rotated = crn::MakeRotation(img, angle, crn::pixel::BWWhite);
+	c = black_center(rotated);
+	REQUIRE(crn::Abs(c.first - (ex + (double(rotated.GetWidth()) - 200.0) / 2.0)) < 1.0);
+	REQUIRE(crn::Abs(c.second - (ey + (double(rotated.GetHeight()) - 120.0) / 2.0)) < 1.0);
+
+	REQUIRE(crn::MakeShearRotation(img, crn::Angle<crn::Radian>(0.0)) == img);
+}